@@ -0,0 +1,472 @@
+#include "header.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+
+// Rules are parsed once into AlertRules and resolved against the metric schema
+// on the sampler's first snapshot. From then on each sample only touches the
+// rules of the collectors that ran, and each rule keeps O(1) state: the
+// previous value for a rate, a moving average, and since when its condition
+// has held. Nothing looks back over older snapshots.
+
+static const char* const thermalRules =
+    "# the Thermal tab's status; the same 50/70/85 C steps it always had\n"
+    "info Warm: sensors.temperature >= 50\n"
+    "warning Hot: sensors.temperature >= 70\n"
+    "critical Critical: sensors.temperature >= 85\n";
+
+static vector<AlertRule> configuredRules;
+static bool rulesConfigured = false;
+static string logFile, socketPath;
+
+const char* alertLevelName(AlertLevel level) {
+    switch (level) {
+        case ALERT_INFO: return "info";
+        case ALERT_WARNING: return "warning";
+        case ALERT_CRITICAL: return "critical";
+    }
+    return "?";
+}
+
+void setAlertRules(const vector<AlertRule>& rules) {
+    configuredRules = rules;
+    rulesConfigured = true;
+}
+
+const vector<AlertRule>& alertRules() {
+    if (!rulesConfigured) {
+        string error;
+        parseAlertRules(thermalRules, configuredRules, error);
+        rulesConfigured = true;
+    }
+    return configuredRules;
+}
+
+void setAlertOutputs(const string& log, const string& socket) {
+    logFile = log;
+    socketPath = socket;
+}
+
+const string& alertLogFile() { return logFile; }
+
+const string& alertSocketPath() { return socketPath; }
+
+// ---- parsing --------------------------------------------------------------
+
+static const char* const processFieldNames[PROCESS_FIELDS] = {
+    "cpu", "rss", "pss", "swap", "read_rate", "write_rate", "net_rx", "net_tx", "fds", "count",
+};
+
+// "30s", "500ms", "5m", "5min", "2h"; a bare number is seconds
+static bool parseDuration(const string& token, float& seconds) {
+    char* end;
+    double value = strtod(token.c_str(), &end);
+    if (end == token.c_str() || !(value >= 0)) return false;
+    string unit = end;
+    if (unit == "ms") value /= 1000.0;
+    else if (unit == "m" || unit == "min") value *= 60.0;
+    else if (unit == "h") value *= 3600.0;
+    else if (!unit.empty() && unit != "s") return false;
+    seconds = static_cast<float>(value);
+    return true;
+}
+
+// "90", "90%", "800MB/s", "10MiB/min", "2k": the value in bytes (per second)
+static bool parseQuantity(const string& token, double& value) {
+    char* end;
+    value = strtod(token.c_str(), &end);
+    if (end == token.c_str() || std::isnan(value)) return false;
+    string unit = end;
+    if (unit == "%") return true;
+    size_t slash = unit.find('/');
+    string size = unit.substr(0, slash), per = slash == string::npos ? "" : unit.substr(slash + 1);
+
+    static const struct { const char* suffix; double scale; } sizes[] = {
+        {"", 1.0},        {"B", 1.0},         {"k", 1e3},          {"K", 1e3},          {"KB", 1e3},
+        {"kB", 1e3},      {"M", 1e6},         {"MB", 1e6},         {"G", 1e9},          {"GB", 1e9},
+        {"T", 1e12},      {"TB", 1e12},       {"KiB", 1024.0},     {"MiB", 1048576.0}, {"GiB", 1073741824.0},
+        {"TiB", 1099511627776.0},
+    };
+    bool known = false;
+    for (const auto& entry : sizes) {
+        if (size != entry.suffix) continue;
+        value *= entry.scale;
+        known = true;
+    }
+    if (!known) return false;
+    if (slash == string::npos || per == "s" || per == "sec") return true;
+    if (per == "min" || per == "m") value /= 60.0;
+    else if (per == "h") value /= 3600.0;
+    else return false;
+    return true;
+}
+
+static bool validMetricName(const string& name) {
+    if (name.empty()) return false;
+    for (char c : name)
+        if (!(c >= 'a' && c <= 'z') && !(c >= '0' && c <= '9') && c != '_' && c != '.') return false;
+    return true;
+}
+
+// The value a rule looks at, from its first token.
+static bool parseTarget(const string& token, AlertRule& rule, string& error) {
+    static const string procPrefix = "proc[name=", netPrefix = "net.";
+    if (token.compare(0, procPrefix.size(), procPrefix) == 0) {
+        size_t close = token.find("].", procPrefix.size());
+        if (close == string::npos || close == procPrefix.size()) {
+            error = "expected proc[name=<name>].<field>";
+            return false;
+        }
+        rule.source = ALERT_PROCESSES;
+        rule.target = token.substr(procPrefix.size(), close - procPrefix.size());
+        string field = token.substr(close + 2);
+        for (int f = 0; f < PROCESS_FIELDS; ++f)
+            if (field == processFieldNames[f]) rule.field = f;
+        if (field != processFieldNames[rule.field]) {
+            error = "unknown process field " + field;
+            return false;
+        }
+        return true;
+    }
+    // net.<interface>.rx_rate; net.rx_rate alone is the built-in total
+    for (int direction = 0; direction < 2; ++direction) {
+        string suffix = direction == 0 ? ".rx_rate" : ".tx_rate";
+        if (token.size() <= netPrefix.size() + suffix.size() || token.compare(0, netPrefix.size(), netPrefix) != 0 ||
+            token.compare(token.size() - suffix.size(), suffix.size(), suffix) != 0)
+            continue;
+        rule.source = ALERT_INTERFACE;
+        rule.target = token.substr(netPrefix.size(), token.size() - netPrefix.size() - suffix.size());
+        rule.field = direction;
+        return true;
+    }
+    if (!validMetricName(token)) {
+        error = "unknown value " + token;
+        return false;
+    }
+    rule.source = ALERT_METRIC;
+    rule.target = token;
+    return true;
+}
+
+static bool parseRule(string line, AlertRule& rule, string& error) {
+    static const char* const levels[] = {"info", "warning", "critical"};
+    if (line.find_first_of("\"\\") != string::npos) {
+        error = "quotes and backslashes aren't allowed";
+        return false;
+    }
+    // a level first, then "name:" if there is one
+    size_t start = line.find_first_not_of(" \t");
+    for (int level = ALERT_INFO; level <= ALERT_CRITICAL; ++level) {
+        size_t length = strlen(levels[level]);
+        if (line.compare(start, length, levels[level]) != 0 || (line.size() > start + length && !isspace(line[start + length])))
+            continue;
+        rule.level = static_cast<AlertLevel>(level);
+        start += length;
+        break;
+    }
+    line = line.substr(start);
+    size_t colon = line.find(':');
+    if (colon != string::npos) {
+        rule.name = line.substr(0, colon);
+        rule.name.erase(0, rule.name.find_first_not_of(" \t"));
+        rule.name.erase(rule.name.find_last_not_of(" \t") + 1);
+        line = line.substr(colon + 1);
+    }
+    line.erase(0, line.find_first_not_of(" \t"));
+    line.erase(line.find_last_not_of(" \t") + 1);
+    rule.expression = line;
+    if (rule.name.empty()) rule.name = line;
+
+    // operators may be written without spaces around them
+    string spaced;
+    for (size_t i = 0; i < line.size(); ++i) {
+        if (line[i] != '<' && line[i] != '>') {
+            spaced += line[i];
+            continue;
+        }
+        spaced += ' ';
+        spaced += line[i];
+        if (i + 1 < line.size() && line[i + 1] == '=') spaced += line[++i];
+        spaced += ' ';
+    }
+    std::istringstream words(spaced);
+    vector<string> tokens;
+    for (string token; words >> token;) tokens.push_back(token);
+
+    size_t at = 0;
+    auto next = [&](const char* what) {
+        if (at < tokens.size()) return true;
+        error = string("expected ") + what;
+        return false;
+    };
+    if (!next("a value") || !parseTarget(tokens[at++], rule, error)) return false;
+    if (at < tokens.size() && tokens[at] == "rate") {
+        rule.rate = true;
+        at++;
+    }
+    if (at < tokens.size() && tokens[at] == "avg") {
+        at++;
+        if (!next("a duration after avg") || !parseDuration(tokens[at++], rule.average) || rule.average <= 0) {
+            error = "bad duration after avg";
+            return false;
+        }
+    }
+    if (!next(">, >=, < or <=")) return false;
+    const string& op = tokens[at++];
+    if (op != ">" && op != ">=" && op != "<" && op != "<=") {
+        error = "expected >, >=, < or <= instead of " + op;
+        return false;
+    }
+    rule.above = op[0] == '>';
+    rule.inclusive = op.size() == 2;
+    if (!next("a threshold") || !parseQuantity(tokens[at++], rule.threshold)) {
+        error = "bad threshold " + tokens[at - 1];
+        return false;
+    }
+    double margin = std::fabs(rule.threshold) * 0.05;
+    rule.clear = rule.above ? rule.threshold - margin : rule.threshold + margin;
+    while (at < tokens.size()) {
+        const string& keyword = tokens[at++];
+        if (keyword == "for") {
+            if (!next("a duration after for") || !parseDuration(tokens[at++], rule.hold)) {
+                error = "bad duration after for";
+                return false;
+            }
+        } else if (keyword == "clear") {
+            if (!next("a threshold after clear") || !parseQuantity(tokens[at++], rule.clear)) {
+                error = "bad threshold after clear";
+                return false;
+            }
+            if (rule.above ? rule.clear > rule.threshold : rule.clear < rule.threshold) {
+                error = "the clear threshold must be on the other side of the threshold";
+                return false;
+            }
+        } else {
+            error = "unexpected " + keyword;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parseAlertRules(const string& text, vector<AlertRule>& rules, string& error) {
+    rules.clear();
+    std::istringstream lines(text);
+    int number = 0;
+    for (string line; getline(lines, line);) {
+        number++;
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == string::npos) continue;
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        AlertRule rule;
+        string problem;
+        if (!parseRule(line, rule, problem)) {
+            error = "line " + std::to_string(number) + ": " + problem;
+            return false;
+        }
+        rules.push_back(rule);
+    }
+    return true;
+}
+
+// ---- evaluation -----------------------------------------------------------
+
+AlertEngine::~AlertEngine() {
+    if (logFd >= 0) close(logFd);
+    if (socketFd >= 0) close(socketFd);
+}
+
+void AlertEngine::configure(const vector<AlertRule>& list, const string& log, const string& socket) {
+    if (configured) return;
+    configured = true;
+    rules = make_shared<const vector<AlertRule>>(list);
+    states.assign(list.size(), State{});
+    firing.reserve(list.size());
+    for (const AlertRule& rule : list)
+        if (rule.source == ALERT_PROCESSES) processNames.push_back(rule.target);
+    sort(processNames.begin(), processNames.end());
+    processNames.erase(unique(processNames.begin(), processNames.end()), processNames.end());
+    processTotals.resize(processNames.size());
+
+    if (!log.empty()) {
+        logFd = open(log.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (logFd < 0) fprintf(stderr, "Warning: could not open alert log %s\n", log.c_str());
+    }
+    if (!socket.empty()) {
+        socketAddress.sun_family = AF_UNIX;
+        if (socket.size() >= sizeof(socketAddress.sun_path)) {
+            fprintf(stderr, "Warning: alert socket path %s is too long\n", socket.c_str());
+        } else {
+            memcpy(socketAddress.sun_path, socket.c_str(), socket.size() + 1);
+            socketFd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        }
+    }
+}
+
+// Maps every rule to the collector behind its value; a metric that isn't in
+// the schema (a plugin that didn't load) leaves its rule idle.
+void AlertEngine::resolve(const shared_ptr<const MetricSchema>& metrics) {
+    schema = metrics;
+    for (auto& list : byCollector) list.clear();
+    for (int i : firing) states[i].firing = false;
+    firing.clear();
+    for (size_t i = 0; i < rules->size(); ++i) {
+        const AlertRule& rule = (*rules)[i];
+        State& state = states[i];
+        state = State{};
+        if (rule.source == ALERT_INTERFACE) {
+            byCollector[COLLECTOR_NETWORK].push_back(i);
+        } else if (rule.source == ALERT_PROCESSES) {
+            state.metric = lower_bound(processNames.begin(), processNames.end(), rule.target) - processNames.begin();
+            byCollector[COLLECTOR_PROCESSES].push_back(i);
+        } else {
+            state.metric = schema ? schema->find(rule.target) : -1;
+            if (state.metric < 0) {
+                fprintf(stderr, "Warning: alert rule \"%s\": no metric %s\n", rule.name.c_str(), rule.target.c_str());
+                continue;
+            }
+            for (size_t s = 0; s < schema->sections.size(); ++s) {
+                const MetricSection& section = schema->sections[s];
+                if (static_cast<size_t>(state.metric) < section.first ||
+                    static_cast<size_t>(state.metric) >= section.first + section.count)
+                    continue;
+                state.section = s;
+                byCollector[section.collector].push_back(i);
+            }
+        }
+    }
+}
+
+void AlertEngine::sumProcesses(const SystemSnapshot& snap) {
+    static const double pageSize = static_cast<double>(sysconf(_SC_PAGESIZE));
+    for (ProcessTotals& totals : processTotals) fill(begin(totals.fields), end(totals.fields), 0.0);
+    for (const Proc& proc : snap.processes) {
+        auto name = lower_bound(processNames.begin(), processNames.end(), proc.name);
+        if (name == processNames.end() || *name != proc.name) continue;
+        double* fields = processTotals[name - processNames.begin()].fields;
+        fields[PROCESS_CPU] += proc.cpuPercent;
+        fields[PROCESS_RSS] += proc.rss * pageSize;
+        fields[PROCESS_PSS] += max(0LL, proc.pss) * 1024.0;
+        fields[PROCESS_SWAP] += max(0LL, proc.swap) * 1024.0;
+        fields[PROCESS_READ_RATE] += proc.io.readBytesPerSec;
+        fields[PROCESS_WRITE_RATE] += proc.io.writeBytesPerSec;
+        fields[PROCESS_NET_RX] += proc.netReceiveRate;
+        fields[PROCESS_NET_TX] += proc.netSendRate;
+        fields[PROCESS_FDS] += max(0, proc.fds.total);
+        fields[PROCESS_COUNT] += 1;
+    }
+}
+
+double AlertEngine::read(const AlertRule& rule, const State& state, const SystemSnapshot& snap) const {
+    switch (rule.source) {
+        case ALERT_METRIC:
+            return state.metric >= 0 && static_cast<size_t>(state.metric) < snap.metricValues.size()
+                       ? snap.metricValues[state.metric]
+                       : NAN;
+        case ALERT_INTERFACE: {
+            const map<string, float>& rates = rule.field == 0 ? snap.rxRate : snap.txRate;
+            auto rate = rates.find(rule.target);
+            return rate != rates.end() ? rate->second : NAN;
+        }
+        case ALERT_PROCESSES: return processTotals[state.metric].fields[rule.field];
+    }
+    return NAN;
+}
+
+void AlertEngine::evaluate(int index, const SystemSnapshot& snap) {
+    const AlertRule& rule = (*rules)[index];
+    State& state = states[index];
+    double value = read(rule, state, snap);
+    if (std::isnan(value)) return;
+    float now = snap.time;
+    if (rule.rate) {
+        double last = state.last;
+        float lastTime = state.lastTime;
+        state.last = value;
+        state.lastTime = now;
+        if (std::isnan(last) || now <= lastTime) return;
+        value = (value - last) / (now - lastTime);
+    }
+    if (rule.average > 0) {
+        // an exponential average over `average` seconds, whatever the gaps between samples
+        if (std::isnan(state.average)) state.average = value;
+        else state.average += (1.0 - std::exp((state.averageTime - now) / rule.average)) * (value - state.average);
+        state.averageTime = now;
+        value = state.average;
+    }
+    state.value = value;
+
+    auto past = [&](double limit) {
+        if (rule.above) return rule.inclusive ? value >= limit : value > limit;
+        return rule.inclusive ? value <= limit : value < limit;
+    };
+    if (!state.firing) {
+        if (!past(rule.threshold)) {
+            state.holding = -1;
+            return;
+        }
+        if (state.holding < 0) state.holding = now;
+        if (now - state.holding < rule.hold) return;
+        state.firing = true;
+        state.since = now;
+        firing.insert(lower_bound(firing.begin(), firing.end(), index), index);
+    } else if (!past(rule.clear)) {
+        state.firing = false;
+        state.holding = -1;
+        firing.erase(lower_bound(firing.begin(), firing.end(), index));
+    } else {
+        return;
+    }
+    timespec wall;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    record(AlertEvent{index, state.firing, now, wall.tv_sec + wall.tv_nsec / 1e9, value});
+}
+
+// Keeps the event for the panel and sends it on as a JSON line.
+void AlertEngine::record(const AlertEvent& event) {
+    events[eventCount++ % MAX_EVENTS] = event;
+    if (logFd < 0 && socketFd < 0) return;
+    const AlertRule& rule = (*rules)[event.rule];
+    char line[1024];
+    int length = snprintf(line, sizeof(line),
+                          "{\"time\":%.3f,\"rule\":\"%s\",\"level\":\"%s\",\"state\":\"%s\",\"value\":%.6g,"
+                          "\"expression\":\"%s\"}\n",
+                          event.wallTime, rule.name.c_str(), alertLevelName(rule.level),
+                          event.firing ? "firing" : "cleared", event.value, rule.expression.c_str());
+    if (length <= 0 || length >= static_cast<int>(sizeof(line))) return;
+    // a full disk or a listener that went away only loses this line
+    if (logFd >= 0) {
+        ssize_t written = write(logFd, line, length);
+        (void)written;
+    }
+    if (socketFd >= 0)
+        sendto(socketFd, line, length, MSG_DONTWAIT, reinterpret_cast<const sockaddr*>(&socketAddress),
+               sizeof(socketAddress));
+}
+
+void AlertEngine::update(SystemSnapshot& snap, unsigned due) {
+    MONITOR_PROBE(PROBE_UPDATE_ALERTS);
+    snap.alertRules = rules;
+    snap.alerts.clear();
+    snap.alertEvents.clear();
+    if (!rules) return;
+    if (snap.metrics != schema) resolve(snap.metrics);
+
+    if (!processNames.empty() && (due & (1u << COLLECTOR_PROCESSES))) sumProcesses(snap);
+    for (int c = 0; c < COLLECTORS; ++c) {
+        if (!(due & (1u << c))) continue;
+        for (int index : byCollector[c]) {
+            // a plugin's section only changes on that plugin's own runs
+            if (c == COLLECTOR_PLUGINS && snap.sectionUpdated[states[index].section] != snap.time) continue;
+            evaluate(index, snap);
+        }
+    }
+
+    // capacity for every rule and event, so no later snapshot allocates
+    snap.alerts.reserve(rules->size());
+    snap.alertEvents.reserve(MAX_EVENTS);
+    for (int index : firing) snap.alerts.push_back(ActiveAlert{index, states[index].since, states[index].value});
+    size_t count = min(eventCount, MAX_EVENTS);
+    for (size_t i = 0; i < count; ++i) snap.alertEvents.push_back(events[(eventCount - count + i) % MAX_EVENTS]);
+}
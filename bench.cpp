@@ -0,0 +1,1641 @@
+#include "header.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ftw.h>
+#include <linux/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// Microbenchmarks for the /proc and /sys parsers. `make bench` builds this
+// without SDL or OpenGL and runs it against the checked-in fixture tree, so
+// results depend on the parser code and not on what the machine is running.
+//
+// Output is one tab-separated line per benchmark with a fixed column order,
+// which makes two runs easy to diff:
+//
+//   benchmark<TAB>ns/op<TAB>ops/s<TAB>allocs/op
+//
+// --verify instead checks the rates and percentages the collectors derive from
+// a generated fixture (fixture.cpp) against the values it was scripted with, and
+// that a sampler tick, a UI frame and the older value-returning calls stay
+// within their heap allocation budgets once warmed up; `make test` runs it
+// alone. The bench is built with the malloc family hooked, so allocations
+// inside libc count too.
+
+// keeps the compiler from discarding a result that is never used
+template <typename T>
+static void keep(T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+static double nowSeconds() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+struct BenchOptions {
+    string root = "fixtures/desktop";
+    double minTime = 0.25; // seconds each benchmark runs for
+    const char* filter = nullptr;
+    bool verify = false;
+};
+
+// Runs fn in batches, doubling the batch until one takes at least minTime,
+// and reports the last batch.
+static void runBenchmark(const BenchOptions& options, const char* name, const std::function<void()>& fn) {
+    if (options.filter && !strstr(name, options.filter)) return;
+
+    fn(); // warm up the page cache and any lazily initialised state
+    unsigned long long iterations = 1;
+    while (true) {
+        unsigned long long allocationsBefore = threadAllocationCount();
+        double start = nowSeconds();
+        for (unsigned long long i = 0; i < iterations; ++i) fn();
+        double elapsed = nowSeconds() - start;
+        unsigned long long allocations = threadAllocationCount() - allocationsBefore;
+
+        if (elapsed >= options.minTime || iterations >= (1ull << 30)) {
+            double nsPerOp = elapsed * 1e9 / iterations;
+            printf("%s\t%.1f\t%.1f\t%.2f\n", name, nsPerOp, iterations / elapsed,
+                   static_cast<double>(allocations) / iterations);
+            fflush(stdout);
+            return;
+        }
+        iterations *= 2;
+    }
+}
+
+// A fixture that doesn't parse gives meaningless timings, so fail loudly instead.
+static bool checkFixture(const BenchOptions& options) {
+    SystemResourceTracker resources;
+    NetworkTracker network;
+    bool ok = true;
+    auto require = [&](bool condition, const char* what) {
+        if (!condition) {
+            fprintf(stderr, "monitor-bench: %s/%s did not parse\n", options.root.c_str(), what);
+            ok = false;
+        }
+    };
+    require(!resources.getProcessList().empty(), "proc/<pid>/stat");
+    require(resources.getMemoryInfo().mem_total_kb > 0, "proc/meminfo");
+    require(!network.getNetworkRX().empty(), "proc/net/dev");
+    return ok;
+}
+
+static int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+    return remove(path);
+}
+
+// Samples a generated tree at two steps, with the clock advanced by the step
+// length in between, and compares what the collectors compute with the rates
+// the tree was generated from.
+static bool verifyFixtureProgression() {
+    char root[] = "/tmp/monitor-verify-XXXXXX";
+    if (!mkdtemp(root)) {
+        perror("monitor-bench: mkdtemp");
+        return false;
+    }
+    FixtureSpec spec;
+    spec.processes = 200;
+    spec.interfaces = 6;
+    spec.sensors = 3;
+    spec.cgroups = 40;
+    spec.stepSeconds = 2.0;
+
+    double now = 100.0;
+    setMonitorRoot(root);
+    setMonitorClock([&] { return now; });
+
+    CPUUsageTracker cpu;
+    ProcessUsageTracker processes;
+    processes.setUpdateInterval(0.5f);
+    SystemResourceTracker resources;
+    NetworkTracker network;
+    NetworkRate rates;
+    DiskStatsTracker diskStats;
+    vector<DiskIO> disks;
+    PressureTracker pressureTracker;
+    Pressure pressure[PRESSURE_RESOURCES];
+    CgroupTracker cgroupTracker;
+    vector<CgroupUsage> cgroups;
+    ProcessIOTracker processIO;
+    FdTracker fdTracker;
+    fdTracker.setBudget(1 << 30);
+    ThreadTracker threadTracker;
+    vector<ThreadUsage> threads;
+    const vector<int> threadIndices = {10, 60, 3}; // two servers and a single-threaded process
+    vector<int> threadPids;
+    for (int index : threadIndices) threadPids.push_back(fixturePid(index));
+
+    int failures = 0;
+    auto expect = [&](const string& what, double actual, double expected) {
+        if (std::fabs(actual - expected) > 0.01 + std::fabs(expected) * 1e-4) {
+            fprintf(stderr, "verify: %s = %.3f, expected %.3f\n", what.c_str(), actual, expected);
+            failures++;
+        }
+    };
+
+    vector<Proc> list;
+    for (int step = 0; step < 2; ++step) {
+        if (!writeFixtureTree(root, spec, step)) {
+            fprintf(stderr, "verify: writing %s failed\n", root);
+            failures++;
+            break;
+        }
+        if (step > 0) now += spec.stepSeconds;
+        cpu.calculateCPUUsage();
+        list = resources.getProcessList();
+        for (const Proc& proc : list) processes.calculateProcessCPUUsage(proc, monitorClock());
+        processIO.update(list);
+        fdTracker.update(list);
+        map<string, RX> rx;
+        map<string, TX> tx;
+        network.getNetworkStats(rx, tx);
+        rates.update(rx, tx, monitorClock());
+        diskStats.update(disks);
+        pressureTracker.read(pressure);
+        cgroupTracker.update(cgroups);
+        threadTracker.update(threadPids, threads);
+    }
+
+    expect("cpu usage", cpu.getCurrentUsage(), fixtureExpectedCPUUsage());
+    expect("process count", list.size(), spec.processes);
+    for (const Proc& proc : list) {
+        int index = (proc.pid - fixturePid(0)) / (fixturePid(1) - fixturePid(0));
+        expect("cpu% of pid " + to_string(proc.pid),
+               processes.calculateProcessCPUUsage(proc, monitorClock()), fixtureExpectedProcessCPU(index));
+    }
+    for (const Proc& proc : list) {
+        int index = (proc.pid - fixturePid(0)) / (fixturePid(1) - fixturePid(0));
+        ProcessIO expected = fixtureExpectedProcessIO(index);
+        string name = "pid " + to_string(proc.pid);
+        expect("io available for " + name, proc.io.available, 1);
+        expect("read bytes/s of " + name, proc.io.readBytesPerSec, expected.readBytesPerSec);
+        expect("write bytes/s of " + name, proc.io.writeBytesPerSec, expected.writeBytesPerSec);
+        expect("cancelled write bytes/s of " + name, proc.io.cancelledWriteBytesPerSec,
+               expected.cancelledWriteBytesPerSec);
+        expect("read calls/s of " + name, proc.io.readCallsPerSec, expected.readCallsPerSec);
+        expect("write calls/s of " + name, proc.io.writeCallsPerSec, expected.writeCallsPerSec);
+    }
+    auto expectFds = [&](const string& what, const Proc& proc, bool growth) {
+        int index = (proc.pid - fixturePid(0)) / (fixturePid(1) - fixturePid(0));
+        FdUsage expected = fixtureExpectedFds(spec, index, 1);
+        string name = what + " of pid " + to_string(proc.pid);
+        expect("fds" + name, proc.fds.total, expected.total);
+        expect("sockets" + name, proc.fds.sockets, expected.sockets);
+        expect("pipes" + name, proc.fds.pipes, expected.pipes);
+        expect("files" + name, proc.fds.files, expected.files);
+        expect("anon inodes" + name, proc.fds.anonInodes, expected.anonInodes);
+        if (growth) expect("fd growth" + name, proc.fds.growthPerSec, expected.growthPerSec);
+    };
+    for (const Proc& proc : list) expectFds("", proc, true);
+    // ten system calls per update split most listings over several updates
+    {
+        FdTracker budgeted;
+        budgeted.setBudget(10);
+        vector<Proc> copy = list;
+        auto listed = [&] { return count_if(copy.begin(), copy.end(), [](const Proc& proc) { return proc.fds.total >= 0; }); };
+        budgeted.update(copy);
+        if (listed() >= spec.processes / 2) {
+            fprintf(stderr, "verify: %ld processes' fds listed within a budget of 10 system calls\n", listed());
+            failures++;
+        }
+        for (int round = 0; round < 100 * spec.processes && listed() < spec.processes; ++round) budgeted.update(copy);
+        for (const Proc& proc : copy) expectFds(" (listed in parts)", proc, false);
+    }
+    // every socket inode found in the listings maps back to its process, until it exits
+    for (const Proc& proc : list) {
+        int index = (proc.pid - fixturePid(0)) / (fixturePid(1) - fixturePid(0));
+        FdUsage expected = fixtureExpectedFds(spec, index, 1);
+        for (int fd = expected.total - expected.sockets; fd < expected.total; ++fd)
+            expect("owner of socket fd " + to_string(fd) + " of pid " + to_string(proc.pid),
+                   fdTracker.socketOwner(fixtureSocketInode(index, fd)), proc.pid);
+    }
+    {
+        const int exited = 3;
+        vector<Proc> remaining;
+        for (const Proc& proc : list)
+            if (proc.pid != fixturePid(exited)) remaining.push_back(proc);
+        fdTracker.update(remaining);
+        FdUsage expected = fixtureExpectedFds(spec, exited, 1);
+        expect("owner of a socket of an exited process",
+               fdTracker.socketOwner(fixtureSocketInode(exited, expected.total - 1)), -1);
+    }
+    // a socket held by two processes (a shared listener, say) passes to the
+    // other holder once the one found first exits
+    {
+        const int holder = 4, sharer = 7;
+        FdUsage expected = fixtureExpectedFds(spec, holder, 1);
+        unsigned inode = fixtureSocketInode(holder, expected.total - 1);
+        string link = TextF("%s/proc/%d/fd/999", root, fixturePid(sharer)).c_str();
+        if (symlink(TextF("socket:[%u]", inode).c_str(), link.c_str()) != 0) {
+            fprintf(stderr, "verify: %s could not be created\n", link.c_str());
+            failures++;
+        }
+        FdTracker shared;
+        shared.setBudget(1 << 30);
+        vector<Proc> both = list;
+        shared.update(both);
+        expect("owner of a shared socket", shared.socketOwner(inode), fixturePid(holder));
+        vector<Proc> remaining;
+        for (const Proc& proc : list)
+            if (proc.pid != fixturePid(holder)) remaining.push_back(proc);
+        shared.update(remaining);
+        expect("owner of a shared socket after its first holder exits", shared.socketOwner(inode), fixturePid(sharer));
+        unlink(link.c_str());
+    }
+    FileHandles handles;
+    expect("file handles read", readFileHandles(handles), 1);
+    expect("allocated file handles", handles.allocated, fixtureExpectedFileHandles().allocated);
+    expect("file handle limit", handles.maximum, fixtureExpectedFileHandles().maximum);
+
+    // PSS and swap: without a time limit every process is read in one update
+    SmapsTracker smaps;
+    smaps.setBudget(1e9);
+    smaps.update(list, {});
+    for (const Proc& proc : list) {
+        int index = (proc.pid - fixturePid(0)) / (fixturePid(1) - fixturePid(0));
+        expect("pss of pid " + to_string(proc.pid), proc.pss, fixtureExpectedPss(index));
+        expect("swap of pid " + to_string(proc.pid), proc.swap, fixtureExpectedSwap(index));
+    }
+    // with no time at all one file is read per update: a visible row first,
+    // then the process with the most resident memory
+    SmapsTracker starved;
+    starved.setBudget(0);
+    auto readCount = [&] { return count_if(list.begin(), list.end(), [](const Proc& proc) { return proc.pss >= 0; }); };
+    starved.update(list, {fixturePid(7)});
+    expect("processes read with no budget", readCount(), 1);
+    expect("visible process read first",
+           find_if(list.begin(), list.end(), [](const Proc& proc) { return proc.pid == fixturePid(7); })->pss,
+           fixtureExpectedPss(7));
+    starved.update(list, {});
+    long long largestRss = 0, largestRead = 0;
+    for (const Proc& proc : list) {
+        largestRss = max(largestRss, proc.rss);
+        if (proc.pss >= 0 && proc.pid != fixturePid(7)) largestRead = proc.rss;
+    }
+    expect("processes read after two updates", readCount(), 2);
+    expect("largest process read next", largestRead, largestRss);
+
+    for (int j = 0; j < spec.interfaces; ++j) {
+        string name = fixtureInterfaceName(j);
+        expect("rx rate of " + name, rates.rxRate[name], fixtureExpectedRxRate(j));
+        expect("tx rate of " + name, rates.txRate[name], fixtureExpectedTxRate(j));
+    }
+    // subtree totals, summed bottom-up from the scripted parents (a parent's
+    // index is always below its children's)
+    auto pidIndex = [&](int pid) { return (pid - fixturePid(0)) / (fixturePid(1) - fixturePid(0)); };
+    vector<double> treeCPU(spec.processes), treeRss(spec.processes), treeCount(spec.processes, 1);
+    for (const Proc& proc : list) {
+        treeCPU[pidIndex(proc.pid)] = fixtureExpectedProcessCPU(pidIndex(proc.pid));
+        treeRss[pidIndex(proc.pid)] = proc.rss;
+    }
+    for (int i = spec.processes - 1; i > 0; --i) {
+        int parent = fixtureParentIndex(i);
+        treeCPU[parent] += treeCPU[i];
+        treeRss[parent] += treeRss[i];
+        treeCount[parent] += treeCount[i];
+    }
+    ProcessTree tree;
+    auto updateTree = [&] {
+        for (Proc& proc : list) proc.cpuPercent = processes.calculateProcessCPUUsage(proc, monitorClock());
+        tree.update(list);
+    };
+    updateTree();
+    for (const Proc& proc : list) {
+        int index = pidIndex(proc.pid);
+        string name = "pid " + to_string(proc.pid);
+        int parent = proc.parent >= 0 ? pidIndex(list[proc.parent].pid) : -1;
+        expect("parent of " + name, parent, fixtureParentIndex(index));
+        expect("subtree cpu% of " + name, proc.treeCPU, treeCPU[index]);
+        expect("subtree rss of " + name, proc.treeRss, treeRss[index]);
+        expect("subtree size of " + name, proc.treeCount, treeCount[index]);
+    }
+    // process 1 exits: its children become roots, and the root loses its subtree;
+    // once it is back, they are linked below it again
+    string exited = string(root) + "/proc/" + to_string(fixturePid(1));
+    nftw(exited.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    list = resources.getProcessList();
+    updateTree();
+    auto findProcess = [&](int index) {
+        return *find_if(list.begin(), list.end(), [&](const Proc& proc) { return proc.pid == fixturePid(index); });
+    };
+    expect("subtree size after an exit", findProcess(0).treeCount, treeCount[0] - treeCount[1]);
+    expect("subtree cpu% after an exit", findProcess(0).treeCPU, treeCPU[0] - treeCPU[1]);
+    expect("orphan's parent", findProcess(5).parent, -1);
+    expect("orphan's subtree size", findProcess(5).treeCount, treeCount[5]);
+    writeFixtureTree(root, spec, 1);
+    list = resources.getProcessList();
+    updateTree();
+    expect("subtree size after a restart", findProcess(0).treeCount, treeCount[0]);
+    expect("subtree cpu% after a restart", findProcess(0).treeCPU, treeCPU[0]);
+    expect("subtree size of the restarted process", findProcess(1).treeCount, treeCount[1]);
+
+    // threads of the watched processes only, busiest first within each
+    size_t expectedThreads = 0;
+    for (int index : threadIndices) {
+        expectedThreads += fixtureThreadCount(index);
+        for (int k = 0; k < fixtureThreadCount(index); ++k) {
+            ThreadUsage expected = fixtureExpectedThread(spec, index, k);
+            auto thread = find_if(threads.begin(), threads.end(),
+                                  [&](const ThreadUsage& entry) { return entry.tid == expected.tid; });
+            string name = "thread " + to_string(expected.tid);
+            if (thread == threads.end()) {
+                fprintf(stderr, "verify: %s is missing\n", name.c_str());
+                failures++;
+                continue;
+            }
+            if (thread->pid != expected.pid || strcmp(thread->name, expected.name) != 0 ||
+                thread->state != expected.state) {
+                fprintf(stderr, "verify: %s is %d/%s/%c, expected %d/%s/%c\n", name.c_str(), thread->pid,
+                        thread->name, thread->state, expected.pid, expected.name, expected.state);
+                failures++;
+            }
+            expect("cpu% of " + name, thread->cpuPercent, expected.cpuPercent);
+            expect("last cpu of " + name, thread->processor, expected.processor);
+        }
+    }
+    expect("thread count", threads.size(), expectedThreads);
+    for (size_t i = 1; i < threads.size(); ++i) {
+        if (threads[i].pid == threads[i - 1].pid && threads[i].cpuPercent > threads[i - 1].cpuPercent) {
+            fprintf(stderr, "verify: threads of %d are not busiest first\n", threads[i].pid);
+            failures++;
+        }
+    }
+    threadTracker.update({}, threads);
+    expect("threads after clearing the selection", threads.size(), 0);
+
+    expect("interface count", network.getNetworkInterfaces().ip4s.size(), spec.interfaces);
+    for (int i = 0; i < PRESSURE_RESOURCES; ++i) {
+        Pressure expected = fixtureExpectedPressure(static_cast<PressureResource>(i));
+        string name = pressureResourceName(static_cast<PressureResource>(i));
+        expect(name + " pressure available", pressure[i].available, 1);
+        expect(name + " some avg10", pressure[i].some.avg10, expected.some.avg10);
+        expect(name + " some avg300", pressure[i].some.avg300, expected.some.avg300);
+        expect(name + " some recent", pressure[i].some.recent, expected.some.recent);
+        expect(name + " full avg60", pressure[i].full.avg60, expected.full.avg60);
+        expect(name + " full recent", pressure[i].full.recent, expected.full.recent);
+    }
+    expect("disk count", disks.size(), spec.disks);
+    for (size_t k = 0; k < disks.size(); ++k) {
+        const DiskIO& disk = disks[k];
+        DiskIO expected = fixtureExpectedDisk(k);
+        string name = disk.name;
+        if (name != expected.name || strcmp(disk.label, expected.label) != 0 || disk.kind != expected.kind) {
+            fprintf(stderr, "verify: disk %zu is %s (%s, %s), expected %s (%s, %s)\n", k, disk.name, disk.label,
+                    diskKindName(disk.kind), expected.name, expected.label, diskKindName(expected.kind));
+            failures++;
+        }
+        expect("read bytes/s of " + name, disk.readBytesPerSec, expected.readBytesPerSec);
+        expect("write bytes/s of " + name, disk.writeBytesPerSec, expected.writeBytesPerSec);
+        expect("read IOPS of " + name, disk.readIops, expected.readIops);
+        expect("write IOPS of " + name, disk.writeIops, expected.writeIops);
+        expect("read await of " + name, disk.readAwaitMs, expected.readAwaitMs);
+        expect("write await of " + name, disk.writeAwaitMs, expected.writeAwaitMs);
+        expect("utilization of " + name, disk.utilization, expected.utilization);
+        expect("queue depth of " + name, disk.queueDepth, expected.queueDepth);
+        expect("in flight on " + name, disk.inFlight, expected.inFlight);
+    }
+    expect("cgroup count", cgroups.size(), spec.cgroups);
+    for (int i = 0; i < spec.cgroups; ++i) {
+        CgroupUsage expected = fixtureExpectedCgroup(spec, i);
+        auto cgroup = find_if(cgroups.begin(), cgroups.end(),
+                              [&](const CgroupUsage& entry) { return entry.path == expected.path; });
+        string name = "cgroup /" + expected.path;
+        if (cgroup == cgroups.end()) {
+            fprintf(stderr, "verify: %s is missing\n", name.c_str());
+            failures++;
+            continue;
+        }
+        expect("depth of " + name, cgroup->depth, expected.depth);
+        expect("cpu% of " + name, cgroup->cpuPercent, expected.cpuPercent);
+        expect("throttled% of " + name, cgroup->throttledPercent, expected.throttledPercent);
+        expect("memory of " + name, cgroup->memoryBytes, expected.memoryBytes);
+        expect("anon memory of " + name, cgroup->anonBytes, expected.anonBytes);
+        expect("kernel memory of " + name, cgroup->kernelBytes, expected.kernelBytes);
+        expect("oom kills in " + name, cgroup->oomKills, expected.oomKills);
+        expect("read bytes/s of " + name, cgroup->readBytesPerSec, expected.readBytesPerSec);
+        expect("write bytes/s of " + name, cgroup->writeBytesPerSec, expected.writeBytesPerSec);
+        expect("write IOPS of " + name, cgroup->writeIops, expected.writeIops);
+        expect("cpu full pressure of " + name, cgroup->cpuFullPressure, expected.cpuFullPressure);
+    }
+    // every cgroup follows its parent in the tree order
+    for (size_t i = 1; i < cgroups.size(); ++i) {
+        const string& path = cgroups[i].path;
+        size_t parent = i;
+        while (parent > 0 && cgroups[--parent].depth >= cgroups[i].depth) {}
+        const string& parentPath = cgroups[parent].path;
+        if (cgroups[parent].depth != cgroups[i].depth - 1 ||
+            path.compare(0, parentPath.size(), parentPath) != 0) {
+            fprintf(stderr, "verify: cgroup /%s is out of tree order\n", path.c_str());
+            failures++;
+        }
+    }
+    // a cgroup created and one removed since the last update show up through inotify
+    string added = "system.slice/zz-added.scope";
+    string removed = fixtureExpectedCgroup(spec, 6).path;
+    mkdir((string(root) + "/sys/fs/cgroup/" + added).c_str(), 0755);
+    nftw((string(root) + "/sys/fs/cgroup/" + removed).c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    cgroupTracker.update(cgroups);
+    auto listed = [&](const string& path) {
+        return any_of(cgroups.begin(), cgroups.end(), [&](const CgroupUsage& entry) { return entry.path == path; });
+    };
+    if (!listed(added) || listed(removed) || cgroups.size() != static_cast<size_t>(spec.cgroups)) {
+        fprintf(stderr, "verify: cgroup tree not updated after adding /%s and removing /%s\n", added.c_str(),
+                removed.c_str());
+        failures++;
+    }
+    MemoryInfo memory = resources.getMemoryInfo();
+    MemoryInfo expectedMemory = fixtureExpectedMemory(1);
+    // everything from mem_total_kb on is a raw unsigned long field
+    if (memcmp(&memory.mem_total_kb, &expectedMemory.mem_total_kb,
+               sizeof(MemoryInfo) - offsetof(MemoryInfo, mem_total_kb)) != 0) {
+        fprintf(stderr, "verify: /proc/meminfo fields differ from what was written\n");
+        failures++;
+    }
+    expect("used ram", memory.used_ram,
+           (expectedMemory.mem_total_kb - expectedMemory.mem_available_kb) / (1024.0 * 1024.0));
+    float layers[MEMORY_LAYER_COUNT];
+    memoryComposition(memory, layers);
+    double layerTotal = 0;
+    for (float layer : layers) layerTotal += layer;
+    expect("memory composition total (kB)", layerTotal, expectedMemory.mem_total_kb);
+    // statvfs() runs on the mount workers, so give them a moment
+    MountTracker mountTracker;
+    vector<MountUsage> mounts;
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        mountTracker.update(mounts);
+        bool pending = false;
+        for (const MountUsage& mount : mounts) pending = pending || mount.state == MOUNT_PENDING;
+        if (!pending) break;
+        usleep(5000);
+    }
+    vector<string> mountPoints = fixtureMountPoints();
+    expect("mount count", mounts.size(), mountPoints.size());
+    for (size_t i = 0; i < mounts.size() && i < mountPoints.size(); ++i) {
+        if (mounts[i].mountPoint != mountPoints[i] || mounts[i].state != MOUNT_OK || mounts[i].totalBytes == 0) {
+            fprintf(stderr, "verify: mount %zu is %s (%s, %llu bytes), expected %s\n", i, mounts[i].mountPoint.c_str(),
+                    mountStateName(mounts[i].state), mounts[i].totalBytes, mountPoints[i].c_str());
+            failures++;
+        }
+    }
+    expect("temperature", getCPUTemperature(), 40.1);
+    expect("fan speed", getFanSpeed(), 1200);
+
+    // a budget of 50 system calls opens and reads 25 files per update, so eight
+    // updates take a first reading of every process; at the next step the files
+    // are open, and one update gives 50 processes their rates
+    int savedBudget = processIOBudget();
+    setProcessIOBudget(50);
+    ProcessIOTracker budgeted;
+    for (int round = 0; round < spec.processes / 25; ++round) budgeted.update(list);
+    writeFixtureTree(root, spec, 2);
+    now += spec.stepSeconds;
+    budgeted.update(list);
+    int withRates = 0;
+    for (const Proc& proc : list) {
+        if (!proc.io.available) continue;
+        withRates++;
+        int index = (proc.pid - fixturePid(0)) / (fixturePid(1) - fixturePid(0));
+        expect("budgeted write bytes/s of pid " + to_string(proc.pid), proc.io.writeBytesPerSec,
+               fixtureExpectedProcessIO(index).writeBytesPerSec);
+    }
+    expect("processes with I/O rates under a budget", withRates, 50);
+    setProcessIOBudget(savedBudget);
+
+    // A trigger that errors or stops being a valid fd is dropped; kept, it would
+    // make every poll() return at once. The fixture's pressure files are plain
+    // files, which take the trigger as data, so this comes last.
+    {
+        PressureTracker triggers;
+        expect("pressure triggers armed", triggers.armTriggers(pressureTrigger()), PRESSURE_RESOURCES);
+        pollfd fds[PRESSURE_RESOURCES];
+        int count = triggers.addPollFds(fds, PRESSURE_RESOURCES);
+        close(fds[0].fd); // POLLNVAL from here on
+        poll(fds, count, 0);
+        triggers.handlePollFds(fds, count, 0.0f);
+        expect("pressure triggers still polled", triggers.addPollFds(fds, PRESSURE_RESOURCES), PRESSURE_RESOURCES - 1);
+    }
+
+    setMonitorClock(nullptr);
+    setMonitorRoot("");
+    nftw(root, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    printf("# verify: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0;
+}
+
+// Sockets the bench holds open, for the checks and benchmark that read the live
+// kernel through sock_diag: a TCP listener with `connections` accepted
+// connections, 100 unread bytes on the first, a UDP socket, a connected Unix
+// pair and an abstract Unix listener.
+struct LoopbackSockets {
+    int listener = -1, udp = -1, unixListener = -1;
+    int unixPair[2] = {-1, -1};
+    vector<int> clients, servers;
+    unsigned short port = 0;
+    string unixName;
+
+    explicit LoopbackSockets(int connections) {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listener, connections + 8) != 0 ||
+            getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+            return;
+        port = ntohs(address.sin_port);
+        for (int i = 0; i < connections; ++i) {
+            int client = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (client < 0 || connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+                if (client >= 0) close(client);
+                break;
+            }
+            clients.push_back(client);
+            servers.push_back(accept4(listener, nullptr, nullptr, SOCK_CLOEXEC));
+        }
+        if (!clients.empty()) {
+            char data[100] = {};
+            ssize_t written = write(clients[0], data, sizeof(data));
+            (void)written;
+        }
+        address.sin_port = 0;
+        udp = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (bind(udp, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {}
+        socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, unixPair);
+        unixName = "monitor-bench-" + to_string(getpid());
+        sockaddr_un unixAddress{};
+        unixAddress.sun_family = AF_UNIX;
+        memcpy(unixAddress.sun_path + 1, unixName.data(), unixName.size()); // abstract: leading NUL
+        unixListener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (bind(unixListener, reinterpret_cast<sockaddr*>(&unixAddress),
+                 offsetof(sockaddr_un, sun_path) + 1 + unixName.size()) == 0)
+            listen(unixListener, 1);
+        usleep(20000); // let loopback deliver the bytes and finish the handshakes
+    }
+    ~LoopbackSockets() {
+        for (int fd : clients) close(fd);
+        for (int fd : servers) close(fd);
+        for (int fd : {listener, udp, unixListener, unixPair[0], unixPair[1]})
+            if (fd >= 0) close(fd);
+    }
+};
+
+static unsigned socketInode(int fd) {
+    struct stat info;
+    return fd >= 0 && fstat(fd, &info) == 0 ? static_cast<unsigned>(info.st_ino) : 0;
+}
+
+// Dumps the live system's sockets and looks for the ones LoopbackSockets opened,
+// with their states, endpoints, queues and this process as their owner. Skipped
+// where sock_diag isn't available (no netlink in a sandbox, say).
+static bool verifyLiveSockets() {
+    LoopbackSockets loopback(1);
+    SystemResourceTracker resources;
+    vector<Proc> list = resources.getProcessList();
+    FdTracker fdTracker;
+    fdTracker.setBudget(1 << 30);
+    fdTracker.update(list);
+    SocketTracker socketTracker;
+    vector<SocketInfo> sockets;
+    vector<char> names;
+    if (!socketTracker.update(sockets, names, fdTracker, list)) {
+        printf("# verify sockets: skipped, NETLINK_SOCK_DIAG is not available\n");
+        return true;
+    }
+
+    int failures = 0;
+    auto check = [&](const char* what, int fd, auto&& test) {
+        unsigned inode = socketInode(fd);
+        auto found = find_if(sockets.begin(), sockets.end(), [&](const SocketInfo& socket) { return socket.inode == inode; });
+        if (inode == 0 || found == sockets.end()) {
+            fprintf(stderr, "verify: %s socket (inode %u) not in the sock_diag dump\n", what, inode);
+            failures++;
+        } else if (found->pid != getpid() || found->process < 0 || list[found->process].pid != getpid()) {
+            fprintf(stderr, "verify: %s socket is owned by pid %d, expected %d\n", what, found->pid, getpid());
+            failures++;
+        } else if (!test(*found)) {
+            fprintf(stderr, "verify: %s socket is %s %s, local port %u, remote port %u, queues %u/%u\n", what,
+                    socketProtocolName(found->protocol), socketStateName(*found), found->localPort,
+                    found->remotePort, found->receiveQueue, found->sendQueue);
+            failures++;
+        }
+    };
+    unsigned short port = loopback.port;
+    unsigned short clientPort = 0;
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+    if (!loopback.clients.empty() &&
+        getsockname(loopback.clients[0], reinterpret_cast<sockaddr*>(&address), &length) == 0)
+        clientPort = ntohs(address.sin_port);
+    auto is = [](const SocketInfo& socket, const char* state) { return strcmp(socketStateName(socket), state) == 0; };
+    check("TCP listener", loopback.listener, [&](const SocketInfo& socket) {
+        return socket.protocol == SOCKET_TCP && is(socket, "LISTEN") && socket.localPort == port;
+    });
+    check("TCP client", loopback.clients.empty() ? -1 : loopback.clients[0], [&](const SocketInfo& socket) {
+        return socket.protocol == SOCKET_TCP && is(socket, "ESTAB") && socket.remotePort == port &&
+               socket.localAddress[0] == 127 && socket.rttUs > 0;
+    });
+    check("TCP server", loopback.servers.empty() ? -1 : loopback.servers[0], [&](const SocketInfo& socket) {
+        return is(socket, "ESTAB") && socket.localPort == port && socket.remotePort == clientPort &&
+               socket.receiveQueue == 100;
+    });
+    check("UDP", loopback.udp, [&](const SocketInfo& socket) {
+        return socket.protocol == SOCKET_UDP && is(socket, "UNCONN") && socket.localPort != 0;
+    });
+    unsigned peer = socketInode(loopback.unixPair[1]);
+    check("Unix pair", loopback.unixPair[0], [&](const SocketInfo& socket) {
+        return socket.protocol == SOCKET_UNIX && socket.unixType == SOCK_STREAM && socket.peerInode == peer;
+    });
+    string unixName = "@" + loopback.unixName;
+    check("Unix listener", loopback.unixListener, [&](const SocketInfo& socket) {
+        return is(socket, "LISTEN") && socket.nameOffset >= 0 && unixName == names.data() + socket.nameOffset;
+    });
+
+    // iperf in miniature: 4 MiB from a client to a server, both in this
+    // process, over two scripted seconds is 2 MiB/s received and 2 MiB/s sent
+    {
+        LoopbackSockets transfer(1);
+        const size_t total = 4 << 20;
+        double now = 100.0;
+        setMonitorClock([&] { return now; });
+        fdTracker.update(list); // learns the new sockets' owner
+        socketTracker.update(sockets, names, fdTracker, list);
+        if (!transfer.clients.empty() && transfer.servers[0] >= 0) {
+            int client = transfer.clients[0], server = transfer.servers[0];
+            std::thread reader([&] {
+                vector<char> data(64 * 1024);
+                for (size_t got = 0; got < total;) {
+                    ssize_t length = read(server, data.data(), min(data.size(), total - got));
+                    if (length <= 0) break;
+                    got += length;
+                }
+            });
+            vector<char> data(total);
+            for (size_t sent = 0; sent < total;) {
+                ssize_t length = write(client, data.data() + sent, total - sent);
+                if (length <= 0) break;
+                sent += length;
+            }
+            reader.join();
+            // bytes_acked lags until the last ACK is back
+            tcp_info info{};
+            socklen_t length = sizeof(info);
+            unsigned long long acked = 0;
+            for (int wait = 0; wait < 100; ++wait, usleep(10000)) {
+                if (getsockopt(client, IPPROTO_TCP, TCP_INFO, &info, &length) == 0) acked = info.tcpi_bytes_acked;
+                if (acked >= total + 100) break; // and the 100 bytes written before
+            }
+        }
+        now += 2.0;
+        socketTracker.update(sockets, names, fdTracker, list);
+        const double expected = total / 2.0;
+        auto self = find_if(list.begin(), list.end(), [](const Proc& proc) { return proc.pid == getpid(); });
+        auto near = [&](double rate) { return std::fabs(rate - expected) < 1.0; };
+        if (self == list.end() || !near(self->netReceiveRate) || !near(self->netSendRate)) {
+            fprintf(stderr, "verify: loopback transfer gave %.0f B/s received and %.0f B/s sent, expected %.0f\n",
+                    self != list.end() ? self->netReceiveRate : 0.0, self != list.end() ? self->netSendRate : 0.0,
+                    expected);
+            failures++;
+        }
+        check("transfer server", transfer.servers.empty() ? -1 : transfer.servers[0],
+              [&](const SocketInfo& socket) { return near(socket.receiveRate) && socket.sendRate == 0; });
+        check("transfer client", transfer.clients.empty() ? -1 : transfer.clients[0],
+              [&](const SocketInfo& socket) { return near(socket.sendRate) && socket.receiveRate == 0; });
+        setMonitorClock(nullptr);
+    }
+    printf("# verify sockets: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0;
+}
+
+// The process list from the scan pool must be the one a single thread reads,
+// in the same order, whatever the number of workers and however often it changes.
+static bool verifyProcessScan() {
+    char root[] = "/tmp/monitor-verify-XXXXXX";
+    if (!mkdtemp(root)) {
+        perror("monitor-bench: mkdtemp");
+        return false;
+    }
+    FixtureSpec spec;
+    spec.processes = 3 * static_cast<int>(ProcessScanPool::PARALLEL_MIN) + 77; // a short last chunk
+    spec.processDetails = false;
+    int failures = 0;
+    if (!writeFixtureTree(root, spec, 0)) {
+        fprintf(stderr, "verify: writing %s failed\n", root);
+        failures++;
+    } else {
+        setMonitorRoot(root);
+        bool ring = ioUringAllowed();
+        setIoUringAllowed(false);
+        SystemResourceTracker single, parallel;
+        single.setScanWorkers(1);
+        vector<Proc> expected, actual;
+        single.getProcessList(expected);
+        if (static_cast<int>(expected.size()) != spec.processes) {
+            fprintf(stderr, "verify: scan found %zu processes, expected %d\n", expected.size(), spec.processes);
+            failures++;
+        }
+        auto compare = [&](const char* what) {
+            bool same = actual.size() == expected.size();
+            for (size_t i = 0; same && i < actual.size(); ++i)
+                same = actual[i].pid == expected[i].pid && actual[i].name == expected[i].name &&
+                       actual[i].utime == expected[i].utime && actual[i].ppid == expected[i].ppid;
+            if (!same && failures++ < 3) fprintf(stderr, "verify: %s differs from a single thread's\n", what);
+        };
+        for (int workers : {2, 8, 3, 8}) {
+            parallel.setScanWorkers(workers);
+            parallel.getProcessList(actual);
+            compare(TextF("%d-worker scan", workers).c_str());
+        }
+        // through io_uring: every file held, then some read by path in between
+        setIoUringAllowed(ring);
+        for (int held : {spec.processes, 1000}) {
+            SystemResourceTracker batched;
+            batched.setStatFileBudget(held);
+            for (int pass = 0; pass < 2; ++pass) {
+                batched.getProcessList(actual);
+                compare(TextF("scan with %d held files, pass %d", held, pass + 1).c_str());
+            }
+            if (batched.heldStatFiles() != held && failures++ < 3)
+                fprintf(stderr, "verify: %d stat files held, expected %d\n", batched.heldStatFiles(), held);
+        }
+        // the pool's workers batch their own chunks: still parallel with the ring
+        SystemResourceTracker pooled;
+        pooled.setScanWorkers(4);
+        pooled.setStatFileBudget(1000);
+        int mostThreads = 0;
+        for (int pass = 0; pass < 4; ++pass) {
+            pooled.getProcessList(actual);
+            compare(TextF("4-worker scan with 1000 held files, pass %d", pass + 1).c_str());
+            mostThreads = max(mostThreads, pooled.lastScanThreads());
+        }
+        ReadBatch probe(2, 1);
+        if (probe.usesRing() && pooled.batchedReadSyscalls() == 0 && failures++ < 3)
+            fprintf(stderr, "verify: the scan pool made no io_uring reads\n");
+        if (mostThreads < 2 && sysconf(_SC_NPROCESSORS_ONLN) > 1 && failures++ < 3)
+            fprintf(stderr, "verify: a 4-worker scan with io_uring ran on %d thread(s)\n", mostThreads);
+        printf("# verify process scan: 4 workers with io_uring %s, up to %d threads took chunks\n",
+               probe.usesRing() ? "on" : "unavailable", mostThreads);
+        setMonitorRoot("");
+    }
+    nftw(root, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    printf("# verify process scan: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0;
+}
+
+// Runs the collector schedule on its own through two minutes of default
+// cadences, then a cadence change and a long sleep.
+static bool verifySchedule() {
+    int failures = 0;
+    auto expect = [&](const char* what, double actual, double expected) {
+        if (std::fabs(actual - expected) > 1e-6) {
+            fprintf(stderr, "verify: schedule %s = %.3f, expected %.3f\n", what, actual, expected);
+            failures++;
+        }
+    };
+    auto fired = [](unsigned due, Collector collector) { return (due & (1u << collector)) != 0; };
+
+    CollectorSchedule schedule;
+    int runs[COLLECTORS] = {};
+    int sharedTicks = 0, strayTicks = 0;
+    const int steps = static_cast<int>(120.0 / CollectorSchedule::JIFFY);
+    for (int step = 1; step <= steps; ++step) {
+        unsigned due = schedule.advance(step * CollectorSchedule::JIFFY);
+        for (int c = 0; c < COLLECTORS; ++c) runs[c] += fired(due, static_cast<Collector>(c));
+        // the fds are listed for the processes just listed, and sockets matched to those fds
+        if ((fired(due, COLLECTOR_SOCKETS) && !fired(due, COLLECTOR_PROCESS_DETAILS)) ||
+            (fired(due, COLLECTOR_PROCESS_DETAILS) && !fired(due, COLLECTOR_PROCESSES)))
+            strayTicks++;
+        // processes and cgroups both take 1 s and milliseconds, so they take turns
+        if (fired(due, COLLECTOR_PROCESSES) && fired(due, COLLECTOR_CGROUPS)) sharedTicks++;
+        // a 1 s deadline always falls on a 250 ms one
+        if (fired(due, COLLECTOR_PROCESSES) && !fired(due, COLLECTOR_CPU)) strayTicks++;
+    }
+    expect("cpu runs", runs[COLLECTOR_CPU], 480);
+    expect("processes runs", runs[COLLECTOR_PROCESSES], 120);
+    expect("sockets runs", runs[COLLECTOR_SOCKETS], 120);
+    expect("cgroups runs", runs[COLLECTOR_CGROUPS], 120);
+    expect("mounts runs", runs[COLLECTOR_MOUNTS], 12);
+    expect("inventory runs", runs[COLLECTOR_INVENTORY], 2);
+    expect("processes ticks shared with cgroups", sharedTicks, 0);
+    expect("unaligned ticks", strayTicks, 0);
+    expect("next deadline", schedule.nextDeadline(), 120.25);
+
+    // 2.6 s for sockets becomes a multiple of the 1 s process cadence
+    schedule.setCadence(COLLECTOR_CPU, 1.0f);
+    schedule.setCadence(COLLECTOR_SOCKETS, 2.6f);
+    expect("sockets effective cadence", schedule.effectiveCadence(COLLECTOR_SOCKETS), 3.0);
+    fill(begin(runs), end(runs), 0);
+    for (int step = steps + 1; step <= 2 * steps; ++step) {
+        unsigned due = schedule.advance(step * CollectorSchedule::JIFFY);
+        for (int c = 0; c < COLLECTORS; ++c) runs[c] += fired(due, static_cast<Collector>(c));
+    }
+    expect("cpu runs at 1 s", runs[COLLECTOR_CPU], 120);
+    expect("sockets runs at 3 s", runs[COLLECTOR_SOCKETS], 40);
+
+    // an hour asleep runs everything once
+    unsigned due = schedule.advance(240.0 + 3600.0);
+    expect("collectors due after a long sleep", __builtin_popcount(due), COLLECTORS);
+    expect("nothing due right after", schedule.advance(240.0 + 3600.0 + CollectorSchedule::JIFFY / 2), 0);
+    printf("# verify schedule: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0;
+}
+
+static int openFdCount() {
+    DIR* dir = opendir("/proc/self/fd");
+    if (!dir) return -1;
+    int count = 0;
+    while (readdir(dir)) count++;
+    closedir(dir);
+    return count;
+}
+
+// Runs a probe on short-lived threads, which must leave their counters behind
+// but not the io file each one opened.
+static bool verifyProbeThreads() {
+    int failures = 0;
+    int before = openFdCount();
+    for (int i = 0; i < 4; ++i) {
+        std::thread worker([] {
+            setProbeThreadName("verify probe");
+            ScopedProbe probe(PROBE_SAMPLER_TICK);
+        });
+        worker.join();
+    }
+    int after = openFdCount();
+    if (after != before) {
+        fprintf(stderr, "verify: %d fds open after the probe threads exited, expected %d\n", after, before);
+        failures++;
+    }
+    unsigned long long calls = 0;
+    forEachProbeTotal([&](const char* name, ProbeId, const ProbeTotals& totals) {
+        if (strcmp(name, "verify probe") == 0) calls += totals.calls;
+    });
+    if (calls != 4) {
+        fprintf(stderr, "verify: exited threads' probes counted %llu calls, expected 4\n", calls);
+        failures++;
+    }
+    printf("# verify probe threads: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0;
+}
+
+// Allocation budgets for one steady-state sampler tick and one UI frame. A tick
+// that refreshes the interface list (COLLECTOR_INTERFACES) also opens
+// <root>/sys/class/net, and opendir() allocates its buffer. The once-a-minute
+// inventory refresh builds new strings and looks the user up through NSS.
+static constexpr unsigned long long TICK_ALLOCATION_BUDGET = 0;
+static constexpr unsigned long long INTERFACE_TICK_ALLOCATION_BUDGET = 1;
+static constexpr unsigned long long INVENTORY_TICK_ALLOCATION_BUDGET = 4;
+static constexpr unsigned long long FRAME_ALLOCATION_BUDGET = 0;
+
+// The calls from before the sampler, which nothing on a tick uses any more,
+// return new containers and have budgets per call of their own. getNetworkRX()
+// and getNetworkTX() build both maps, one node per interface in each (the
+// fixture's names fit in std::string without allocating). countProcessStates()
+// reuses the map's nodes but opens /proc with a DIR of its own, under a root
+// path that is built for the call.
+static constexpr unsigned long long NETWORK_MAP_ALLOCATIONS_PER_INTERFACE = 2;
+static constexpr unsigned long long COUNT_STATES_ALLOCATION_BUDGET = 3;
+
+// An ImGui context with a built font atlas, enough to run frames without a window
+static void createHeadlessContext() {
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.DisplaySize = ImVec2(1280, 720);
+    io.DeltaTime = 1.0f / 60.0f;
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+}
+
+// one frame of the SDL frontend, minus the platform and renderer backends
+static void drawFrame(const SystemSnapshot& snap) {
+    ImGui::NewFrame();
+    ImVec2 display = ImGui::GetIO().DisplaySize;
+    memoryProcessesWindow("== Memory and Processes ==", ImVec2((display.x / 2) - 20, (display.y / 2) + 30), ImVec2((display.x / 2) + 10, 10), snap);
+    systemWindow("== System ==", ImVec2((display.x / 2) - 10, (display.y / 2) + 30), ImVec2(10, 10), snap);
+    networkWindow("== Network ==", ImVec2(display.x - 20, (display.y / 2) - 60), ImVec2(10, (display.y / 2) + 50), snap);
+    ImGui::Render();
+}
+
+// Runs sampler ticks and UI frames against a generated tree and checks that,
+// after warming up, each stays within its allocation budget.
+static bool verifySteadyStateAllocations() {
+    char root[] = "/tmp/monitor-verify-XXXXXX";
+    if (!mkdtemp(root)) {
+        perror("monitor-bench: mkdtemp");
+        return false;
+    }
+    FixtureSpec spec;
+    spec.processes = 300;
+    spec.interfaces = 8;
+    spec.sensors = 3;
+    spec.disks = 300;
+    spec.cgroups = 2000;
+    if (!writeFixtureTree(root, spec, 0)) {
+        fprintf(stderr, "verify: writing %s failed\n", root);
+        return false;
+    }
+
+    double now = 100.0;
+    setMonitorRoot(root);
+    setMonitorClock([&] { return now; });
+    int failures = 0;
+    {
+        // half-second ticks alternate between refreshing the process list and
+        // carrying it over, and with the slower details and sockets, every way
+        // of carrying over a part of the process list is covered
+        Sampler sampler;
+        sampler.setThreadPids({fixturePid(10), fixturePid(60)}); // as if selected in the UI
+        sampler.setCadence(COLLECTOR_PROCESS_DETAILS, 2.0f);
+        sampler.setCadence(COLLECTOR_SOCKETS, 4.0f);
+        const double step = 0.5;
+        // long enough for the fd listings to get round every process at 2 s
+        const int warmup = 4 * static_cast<int>(sampler.cadence(COLLECTOR_INTERFACES) / step);
+        for (int tick = 0; tick < 4 * warmup; ++tick) {
+            now += step;
+            unsigned long long before = threadAllocationCount();
+            sampler.tick();
+            unsigned long long allocations = threadAllocationCount() - before;
+            shared_ptr<const SystemSnapshot> latest = sampler.latest();
+            auto ran = [&](Collector collector) { return latest->collectors[collector].lastRun == latest->time; };
+            unsigned long long budget = TICK_ALLOCATION_BUDGET;
+            if (ran(COLLECTOR_INTERFACES)) budget += INTERFACE_TICK_ALLOCATION_BUDGET;
+            if (ran(COLLECTOR_INVENTORY)) budget += INVENTORY_TICK_ALLOCATION_BUDGET;
+            if (tick >= warmup && allocations > budget && failures++ < 3) {
+                fprintf(stderr, "verify: sampler tick %d made %llu allocations, budget %llu\n",
+                        tick, allocations, budget);
+            }
+        }
+
+        createHeadlessContext();
+        shared_ptr<const SystemSnapshot> snap = sampler.latest();
+        for (int frame = 0; frame < 40; ++frame) {
+            unsigned long long before = threadAllocationCount();
+            drawFrame(*snap);
+            unsigned long long allocations = threadAllocationCount() - before;
+            if (frame >= 20 && allocations > FRAME_ALLOCATION_BUDGET && failures++ < 6) {
+                fprintf(stderr, "verify: UI frame %d made %llu allocations, budget %llu\n",
+                        frame, allocations, FRAME_ALLOCATION_BUDGET);
+            }
+        }
+        ImGui::DestroyContext();
+    }
+    {
+        auto check = [&](const char* call, unsigned long long budget, const std::function<void()>& fn) {
+            fn(); // the first call fills the map
+            unsigned long long before = threadAllocationCount();
+            fn();
+            unsigned long long allocations = threadAllocationCount() - before;
+            if (allocations > budget && failures++ < 3)
+                fprintf(stderr, "verify: %s made %llu allocations, budget %llu\n", call, allocations, budget);
+        };
+        NetworkTracker network;
+        unsigned long long networkBudget = NETWORK_MAP_ALLOCATIONS_PER_INTERFACE * spec.interfaces;
+        check("getNetworkRX", networkBudget, [&] {
+            auto rx = network.getNetworkRX();
+            keep(rx);
+        });
+        check("getNetworkTX", networkBudget, [&] {
+            auto tx = network.getNetworkTX();
+            keep(tx);
+        });
+        map<char, int> states;
+        check("countProcessStates", COUNT_STATES_ALLOCATION_BUDGET, [&] {
+            countProcessStates(states);
+            keep(states);
+        });
+    }
+
+    setMonitorClock(nullptr);
+    setMonitorRoot("");
+    nftw(root, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    printf("# verify allocations: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0;
+}
+
+// One publisher per segment: a second one is refused and leaves the first's
+// alone, and readers get nothing until the first snapshot is in.
+static bool verifySharedMemory() {
+    string name = "/monitor-bench-" + to_string(getpid());
+    int failures = 0;
+    auto fail = [&](const char* what) {
+        fprintf(stderr, "verify: shared memory: %s\n", what);
+        failures++;
+    };
+    SnapshotPublisher first, second;
+    if (!first.open(name.c_str())) {
+        fail("the segment could not be created");
+    } else {
+        if (second.open(name.c_str()) || errno != EBUSY) fail("a second publisher was let in");
+        const monitor_shm_segment* segment = monitor_shm_map(name.c_str());
+        monitor_shm_snapshot read;
+        if (!segment) fail("the segment could not be mapped");
+        else if (monitor_shm_read(segment, &read) == 0) fail("a read succeeded before anything was published");
+        monitor_shm_snapshot published{};
+        published.cpu_percent = 42.0f;
+        first.publish(published);
+        first.publish(published);
+        if (segment && (monitor_shm_read(segment, &read) != 0 || read.cpu_percent != 42.0f || read.sequence != 2))
+            fail("the published snapshot didn't read back");
+        if (segment && segment->seq != 4) fail("the sequence isn't even after two publishes");
+        monitor_shm_unmap(segment);
+    }
+    first.close();
+    printf("# verify shared memory: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0;
+}
+
+// Loads the sample textfile plugin (make plugins) from a scratch directory and
+// follows its file through a few seconds of ticks, on top of a generated tree
+// so the built-in sections have something to compare against.
+static bool verifyPlugins() {
+    char resolved[PATH_MAX];
+    if (!realpath("plugins/textfile.so", resolved)) {
+        fprintf(stderr, "verify: plugins/textfile.so is missing; run make plugins\n");
+        printf("# verify plugins: FAILED\n");
+        return false;
+    }
+    char root[] = "/tmp/monitor-verify-XXXXXX";
+    if (!mkdtemp(root)) {
+        perror("monitor-bench: mkdtemp");
+        return false;
+    }
+    FixtureSpec spec;
+    spec.processes = 100;
+    spec.interfaces = 4;
+    spec.sensors = 2;
+    spec.cgroups = 8;
+    string directory = string(root) + "/plugins";
+    auto writeText = [&](const char* text) {
+        std::ofstream(directory + "/textfile.txt") << text;
+    };
+    if (!writeFixtureTree(root, spec, 0) || mkdir(directory.c_str(), 0755) != 0 ||
+        symlink(resolved, (directory + "/textfile.so").c_str()) != 0) {
+        fprintf(stderr, "verify: setting up %s failed\n", root);
+        return false;
+    }
+    writeText("# name value unit\nqueue_depth 12\nbackup_age 3600 s\n");
+
+    int failures = 0;
+    auto expect = [&](const char* what, double actual, double expected) {
+        if (!(std::fabs(actual - expected) <= 1e-6 * max(1.0, std::fabs(expected))) &&
+            !(std::isnan(actual) && std::isnan(expected))) {
+            fprintf(stderr, "verify: plugins %s = %g, expected %g\n", what, actual, expected);
+            failures++;
+        }
+    };
+    double now = 100.0;
+    setMonitorRoot(root);
+    setMonitorClock([&] { return now; });
+    setPluginDirectory(directory);
+    {
+        Sampler sampler;
+        auto metric = [&](const char* name) {
+            shared_ptr<const SystemSnapshot> snap = sampler.latest();
+            int index = snap->metrics ? snap->metrics->find(name) : -1;
+            return index >= 0 ? snap->metricValues[index] : -1.0;
+        };
+        sampler.tick();
+        shared_ptr<const SystemSnapshot> snap = sampler.latest();
+        expect("loaded sections", snap->metrics ? snap->metrics->sections.size() : 0, 8);
+        expect("textfile.queue_depth", metric("textfile.queue_depth"), 12);
+        expect("textfile.backup_age", metric("textfile.backup_age"), 3600);
+        int age = snap->metrics->find("textfile.backup_age");
+        if (age < 0 || snap->metrics->units[age] != "s") {
+            fprintf(stderr, "verify: plugins textfile.backup_age has no unit s\n");
+            failures++;
+        }
+
+        // the plugin runs once a second, so a change shows up on the next full second
+        writeText("queue_depth 30\n");
+        now += 0.5;
+        sampler.tick();
+        expect("textfile.queue_depth before its next run", metric("textfile.queue_depth"), 12);
+        unsigned long long allocations = 0;
+        for (int tick = 0; tick < 48; ++tick) {
+            now += 0.25;
+            unsigned long long before = threadAllocationCount();
+            sampler.tick();
+            shared_ptr<const SystemSnapshot> latest = sampler.latest();
+            // past the snapshot pool's warmup; a tick listing interfaces allocates in opendir()
+            if (tick >= 16 && latest->collectors[COLLECTOR_INTERFACES].lastRun != latest->time)
+                allocations += threadAllocationCount() - before;
+        }
+        expect("textfile.queue_depth after its next run", metric("textfile.queue_depth"), 30);
+        expect("textfile.backup_age once gone from the file", metric("textfile.backup_age"), NAN);
+        expect("allocations over 32 ticks", allocations, 0);
+
+        snap = sampler.latest();
+        double rx = 0.0;
+        for (const auto& rate : snap->rxRate) rx += rate.second;
+        expect("cpu.total", metric("cpu.total"), snap->cpuUsage);
+        expect("memory.used_percent", metric("memory.used_percent"), snap->memory.ram_percent);
+        expect("disk.total", metric("disk.total"), static_cast<double>(snap->disk.total_bytes));
+        expect("processes.total", metric("processes.total"), snap->totalProcesses);
+        expect("net.rx_rate", metric("net.rx_rate"), rx);
+        expect("psi.memory.some.avg10", metric("psi.memory.some.avg10"), snap->pressure[PRESSURE_MEMORY].some.avg10);
+    }
+    setPluginDirectory("");
+    setMonitorClock(nullptr);
+    setMonitorRoot("");
+    nftw(root, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    printf("# verify plugins: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0;
+}
+
+// Two built-in style sections for the alert checks, without a sampler
+static shared_ptr<const MetricSchema> alertSchema() {
+    auto schema = make_shared<MetricSchema>();
+    schema->sections = {{"cpu", COLLECTOR_CPU, 0.0f, 0, 1}, {"psi", COLLECTOR_PRESSURE, 0.0f, 1, 1}};
+    schema->names = {"cpu.total", "psi.memory.some.avg10"};
+    schema->units = {"%", "%"};
+    return schema;
+}
+
+// Parses the rules from the request that asked for them and feeds the engine
+// a scripted minute of snapshots, one a second, checking when each rule fires
+// and clears and that the log gets one line per transition.
+static bool verifyAlerts() {
+    int failures = 0;
+    auto expect = [&](const char* what, double actual, double expected) {
+        if (std::fabs(actual - expected) > 1e-6 * max(1.0, std::fabs(expected))) {
+            fprintf(stderr, "verify: alerts %s = %g, expected %g\n", what, actual, expected);
+            failures++;
+        }
+    };
+
+    vector<AlertRule> rules;
+    string error;
+    const char* text = "critical busy: cpu.total > 90 for 30s\n"
+                       "# comment\n"
+                       "net.eth0.rx_rate>800MB/s\n"
+                       "proc[name=java].rss rate > 10MB/min\n"
+                       "psi.memory.some.avg10 > 20 clear 10\n"
+                       "info averaged: cpu.total avg 10s >= 50\n";
+    if (!parseAlertRules(text, rules, error)) {
+        fprintf(stderr, "verify: alerts rules don't parse: %s\n", error.c_str());
+        printf("# verify alerts: FAILED\n");
+        return false;
+    }
+    expect("rules", rules.size(), 5);
+    expect("busy level", rules[0].level, ALERT_CRITICAL);
+    expect("busy hold", rules[0].hold, 30);
+    expect("busy clear", rules[0].clear, 85.5);
+    expect("eth0 source", rules[1].source, ALERT_INTERFACE);
+    expect("eth0 threshold", rules[1].threshold, 800e6);
+    expect("java threshold", rules[2].threshold, 10e6 / 60);
+    expect("java field", rules[2].field, PROCESS_RSS);
+    expect("averaged time constant", rules[4].average, 10);
+    for (const char* bad : {"cpu.total >> 5", "cpu.total > 5 clear 9", "proc[name=java].bogus > 1", "cpu.total > 5XB",
+                            "cpu.total > 5 for ever"}) {
+        vector<AlertRule> none;
+        if (parseAlertRules(string("\n") + bad, none, error) || error.compare(0, 7, "line 2:") != 0) {
+            fprintf(stderr, "verify: alerts rule \"%s\" parsed, or the error \"%s\" has no line\n", bad, error.c_str());
+            failures++;
+        }
+    }
+
+    char log[] = "/tmp/monitor-alerts-XXXXXX";
+    int logFd = mkstemp(log);
+    if (logFd >= 0) close(logFd);
+    int transitions = 0;
+    {
+        AlertEngine engine;
+        engine.configure(rules, log, "");
+        const long pageSize = sysconf(_SC_PAGESIZE);
+        SystemSnapshot snap;
+        snap.metrics = alertSchema();
+        snap.metricValues = {0.0, 25.0};
+        snap.sectionUpdated = {0.0f, 0.0f};
+        snap.processes.resize(3);
+        snap.processes[0].name = "java";
+        snap.processes[1].name = "bash";
+        snap.processes[2].name = "java";
+        snap.rxRate["eth0"] = 900e6;
+        snap.rxRate["eth1"] = 5e9;
+        unsigned long long allocations = 0;
+        auto firing = [&](int rule) {
+            for (const ActiveAlert& alert : snap.alerts)
+                if (alert.rule == rule) return 1.0;
+            return 0.0;
+        };
+        for (int t = 0; t <= 60; ++t) {
+            snap.time = static_cast<float>(t);
+            // 95% for 32 s, then 88% (inside the hysteresis) and then 80%
+            snap.metricValues[0] = t < 32 ? 95.0 : t < 34 ? 88.0 : 80.0;
+            snap.metricValues[1] = t < 40 ? 25.0 : t < 45 ? 15.0 : 5.0;
+            // the java processes grow by 1 MB/s together until t = 20
+            for (int i : {0, 2}) snap.processes[i].rss = (min(t, 20) * 500000 + 100000000) / pageSize;
+            unsigned long long before = threadAllocationCount();
+            engine.update(snap, (1u << COLLECTORS) - 1);
+            if (t > 2) allocations += threadAllocationCount() - before;
+
+            if (t == 29) expect("busy firing after 29 s", firing(0), 0);
+            if (t == 30) expect("busy firing after 30 s", firing(0), 1);
+            if (t == 33) expect("busy firing at 88%", firing(0), 1);
+            if (t == 34) expect("busy firing at 80%", firing(0), 0);
+            if (t == 0) expect("eth0 firing", firing(1), 1);
+            if (t == 0) expect("java firing before a rate", firing(2), 0);
+            if (t == 1) expect("java firing", firing(2), 1);
+            if (t == 21) expect("java firing once steady", firing(2), 0);
+            if (t == 42) expect("psi firing at 15", firing(3), 1);
+            if (t == 45) expect("psi firing at 5", firing(3), 0);
+            // the 10 s average is still far above 50% a second after the raw value fell to 80%
+            if (t == 34) expect("averaged firing after 80%", firing(4), 1);
+        }
+        expect("allocations", allocations, 0);
+        transitions = static_cast<int>(snap.alertEvents.size());
+        expect("transitions", transitions, 8);
+    }
+    std::ifstream lines(log);
+    int logged = 0;
+    for (string line; getline(lines, line);) logged += line.compare(0, 8, "{\"time\":") == 0;
+    expect("log lines", logged, transitions);
+    unlink(log);
+    printf("# verify alerts: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: monitor-bench [--root DIR] [--time SECONDS] [--filter NAME] [--verify]\n");
+}
+
+// getProcessList on a generated tree of 100,000 processes with 1 to 8 scan
+// threads reading with pread(), then 4 reading through io_uring. The tree is
+// written to disk rather than generated by the kernel on every read like /proc,
+// so the parsing is a larger share of the time here.
+static void benchmarkScanScaling(const BenchOptions& options) {
+    const int workerCounts[] = {1, 2, 4, 8, 4};
+    const int runs = 5;
+    FormattedText names[runs];
+    bool wanted = false;
+    for (int i = 0; i < runs; ++i) {
+        names[i] = TextF("getProcessList (100k processes, %d worker%s%s)", workerCounts[i], workerCounts[i] > 1 ? "s" : "",
+                         i == runs - 1 ? ", io_uring" : "");
+        wanted = wanted || !options.filter || strstr(names[i].c_str(), options.filter);
+    }
+    if (!wanted) return; // writing the tree takes seconds
+    char root[] = "/tmp/monitor-scan-XXXXXX";
+    if (!mkdtemp(root)) {
+        perror("monitor-bench: mkdtemp");
+        return;
+    }
+    FixtureSpec spec;
+    spec.processes = 100000;
+    spec.processDetails = false;
+    if (writeFixtureTree(root, spec, 0)) {
+        setMonitorRoot(root);
+        bool ring = ioUringAllowed();
+        for (int i = 0; i < runs; ++i) {
+            setIoUringAllowed(i == runs - 1 && ring);
+            SystemResourceTracker resources;
+            resources.setScanWorkers(workerCounts[i]);
+            vector<Proc> processes;
+            runBenchmark(options, names[i].c_str(), [&] {
+                resources.getProcessList(processes);
+                keep(processes);
+            });
+        }
+        setIoUringAllowed(ring);
+        setMonitorRoot(options.root);
+    } else {
+        fprintf(stderr, "monitor-bench: writing %s failed\n", root);
+    }
+    nftw(root, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+// read-family system calls made by this thread so far, from its I/O accounting
+static unsigned long long threadReadSyscalls() {
+    char text[256];
+    if (readFileInto("/proc/thread-self/io", text, sizeof(text)) <= 0) return 0;
+    const char* at = strstr(text, "syscr:");
+    return at ? strtoull(at + 6, nullptr, 10) : 0;
+}
+
+// getProcessList on generated trees of 10,000 and 50,000 processes, with the
+// stat files held open and read with pread() or through io_uring, on one
+// thread. Besides the timings it prints the system calls a scan spends
+// reading: syscr, which counts read() and pread(), plus io_uring_enter().
+// Reading the directory and opening files past the fd limit aren't included.
+static void benchmarkBatchedReads(const BenchOptions& options) {
+    const int processCounts[] = {10000, 50000};
+    const char* const backends[] = {"pread", "io_uring"};
+    FormattedText names[2][2];
+    bool wanted[2] = {false, false};
+    for (int n = 0; n < 2; ++n) {
+        for (int b = 0; b < 2; ++b) {
+            names[n][b] = TextF("getProcessList (%dk processes, %s)", processCounts[n] / 1000, backends[b]);
+            wanted[n] = wanted[n] || !options.filter || strstr(names[n][b].c_str(), options.filter);
+        }
+    }
+    rlimit files;
+    int fdLimit = getrlimit(RLIMIT_NOFILE, &files) == 0 ? static_cast<int>(min<rlim_t>(files.rlim_cur, INT_MAX)) : 1024;
+    bool ring = ioUringAllowed();
+    for (int n = 0; n < 2; ++n) {
+        if (!wanted[n]) continue; // writing the tree takes seconds
+        char root[] = "/tmp/monitor-reads-XXXXXX";
+        if (!mkdtemp(root)) {
+            perror("monitor-bench: mkdtemp");
+            return;
+        }
+        FixtureSpec spec;
+        spec.processes = processCounts[n];
+        spec.processDetails = false;
+        if (!writeFixtureTree(root, spec, 0)) {
+            fprintf(stderr, "monitor-bench: writing %s failed\n", root);
+            nftw(root, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+            continue;
+        }
+        setMonitorRoot(root);
+        for (int b = 0; b < 2; ++b) {
+            setIoUringAllowed(b == 1 && ring);
+            SystemResourceTracker resources;
+            resources.setScanWorkers(1);
+            resources.setStatFileBudget(max(0, fdLimit - 1024)); // what the bench itself needs
+            vector<Proc> processes;
+            runBenchmark(options, names[n][b].c_str(), [&] {
+                resources.getProcessList(processes);
+                keep(processes);
+            });
+            if (options.filter && !strstr(names[n][b].c_str(), options.filter)) continue;
+            const int scans = 4;
+            unsigned long long reads = threadReadSyscalls(), enters = threadRingEnters();
+            for (int i = 0; i < scans; ++i) resources.getProcessList(processes);
+            reads = threadReadSyscalls() - reads;
+            enters = threadRingEnters() - enters;
+            printf("# %s: %zu processes, %d stat files held; %.1f read syscalls + %.1f io_uring_enter per scan\n",
+                   names[n][b].c_str(), processes.size(), resources.heldStatFiles(),
+                   static_cast<double>(reads) / scans, static_cast<double>(enters) / scans);
+        }
+        setIoUringAllowed(ring);
+        setMonitorRoot(options.root);
+        nftw(root, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+            options.root = argv[++i];
+        } else if (strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+            options.minTime = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            options.verify = true;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    // the process scan keeps its stat files open, as many as the soft limit allows
+    rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < files.rlim_max) {
+        files.rlim_cur = files.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
+
+    if (options.verify) {
+        bool progression = verifyFixtureProgression();
+        bool allocations = verifySteadyStateAllocations();
+        bool sockets = verifyLiveSockets();
+        bool schedule = verifySchedule();
+        bool scan = verifyProcessScan();
+        bool plugins = verifyPlugins();
+        bool alerts = verifyAlerts();
+        bool shm = verifySharedMemory();
+        bool probes = verifyProbeThreads();
+        return progression && allocations && sockets && schedule && scan && plugins && alerts && shm && probes ? 0 : 1;
+    }
+
+    setMonitorRoot(options.root);
+    if (!checkFixture(options)) return 1;
+
+    SystemResourceTracker resources;
+    CPUUsageTracker cpu;
+    NetworkTracker network;
+
+    printf("# monitor-bench root=%s\n", options.root.c_str());
+    printf("benchmark\tns/op\tops/s\tallocs/op\n");
+    vector<Proc> processes;
+    runBenchmark(options, "getProcessList", [&] {
+        resources.getProcessList(processes);
+        keep(processes);
+    });
+    // a steady process list, so this is the cost of an update with nothing to change
+    ProcessTree tree;
+    runBenchmark(options, "ProcessTree::update", [&] {
+        tree.update(processes);
+        keep(processes);
+    });
+    // the threads of the busiest process, as if it were selected in the UI
+    ThreadTracker threadTracker;
+    vector<ThreadUsage> threads;
+    vector<int> threadPids;
+    auto busiest = max_element(processes.begin(), processes.end(),
+                               [](const Proc& a, const Proc& b) { return a.utime + a.stime < b.utime + b.stime; });
+    if (busiest != processes.end()) threadPids.push_back(busiest->pid);
+    runBenchmark(options, "ThreadTracker::update", [&] {
+        threadTracker.update(threadPids, threads);
+        keep(threads);
+    });
+    // with the default budget; a small tree is read whole every time
+    SmapsTracker smaps;
+    runBenchmark(options, "SmapsTracker::update", [&] {
+        smaps.update(processes, {});
+        keep(processes);
+    });
+    FdTracker fdTracker;
+    runBenchmark(options, "FdTracker::update", [&] {
+        fdTracker.update(processes);
+        keep(processes);
+    });
+    // sock_diag answers from the live kernel whatever the root, so unlike the
+    // rest this depends on the machine; the bench adds loopback connections of
+    // its own so there is something to dump
+    {
+        setMonitorRoot("");
+        rlimit files;
+        int connections = getrlimit(RLIMIT_NOFILE, &files) == 0 ? static_cast<int>(min<rlim_t>(1000, (files.rlim_cur - 64) / 2)) : 100;
+        LoopbackSockets loopback(connections);
+        SystemResourceTracker liveResources;
+        vector<Proc> liveProcesses = liveResources.getProcessList();
+        FdTracker liveFds;
+        liveFds.setBudget(1 << 30);
+        liveFds.update(liveProcesses);
+        SocketTracker socketTracker;
+        vector<SocketInfo> sockets;
+        vector<char> names;
+        if (socketTracker.update(sockets, names, liveFds, liveProcesses)) {
+            runBenchmark(options, "SocketTracker::update (live)", [&] {
+                socketTracker.update(sockets, names, liveFds, liveProcesses);
+                keep(sockets);
+            });
+        }
+        setMonitorRoot(options.root);
+    }
+    // with the files held open, one pread() per process
+    ProcessIOTracker processIO;
+    runBenchmark(options, "ProcessIOTracker::update", [&] {
+        processIO.update(processes);
+        keep(processes);
+    });
+    map<char, int> states;
+    runBenchmark(options, "countProcessStates", [&] {
+        countProcessStates(states);
+        keep(states);
+    });
+    runBenchmark(options, "getMemoryInfo", [&] {
+        MemoryInfo memory = resources.getMemoryInfo();
+        keep(memory);
+    });
+    runBenchmark(options, "calculateCPUUsage", [&] {
+        float usage = cpu.calculateCPUUsage();
+        keep(usage);
+    });
+    runBenchmark(options, "getNetworkRX", [&] {
+        auto rx = network.getNetworkRX();
+        keep(rx);
+    });
+    runBenchmark(options, "getNetworkTX", [&] {
+        auto tx = network.getNetworkTX();
+        keep(tx);
+    });
+    map<string, RX> rx;
+    map<string, TX> tx;
+    runBenchmark(options, "getNetworkStats", [&] {
+        network.getNetworkStats(rx, tx);
+        keep(rx);
+    });
+    // with a root set this lists <root>/sys/class/net instead of calling getifaddrs()
+    Networks interfaces;
+    runBenchmark(options, "getNetworkInterfaces", [&] {
+        network.getNetworkInterfaces(interfaces);
+        keep(interfaces);
+    });
+    runBenchmark(options, "getCPUTemperature", [&] {
+        float temperature = getCPUTemperature();
+        keep(temperature);
+    });
+    runBenchmark(options, "getFanSpeed", [&] {
+        float speed = getFanSpeed();
+        keep(speed);
+    });
+    DiskStatsTracker diskStats;
+    vector<DiskIO> disks;
+    runBenchmark(options, "DiskStatsTracker::update", [&] {
+        diskStats.update(disks);
+        keep(disks);
+    });
+    PressureTracker pressureTracker;
+    Pressure pressure[PRESSURE_RESOURCES];
+    runBenchmark(options, "PressureTracker::read", [&] {
+        pressureTracker.read(pressure);
+        keep(pressure);
+    });
+    CgroupTracker cgroupTracker;
+    vector<CgroupUsage> cgroups;
+    runBenchmark(options, "CgroupTracker::update", [&] {
+        cgroupTracker.update(cgroups);
+        keep(cgroups);
+    });
+
+    // the wheel moved on by one CPU period, as the sampler does every tick
+    CollectorSchedule schedule;
+    double scheduleTime = 0.0;
+    runBenchmark(options, "CollectorSchedule::advance", [&] {
+        scheduleTime += 0.25;
+        unsigned due = schedule.advance(scheduleTime);
+        keep(due);
+    });
+
+    // 5000 threshold rules on the CPU and 100 on processes of 10 names, none firing
+    {
+        string text;
+        for (int i = 0; i < 5000; ++i) text += "cpu.total > " + std::to_string(100 + i) + " for 30s\n";
+        for (int i = 0; i < 100; ++i) text += "proc[name=worker" + std::to_string(i % 10) + "].cpu > 1000\n";
+        vector<AlertRule> rules;
+        string error;
+        parseAlertRules(text, rules, error);
+        AlertEngine engine;
+        engine.configure(rules, "", "");
+        SystemSnapshot snap;
+        snap.metrics = alertSchema();
+        snap.metricValues = {50.0, 0.0};
+        snap.sectionUpdated = {0.0f, 0.0f};
+        snap.processes = processes;
+        runBenchmark(options, "AlertEngine::update (5100 rules)", [&] {
+            snap.time += 0.25f;
+            engine.update(snap, (1u << COLLECTOR_CPU) | (1u << COLLECTOR_PROCESSES));
+            keep(snap);
+        });
+    }
+
+    // sampler ticks 250 ms apart on a scripted clock, so each runs the
+    // collectors due then on the default cadences
+    double tickTime = 1000.0;
+    setMonitorClock([&] { return tickTime; });
+    Sampler sampler;
+    runBenchmark(options, "Sampler::tick (250 ms apart)", [&] {
+        tickTime += 0.25;
+        sampler.tick();
+    });
+    setMonitorClock(nullptr);
+
+    createHeadlessContext();
+    shared_ptr<const SystemSnapshot> snap = sampler.latest();
+    runBenchmark(options, "UI frame", [&] { drawFrame(*snap); });
+
+    // the Connections tab with 200,000 sockets: on the same snapshot a frame
+    // draws only the rows on screen; a new snapshot also rebuilds the row order
+    SystemSnapshot manySockets;
+    manySockets.socketsAvailable = true;
+    if (snap) manySockets.processes = snap->processes; // no snapshot when --filter skipped the tick
+    manySockets.sockets.resize(200000);
+    for (size_t i = 0; i < manySockets.sockets.size(); ++i) {
+        SocketInfo& socket = manySockets.sockets[i];
+        memset(&socket, 0, sizeof(socket));
+        socket.protocol = static_cast<SocketProtocol>(i % 8 == 0 ? SOCKET_UNIX : i % 8 == 1 ? SOCKET_UDP : SOCKET_TCP);
+        socket.family = socket.protocol == SOCKET_UNIX ? AF_UNIX : i % 3 == 0 ? AF_INET6 : AF_INET;
+        socket.state = i % 5 == 0 ? 6 : 1;
+        socket.localAddress[0] = 10;
+        socket.localAddress[3] = i % 200;
+        socket.remoteAddress[0] = 192;
+        socket.remoteAddress[3] = i % 251;
+        socket.localPort = 443;
+        socket.remotePort = 1024 + i % 60000;
+        socket.inode = 100000 + i;
+        socket.receiveQueue = i % 7 * 100;
+        socket.rttUs = 200 + i % 5000;
+        socket.process = manySockets.processes.empty() ? -1 : static_cast<int>(i % manySockets.processes.size());
+        socket.pid = socket.process >= 0 ? manySockets.processes[socket.process].pid : -1;
+        socket.nameOffset = -1;
+    }
+    auto drawConnections = [&] {
+        ImGui::NewFrame();
+        ImGui::Begin("Connections");
+        ImGui::SetWindowSize(ImVec2(1260, 700));
+        connectionsTable(manySockets);
+        ImGui::End();
+        ImGui::Render();
+    };
+    runBenchmark(options, "Connections frame (200k sockets)", drawConnections);
+    runBenchmark(options, "Connections frame, new snapshot (200k sockets)", [&] {
+        manySockets.generation++;
+        drawConnections();
+    });
+    ImGui::DestroyContext();
+
+    benchmarkScanScaling(options);
+    benchmarkBatchedReads(options);
+    return 0;
+}
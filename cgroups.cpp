@@ -0,0 +1,361 @@
+#include "header.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+// cgroup v2 accounting (Documentation/admin-guide/cgroup-v2.rst). With 2,000+
+// cgroups, walking the hierarchy and opening six files per cgroup on every update
+// would cost far more than reading them, so the tree is kept in a preorder vector
+// that inotify keeps current, and the interface files stay open between reads.
+
+enum CgroupFile {
+    CGROUP_CPU_STAT,
+    CGROUP_MEMORY_CURRENT,
+    CGROUP_MEMORY_STAT,
+    CGROUP_MEMORY_EVENTS,
+    CGROUP_IO_STAT,
+    CGROUP_CPU_PRESSURE,
+    CGROUP_FILE_COUNT
+};
+
+static const char* const CGROUP_FILES[CGROUP_FILE_COUNT] = {
+    "cpu.stat", "memory.current", "memory.stat", "memory.events", "io.stat", "cpu.pressure",
+};
+
+static_assert(CGROUP_FILE_COUNT == 6, "CgroupTracker::FILES is the number of interface files");
+
+// Node::fds values other than an open descriptor
+static constexpr int NOT_OPEN = -1;
+static constexpr int MISSING = -2; // the controller isn't enabled here; retried every RESCAN_INTERVAL
+
+// directory changes that add or remove cgroups
+static constexpr uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+CgroupTracker::~CgroupTracker() {
+    for (Node& node : nodes) release(node);
+    if (inotifyFd >= 0) close(inotifyFd);
+}
+
+void CgroupTracker::release(Node& node) {
+    for (int& fd : node.fds) {
+        if (fd >= 0) {
+            close(fd);
+            cachedFds--;
+        }
+        fd = NOT_OPEN;
+    }
+    // the kernel drops the watch itself when the directory is removed
+    if (node.wd >= 0 && inotifyFd >= 0) inotify_rm_watch(inotifyFd, node.wd);
+    node.wd = -1;
+}
+
+// index one past the last descendant of nodes[index]
+size_t CgroupTracker::subtreeEnd(size_t index) const {
+    size_t end = index + 1;
+    while (end < nodes.size() && nodes[end].usage.depth > nodes[index].usage.depth) end++;
+    return end;
+}
+
+CgroupTracker::Node CgroupTracker::makeNode(const string& path, int depth) {
+    Node node;
+    node.usage.path = path;
+    node.usage.depth = depth;
+    std::fill(std::begin(node.fds), std::end(node.fds), NOT_OPEN);
+    if (inotifyFd >= 0) {
+        // watched before it is listed, so a child created in between isn't missed
+        string dir = path.empty() ? base : base + "/" + path;
+        node.wd = inotify_add_watch(inotifyFd, dir.c_str(), WATCH_MASK);
+        if (node.wd < 0) watching = false; // e.g. out of max_user_watches
+    }
+    return node;
+}
+
+// Lists the child directories of `path` and appends their nodes, in name order,
+// to `out`. [oldBegin, oldEnd) is the previous subtree of `path` in `nodes`:
+// children that are still there are moved over with their counters and open
+// files, and with their whole subtree unless `deep` asks for it to be listed too.
+void CgroupTracker::scanChildren(const string& path, int depth, size_t oldBegin, size_t oldEnd, bool deep,
+                                 vector<Node>& out) {
+    vector<string> names;
+    string dir = path.empty() ? base : base + "/" + path;
+    if (DIR* handle = opendir(dir.c_str())) {
+        while (dirent* entry = readdir(handle)) {
+            if (entry->d_name[0] == '.') continue;
+            bool isDir = entry->d_type == DT_DIR;
+            if (entry->d_type == DT_UNKNOWN) {
+                struct stat info;
+                isDir = fstatat(dirfd(handle), entry->d_name, &info, 0) == 0 && S_ISDIR(info.st_mode);
+            }
+            if (isDir) names.push_back(entry->d_name);
+        }
+        closedir(handle);
+    }
+    sort(names.begin(), names.end());
+
+    vector<bool> kept(oldEnd - oldBegin, false);
+    size_t cursor = oldBegin; // old children are in name order too
+    for (const string& name : names) {
+        string child = path.empty() ? name : path + "/" + name;
+        size_t found = oldEnd;
+        for (size_t i = cursor; i < oldEnd; i = subtreeEnd(i)) {
+            if (nodes[i].usage.path == child) {
+                found = i;
+                break;
+            }
+        }
+        if (found == oldEnd) {
+            out.push_back(makeNode(child, depth + 1));
+            scanChildren(child, depth + 1, 0, 0, true, out);
+            continue;
+        }
+        size_t end = subtreeEnd(found);
+        cursor = end;
+        kept[found - oldBegin] = true;
+        out.push_back(std::move(nodes[found]));
+        if (deep) {
+            scanChildren(child, depth + 1, found + 1, end, true, out);
+        } else {
+            for (size_t i = found + 1; i < end; ++i) {
+                kept[i - oldBegin] = true;
+                out.push_back(std::move(nodes[i]));
+            }
+        }
+    }
+    // children that are gone, with everything below them
+    for (size_t i = oldBegin; i < oldEnd; i = subtreeEnd(i)) {
+        if (nodes[i].usage.depth != depth + 1 || kept[i - oldBegin]) continue;
+        for (size_t j = i; j < subtreeEnd(i); ++j) release(nodes[j]);
+    }
+}
+
+// Lists the children of nodes[index] again and splices the result into the tree.
+void CgroupTracker::rescan(size_t index, bool deep) {
+    size_t end = subtreeEnd(index);
+    vector<Node> subtree;
+    string path = nodes[index].usage.path;
+    scanChildren(path, nodes[index].usage.depth, index + 1, end, deep, subtree);
+    nodes.erase(nodes.begin() + index + 1, nodes.begin() + end);
+    nodes.insert(nodes.begin() + index + 1, make_move_iterator(subtree.begin()), make_move_iterator(subtree.end()));
+}
+
+// Finds the cgroup2 mount (in the unified/ directory on hybrid systems) and walks
+// it from scratch.
+void CgroupTracker::reset() {
+    for (Node& node : nodes) release(node);
+    nodes.clear();
+    if (inotifyFd >= 0) close(inotifyFd);
+    inotifyFd = -1;
+    baseRoot = monitorRootGeneration();
+    lastTime = -1;
+
+    base.clear();
+    char path[PATH_MAX];
+    for (const char* candidate : {"/sys/fs/cgroup", "/sys/fs/cgroup/unified"}) {
+        if (monitorPathf(path, sizeof(path), "%s/cgroup.controllers", candidate) && access(path, F_OK) == 0) {
+            base = monitorPath(candidate);
+            break;
+        }
+    }
+    if (base.empty()) return;
+
+    // half the open-file limit, so the cache can't starve the rest of the monitor
+    rlimit limit;
+    fdBudget = getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY
+                   ? static_cast<int>(min<rlim_t>(limit.rlim_cur / 2, INT_MAX))
+                   : 512;
+
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    watching = inotifyFd >= 0;
+    nodes.push_back(makeNode("", 0));
+    rescan(0, true);
+    lastRescan = monitorClock();
+}
+
+// Rescans the directories that gained or lost children since the last update.
+void CgroupTracker::handleEvents() {
+    alignas(inotify_event) char buffer[4096];
+    bool overflow = false;
+    changedWds.clear();
+    while (true) {
+        ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) break;
+        for (char* at = buffer; at < buffer + length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(at);
+            at += sizeof(inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+            } else if (event->mask & IN_IGNORED) {
+                for (Node& node : nodes)
+                    if (node.wd == event->wd) node.wd = -1;
+            } else if ((event->mask & IN_ISDIR) &&
+                       find(changedWds.begin(), changedWds.end(), event->wd) == changedWds.end()) {
+                changedWds.push_back(event->wd);
+            }
+        }
+    }
+    if (overflow) {
+        rescan(0, true);
+        return;
+    }
+    for (int wd : changedWds) {
+        // a directory rescanned earlier in this loop may have taken this one with it
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i].wd != wd) continue;
+            rescan(i, false);
+            break;
+        }
+    }
+}
+
+// Reads one interface file into `text`; -1 if the cgroup doesn't have it.
+ssize_t CgroupTracker::readFile(Node& node, int file) {
+    int fd = node.fds[file];
+    if (fd == MISSING) return -1;
+    bool cached = fd >= 0;
+    if (!cached) {
+        char path[PATH_MAX];
+        int length = node.usage.path.empty()
+                         ? snprintf(path, sizeof(path), "%s/%s", base.c_str(), CGROUP_FILES[file])
+                         : snprintf(path, sizeof(path), "%s/%s/%s", base.c_str(), node.usage.path.c_str(), CGROUP_FILES[file]);
+        if (length < 0 || static_cast<size_t>(length) >= sizeof(path)) return -1;
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            if (errno == ENOENT) node.fds[file] = MISSING;
+            return -1;
+        }
+        if (cachedFds < fdBudget) {
+            node.fds[file] = fd;
+            cachedFds++;
+            cached = true;
+        }
+    }
+
+    if (text.size() < 4096) text.resize(4096);
+    size_t length = 0;
+    while (true) {
+        if (length + 1 >= text.size()) text.resize(text.size() * 2);
+        size_t space = text.size() - 1 - length;
+        ssize_t n = pread(fd, text.data() + length, space, length);
+        if (n <= 0) break;
+        length += n;
+        // kernfs hands over the whole file when it fits, so a short read is the
+        // end; this saves the extra pread() that would return 0
+        if (static_cast<size_t>(n) < space) break;
+    }
+    text[length] = '\0';
+    if (!cached) close(fd);
+    return length;
+}
+
+// Looks up "key value" lines; keys that aren't there leave their value alone.
+static void parseKeyValues(const char* text, const char* const* keys, unsigned long long* values, int count) {
+    for (const char* line = text; *line;) {
+        const char* space = strchr(line, ' ');
+        const char* end = strchr(line, '\n');
+        if (space && (!end || space < end)) {
+            size_t length = space - line;
+            for (int k = 0; k < count; ++k) {
+                if (strlen(keys[k]) == length && memcmp(line, keys[k], length) == 0) {
+                    values[k] = strtoull(space + 1, nullptr, 10);
+                    break;
+                }
+            }
+        }
+        line = end ? end + 1 : line + strlen(line);
+    }
+}
+
+static float ratePerSecond(unsigned long long now, unsigned long long before, double seconds) {
+    return now >= before ? static_cast<float>((now - before) / seconds) : 0.0f;
+}
+
+void CgroupTracker::readNode(Node& node, double seconds) {
+    CgroupUsage& usage = node.usage;
+    bool hasInterval = node.sampled && seconds > 0;
+
+    static const char* const cpuKeys[] = {"usage_usec", "throttled_usec"};
+    unsigned long long cpu[2] = {};
+    if (readFile(node, CGROUP_CPU_STAT) > 0) parseKeyValues(text.data(), cpuKeys, cpu, 2);
+    usage.cpuPercent = hasInterval ? ratePerSecond(cpu[0], node.usageUsec, seconds) / 1e4f : 0.0f;
+    usage.throttledPercent = hasInterval ? min(100.0f, ratePerSecond(cpu[1], node.throttledUsec, seconds) / 1e4f) : 0.0f;
+    node.usageUsec = cpu[0];
+    node.throttledUsec = cpu[1];
+
+    usage.memoryBytes = readFile(node, CGROUP_MEMORY_CURRENT) > 0 ? strtoull(text.data(), nullptr, 10) : 0;
+
+    // "kernel" only exists since 5.18; before that, add up its main parts
+    static const char* const memoryKeys[] = {"anon", "file", "kernel", "kernel_stack", "pagetables", "slab"};
+    unsigned long long memory[6] = {};
+    if (readFile(node, CGROUP_MEMORY_STAT) > 0) parseKeyValues(text.data(), memoryKeys, memory, 6);
+    usage.anonBytes = memory[0];
+    usage.fileBytes = memory[1];
+    usage.kernelBytes = memory[2] ? memory[2] : memory[3] + memory[4] + memory[5];
+
+    static const char* const eventKeys[] = {"high", "max", "oom_kill"};
+    unsigned long long events[3] = {};
+    if (readFile(node, CGROUP_MEMORY_EVENTS) > 0) parseKeyValues(text.data(), eventKeys, events, 3);
+    usage.highEvents = events[0];
+    usage.maxEvents = events[1];
+    usage.oomKills = events[2];
+
+    // "8:0 rbytes=1 wbytes=2 rios=3 wios=4 dbytes=0 dios=0", one line per device
+    unsigned long long io[4] = {};
+    if (readFile(node, CGROUP_IO_STAT) > 0) {
+        static const char* const ioKeys[] = {"rbytes=", "wbytes=", "rios=", "wios="};
+        for (const char* line = text.data(); *line;) {
+            const char* end = strchr(line, '\n');
+            for (int k = 0; k < 4; ++k) {
+                const char* at = strstr(line, ioKeys[k]);
+                if (at && (!end || at < end)) io[k] += strtoull(at + strlen(ioKeys[k]), nullptr, 10);
+            }
+            line = end ? end + 1 : line + strlen(line);
+        }
+    }
+    usage.readBytesPerSec = hasInterval ? ratePerSecond(io[0], node.readBytes, seconds) : 0.0f;
+    usage.writeBytesPerSec = hasInterval ? ratePerSecond(io[1], node.writtenBytes, seconds) : 0.0f;
+    usage.readIops = hasInterval ? ratePerSecond(io[2], node.reads, seconds) : 0.0f;
+    usage.writeIops = hasInterval ? ratePerSecond(io[3], node.writes, seconds) : 0.0f;
+    node.readBytes = io[0];
+    node.writtenBytes = io[1];
+    node.reads = io[2];
+    node.writes = io[3];
+
+    Pressure pressure{};
+    if (readFile(node, CGROUP_CPU_PRESSURE) > 0) parsePressure(text.data(), pressure);
+    usage.cpuSomePressure = pressure.some.avg10;
+    usage.cpuFullPressure = pressure.full.avg10;
+    node.sampled = true;
+}
+
+void CgroupTracker::update(vector<CgroupUsage>& cgroups) {
+    MONITOR_PROBE(PROBE_UPDATE_CGROUPS);
+    if (baseRoot != monitorRootGeneration()) reset();
+    if (base.empty()) {
+        cgroups.clear();
+        return;
+    }
+
+    double now = monitorClock();
+    if (inotifyFd >= 0) handleEvents();
+    if (now - lastRescan >= RESCAN_INTERVAL) {
+        lastRescan = now;
+        if (!watching) rescan(0, true);
+        for (Node& node : nodes)
+            for (int& fd : node.fds)
+                if (fd == MISSING) fd = NOT_OPEN;
+    }
+
+    double seconds = lastTime >= 0 ? now - lastTime : 0;
+    lastTime = now;
+    size_t count = 0;
+    for (Node& node : nodes) {
+        readNode(node, seconds);
+        if (count == cgroups.size()) cgroups.emplace_back();
+        cgroups[count++] = node.usage;
+    }
+    cgroups.resize(count);
+}
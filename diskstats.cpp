@@ -0,0 +1,151 @@
+#include "header.h"
+#include <cstring>
+
+// Block device I/O rates from the counters in /proc/diskstats (see the kernel's
+// Documentation/admin-guide/iostats.rst). The whole file is parsed in one pass
+// into vectors that are reused between updates; sysfs is only consulted the
+// first time a device shows up, to tell partitions and device-mapper targets apart.
+
+// fields after "major minor name"; newer kernels append discard and flush
+// counters, which aren't used here
+enum DiskStatField {
+    DISK_READS,
+    DISK_READS_MERGED,
+    DISK_SECTORS_READ,
+    DISK_MS_READING,
+    DISK_WRITES,
+    DISK_WRITES_MERGED,
+    DISK_SECTORS_WRITTEN,
+    DISK_MS_WRITING,
+    DISK_IN_FLIGHT,
+    DISK_MS_DOING_IO,
+    DISK_WEIGHTED_MS,
+    DISK_STAT_FIELDS
+};
+
+// diskstats counts 512-byte sectors whatever the device's logical block size
+static constexpr double SECTOR_BYTES = 512.0;
+
+const char* diskKindName(DiskKind kind) {
+    switch (kind) {
+        case DISK_WHOLE: return "disk";
+        case DISK_PARTITION: return "part";
+        case DISK_MAPPER: return "dm";
+        case DISK_VIRTUAL: return "virtual";
+    }
+    return "?";
+}
+
+// Partitions have a "partition" attribute and device-mapper targets a dm/name,
+// so sd*, nvme*n*p*, mmcblk*p* and the rest need no name rules.
+static void classifyDisk(DiskIO& disk) {
+    snprintf(disk.label, sizeof(disk.label), "%s", disk.name);
+    if (strncmp(disk.name, "loop", 4) == 0 || strncmp(disk.name, "ram", 3) == 0 ||
+        strncmp(disk.name, "zram", 4) == 0) {
+        disk.kind = DISK_VIRTUAL;
+        return;
+    }
+    char path[PATH_MAX];
+    char name[sizeof(disk.label)];
+    if (monitorPathf(path, sizeof(path), "/sys/class/block/%s/partition", disk.name) && access(path, F_OK) == 0) {
+        disk.kind = DISK_PARTITION;
+    } else if (monitorPathf(path, sizeof(path), "/sys/class/block/%s/dm/name", disk.name) &&
+               readFileInto(path, name, sizeof(name)) > 0) {
+        name[strcspn(name, "\n")] = '\0';
+        if (name[0]) snprintf(disk.label, sizeof(disk.label), "%s", name);
+        disk.kind = DISK_MAPPER;
+    } else {
+        disk.kind = DISK_WHOLE;
+    }
+}
+
+// counters are unsigned long in the kernel, so they wrap on 32-bit systems
+static unsigned long long counterDelta(unsigned long long now, unsigned long long before) {
+    return now >= before ? now - before : 0;
+}
+
+void DiskStatsTracker::update(vector<DiskIO>& disks) {
+    MONITOR_PROBE(PROBE_GET_DISK_STATS);
+    char path[PATH_MAX];
+    if (!monitorPathf(path, sizeof(path), "/proc/diskstats") || readFileInto(path, text) < 0) {
+        devices.clear();
+        current.clear();
+        disks.clear();
+        return;
+    }
+    double now = monitorClock();
+    double seconds = lastTime >= 0 ? now - lastTime : 0;
+    lastTime = now;
+
+    size_t index = 0;
+    for (char* line = text.data(); *line; ) {
+        char* end;
+        unsigned major = strtoul(line, &end, 10);
+        unsigned minor = strtoul(end, &end, 10);
+        while (*end == ' ') end++;
+        const char* name = end;
+        while (*end && *end != ' ' && *end != '\n') end++;
+        size_t nameLength = end - name;
+        unsigned long long field[DISK_STAT_FIELDS] = {};
+        for (int i = 0; i < DISK_STAT_FIELDS && *end && *end != '\n'; ++i) field[i] = strtoull(end, &end, 10);
+        char* next = strchr(end, '\n');
+        line = next ? next + 1 : end + strlen(end);
+        if (nameLength == 0 || nameLength >= sizeof(DiskIO::name)) continue;
+
+        // the kernel lists devices in the same order every time, so the device is
+        // normally the one at `index`; devices skipped over were removed
+        size_t found = index;
+        while (found < devices.size() && (devices[found].major != major || devices[found].minor != minor)) found++;
+        bool added = found == devices.size();
+        if (added) {
+            devices.insert(devices.begin() + index, Device{});
+            current.insert(current.begin() + index, DiskIO{});
+        } else if (found > index) {
+            devices.erase(devices.begin() + index, devices.begin() + found);
+            current.erase(current.begin() + index, current.begin() + found);
+        }
+
+        Device& device = devices[index];
+        DiskIO& disk = current[index];
+        index++;
+        if (added || strncmp(disk.name, name, nameLength) != 0 || disk.name[nameLength] != '\0') {
+            memcpy(disk.name, name, nameLength);
+            disk.name[nameLength] = '\0';
+            disk.major = major;
+            disk.minor = minor;
+            classifyDisk(disk);
+            added = true;
+        }
+
+        if (!added && seconds > 0) {
+            unsigned long long reads = counterDelta(field[DISK_READS], device.readsCompleted);
+            unsigned long long writes = counterDelta(field[DISK_WRITES], device.writesCompleted);
+            disk.readBytesPerSec = counterDelta(field[DISK_SECTORS_READ], device.sectorsRead) * SECTOR_BYTES / seconds;
+            disk.writeBytesPerSec = counterDelta(field[DISK_SECTORS_WRITTEN], device.sectorsWritten) * SECTOR_BYTES / seconds;
+            disk.readIops = reads / seconds;
+            disk.writeIops = writes / seconds;
+            disk.readAwaitMs = reads ? static_cast<float>(counterDelta(field[DISK_MS_READING], device.msReading)) / reads : 0.0f;
+            disk.writeAwaitMs = writes ? static_cast<float>(counterDelta(field[DISK_MS_WRITING], device.msWriting)) / writes : 0.0f;
+            // io_ticks and the weighted time are in milliseconds
+            disk.utilization = min(100.0, counterDelta(field[DISK_MS_DOING_IO], device.msDoingIo) / (seconds * 10.0));
+            disk.queueDepth = counterDelta(field[DISK_WEIGHTED_MS], device.weightedMs) / (seconds * 1000.0);
+        } else {
+            // no interval yet for a device seen for the first time
+            disk.readBytesPerSec = disk.writeBytesPerSec = 0.0f;
+            disk.readIops = disk.writeIops = 0.0f;
+            disk.readAwaitMs = disk.writeAwaitMs = 0.0f;
+            disk.utilization = disk.queueDepth = 0.0f;
+        }
+        disk.inFlight = field[DISK_IN_FLIGHT];
+        disk.readBytes = static_cast<unsigned long long>(field[DISK_SECTORS_READ] * SECTOR_BYTES);
+        disk.writtenBytes = static_cast<unsigned long long>(field[DISK_SECTORS_WRITTEN] * SECTOR_BYTES);
+
+        device = Device{major, minor,
+                        field[DISK_READS], field[DISK_SECTORS_READ], field[DISK_MS_READING],
+                        field[DISK_WRITES], field[DISK_SECTORS_WRITTEN], field[DISK_MS_WRITING],
+                        field[DISK_MS_DOING_IO], field[DISK_WEIGHTED_MS]};
+    }
+    devices.resize(index);
+    current.resize(index);
+    disks = current;
+}
@@ -0,0 +1,228 @@
+#include "header.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/syscall.h>
+
+// /proc/<pid>/fd has one symlink per open descriptor, pointing to a path for
+// files and devices, or to a pseudo name:
+//   socket:[123456]  pipe:[123457]  anon_inode:[eventfd]  anon_inode:inotify
+// A leaking process usually leaks one kind, so the counts are kept by kind.
+//
+// getdents64() is used directly instead of readdir(): the directory fd stays
+// open across updates while a listing is in progress, and each call returns as
+// many entries as fit in the buffer. The buffer is kept small so one call
+// doesn't overshoot the budget by much.
+
+struct LinuxDirent64 {
+    ino64_t d_ino;
+    off64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+static constexpr size_t DIRENT_BUFFER = 4096;
+
+void SocketOwnerTable::grow() {
+    vector<Slot> old(max<size_t>(64, slots.size() * 2), Slot{0, 0});
+    old.swap(slots);
+    used = 0;
+    for (const Slot& slot : old)
+        if (slot.inode) insert(slot.inode, slot.pid);
+}
+
+void SocketOwnerTable::insert(unsigned inode, int pid) {
+    if (inode == 0) return;
+    if ((used + 1) * 2 > slots.size()) grow();
+    size_t at = home(inode);
+    while (slots[at].inode && slots[at].inode != inode) at = (at + 1) & (slots.size() - 1);
+    if (slots[at].inode) return;
+    slots[at] = Slot{inode, pid};
+    used++;
+}
+
+// Removing from a linear-probing table moves later entries of the same run back
+// into the gap, so lookups never need tombstones.
+void SocketOwnerTable::erase(unsigned inode, int pid) {
+    if (slots.empty() || inode == 0) return;
+    size_t mask = slots.size() - 1;
+    size_t at = home(inode);
+    while (slots[at].inode && slots[at].inode != inode) at = (at + 1) & mask;
+    if (slots[at].inode != inode || slots[at].pid != pid) return;
+    slots[at].inode = 0;
+    used--;
+    for (size_t gap = at, next = (at + 1) & mask; slots[next].inode; next = (next + 1) & mask) {
+        size_t want = home(slots[next].inode);
+        // move it unless its home lies cyclically in (gap, next]
+        bool stays = gap <= next ? gap < want && want <= next : gap < want || want <= next;
+        if (stays) continue;
+        slots[gap] = slots[next];
+        slots[next].inode = 0;
+        gap = next;
+    }
+}
+
+int SocketOwnerTable::find(unsigned inode) const {
+    if (slots.empty() || inode == 0) return -1;
+    for (size_t at = home(inode); slots[at].inode; at = (at + 1) & (slots.size() - 1))
+        if (slots[at].inode == inode) return slots[at].pid;
+    return -1;
+}
+
+void SocketOwnerTable::clear() {
+    fill(slots.begin(), slots.end(), Slot{0, 0});
+    used = 0;
+}
+
+FdTracker::~FdTracker() { stopScan(); }
+
+void FdTracker::stopScan() {
+    if (scanFd >= 0) close(scanFd);
+    scanFd = -1;
+    scanPid = -1;
+}
+
+// Lists (more of) one process's fds. Returns true once the listing is complete,
+// or can't be done, and false if the budget ran out first.
+bool FdTracker::scan(int pid, Entry& entry, int& calls) {
+    if (scanPid != pid) {
+        stopScan();
+        char path[PATH_MAX];
+        if (!monitorPathf(path, sizeof(path), "/proc/%d/fd", pid)) return true;
+        scanFd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        calls++;
+        if (scanFd < 0) {
+            entry.denied = errno == EACCES || errno == EPERM;
+            return true;
+        }
+        scanPid = pid;
+        scanCounts = FdUsage{};
+        scanCounts.total = 0;
+        scanSockets.clear();
+    }
+
+    if (buffer.size() < DIRENT_BUFFER) buffer.resize(DIRENT_BUFFER);
+    while (calls < syscallBudget) {
+        long length = syscall(SYS_getdents64, scanFd, buffer.data(), buffer.size());
+        calls++;
+        if (length < 0) { // the process exited while being listed
+            stopScan();
+            return true;
+        }
+        if (length == 0) {
+            double now = monitorClock();
+            if (entry.usage.total >= 0 && now > entry.listedAt)
+                scanCounts.growthPerSec = static_cast<float>((scanCounts.total - entry.usage.total) / (now - entry.listedAt));
+            else if (entry.usage.total >= 0)
+                scanCounts.growthPerSec = entry.usage.growthPerSec;
+            entry.usage = scanCounts;
+            entry.listedAt = now;
+            setSockets(pid, entry, scanSockets);
+            stopScan();
+            return true;
+        }
+        for (long at = 0; at < length;) {
+            const LinuxDirent64* record = reinterpret_cast<const LinuxDirent64*>(buffer.data() + at);
+            at += record->d_reclen;
+            if (record->d_name[0] == '.') continue;
+            char target[64]; // long paths are cut short, only the start matters
+            ssize_t targetLength = readlinkat(scanFd, record->d_name, target, sizeof(target) - 1);
+            calls++;
+            if (targetLength < 0) continue; // closed since the listing
+            target[targetLength] = '\0';
+            scanCounts.total++;
+            if (strncmp(target, "socket:[", 8) == 0) {
+                scanCounts.sockets++;
+                scanSockets.push_back(static_cast<unsigned>(strtoul(target + 8, nullptr, 10)));
+            }
+            else if (strncmp(target, "pipe:", 5) == 0) scanCounts.pipes++;
+            else if (strncmp(target, "anon_inode:", 11) == 0) scanCounts.anonInodes++;
+            else if (target[0] == '/') scanCounts.files++;
+            else scanCounts.other++;
+        }
+    }
+    return false;
+}
+
+// Replaces a process's socket inodes with `sockets` and updates the owner table:
+// the ones it no longer holds are given up, and every one it holds is claimed,
+// not only the new ones. A socket shared with a process that has since exited
+// (a prefork server's listener, one inherited from a parent) lost its owner
+// then and goes to whichever holder is listed next. `sockets` gets the old
+// list's storage back.
+void FdTracker::setSockets(int pid, Entry& entry, vector<unsigned>& sockets) {
+    sort(sockets.begin(), sockets.end());
+    auto kept = sockets.begin();
+    for (unsigned inode : entry.sockets) {
+        while (kept != sockets.end() && *kept < inode) ++kept;
+        if (kept != sockets.end() && *kept == inode) ++kept;
+        else owners.erase(inode, pid);
+    }
+    for (unsigned inode : sockets) owners.insert(inode, pid);
+    entry.sockets.swap(sockets);
+}
+
+void FdTracker::update(vector<Proc>& processes) {
+    MONITOR_PROBE(PROBE_UPDATE_FDS);
+    if (rootGeneration != monitorRootGeneration()) {
+        stopScan();
+        entries.clear();
+        owners.clear();
+        rootGeneration = monitorRootGeneration();
+    }
+
+    // a PID that names another process now starts over
+    pass++;
+    for (const Proc& proc : processes) {
+        Entry& entry = entries[proc.pid];
+        if (entry.startTime != proc.startTime) {
+            if (scanPid == proc.pid) stopScan();
+            for (unsigned inode : entry.sockets) owners.erase(inode, proc.pid);
+            entry = Entry{};
+            entry.startTime = proc.startTime;
+        }
+        entry.seenPass = pass;
+    }
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.seenPass == pass) {
+            ++it;
+            continue;
+        }
+        if (scanPid == it->first) stopScan();
+        for (unsigned inode : it->second.sockets) owners.erase(inode, it->first);
+        it = entries.erase(it);
+    }
+
+    // the listing left unfinished last time, then on in PID order
+    int calls = 0;
+    auto it = scanPid >= 0 ? entries.find(scanPid) : entries.upper_bound(nextPid);
+    for (size_t visited = 0; visited < entries.size() && calls < syscallBudget; ++visited, ++it) {
+        if (it == entries.end()) it = entries.begin();
+        if (it->second.denied) continue;
+        nextPid = it->first;
+        if (!scan(it->first, it->second, calls)) break;
+    }
+
+    apply(processes);
+}
+
+void FdTracker::apply(vector<Proc>& processes) const {
+    for (Proc& proc : processes) {
+        auto it = entries.find(proc.pid);
+        bool same = it != entries.end() && it->second.startTime == proc.startTime;
+        proc.fds = same ? it->second.usage : FdUsage{};
+    }
+}
+
+bool readFileHandles(FileHandles& out) {
+    char path[PATH_MAX];
+    char text[128];
+    out = FileHandles{};
+    if (!monitorPathf(path, sizeof(path), "/proc/sys/fs/file-nr") || readFileInto(path, text, sizeof(text)) <= 0)
+        return false;
+    // allocated, free (always 0 since 2.6), maximum
+    long long unused;
+    return sscanf(text, "%lld %lld %lld", &out.allocated, &unused, &out.maximum) == 3;
+}
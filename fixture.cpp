@@ -0,0 +1,531 @@
+#include "header.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+
+// Writes a synthetic /proc and /sys tree for the collectors to read through
+// setMonitorRoot(). Each call writes the state at one step; counters grow
+// linearly with simulated time (step * stepSeconds), so rewriting the tree for
+// the next step and advancing the clock by stepSeconds gives the collectors
+// deltas whose rates are known in advance.
+//
+// Only the files the collectors read are written. Rewriting a directory with a
+// smaller spec leaves the extra entries of the larger one behind.
+
+// share of each CPU spent in user, system and idle time; busy = 40%
+static constexpr double CPU_USER_SHARE = 0.30;
+static constexpr double CPU_SYSTEM_SHARE = 0.10;
+static constexpr double CPU_IDLE_SHARE = 0.60;
+
+static const char PROCESS_STATES[] = "RSSSSSSSSSSSSSSDSSSZSSSSIT";
+
+static bool makeDirs(const string& path) {
+    for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+        string prefix = path.substr(0, slash);
+        if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        if (slash == string::npos) return true;
+    }
+}
+
+static bool writeFile(const string& path, const string& contents) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) return false;
+    size_t written = fwrite(contents.data(), 1, contents.size(), file);
+    return fclose(file) == 0 && written == contents.size();
+}
+
+static long long clockTicks() {
+    static const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    return ticksPerSecond > 0 ? ticksPerSecond : 100;
+}
+
+int fixturePid(int index) { return 100 + index * 3; }
+
+// every process but the first has four children, breadth first
+int fixtureParentIndex(int index) { return index > 0 ? (index - 1) / 4 : -1; }
+
+float fixtureExpectedCPUUsage() { return 100.0f * (CPU_USER_SHARE + CPU_SYSTEM_SHARE); }
+
+float fixtureExpectedProcessCPU(int index) { return static_cast<float>((index * 7) % 100); }
+
+float fixtureExpectedRxRate(int iface) { return 1000.0f * (iface + 1); }
+
+float fixtureExpectedTxRate(int iface) { return 250.0f * (iface + 1); }
+
+string fixtureInterfaceName(int iface) {
+    return iface == 0 ? "lo" : TextF("eth%d", iface - 1).c_str();
+}
+
+static bool writeProcStat(const string& root, const FixtureSpec& spec, double seconds) {
+    double ticks = clockTicks() * seconds;
+    long long user = 1000 + llround(CPU_USER_SHARE * ticks);
+    long long system = 500 + llround(CPU_SYSTEM_SHARE * ticks);
+    long long idle = 5000 + llround(CPU_IDLE_SHARE * ticks);
+
+    string text = TextF("cpu  %lld 0 %lld %lld 0 0 0 0 0 0\n",
+                        user * spec.cpus, system * spec.cpus, idle * spec.cpus).c_str();
+    for (int cpu = 0; cpu < spec.cpus; ++cpu)
+        text += TextF("cpu%d %lld 0 %lld %lld 0 0 0 0 0 0\n", cpu, user, system, idle).c_str();
+    text += TextF("ctxt %lld\nbtime 1760000000\nprocesses %d\n",
+                  llround(1000 * seconds), spec.processes).c_str();
+    return writeFile(root + "/proc/stat", text);
+}
+
+MemoryInfo fixtureExpectedMemory(int step) {
+    MemoryInfo mem{};
+    mem.mem_total_kb = 16UL * 1024 * 1024;
+    mem.mem_available_kb = mem.mem_total_kb / 2 + (step % 16) * 65536;
+    mem.mem_free_kb = mem.mem_available_kb / 2;
+    mem.buffers_kb = 262144;
+    mem.cached_kb = mem.mem_available_kb / 3;
+    mem.swap_cached_kb = 1024;
+    mem.shmem_kb = 131072 + (step % 4) * 1024;
+    mem.slab_kb = 524288;
+    mem.slab_reclaimable_kb = 393216;
+    mem.slab_unreclaimable_kb = 131072;
+    mem.dirty_kb = 2048 + (step % 8) * 512;
+    mem.writeback_kb = step % 2 ? 256 : 0;
+    mem.anon_pages_kb = 4UL * 1024 * 1024 + (step % 16) * 8192;
+    mem.mapped_kb = 786432;
+    mem.commit_limit_kb = 10485760;
+    mem.committed_as_kb = 12582912;
+    mem.hugepages_total = 16;
+    mem.hugepages_free = 12;
+    mem.hugepages_reserved = 2;
+    mem.hugepages_surplus = 0;
+    mem.hugepage_size_kb = 2048;
+    mem.swap_total_kb = 2097152;
+    mem.swap_free_kb = mem.swap_total_kb - (step % 8) * 4096;
+    return mem;
+}
+
+// Written in the kernel's order, including keys the collectors skip.
+static bool writeMeminfo(const string& root, int step) {
+    MemoryInfo mem = fixtureExpectedMemory(step);
+    string text;
+    auto line = [&](const char* key, unsigned long value, const char* unit = " kB") {
+        char label[24];
+        snprintf(label, sizeof(label), "%s:", key);
+        text += TextF("%-16s%8lu%s\n", label, value, unit).c_str();
+    };
+    line("MemTotal", mem.mem_total_kb);
+    line("MemFree", mem.mem_free_kb);
+    line("MemAvailable", mem.mem_available_kb);
+    line("Buffers", mem.buffers_kb);
+    line("Cached", mem.cached_kb);
+    line("SwapCached", mem.swap_cached_kb);
+    line("Active", 6291456);
+    line("Inactive", 3145728);
+    line("SwapTotal", mem.swap_total_kb);
+    line("SwapFree", mem.swap_free_kb);
+    line("Dirty", mem.dirty_kb);
+    line("Writeback", mem.writeback_kb);
+    line("AnonPages", mem.anon_pages_kb);
+    line("Mapped", mem.mapped_kb);
+    line("Shmem", mem.shmem_kb);
+    line("KReclaimable", mem.slab_reclaimable_kb);
+    line("Slab", mem.slab_kb);
+    line("SReclaimable", mem.slab_reclaimable_kb);
+    line("SUnreclaim", mem.slab_unreclaimable_kb);
+    line("KernelStack", 24576);
+    line("PageTables", 65536);
+    line("CommitLimit", mem.commit_limit_kb);
+    line("Committed_AS", mem.committed_as_kb);
+    line("VmallocTotal", 34359738367UL);
+    line("AnonHugePages", 0);
+    line("HugePages_Total", mem.hugepages_total, "");
+    line("HugePages_Free", mem.hugepages_free, "");
+    line("HugePages_Rsvd", mem.hugepages_reserved, "");
+    line("HugePages_Surp", mem.hugepages_surplus, "");
+    line("Hugepagesize", mem.hugepage_size_kb);
+    line("Hugetlb", mem.hugepages_total * mem.hugepage_size_kb);
+    line("DirectMap4k", 456789);
+    return writeFile(root + "/proc/meminfo", text);
+}
+
+// one /proc/<pid>/stat or /proc/<pid>/task/<tid>/stat line
+static string statLine(int id, const string& name, char state, int ppid, long long utime, long long stime,
+                       int startTime, long long vsize, long long rss, int processor) {
+    string stat = TextF("%d (%s) %c %d %d %d 0 -1 4194560 0 0 0 0 %lld %lld 0 0 20 0 1 0 %d %lld %lld",
+                        id, name.c_str(), state, ppid, id, id, utime, stime, startTime, vsize, rss).c_str();
+    stat += TextF(" 18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 %d 0 0 0 0 0\n", processor).c_str();
+    return stat;
+}
+
+// every 50th process, starting at 10, is a server with four threads
+int fixtureThreadCount(int index) { return index % 50 == 10 ? 4 : 1; }
+
+// The main thread has the process's PID. A multithreaded process's CPU time is
+// split 1:2:3:4 between its threads, which with the process CPU% of these
+// indices gives whole percentages.
+ThreadUsage fixtureExpectedThread(const FixtureSpec& spec, int index, int thread) {
+    ThreadUsage usage;
+    usage.pid = fixturePid(index);
+    usage.tid = thread == 0 ? usage.pid : 1000000 + index * 4 + thread;
+    snprintf(usage.name, sizeof(usage.name), thread == 0 ? "proc-%d" : "worker-%d", thread == 0 ? index : thread);
+    usage.state = thread == 0 ? PROCESS_STATES[index % (sizeof(PROCESS_STATES) - 1)] : thread == 1 ? 'R' : 'S';
+    usage.processor = (index + thread) % spec.cpus;
+    usage.cpuPercent = fixtureExpectedProcessCPU(index);
+    if (fixtureThreadCount(index) > 1) usage.cpuPercent = usage.cpuPercent * (thread + 1) / 10;
+    return usage;
+}
+
+// resident memory is (index % 64 + 1) MB; a quarter of it is shared with others
+long long fixtureExpectedPss(int index) { return (index % 64 + 1) * 768LL; }
+
+long long fixtureExpectedSwap(int index) { return (index % 5) * 256LL; }
+
+ProcessIO fixtureExpectedProcessIO(int index) {
+    ProcessIO io;
+    io.available = true;
+    io.readBytesPerSec = 4096.0f * (index % 13);
+    io.writeBytesPerSec = 8192.0f * (index % 7);
+    io.cancelledWriteBytesPerSec = index % 3 == 0 ? 4096.0f : 0.0f;
+    io.readCallsPerSec = 10.0f * (index % 11);
+    io.writeCallsPerSec = 5.0f * (index % 9);
+    return io;
+}
+
+// every tenth process, from index 3, leaks two sockets a second
+FdUsage fixtureExpectedFds(const FixtureSpec& spec, int index, int step) {
+    bool leaking = index % 10 == 3;
+    FdUsage fds;
+    fds.files = 3 + index % 4; // stdin, stdout and stderr on the terminal, then log files
+    fds.pipes = 2 * (index % 3);
+    fds.anonInodes = index % 2;
+    fds.sockets = index % 5 + (leaking ? static_cast<int>(llround(2 * step * spec.stepSeconds)) : 0);
+    fds.total = fds.files + fds.pipes + fds.anonInodes + fds.sockets;
+    fds.growthPerSec = leaking ? 2.0f : 0.0f;
+    return fds;
+}
+
+unsigned fixtureSocketInode(int index, int fd) { return 900000 + index * 4096 + fd; }
+
+FileHandles fixtureExpectedFileHandles() { return FileHandles{12288, 1048576}; }
+
+// /proc/<pid>/fd: descriptors are numbered by kind, so a later step only adds
+// the leaked sockets at the end and the links already there stay valid
+static bool writeFds(const string& dir, const FixtureSpec& spec, int index, int step) {
+    FdUsage fds = fixtureExpectedFds(spec, index, step);
+    string fdDir = dir + "/fd";
+    if (mkdir(fdDir.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    for (int fd = 0; fd < fds.total; ++fd) {
+        FormattedText target;
+        if (fd < 3) target = TextF("/dev/pts/0");
+        else if (fd < fds.files) target = TextF("/var/log/proc-%d.%d.log", index, fd);
+        else if (fd < fds.files + fds.pipes) target = TextF("pipe:[%d]", 40000 + index * 16 + fd);
+        else if (fd < fds.files + fds.pipes + fds.anonInodes) target = TextF("anon_inode:[eventfd]");
+        else target = TextF("socket:[%u]", fixtureSocketInode(index, fd));
+        if (symlink(target.c_str(), (fdDir + "/" + to_string(fd)).c_str()) != 0 && errno != EEXIST) return false;
+    }
+    return true;
+}
+
+static bool writeProcesses(const string& root, const FixtureSpec& spec, int step, double seconds) {
+    long long ticks = clockTicks();
+    for (int i = 0; i < spec.processes; ++i) {
+        int pid = fixturePid(i);
+        string dir = root + "/proc/" + to_string(pid);
+        if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) return false;
+
+        // split the process's CPU time 3:1 between user and kernel mode; the
+        // sum is what the collectors use
+        long long used = llround(fixtureExpectedProcessCPU(i) / 100.0 * ticks * seconds);
+        long long utime = 10 + i % 1000 + used - used / 4;
+        long long stime = 5 + i % 500 + used / 4;
+        long long vsize = (i % 64 + 1) * 4096LL * 1024;
+        long long rss = vsize / 4096 / 4;
+        char state = PROCESS_STATES[i % (sizeof(PROCESS_STATES) - 1)];
+
+        int parent = fixtureParentIndex(i);
+        int ppid = parent >= 0 ? fixturePid(parent) : 1;
+        if (!writeFile(dir + "/stat", statLine(pid, TextF("proc-%d", i).c_str(), state, ppid, utime, stime, 100 + i,
+                                               vsize, rss, i % spec.cpus)))
+            return false;
+        if (!spec.processDetails) continue;
+        long long rssKb = rss * 4, pss = fixtureExpectedPss(i);
+        // formatted in pieces, each fits a TextF buffer
+        string smaps = "00400000-7ffd2c5f1000 ---p 00000000 00:00 0                          [rollup]\n";
+        smaps += TextF("Rss:            %8lld kB\nPss:            %8lld kB\nPss_Anon:       %8lld kB\n"
+                       "Pss_File:       %8lld kB\nPss_Shmem:             0 kB\n",
+                       rssKb, pss, pss / 2, pss - pss / 2).c_str();
+        smaps += TextF("Shared_Clean:   %8lld kB\nShared_Dirty:          0 kB\nPrivate_Clean:         0 kB\n"
+                       "Private_Dirty:  %8lld kB\nReferenced:     %8lld kB\n",
+                       rssKb / 2, rssKb / 2, rssKb).c_str();
+        smaps += TextF("Anonymous:      %8lld kB\nSwap:           %8lld kB\nSwapPss:        %8lld kB\n"
+                       "Locked:                0 kB\n",
+                       rssKb / 2, fixtureExpectedSwap(i), fixtureExpectedSwap(i)).c_str();
+        if (!writeFile(dir + "/smaps_rollup", smaps) || !writeFds(dir, spec, i, step)) return false;
+
+        // rchar/wchar also count page cache hits, so they run ahead of the disk
+        ProcessIO io = fixtureExpectedProcessIO(i);
+        long long readBytes = 1 << 20, writeBytes = 1 << 19;
+        readBytes += llround(io.readBytesPerSec * seconds);
+        writeBytes += llround(io.writeBytesPerSec * seconds);
+        if (!writeFile(dir + "/io", TextF("rchar: %lld\nwchar: %lld\nsyscr: %lld\nsyscw: %lld\nread_bytes: %lld\n"
+                                          "write_bytes: %lld\ncancelled_write_bytes: %lld\n",
+                                          readBytes * 3, writeBytes * 2, 100 + llround(io.readCallsPerSec * seconds),
+                                          100 + llround(io.writeCallsPerSec * seconds), readBytes, writeBytes,
+                                          llround(io.cancelledWriteBytesPerSec * seconds)).c_str()))
+            return false;
+
+        for (int k = 0; k < fixtureThreadCount(i); ++k) {
+            ThreadUsage thread = fixtureExpectedThread(spec, i, k);
+            string taskDir = dir + "/task/" + to_string(thread.tid);
+            long long threadUsed = llround(thread.cpuPercent / 100.0 * ticks * seconds);
+            if (!makeDirs(taskDir) ||
+                !writeFile(taskDir + "/stat", statLine(thread.tid, thread.name, thread.state, ppid,
+                                                       10 + k + threadUsed - threadUsed / 4, 5 + threadUsed / 4,
+                                                       100 + i, vsize, rss, thread.processor)))
+                return false;
+        }
+    }
+    return true;
+}
+
+static bool writeNetwork(const string& root, const FixtureSpec& spec, double seconds) {
+    string text =
+        "Inter-|   Receive                                                |  Transmit\n"
+        " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n";
+    for (int j = 0; j < spec.interfaces; ++j) {
+        string name = fixtureInterfaceName(j);
+        long long rx = 1000000LL * (j + 1) + llround(fixtureExpectedRxRate(j) * seconds);
+        long long tx = 500000LL * (j + 1) + llround(fixtureExpectedTxRate(j) * seconds);
+        text += TextF("%6s: %lld %lld 0 0 0 0 0 0 %lld %lld 0 0 0 0 0 0\n",
+                      name.c_str(), rx, rx / 1000, tx, tx / 1000).c_str();
+        if (!makeDirs(root + "/sys/class/net/" + name)) return false;
+    }
+    return writeFile(root + "/proc/net/dev", text);
+}
+
+static bool writeSensors(const string& root, const FixtureSpec& spec, int step) {
+    for (int k = 0; k < spec.sensors; ++k) {
+        string hwmon = root + "/sys/class/hwmon/hwmon" + to_string(k);
+        string zone = root + "/sys/class/thermal/thermal_zone" + to_string(k);
+        int temp = 40000 + 1000 * k + (step % 10) * 100; // millidegrees
+        if (!makeDirs(hwmon) || !makeDirs(zone)) return false;
+        if (!writeFile(hwmon + "/name", k == 0 ? "coretemp\n" : TextF("sensor%d\n", k).c_str()) ||
+            !writeFile(hwmon + "/temp1_input", TextF("%d\n", temp).c_str()) ||
+            !writeFile(hwmon + "/fan1_input", TextF("%d\n", 1200 + 100 * k).c_str()) ||
+            !writeFile(zone + "/type", k == 0 ? "x86_pkg_temp\n" : "acpitz\n") ||
+            !writeFile(zone + "/temp", TextF("%d\n", temp).c_str())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Device 0 is an NVMe namespace, 1 its partition, 2 an LVM volume on top and the
+// rest SCSI disks (sda, sdb, ..., sdz, sdaa, ...). Every device runs a steady
+// load that scales with its index.
+DiskIO fixtureExpectedDisk(int index) {
+    DiskIO disk{};
+    if (index == 0) {
+        snprintf(disk.name, sizeof(disk.name), "nvme0n1");
+    } else if (index == 1) {
+        snprintf(disk.name, sizeof(disk.name), "nvme0n1p1");
+        disk.kind = DISK_PARTITION;
+    } else if (index == 2) {
+        snprintf(disk.name, sizeof(disk.name), "dm-0");
+        disk.kind = DISK_MAPPER;
+    } else {
+        char letters[8];
+        int length = 0;
+        for (int n = index - 3; length < 7; n = n / 26 - 1) {
+            letters[length++] = static_cast<char>('a' + n % 26);
+            if (n < 26) break;
+        }
+        int at = snprintf(disk.name, sizeof(disk.name), "sd");
+        while (length > 0) disk.name[at++] = letters[--length];
+        disk.name[at] = '\0';
+    }
+    snprintf(disk.label, sizeof(disk.label), "%s", index == 2 ? "vg0-root" : disk.name);
+    disk.major = index < 2 ? 259 : index == 2 ? 253 : 8;
+    disk.minor = index < 3 ? index : (index - 3) * 16;
+    disk.readIops = 100.0f * (index + 1);
+    disk.writeIops = 50.0f * (index + 1);
+    disk.readBytesPerSec = disk.readIops * 8192;
+    disk.writeBytesPerSec = disk.writeIops * 16384;
+    disk.readAwaitMs = 2.0f;
+    disk.writeAwaitMs = 4.0f;
+    disk.utilization = 25.0f;
+    disk.queueDepth = 1.5f;
+    disk.inFlight = index % 4;
+    return disk;
+}
+
+static bool writeDisks(const string& root, const FixtureSpec& spec, double seconds) {
+    string text;
+    for (int k = 0; k < spec.disks; ++k) {
+        DiskIO disk = fixtureExpectedDisk(k);
+        long long reads = 1000 + llround(disk.readIops * seconds);
+        long long writes = 500 + llround(disk.writeIops * seconds);
+        text += TextF("%4u %7u %s %lld 0 %lld %lld %lld 0 %lld %lld %u %lld %lld 0 0 0 0 0 0\n",
+                      disk.major, disk.minor, disk.name,
+                      reads, llround(reads * disk.readBytesPerSec / disk.readIops / 512),
+                      llround(reads * disk.readAwaitMs),
+                      writes, llround(writes * disk.writeBytesPerSec / disk.writeIops / 512),
+                      llround(writes * disk.writeAwaitMs), disk.inFlight,
+                      llround(seconds * disk.utilization * 10), llround(seconds * disk.queueDepth * 1000)).c_str();
+
+        string block = root + "/sys/class/block/" + disk.name;
+        if (!makeDirs(block)) return false;
+        if (disk.kind == DISK_PARTITION && !writeFile(block + "/partition", "1\n")) return false;
+        if (disk.kind == DISK_MAPPER && (!makeDirs(block + "/dm") || !writeFile(block + "/dm/name", string(disk.label) + "\n")))
+            return false;
+    }
+    return writeFile(root + "/proc/diskstats", text);
+}
+
+// Steady stall shares per resource; the averages are written as-is.
+Pressure fixtureExpectedPressure(PressureResource resource) {
+    static const float someShare[PRESSURE_RESOURCES] = {5.0f, 2.0f, 10.0f};
+    static const float fullShare[PRESSURE_RESOURCES] = {0.0f, 1.0f, 4.0f};
+    Pressure pressure{};
+    pressure.available = true;
+    pressure.some = PressureLine{someShare[resource], someShare[resource] * 0.8f, someShare[resource] * 0.5f, 0, someShare[resource]};
+    pressure.full = PressureLine{fullShare[resource], fullShare[resource] * 0.8f, fullShare[resource] * 0.5f, 0, fullShare[resource]};
+    return pressure;
+}
+
+static bool writePressure(const string& root, double seconds) {
+    static const char* const names[PRESSURE_RESOURCES] = {"cpu", "memory", "io"};
+    if (!makeDirs(root + "/proc/pressure")) return false;
+    for (int i = 0; i < PRESSURE_RESOURCES; ++i) {
+        Pressure pressure = fixtureExpectedPressure(static_cast<PressureResource>(i));
+        string text;
+        for (const auto& [kind, line] : {pair<const char*, PressureLine>{"some", pressure.some}, {"full", pressure.full}}) {
+            // recent is a percentage, total is in microseconds
+            long long total = 1000000 + llround(line.recent / 100.0 * seconds * 1e6);
+            text += TextF("%s avg10=%.2f avg60=%.2f avg300=%.2f total=%lld\n", kind, line.avg10, line.avg60,
+                          line.avg300, total).c_str();
+        }
+        if (!writeFile(root + "/proc/pressure/" + names[i], text)) return false;
+    }
+    return true;
+}
+
+// Cgroup 0 is the root, 1-3 are slices, and the rest are services spread over
+// the slices. Services run a steady load that scales with their index; slices and
+// the root add up their services, like the kernel's hierarchical counters.
+static const char* const FIXTURE_SLICES[] = {"machine.slice", "system.slice", "user.slice"};
+
+static int fixtureCgroupParent(int index) { return index < 4 ? 0 : 1 + (index - 4) % 3; }
+
+static CgroupUsage fixtureServiceCgroup(int index) {
+    CgroupUsage usage;
+    usage.path = TextF("%s/unit-%d.service", FIXTURE_SLICES[fixtureCgroupParent(index) - 1], index).c_str();
+    usage.depth = 2;
+    usage.cpuPercent = 1.0f + index % 7;
+    usage.throttledPercent = index % 4 == 0 ? 0.2f : 0.0f;
+    usage.memoryBytes = (64ull + index) << 20;
+    usage.anonBytes = usage.memoryBytes / 2;
+    usage.fileBytes = usage.memoryBytes / 4;
+    usage.kernelBytes = usage.memoryBytes / 8;
+    usage.highEvents = index % 3;
+    usage.oomKills = index % 10 == 0;
+    usage.readIops = index % 5;
+    usage.writeIops = 2.0f * (1 + index % 3);
+    usage.readBytesPerSec = usage.readIops * 8192;
+    usage.writeBytesPerSec = usage.writeIops * 8192;
+    return usage;
+}
+
+CgroupUsage fixtureExpectedCgroup(const FixtureSpec& spec, int index) {
+    CgroupUsage usage;
+    if (index >= 4) {
+        usage = fixtureServiceCgroup(index);
+    } else {
+        usage.path = index == 0 ? "" : FIXTURE_SLICES[index - 1];
+        usage.depth = index == 0 ? 0 : 1;
+        for (int i = 4; i < spec.cgroups; ++i) {
+            if (index != 0 && fixtureCgroupParent(i) != index) continue;
+            CgroupUsage service = fixtureServiceCgroup(i);
+            usage.cpuPercent += service.cpuPercent;
+            usage.memoryBytes += service.memoryBytes;
+            usage.anonBytes += service.anonBytes;
+            usage.fileBytes += service.fileBytes;
+            usage.kernelBytes += service.kernelBytes;
+            usage.highEvents += service.highEvents;
+            usage.oomKills += service.oomKills;
+            usage.readIops += service.readIops;
+            usage.writeIops += service.writeIops;
+            usage.readBytesPerSec += service.readBytesPerSec;
+            usage.writeBytesPerSec += service.writeBytesPerSec;
+        }
+        if (index == 0) usage.memoryBytes = 0; // the root has no memory.current
+    }
+    usage.cpuSomePressure = 0.5f * (index % 4);
+    usage.cpuFullPressure = 0.25f * (index % 2);
+    return usage;
+}
+
+static bool writeCgroups(const string& root, const FixtureSpec& spec, double seconds) {
+    string base = root + "/sys/fs/cgroup";
+    if (spec.cgroups > 0 && (!makeDirs(base) || !writeFile(base + "/cgroup.controllers", "cpuset cpu io memory pids\n")))
+        return false;
+    for (int i = 0; i < spec.cgroups; ++i) {
+        CgroupUsage usage = fixtureExpectedCgroup(spec, i);
+        string dir = usage.path.empty() ? base : base + "/" + usage.path;
+        long long usageUsec = 1000000 + llround(usage.cpuPercent * 1e4 * seconds);
+        long long throttledUsec = llround(usage.throttledPercent * 1e4 * seconds);
+        // reads go to one device and writes to another, so io.stat lines have to be added up
+        long long reads = 100 + llround(usage.readIops * seconds);
+        long long writes = 100 + llround(usage.writeIops * seconds);
+        if (!makeDirs(dir) ||
+            !writeFile(dir + "/cpu.stat", TextF("usage_usec %lld\nuser_usec %lld\nsystem_usec %lld\nnr_periods 0\n"
+                                                "nr_throttled 0\nthrottled_usec %lld\n",
+                                                usageUsec, usageUsec * 3 / 4, usageUsec / 4, throttledUsec).c_str()) ||
+            !writeFile(dir + "/memory.stat", TextF("anon %llu\nfile %llu\nkernel %llu\nkernel_stack 16384\n"
+                                                   "pagetables 65536\nsock 0\nshmem 0\n",
+                                                   usage.anonBytes, usage.fileBytes, usage.kernelBytes).c_str()) ||
+            !writeFile(dir + "/memory.events", TextF("low 0\nhigh %llu\nmax 0\noom %llu\noom_kill %llu\n",
+                                                     usage.highEvents, usage.oomKills, usage.oomKills).c_str()) ||
+            !writeFile(dir + "/io.stat", TextF("8:0 rbytes=%lld wbytes=0 rios=%lld wios=0 dbytes=0 dios=0\n"
+                                               "259:0 rbytes=0 wbytes=%lld rios=0 wios=%lld dbytes=0 dios=0\n",
+                                               reads * 8192, reads, writes * 8192, writes).c_str()) ||
+            !writeFile(dir + "/cpu.pressure", TextF("some avg10=%.2f avg60=0.00 avg300=0.00 total=0\n"
+                                                    "full avg10=%.2f avg60=0.00 avg300=0.00 total=0\n",
+                                                    usage.cpuSomePressure, usage.cpuFullPressure).c_str())) {
+            return false;
+        }
+        if (i > 0 && !writeFile(dir + "/memory.current", TextF("%llu\n", usage.memoryBytes).c_str())) return false;
+    }
+    return true;
+}
+
+// Mount points are directories inside the tree, so the mount workers statvfs()
+// whatever filesystem holds it. /proc is filtered out as a pseudo filesystem and
+// /srv/exports as a bind mount of /data; a space exercises mountinfo's escaping.
+static const char FIXTURE_MOUNTINFO[] =
+    "21 1 8:1 / / rw,relatime shared:1 - ext4 /dev/sda1 rw\n"
+    "22 21 0:20 / /proc rw,nosuid,nodev,noexec shared:2 - proc proc rw\n"
+    "23 21 8:17 / /data rw,noatime shared:3 - xfs /dev/sdb1 rw,attr2\n"
+    "24 21 8:17 /exports /srv/exports rw,noatime shared:3 - xfs /dev/sdb1 rw,attr2\n"
+    "25 21 0:45 / /mnt/nfs rw,relatime shared:4 - nfs4 fileserver:/export rw,vers=4.2\n"
+    "26 21 0:46 / /mnt/with\\040space rw shared:5 - tmpfs tmpfs rw,size=65536k\n";
+
+vector<string> fixtureMountPoints() { return {"/", "/data", "/mnt/nfs", "/mnt/with space"}; }
+
+static bool writeMounts(const string& root) {
+    for (const string& mountPoint : fixtureMountPoints())
+        if (!makeDirs(root + mountPoint)) return false;
+    return makeDirs(root + "/proc/self") && writeFile(root + "/proc/self/mountinfo", FIXTURE_MOUNTINFO);
+}
+
+bool writeFixtureTree(const string& root, const FixtureSpec& spec, int step) {
+    double seconds = step * spec.stepSeconds;
+    if (!makeDirs(root + "/proc/net") || !makeDirs(root + "/proc/sys/fs") || !makeDirs(root + "/sys/class")) return false;
+    FileHandles handles = fixtureExpectedFileHandles();
+    if (!writeFile(root + "/proc/sys/fs/file-nr", TextF("%lld\t0\t%lld\n", handles.allocated, handles.maximum).c_str()))
+        return false;
+    return writeProcStat(root, spec, seconds) &&
+           writeMeminfo(root, step) &&
+           writeProcesses(root, spec, step, seconds) &&
+           writeNetwork(root, spec, seconds) &&
+           writeSensors(root, spec, step) &&
+           writeDisks(root, spec, seconds) &&
+           writePressure(root, seconds) &&
+           writeCgroups(root, spec, seconds) &&
+           writeMounts(root);
+}
@@ -0,0 +1,59 @@
+#include "header.h"
+#include <cstring>
+
+// monitor-fixture: writes a synthetic /proc and /sys tree (see fixture.cpp) that
+// the monitor and monitor-bench can read with --root. Run it again with the
+// next --step to advance every counter by --dt seconds.
+
+static void usage() {
+    fprintf(stderr,
+            "usage: monitor-fixture --out DIR [--procs N] [--ifaces M] [--sensors K]\n"
+            "                       [--cpus C] [--disks D] [--cgroups G] [--step S] [--dt SECONDS]\n"
+            "                       [--stat-only]\n");
+}
+
+int main(int argc, char** argv) {
+    FixtureSpec spec;
+    const char* out = nullptr;
+    int step = 0;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--out") == 0 && hasValue) {
+            out = argv[++i];
+        } else if (strcmp(argv[i], "--procs") == 0 && hasValue) {
+            spec.processes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ifaces") == 0 && hasValue) {
+            spec.interfaces = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sensors") == 0 && hasValue) {
+            spec.sensors = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cpus") == 0 && hasValue) {
+            spec.cpus = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--disks") == 0 && hasValue) {
+            spec.disks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cgroups") == 0 && hasValue) {
+            spec.cgroups = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--step") == 0 && hasValue) {
+            step = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--dt") == 0 && hasValue) {
+            spec.stepSeconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--stat-only") == 0) {
+            spec.processDetails = false; // processes get /proc/<pid>/stat and nothing else
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!out || spec.processes < 0 || spec.interfaces < 0 || spec.sensors < 0 || spec.disks < 0 ||
+        spec.cgroups < 0 || spec.cpus < 1) {
+        usage();
+        return 2;
+    }
+
+    if (!writeFixtureTree(out, spec, step)) {
+        fprintf(stderr, "monitor-fixture: writing %s failed: %s\n", out, strerror(errno));
+        return 1;
+    }
+    printf("wrote %s: %d processes, %d interfaces, %d sensors, %d disks, %d cgroups, step %d (t=%.2fs)\n", out,
+           spec.processes, spec.interfaces, spec.sensors, spec.disks, spec.cgroups, step, step * spec.stepSeconds);
+    return 0;
+}
@@ -21,6 +21,9 @@
 // mostly in unix system
 // not sure if it will work in windows
 #include <cpuid.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // __rdtsc for trace timestamps
+#endif
 // this is for the memory usage and other memory visualization
 // for linux gotta find a way for windows
 #include <sys/types.h>
@@ -28,13 +31,28 @@
 #include <sys/statvfs.h>
 // for time and date
 #include <ctime>
+#include <chrono>
 // ifconfig ip addresses
 #include <sys/types.h>
 #include <ifaddrs.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/un.h>
 #include <map>
+#include <set>
 #include <sstream>
+// background sampling thread
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <poll.h>
+// fixed layout shared with other local processes
+#include "monitor_shm.h"
+#include "monitor_plugin.h"
 
 
 using namespace std;
@@ -54,60 +72,94 @@ struct CPUStats
 };
 
 // processes `stat`
+// Storage I/O of one process from /proc/<pid>/io, as rates over the interval
+// between its last two reads
+struct ProcessIO {
+    bool available = false; // read at least twice; another user's processes never are
+    float readBytesPerSec = 0.0f;  // read_bytes: fetched from storage
+    float writeBytesPerSec = 0.0f; // write_bytes: caused to be written back
+    float cancelledWriteBytesPerSec = 0.0f; // dirtied but truncated before writeback
+    float readCallsPerSec = 0.0f;  // syscr
+    float writeCallsPerSec = 0.0f; // syscw
+};
+
+// Open file descriptors of one process, by what /proc/<pid>/fd/<n> points to
+struct FdUsage {
+    int total = -1; // -1 until the process's fd directory has been listed
+    int sockets = 0, pipes = 0, files = 0, anonInodes = 0, other = 0;
+    float growthPerSec = 0.0f; // change of `total` between the last two listings
+};
+
+// /proc/sys/fs/file-nr: file handles allocated system-wide, and the limit
+struct FileHandles {
+    long long allocated = 0;
+    long long maximum = 0;
+};
+
 struct Proc
 {
     int pid;
+    int ppid;
     string name;
     char state;
     long long int vsize;
     long long int rss;
     long long int utime;
     long long int stime;
+    long long startTime; // clock ticks after boot; with the PID, names one process
+    float cpuPercent; // filled in by the sampler from utime/stime deltas
+    // kB from /proc/<pid>/smaps_rollup, filled in by SmapsTracker; -1 until it
+    // has been read (or when it can't be, as for other users' processes)
+    long long pss;
+    long long swap;
+    ProcessIO io; // filled in by ProcessIOTracker
+    FdUsage fds;  // filled in by FdTracker
+    // TCP payload bytes/s over the process's sockets, filled in by SocketTracker
+    float netReceiveRate;
+    float netSendRate;
+
+    // process tree, filled in by ProcessTree::update: indices into the same
+    // list, -1 for none; children are in PID order
+    int parent;
+    int firstChild;
+    int nextSibling;
+    float treeCPU;      // cpuPercent of the process and all its descendants
+    long long treeRss;  // rss of the same, in pages
+    int treeCount;      // processes in the subtree, the process itself included
 };
 
 struct IP4
 {
-    char *name;
+    char name[IFNAMSIZ];
     char addressBuffer[INET_ADDRSTRLEN];
 };
 
-// struct Networks
-// {
-//     vector<IP4> ip4s;
-//     ~Networks();
-
-// };
 struct Networks {
     std::vector<IP4> ip4s;
-    ~Networks() {
-        for (auto& ip4 : ip4s) {
-            free(ip4.name);
-        }
-    }
 };
 
 struct RX
 {
-    int bytes;
-    int packets;
-    int errs;
-    int drop;
-    int fifo;
-    int frame;
-    int compressed;
-    int multicast;
+    long long bytes;
+    long long packets;
+    long long errs;
+    long long drop;
+    long long fifo;
+    long long frame;
+    long long compressed;
+    long long multicast;
 };
 
 struct TX
 {
-    int bytes;
-    int packets;
-    int errs;
-    int drop;
-    int fifo;
-    int colls;
-    int carrier;
-    int compressed;
+    long long bytes;
+    long long packets;
+    long long errs;
+    long long drop;
+    long long fifo;
+    long long colls;
+    long long carrier;
+    long long compressed;
 };
 
 
@@ -119,20 +171,492 @@ struct MemoryInfo {
     float total_swap;  // Total swap in GB
     float used_swap;   // Used swap in GB
     float swap_percent; // Percentage of swap used
+    unsigned long mem_total_kb;     // raw /proc/meminfo values, for consumers that
+    unsigned long mem_available_kb; // want exact numbers rather than rounded GB
+    unsigned long swap_total_kb;
+    unsigned long swap_free_kb;
+
+    // the rest of /proc/meminfo that says something about memory pressure, in kB
+    // (HugePages_* are page counts). Keys the kernel doesn't have read as 0.
+    unsigned long mem_free_kb;
+    unsigned long buffers_kb;
+    unsigned long cached_kb;        // page cache, including shmem
+    unsigned long swap_cached_kb;
+    unsigned long shmem_kb;
+    unsigned long slab_kb;
+    unsigned long slab_reclaimable_kb;
+    unsigned long slab_unreclaimable_kb;
+    unsigned long dirty_kb;
+    unsigned long writeback_kb;
+    unsigned long anon_pages_kb;
+    unsigned long mapped_kb;
+    unsigned long commit_limit_kb;
+    unsigned long committed_as_kb;
+    unsigned long hugepages_total;
+    unsigned long hugepages_free;
+    unsigned long hugepages_reserved;
+    unsigned long hugepages_surplus;
+    unsigned long hugepage_size_kb;
 };
 
+// Where the RAM goes, as non-overlapping layers that add up to MemTotal. Shmem is
+// split out of Cached, and "Kernel" is whatever MemTotal leaves unaccounted for
+// (page tables, kernel stacks, vmalloc, ...).
+enum MemoryLayer {
+    MEMORY_ANON,
+    MEMORY_SHMEM,
+    MEMORY_PAGE_CACHE,
+    MEMORY_BUFFERS,
+    MEMORY_SLAB,
+    MEMORY_KERNEL,
+    MEMORY_FREE,
+    MEMORY_LAYER_COUNT
+};
+
+const char* memoryLayerName(MemoryLayer layer);
+void memoryComposition(const MemoryInfo& mem, float layersKb[MEMORY_LAYER_COUNT]);
+
 
 struct DiskInfo {
     float total_space;   // Total disk space in GB
     float used_space;    // Used disk space in GB
     float usage_percent; // Percentage of disk used
+    unsigned long long total_bytes;
+    unsigned long long used_bytes;
+};
+
+DiskInfo makeDiskInfo(unsigned long long totalBytes, unsigned long long usedBytes);
+
+// One mounted filesystem from /proc/self/mountinfo and its last statvfs().
+enum MountState {
+    MOUNT_PENDING, // not sampled yet
+    MOUNT_OK,
+    MOUNT_HUNG,    // statvfs() has been running longer than MountTracker::TIMEOUT
+    MOUNT_STALE,   // ESTALE, or the values are older than MountTracker::STALE_AGE
+    MOUNT_ERROR,   // statvfs() failed; see error
+};
+
+const char* mountStateName(MountState state);
+
+struct MountUsage {
+    int id = 0; // mount ID, first field of mountinfo
+    string mountPoint;
+    string fsType;
+    string source;
+    MountState state = MOUNT_PENDING;
+    int error = 0;    // errno of the last failed statvfs()
+    float age = 0.0f; // seconds since the values below were read
+    unsigned long long totalBytes = 0;
+    unsigned long long usedBytes = 0;
+    unsigned long long availableBytes = 0; // for unprivileged users
+    unsigned long long totalInodes = 0;
+    unsigned long long usedInodes = 0;
+};
+
+// Keeps the mount list and every filesystem's usage current without ever calling
+// statvfs() on the caller's thread: a hung NFS server blocks one pool worker, not
+// the sampler. mountinfo is re-read only after poll() reports POLLPRI on it.
+class MountTracker {
+public:
+    struct Pool; // shared with the workers, and outlives any that are stuck
+
+private:
+    shared_ptr<Pool> pool;
+    int mountinfoFd = -1;
+    unsigned mountinfoRoot = 0; // monitorRootGeneration() that mountinfoFd was opened under
+    vector<char> mountinfo;
+
+    bool mountsChanged();
+    void readMounts();
+
+public:
+    static constexpr int WORKERS = 2;        // workers kept free for healthy mounts
+    static constexpr int MAX_WORKERS = 8;    // cap, including workers stuck on hung mounts
+    static constexpr double INTERVAL = 2.0;  // seconds between statvfs() calls per mount
+    static constexpr double TIMEOUT = 2.0;   // a statvfs() running this long marks the mount hung
+    static constexpr double STALE_AGE = 3 * INTERVAL;
+
+    MountTracker();
+    MountTracker(const MountTracker&) = delete;
+    MountTracker& operator=(const MountTracker&) = delete;
+    ~MountTracker();
+    // queues the statvfs() calls that are due and copies the latest results into
+    // `mounts`, reusing its elements; never blocks on a filesystem
+    void update(vector<MountUsage>& mounts);
+};
+
+// Block device I/O from /proc/diskstats, as rates over the last update interval.
+enum DiskKind {
+    DISK_WHOLE,     // a whole disk, NVMe namespace, md array, ...
+    DISK_PARTITION, // counted in its parent disk as well
+    DISK_MAPPER,    // device-mapper (LVM, dm-crypt, multipath)
+    DISK_VIRTUAL,   // loop, ram and zram devices
+};
+
+const char* diskKindName(DiskKind kind);
+
+struct DiskIO {
+    char name[32];  // kernel name: sda, nvme0n1p2, dm-0
+    char label[64]; // device-mapper name (vg0-root) where there is one, else the kernel name
+    DiskKind kind;
+    unsigned major, minor;
+    float readBytesPerSec, writeBytesPerSec;
+    float readIops, writeIops;
+    float readAwaitMs, writeAwaitMs; // average time per completed request, queueing included
+    float utilization;               // % of the interval with at least one request in flight
+    float queueDepth;                // average requests in flight over the interval
+    unsigned inFlight;               // requests in flight right now
+    unsigned long long readBytes, writtenBytes; // since boot
+};
+
+class DiskStatsTracker {
+private:
+    // what the previous read left, in /proc/diskstats order like the output
+    struct Device {
+        unsigned major, minor;
+        unsigned long long readsCompleted, sectorsRead, msReading;
+        unsigned long long writesCompleted, sectorsWritten, msWriting;
+        unsigned long long msDoingIo, weightedMs;
+    };
+    vector<Device> devices;
+    vector<DiskIO> current; // parallel to devices; copied out, since callers may pass any vector
+    vector<char> text;      // last read of /proc/diskstats, reused between reads
+    double lastTime = -1;
+
+public:
+    // one pass over /proc/diskstats; `disks` keeps one element per device in
+    // kernel order and is reused, so a steady device list costs no allocations
+    void update(vector<DiskIO>& disks);
+};
+
+// Pressure Stall Information from /proc/pressure (Linux 4.20+ with PSI enabled).
+enum PressureResource { PRESSURE_CPU, PRESSURE_MEMORY, PRESSURE_IO, PRESSURE_RESOURCES };
+
+const char* pressureResourceName(PressureResource resource);
+
+struct PressureLine {
+    float avg10, avg60, avg300; // % of time stalled, averaged by the kernel
+    unsigned long long total;   // stalled time since boot, in microseconds
+    float recent;               // % of the last sampling interval spent stalled, from `total`
+};
+
+struct Pressure {
+    bool available; // false without CONFIG_PSI, or when booted with psi=0
+    PressureLine some; // at least one task stalled
+    PressureLine full; // all non-idle tasks stalled at once (always 0 for cpu before 5.13)
+};
+
+// One PSI trigger firing: the stall threshold was crossed within the trigger's window
+struct StallEvent {
+    PressureResource resource;
+    float time;      // sampler time (SystemSnapshot::time) when poll() returned
+    double wallTime; // CLOCK_REALTIME seconds, for display
+    float avg10;     // the resource's "some" avg10 right after the event
+};
+
+// Sets the trigger armed on each /proc/pressure file, in the kernel's
+// "<some|full> <stall us> <window us>" form; "" disables triggers.
+void setPressureTrigger(const string& trigger);
+const string& pressureTrigger();
+// parses the text of a pressure file (also cgroup v2's *.pressure); modifies `text`
+bool parsePressure(char* text, Pressure& out);
+
+class PressureTracker {
+private:
+    unsigned long long lastTotals[PRESSURE_RESOURCES][2] = {};
+    double lastTime = -1;
+    int triggerFds[PRESSURE_RESOURCES] = {-1, -1, -1};
+    StallEvent events[64]; // ring of the most recent events
+    size_t eventCount = 0; // events ever recorded
+
+public:
+    static constexpr size_t MAX_EVENTS = sizeof(events) / sizeof(events[0]);
+
+    PressureTracker() = default;
+    PressureTracker(const PressureTracker&) = delete;
+    PressureTracker& operator=(const PressureTracker&) = delete;
+    ~PressureTracker();
+    void read(Pressure pressure[PRESSURE_RESOURCES]);
+    // registers `trigger` on every resource; returns how many accepted it
+    int armTriggers(const string& trigger);
+    void disarmTriggers();
+    // adds a POLLPRI entry per armed trigger to `fds`; returns how many
+    int addPollFds(pollfd* fds, int capacity) const;
+    // records an event for every trigger entry with POLLPRI set in revents and
+    // disarms those with POLLERR or POLLNVAL
+    void handlePollFds(const pollfd* fds, int count, float time);
+    // the most recent events, oldest first
+    void copyEvents(vector<StallEvent>& out) const;
+};
+
+// cgroup v2 accounting from /sys/fs/cgroup, one entry per control group
+struct CgroupUsage {
+    string path;            // relative to the cgroup2 mount, "" for the root
+    int depth = 0;          // 0 for the root; a cgroup's subtree follows it with larger depths
+    float cpuPercent = 0.0f;       // of one CPU, descendants included (cpu.stat usage_usec)
+    float throttledPercent = 0.0f; // share of the interval spent throttled by cpu.max
+    unsigned long long memoryBytes = 0; // memory.current; the root has none
+    unsigned long long anonBytes = 0, fileBytes = 0, kernelBytes = 0; // from memory.stat
+    unsigned long long highEvents = 0, maxEvents = 0, oomKills = 0;   // memory.events, since creation
+    float readBytesPerSec = 0.0f, writeBytesPerSec = 0.0f; // io.stat, summed over devices
+    float readIops = 0.0f, writeIops = 0.0f;
+    float cpuSomePressure = 0.0f, cpuFullPressure = 0.0f; // cpu.pressure avg10
+};
+
+// Walks the cgroup2 hierarchy once, then follows it through inotify: only the
+// directory that gained or lost a child is listed again. Every cgroup's interface
+// files stay open and are re-read with pread(), as long as the open-file limit
+// allows; the rest are opened per read.
+class CgroupTracker {
+private:
+    static constexpr int FILES = 6; // the interface files read, see cgroups.cpp
+
+    struct Node {
+        CgroupUsage usage;
+        int wd = -1;       // inotify watch on the directory
+        int fds[FILES];    // open interface files, or NOT_OPEN / MISSING
+        bool sampled = false; // the counters below are from a previous read
+        unsigned long long usageUsec = 0, throttledUsec = 0;
+        unsigned long long readBytes = 0, writtenBytes = 0, reads = 0, writes = 0;
+    };
+    vector<Node> nodes; // preorder: each cgroup is followed by its subtree
+    string base;        // the cgroup2 mount below the monitor root, "" without one
+    unsigned baseRoot = 0; // monitorRootGeneration() that base was found under
+    int inotifyFd = -1;
+    bool watching = false;  // every directory has a watch; otherwise rescan periodically
+    int cachedFds = 0;
+    int fdBudget = 0;
+    double lastTime = -1;
+    double lastRescan = -1;
+    vector<char> text;      // file contents, reused between reads
+    vector<int> changedWds; // directories with inotify events, reused between updates
+
+    void reset();
+    void release(Node& node);
+    size_t subtreeEnd(size_t index) const;
+    void rescan(size_t index, bool deep);
+    void scanChildren(const string& path, int depth, size_t oldBegin, size_t oldEnd, bool deep, vector<Node>& out);
+    Node makeNode(const string& path, int depth);
+    void handleEvents();
+    ssize_t readFile(Node& node, int file);
+    void readNode(Node& node, double seconds);
+
+public:
+    // without inotify the tree is walked again this often; files that were
+    // missing (controller not enabled) are retried at the same pace
+    static constexpr double RESCAN_INTERVAL = 10.0;
+
+    CgroupTracker() = default;
+    CgroupTracker(const CgroupTracker&) = delete;
+    CgroupTracker& operator=(const CgroupTracker&) = delete;
+    ~CgroupTracker();
+    // reads every cgroup's accounting; `cgroups` is filled in tree order and its
+    // elements are reused, so a steady hierarchy costs no allocations
+    void update(vector<CgroupUsage>& cgroups);
+};
+
+// io_uring is used where the kernel allows it unless this turns it off (--no-io-uring)
+void setIoUringAllowed(bool allowed);
+bool ioUringAllowed();
+
+// Reads the start of many open files with as few system calls as possible.
+// Reads are queued with add() and done by run() a window at a time: through
+// io_uring, one io_uring_enter() queues the whole window and waits for it, into
+// a buffer registered with the kernel once; without it (an old kernel, a seccomp
+// filter, --no-io-uring) each is a pread(). Either way the window's results are
+// handed to the caller before the next window reuses the buffer.
+class ReadBatch {
+private:
+    struct Ring; // readbatch.cpp
+    vector<int> fds;      // queued reads, in order
+    vector<int> results;  // of the current window: bytes read or -errno
+    vector<char> buffers; // window slots of readSize bytes each
+    vector<char> retired; // the buffer of a ring that failed, which reads may still land in
+    size_t readSize;
+    unsigned window;
+    unsigned ioWorkers;   // cap on the ring's io-wq threads
+    unique_ptr<Ring> ring;
+    bool ringFailed = false; // setup failed or the kernel refused a read; pread from now on
+    unsigned long long calls = 0;
+
+    void runWindow(size_t first, size_t count);
+    bool submit(size_t first, size_t count);
+
+public:
+    // reads of up to readSize - 1 bytes, `window` of them at a time; the
+    // kernel runs them on up to ioWorkers threads, 0 for processScanWorkers()
+    ReadBatch(size_t readSize, unsigned window, unsigned ioWorkers = 0);
+    ReadBatch(const ReadBatch&) = delete;
+    ReadBatch& operator=(const ReadBatch&) = delete;
+    ~ReadBatch();
+    void clear() { fds.clear(); }
+    void add(int fd) { fds.push_back(fd); }
+    size_t size() const { return fds.size(); }
+    // whether run() goes through io_uring; sets the ring up on first use
+    bool usesRing();
+    // Reads everything queued, from offset 0, and calls consume(index, text,
+    // length) for each in the order they were added. `text` is NUL-terminated
+    // and only valid during the call; length is -errno if the read failed.
+    template <typename Consume>
+    void run(Consume&& consume) {
+        for (size_t first = 0; first < fds.size(); first += window) {
+            size_t count = min<size_t>(window, fds.size() - first);
+            runWindow(first, count);
+            for (size_t i = 0; i < count; ++i)
+                consume(first + i, buffers.data() + i * readSize, static_cast<ssize_t>(results[i]));
+        }
+    }
+    // system calls made so far: io_uring_enter() or pread()
+    unsigned long long syscalls() const { return calls; }
+};
+
+// Reads /proc/<pid>/stat into `process`, resetting the fields other collectors
+// fill in; false if the process exited since it was listed. `fd` is the file
+// ProcessStatFiles holds open for it, or -1; if that no longer reads (the PID
+// has been reused) it is set to ProcessStatFiles::STALE and the file is opened
+// by path instead.
+bool readProcess(int pid, int& fd, Proc& process);
+// same, from a stat line that has already been read
+bool parseProcess(int pid, const char* line, Proc& process);
+// Reads pids[begin, end) into processes[used...] in PID order: the held files
+// through `reads`, a window at a time, the others by path in between. Returns
+// the new count of processes used.
+size_t readProcessesBatched(ReadBatch& reads, const vector<int>& pids, vector<int>& fds, size_t begin, size_t end,
+                            vector<Proc>& processes, size_t used);
+
+// Share of the machine's CPUs the /proc scan may use (--scan-share); the number
+// of scan threads, the caller included, is that many CPUs, at least one and at
+// most ProcessScanPool::MAX_WORKERS
+void setProcessScanShare(double share);
+int processScanWorkers();
+
+// Parses the stat files of a PID list on several threads. The list is cut into
+// chunks; each worker starts on an even share of them and, once through, takes
+// what is left of the others' shares, so a worker slowed down by a few large
+// processes or by the scheduler doesn't hold up the scan. Workers write into
+// buffers of their own and note where each chunk went; the caller joins in as
+// worker 0 and, once all are done, swaps the results into place in chunk order,
+// so the list comes out in /proc order without any locking around the parsing.
+// Where io_uring is there, each worker reads its chunk's held files through a
+// ring of its own, with one io-wq thread.
+class ProcessScanPool {
+public:
+    static constexpr int MAX_WORKERS = 8;
+    static constexpr size_t CHUNK = 256;          // PIDs a worker takes at a time
+    static constexpr size_t PARALLEL_MIN = 2048;  // fewer are parsed by the caller alone
+
+private:
+    struct Worker {
+        vector<Proc> out;          // reused; elements past `used` are spares
+        size_t used = 0;
+        unique_ptr<ReadBatch> reads; // its chunks' held stat files, when io_uring is there
+        std::atomic<size_t> next;  // its share's next chunk, taken by it or by a thief
+        size_t end = 0;            // one past its share's last chunk
+    };
+    struct ChunkResult {
+        int worker;
+        unsigned first, count; // range of that worker's `out`
+    };
+    vector<unique_ptr<Worker>> workers; // [0] is the calling thread
+    vector<std::thread> threads;        // threads[i] runs workers[i + 1]
+    vector<ChunkResult> chunks;
+    const vector<int>* pids = nullptr;
+    vector<int>* fds = nullptr;
+    std::mutex lock;
+    std::condition_variable wake, finished;
+    unsigned long long round = 0; // bumped for every scan, which wakes the threads
+    int busy = 0;                 // threads still working on this round
+    bool stopping = false;
+    int threadsUsed = 0;          // of the last scan
+
+    void threadMain(int self, unsigned long long seen);
+    void work(int self);
+    void parseChunk(Worker& worker, int self, size_t chunk);
+    void stopThreads();
+
+public:
+    ProcessScanPool() = default;
+    ProcessScanPool(const ProcessScanPool&) = delete;
+    ProcessScanPool& operator=(const ProcessScanPool&) = delete;
+    ~ProcessScanPool();
+    void setWorkers(int count); // the caller included
+    int size() const { return static_cast<int>(workers.size()); }
+    // refills `processes` with the ones in `pids` that could be read, in order;
+    // fds[i] is pids[i]'s held stat file, see readProcess()
+    void scan(const vector<int>& pids, vector<int>& fds, vector<Proc>& processes);
+    // threads that parsed at least one chunk of the last scan
+    int lastScanThreads() const { return threadsUsed; }
+    // system calls the workers made reading held stat files through io_uring
+    unsigned long long batchedReadSyscalls() const;
+};
+
+// Keeps /proc/<pid>/stat open between scans, so reading a process costs one
+// read instead of an open, a read and a close, within an eighth of the
+// open-file limit. A held file stays tied to the process it was opened for:
+// once that exits, reads fail instead of showing whatever reuses the PID.
+class ProcessStatFiles {
+public:
+    static constexpr int STALE = -2; // a held file that stopped reading, see readProcess()
+
+private:
+    struct Held {
+        int pid;
+        int fd;
+    };
+    vector<Held> held;   // by PID
+    vector<Held> opened; // this scan's, merged into `held` afterwards
+    int budget = -1;     // worked out on first use, unless set
+    unsigned rootGeneration = 0;
+
+    void closeAll();
+
+public:
+    ProcessStatFiles() = default;
+    ProcessStatFiles(const ProcessStatFiles&) = delete;
+    ProcessStatFiles& operator=(const ProcessStatFiles&) = delete;
+    ~ProcessStatFiles() { closeAll(); }
+    // Sets fds[i] to pids[i]'s held file, opening it if the budget allows,
+    // or -1; closes those of processes no longer listed. `pids` is sorted.
+    void match(const vector<int>& pids, vector<int>& fds);
+    // closes the files marked STALE during the scan, so they are reopened next time
+    void dropStale(const vector<int>& pids, const vector<int>& fds);
+    void setBudget(int files) { budget = files; }
+    int heldCount() const { return static_cast<int>(held.size()); }
 };
 
 class SystemResourceTracker {
+private:
+    DIR* procDir = nullptr; // kept open and rewound for every scan instead of reopened
+    unsigned procDirRoot = 0; // monitorRootGeneration() that procDir was opened under
+    vector<int> pids;       // from the last readdir() pass, sorted
+    vector<int> statFds;    // pids[i]'s held stat file, see ProcessStatFiles
+    ProcessStatFiles statFiles;
+    ReadBatch statReads{STAT_READ_SIZE, 1024}; // the held files of a short list, when io_uring is there
+    ProcessScanPool scanPool;
+    int scanWorkers = 0;    // fixed by setScanWorkers(); 0 follows processScanWorkers()
+    int scanThreads = 0;    // that took part in the last scan
+
 public:
+    SystemResourceTracker() = default;
+    SystemResourceTracker(const SystemResourceTracker&) = delete;
+    SystemResourceTracker& operator=(const SystemResourceTracker&) = delete;
+    ~SystemResourceTracker();
     MemoryInfo getMemoryInfo();
     DiskInfo getDiskInfo();
     vector<Proc> getProcessList();
+    // refills `processes`, reusing its elements, so a steady process count costs no allocations
+    void getProcessList(vector<Proc>& processes);
+    // scan threads, the caller included, regardless of --scan-share (for the benchmark)
+    void setScanWorkers(int count) { scanWorkers = count; }
+    // stat files held open, regardless of the open-file limit (for the benchmark)
+    void setStatFileBudget(int files) { statFiles.setBudget(files); }
+    int heldStatFiles() const { return statFiles.heldCount(); }
+    // system calls made reading held stat files through io_uring, by the scan pool too
+    unsigned long long batchedReadSyscalls() const { return statReads.syscalls() + scanPool.batchedReadSyscalls(); }
+    // threads that took part in the last scan
+    int lastScanThreads() const { return scanThreads; }
+
+    static constexpr size_t STAT_READ_SIZE = 1024; // a stat line, with room to spare
 };
 
 class CPUUsageTracker {
@@ -148,41 +672,1021 @@ public:
 
 class ProcessUsageTracker {
     private:
-        map<int, pair<long long, long long>> lastProcessCPUTime;
+        map<int, pair<long long, long long>> lastProcessCPUTime; // pid -> (CPU jiffies, sample time in ms)
         float deltaTime;
         float updateInterval;
-        float lastUpdateTime;
         map<int, float> cpuUsageCache;
+        vector<int> alivePids; // scratch for forgetExited, kept to reuse its capacity
     
     public:
         ProcessUsageTracker();
         float calculateProcessCPUUsage(const Proc& process, float currentTime); // No change needed, just context
         void updateDeltaTime(float dt);
+        void setUpdateInterval(float seconds);
+        void forgetExited(const vector<Proc>& processes);
+    };
+
+// Parent/child index over the process list, with CPU%, RSS and process counts
+// summed over every subtree. It is kept between updates and only changed where
+// processes started, exited, were reparented or changed their own values.
+class ProcessTree {
+private:
+    struct Node {
+        int pid = 0; // 0 for a free slot
+        int ppid = 0;
+        int parent = -1, firstChild = -1, nextSibling = -1, prevSibling = -1; // slots
+        double cpu = 0, treeCPU = 0; // double, so adding and removing deltas doesn't drift
+        long long rss = 0, treeRss = 0;
+        int treeCount = 1;
+        int listIndex = -1; // position in the list given to update(), -1 once exited
+    };
+    vector<Node> nodes;
+    vector<int> freeSlots;
+    map<int, int> slots;    // pid -> slot
+    vector<int> listSlots;  // slot of every process in the list, reused
+
+    int slotOf(int pid) const;
+    void addToPath(int slot, double cpu, long long rss, int count);
+    void detach(int slot);
+    void attach(int slot, int parentSlot);
+
+public:
+    // links `processes` into the tree and fills in their tree fields
+    void update(vector<Proc>& processes);
+};
+
+// Proportional set size and swap of every process. smaps_rollup walks the whole
+// address space, so reading it for each process every second would cost more
+// than the rest of the sampler together. Each update reads what fits in a time
+// budget: rows on screen first, then the largest processes by RSS, then the
+// rest in turn, carrying the last values over for everything not read.
+class SmapsTracker {
+private:
+    struct Entry {
+        long long pss = -1, swap = -1;
+        unsigned long long readPass = 0; // update that last read it, 0 for never
+        unsigned long long seenPass = 0; // update that last found the process
+        long long startTime = -1;         // Proc::startTime, to tell a reused PID
+        bool denied = false;              // another user's process; not retried
     };
+    map<int, Entry> entries; // pid ->
+    unsigned long long pass = 0;
+    int nextPid = 0;         // where the round-robin continues
+    double budget = 0.002;   // seconds of reading per update
+    vector<int> largest;     // scratch: indices into the process list by RSS
+    vector<char> buffer;     // last file read, reused
+
+    void read(int pid, Entry& entry);
+
+public:
+    static constexpr int TOP_PROCESSES = 32; // read right after the visible rows
+
+    void setBudget(double seconds) { budget = seconds; }
+    // reads some processes' smaps_rollup and fills in pss and swap for all of
+    // `processes`; `visible` are the PIDs on screen
+    void update(vector<Proc>& processes, const vector<int>& visible);
+    // fills in pss and swap from the last reads, without reading anything
+    void apply(vector<Proc>& processes) const;
+};
+
+// Reads /proc/<pid>/io round-robin in PID order, as many as fit in a budget of
+// system calls per update. Each process's file stays open and is re-read with
+// pread(), one call instead of three, within a quarter of the open-file limit;
+// with io_uring the open files of one update are read in a single batch.
+class ProcessIOTracker {
+private:
+    static constexpr size_t IO_READ_SIZE = 512;
+
+    struct Counters {
+        unsigned long long readBytes = 0, writeBytes = 0, cancelledWriteBytes = 0;
+        unsigned long long readCalls = 0, writeCalls = 0;
+    };
+    struct Entry {
+        int fd = -1;
+        bool denied = false; // /proc/<pid>/io needs ptrace access; not retried
+        Counters last;
+        double lastTime = -1; // monitorClock() of the last read
+        ProcessIO io;
+        unsigned long long seenPass = 0;
+    };
+    map<int, Entry> entries; // pid ->
+    unsigned long long pass = 0;
+    int nextPid = 0; // where the round-robin continues
+    int cachedFds = 0;
+    int fdBudget = -1; // worked out on the first update
+    unsigned rootGeneration = 0;
+    ReadBatch reads{IO_READ_SIZE, 1024}; // this update's reads of open files
+    vector<Entry*> queued;               // whose they are
+
+    int read(int pid, Entry& entry, double now);
+    void parse(Entry& entry, char* text, ssize_t length, double now);
+    void forget(Entry& entry);
+
+public:
+    ProcessIOTracker() = default;
+    ProcessIOTracker(const ProcessIOTracker&) = delete;
+    ProcessIOTracker& operator=(const ProcessIOTracker&) = delete;
+    ~ProcessIOTracker();
+    // reads the next processes' counters and fills in `io` for all of `processes`
+    void update(vector<Proc>& processes);
+    // fills in `io` from the last reads, without reading anything
+    void apply(vector<Proc>& processes) const;
+};
+
+// system calls ProcessIOTracker may spend per update (--io-budget)
+void setProcessIOBudget(int syscalls);
+int processIOBudget();
+
+// Socket inode -> PID of the process holding it, filled in from the fd
+// listings. Open addressing with linear probing in one array, so adding and
+// removing owners doesn't allocate once the table has grown to size. A socket
+// shared by several processes (a listener inherited by forked workers) belongs
+// to whichever was listed first.
+class SocketOwnerTable {
+private:
+    struct Slot {
+        unsigned inode; // 0 for a free slot
+        int pid;
+    };
+    vector<Slot> slots; // a power of two in size, at most half full
+    size_t used = 0;
+
+    size_t home(unsigned inode) const { return (inode * 2654435761u) & (slots.size() - 1); }
+    void grow();
+
+public:
+    void insert(unsigned inode, int pid); // keeps an existing owner
+    void erase(unsigned inode, int pid);  // only if `pid` is the owner
+    int find(unsigned inode) const;       // -1 if unknown
+    void clear();
+    size_t size() const { return used; }
+};
+
+// Counts every process's open file descriptors by type: getdents64() on
+// /proc/<pid>/fd and readlinkat() on each entry. A process with many fds can't
+// be listed in one go, so an update stops when its system call budget is spent
+// and the next one carries on in the same directory. Counts are kept per
+// (PID, start time) until the process is listed again.
+class FdTracker {
+private:
+    struct Entry {
+        long long startTime = -1;
+        bool denied = false; // /proc/<pid>/fd needs ptrace access; not retried
+        FdUsage usage;       // from the last complete listing
+        double listedAt = -1;
+        unsigned long long seenPass = 0;
+        vector<unsigned> sockets; // socket inodes of the last complete listing, sorted
+    };
+    map<int, Entry> entries; // pid ->
+    unsigned long long pass = 0;
+    int nextPid = 0;  // where the round-robin continues
+    int syscallBudget = DEFAULT_BUDGET;
+    // the listing in progress
+    int scanPid = -1;
+    int scanFd = -1;
+    FdUsage scanCounts;
+    vector<unsigned> scanSockets;
+    vector<char> buffer; // getdents64 records, reused
+    SocketOwnerTable owners;
+    unsigned rootGeneration = 0;
+
+    void stopScan();
+    bool scan(int pid, Entry& entry, int& calls);
+    void setSockets(int pid, Entry& entry, vector<unsigned>& sockets);
+
+public:
+    static constexpr int DEFAULT_BUDGET = 2048; // system calls per update
+
+    FdTracker() = default;
+    FdTracker(const FdTracker&) = delete;
+    FdTracker& operator=(const FdTracker&) = delete;
+    ~FdTracker();
+    void setBudget(int syscalls) { syscallBudget = max(1, syscalls); }
+    // lists the next processes' fds and fills in `fds` for all of `processes`
+    void update(vector<Proc>& processes);
+    // fills in `fds` from the last listings, without listing anything
+    void apply(vector<Proc>& processes) const;
+    // PID of the process with socket `inode` open as of its last listing, or -1
+    int socketOwner(unsigned inode) const { return owners.find(inode); }
+};
+
+bool readFileHandles(FileHandles& out);
+
+// One thread of a watched process, from /proc/<pid>/task/<tid>/stat
+struct ThreadUsage {
+    int pid = 0;
+    int tid = 0;
+    char name[16] = ""; // comm, which the kernel limits to 15 characters
+    char state = 0;
+    int processor = -1;      // CPU the thread last ran on
+    float cpuPercent = 0.0f; // of one core
+};
+
+// Threads of a few processes, the ones selected in the process list. Nothing is
+// read for any other process; the task directories of the watched ones stay open
+// and the per-thread CPU times from the last update are kept sorted by TID. An
+// empty watch list closes and frees all of it.
+class ThreadTracker {
+private:
+    struct Watched {
+        int pid;
+        DIR* tasks; // /proc/<pid>/task, nullptr if it couldn't be opened
+    };
+    struct Sample {
+        int tid;
+        long long cpuTime; // utime + stime, in clock ticks
+    };
+    vector<Watched> watched;
+    vector<Sample> samples, nextSamples;
+    double lastTime = -1;
+    unsigned rootGeneration = 0;
+
+    void release();
+
+public:
+    ThreadTracker() = default;
+    ThreadTracker(const ThreadTracker&) = delete;
+    ThreadTracker& operator=(const ThreadTracker&) = delete;
+    ~ThreadTracker();
+    // fills `threads` with every thread of `pids`, busiest first within each process
+    void update(const vector<int>& pids, vector<ThreadUsage>& threads);
+};
+
+// One socket from NETLINK_SOCK_DIAG. States use the kernel's TCP numbering
+// (TCP_ESTABLISHED = 1 ... TCP_NEW_SYN_RECV = 12) for every protocol: an
+// unconnected UDP or Unix datagram socket is TCP_CLOSE.
+enum SocketProtocol : unsigned char { SOCKET_TCP, SOCKET_UDP, SOCKET_UNIX, SOCKET_PROTOCOLS };
+
+const char* socketProtocolName(SocketProtocol protocol);
+
+struct SocketInfo {
+    SocketProtocol protocol;
+    unsigned char family; // AF_INET, AF_INET6 or AF_UNIX
+    unsigned char state;
+    unsigned char unixType;   // SOCK_STREAM, SOCK_DGRAM or SOCK_SEQPACKET, Unix only
+    unsigned char localAddress[16], remoteAddress[16]; // network byte order; IPv4 uses the first 4
+    unsigned short localPort, remotePort;
+    unsigned inode;      // 0 for TIME_WAIT and SYN_RECV entries, which have no socket yet
+    unsigned peerInode;  // the other end of a connected Unix socket
+    unsigned receiveQueue, sendQueue; // bytes; for a listener, pending connections and the backlog
+    unsigned rttUs;       // smoothed RTT, TCP only
+    unsigned retransmits; // segments retransmitted over the connection's life, TCP only
+    // TCP payload bytes/s since the previous dump: tcp_info bytes_received and
+    // bytes_acked, so retransmissions aren't counted twice
+    float receiveRate, sendRate;
+    int pid;        // owner through FdTracker, -1 until its process has been listed (or for none)
+    int process;    // index of the owner in SystemSnapshot::processes, -1 for none
+    int nameOffset; // bound path of a Unix socket in SystemSnapshot::socketNames, -1 for none
+};
+
+const char* socketStateName(const SocketInfo& socket);
+
+// Dumps every TCP, UDP and Unix socket through NETLINK_SOCK_DIAG, which the
+// kernel answers from its socket hash tables in binary; /proc/net/tcp is text
+// that gets slower per line as the table grows. One netlink socket and one
+// receive buffer are kept for all dumps.
+//
+// TCP byte counters are kept from one dump to the next, sorted by inode, and
+// their differences summed per owning process. A socket that appeared since
+// the last dump counts all its bytes; one that closed in between loses what it
+// moved after that dump. UDP has no per-socket counters and isn't attributed.
+class SocketTracker {
+private:
+    struct Transferred {
+        unsigned inode;
+        int socket; // index in this dump's list
+        unsigned long long received, acked;
+    };
+    int netlinkFd = -1;
+    vector<char> buffer;
+    vector<pair<int, int>> processIndex; // (pid, index in the process list), sorted by pid
+    size_t count = 0;                    // sockets filled in so far by this update
+    vector<Transferred> transferred, lastTransferred; // TCP counters of this and the last dump
+    double lastTime = -1;
+
+    bool dump(const void* request, size_t length, vector<SocketInfo>& sockets, vector<char>& names);
+    SocketInfo& next(vector<SocketInfo>& sockets);
+
+public:
+    static constexpr size_t BUFFER_SIZE = 64 * 1024; // receive buffer, a few hundred sockets per recv()
+
+    SocketTracker() = default;
+    SocketTracker(const SocketTracker&) = delete;
+    SocketTracker& operator=(const SocketTracker&) = delete;
+    ~SocketTracker();
+    // refills `sockets` and `names`, reusing their storage, looks up each
+    // socket's owner among `processes` and fills in their network rates.
+    // Returns false when sock_diag can't be used; with a fixture root it isn't,
+    // as the live kernel's sockets don't belong to the fixture's processes.
+    bool update(vector<SocketInfo>& sockets, vector<char>& names, const FdTracker& owners,
+                vector<Proc>& processes);
+    // looks up the owners of sockets from an earlier update among a newer
+    // process list and fills in the processes' network rates
+    void attribute(vector<SocketInfo>& sockets, const FdTracker& owners, vector<Proc>& processes);
+};
 
 class NetworkTracker {
+private:
+    vector<char> netDev; // last read of /proc/net/dev, reused between reads
+    string name;         // interface name being looked up, reused between lines
+
 public:
     Networks getNetworkInterfaces();
+    void getNetworkInterfaces(Networks& nets);
     map<string, RX> getNetworkRX();
     map<string, TX> getNetworkTX();
+    // one read of /proc/net/dev for both directions; existing map entries are
+    // updated in place, so a steady set of interfaces costs no allocations
+    void getNetworkStats(map<string, RX>& rx, map<string, TX>& tx);
+};
+
+// A struct that measures and smooths network upload/download rates
+// in bytes per second over time; how often it's updated is COLLECTOR_NETWORK's cadence
+struct NetworkRate {
+    map<string, pair<long long, float>> lastRX, lastTX; // Last bytes, timestamp
+    map<string, float> rxRate, txRate; // Smoothed rates in bytes/sec
+    static constexpr float ALPHA = 0.3f; // Smoothing factor (0 < ALPHA < 1, lower = smoother)
+
+    void update(const map<string, RX>& rxStats, const map<string, TX>& txStats, float time);
+};
+
+// Publishes snapshots into a POSIX shared-memory segment (see monitor_shm.h)
+class SnapshotPublisher {
+private:
+    int fd;
+    monitor_shm_segment* segment;
+    string name;
+    uint64_t sequence;
+
+    bool isNamed(const char* shmName) const;
+
+public:
+    SnapshotPublisher();
+    ~SnapshotPublisher();
+    bool open(const char* shmName = MONITOR_SHM_NAME);
+    void close();
+    bool isOpen() const;
+    void publish(const monitor_shm_snapshot& snapshot);
+};
+
+// Span tracing for the Chrome trace-event format (chrome://tracing, Perfetto).
+// Spans go into a preallocated ring buffer per thread and are only recorded
+// while tracing is switched on at runtime. Building with -DMONITOR_TRACING=0
+// compiles TRACE_SCOPE out entirely.
+#ifndef MONITOR_TRACING
+#define MONITOR_TRACING 1
+#endif
+
+extern std::atomic<bool> tracingEnabled;
+
+struct TraceEvent {
+    const char* name; // must be a string with static lifetime
+    unsigned long long start; // traceNow() ticks
+    unsigned long long end;
+};
+
+// Timestamps for spans. On x86 this is the TSC, which is cheaper to read than
+// clock_gettime; ticks are converted to nanoseconds when the trace is written.
+inline unsigned long long traceNow() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long long>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+void recordTraceSpan(const char* name, unsigned long long start, unsigned long long end);
+
+class TraceSpan {
+private:
+    const char* name;
+    unsigned long long start; // 0 when tracing was off at construction
+
+public:
+    explicit TraceSpan(const char* spanName)
+        : name(spanName), start(tracingEnabled.load(std::memory_order_relaxed) ? traceNow() : 0) {}
+    ~TraceSpan() {
+        if (start) recordTraceSpan(name, start, traceNow());
+    }
+};
+
+#if MONITOR_TRACING
+#define TRACE_SCOPE(name) TraceSpan MONITOR_PROBE_CONCAT(trace_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)
+#endif
+
+void setTracing(bool enabled);
+void setTraceThreadName(const char* name);
+// writes every span still in the ring buffers as Chrome trace-event JSON
+bool writeChromeTrace(const char* path);
+
+// Code regions whose cost is tracked for the "Monitor Overhead" panel
+enum ProbeId {
+    PROBE_SAMPLER_TICK,
+    PROBE_CALCULATE_CPU_USAGE,
+    PROBE_GET_PROCESS_LIST,
+    PROBE_COUNT_PROCESS_STATES,
+    PROBE_UPDATE_PROCESS_TREE,
+    PROBE_UPDATE_THREADS,
+    PROBE_UPDATE_SMAPS,
+    PROBE_UPDATE_PROCESS_IO,
+    PROBE_UPDATE_FDS,
+    PROBE_UPDATE_SOCKETS,
+    PROBE_GET_MEMORY_INFO,
+    PROBE_GET_DISK_INFO,
+    PROBE_UPDATE_MOUNTS,
+    PROBE_GET_DISK_STATS,
+    PROBE_READ_PRESSURE,
+    PROBE_UPDATE_CGROUPS,
+    PROBE_UPDATE_PLUGINS,
+    PROBE_UPDATE_ALERTS,
+    PROBE_GET_NETWORK_INTERFACES,
+    PROBE_GET_NETWORK_RX,
+    PROBE_GET_NETWORK_TX,
+    PROBE_GET_NETWORK_STATS,
+    PROBE_GET_CPU_TEMPERATURE,
+    PROBE_GET_FAN_SPEED,
+    PROBE_READ_SENSORS,
+    PROBE_CPU_INFO,
+    PROBE_SYSTEM_WINDOW,
+    PROBE_MEMORY_PROCESSES_WINDOW,
+    PROBE_NETWORK_WINDOW,
+    PROBE_TERMINAL_FRAME,
+    PROBE_COUNT
+};
+
+// Accumulated cost of one probe on one thread
+struct ProbeTotals {
+    unsigned long long calls;
+    unsigned long long wallNs;
+    unsigned long long maxNs;
+    unsigned long long syscalls;    // read/write-family syscalls (syscr + syscw) and io_uring_enter()
+    unsigned long long bytesRead;   // rchar: bytes read through read-family syscalls
+    unsigned long long allocations; // heap allocations, see threadAllocationCount()
+};
+
+// Measures wall time, syscalls, bytes read and heap allocations between its
+// construction and destruction, and adds them to the calling thread's counters.
+// The counters are per thread and only written by their owner, so recording
+// never takes a lock.
+class ScopedProbe {
+private:
+    ProbeId id;
+    unsigned long long startNs;
+    unsigned long long startSyscalls;
+    unsigned long long startBytes;
+    unsigned long long startProbeSyscalls;
+    unsigned long long startProbeBytes;
+    unsigned long long startAllocations;
+    unsigned long long startRingEnters;
+
+public:
+    explicit ScopedProbe(ProbeId probe);
+    ~ScopedProbe();
+};
+
+#define MONITOR_PROBE_CONCAT2(a, b) a##b
+#define MONITOR_PROBE_CONCAT(a, b) MONITOR_PROBE_CONCAT2(a, b)
+// probes also open a trace span, so the trace shows every probed region.
+// -DMONITOR_PROBES=0 drops the counters (the benchmark measures without them).
+#ifndef MONITOR_PROBES
+#define MONITOR_PROBES 1
+#endif
+#if MONITOR_PROBES
+#define MONITOR_PROBE(id)                                           \
+    ScopedProbe MONITOR_PROBE_CONCAT(probe_, __LINE__)(id);         \
+    TRACE_SCOPE(probeName(id))
+#else
+#define MONITOR_PROBE(id) TRACE_SCOPE(probeName(id))
+#endif
+
+const char* probeName(ProbeId id);
+void setProbeThreadName(const char* name);
+// calls fn(threadName, probe, totals) for every probe that ran on any thread
+void forEachProbeTotal(const std::function<void(const char*, ProbeId, const ProbeTotals&)>& fn);
+void resetProbeTotals();
+// Heap allocations made by the calling thread: operator new calls, plus the
+// malloc family when built with -DMONITOR_COUNT_MALLOC=1 (the benchmark does).
+unsigned long long threadAllocationCount();
+// io_uring_enter() calls made by the calling thread (ReadBatch notes them).
+// syscr and syscw don't count them, so probes add them to their syscalls.
+void countRingEnter();
+unsigned long long threadRingEnters();
+
+// The monitor's own CPU% and memory, from /proc/self
+struct SelfUsage {
+    float cpuPercent;
+    unsigned long long rssBytes;
+    unsigned long long vmBytes;
+    int threads;
+};
+
+class SelfUsageTracker {
+private:
+    long long lastCPUTime; // utime + stime in jiffies
+    std::chrono::steady_clock::time_point lastSample;
+    SelfUsage current;
+
+public:
+    SelfUsageTracker();
+    SelfUsage update(); // recomputes at most once per second
+};
+
+// What the Sampler collects, each on a cadence of its own
+enum Collector {
+    COLLECTOR_CPU,             // /proc/stat
+    COLLECTOR_SENSORS,         // temperature and fan speed
+    COLLECTOR_MEMORY,          // /proc/meminfo and open file handles
+    COLLECTOR_DISKS,           // /proc/diskstats
+    COLLECTOR_PRESSURE,        // /proc/pressure
+    COLLECTOR_NETWORK,         // /proc/net/dev
+    COLLECTOR_PROCESSES,       // process list, CPU%, states, tree, selected threads
+    COLLECTOR_PROCESS_DETAILS, // PSS and swap, disk I/O and fds of the processes just listed
+    COLLECTOR_SOCKETS,         // sock_diag, with owners from the fds just listed
+    COLLECTOR_CGROUPS,
+    COLLECTOR_MOUNTS,
+    COLLECTOR_INTERFACES,      // interface addresses
+    COLLECTOR_INVENTORY,       // hostname, user name, CPU model
+    COLLECTOR_PLUGINS,         // loaded collector plugins, each every so many of its runs
+    COLLECTORS
+};
+
+const char* collectorName(Collector collector);
+bool collectorByName(const char* name, Collector& collector);
+// Cadence, in seconds, that new Samplers start with (--cadence); 0 for the built-in one
+void setDefaultCadence(Collector collector, float seconds);
+float defaultCadence(Collector collector);
+
+// How a collector is being run, as of the snapshot it's in
+struct CollectorStatus {
+    float cadence = 0.0f;   // seconds, as asked for
+    float effective = 0.0f; // seconds between runs after alignment, see CollectorSchedule
+    float lastRun = -1.0f;  // SystemSnapshot::time of its last run
+    float costMs = 0.0f;    // average time a run takes
 };
 
+// Decides which collectors run on a sampler tick. Deadlines are kept in a
+// hierarchical timer wheel: 64 slots of one JIFFY, 64 of 64 jiffies and 64 of
+// 4096, with a timer moving down a level as its slot comes round. Each
+// collector runs on the multiples of its period (plus a phase), so a 250 ms and
+// a 1 s collector fire together every second and the sampler wakes up once for
+// both. A collector that works on another's data (the fds of the processes just
+// listed) has its period rounded to a multiple of that one's and always fires
+// with it; expensive collectors with the same period are spread over it instead.
+class CollectorSchedule {
+public:
+    static constexpr double JIFFY = 0.05; // seconds
+
+private:
+    static constexpr int LEVELS = 3, SLOT_BITS = 6, SLOTS = 1 << SLOT_BITS;
+    static constexpr unsigned long long MAX_PERIOD = (1ull << (LEVELS * SLOT_BITS)) - 1;
+    struct Timer {
+        unsigned long long expires; // jiffy
+        int next;                   // in its slot's list, -1 at the end
+        int level, slot;            // -1 while not in the wheel
+    };
+    Timer timers[COLLECTORS];
+    int heads[LEVELS][SLOTS];
+    unsigned long long current = 0; // the jiffy the wheel has reached
+    float requested[COLLECTORS];
+    unsigned long long period[COLLECTORS]; // jiffies
+    unsigned long long phase[COLLECTORS];
+
+    void link(int id);
+    void unlink(int id);
+    void arm(int id, unsigned long long after);
+    void cascade(int level);
+    void align();
+
+public:
+    CollectorSchedule();
+    void setCadence(Collector collector, float seconds);
+    float cadence(Collector collector) const { return requested[collector]; }
+    float effectiveCadence(Collector collector) const { return static_cast<float>(period[collector] * JIFFY); }
+    // the collector whose data `collector` works on, or `collector` itself
+    static Collector base(Collector collector);
+    static bool expensive(Collector collector);
+    // Moves the wheel forward to `seconds` since the schedule started and returns
+    // the collectors whose deadlines were passed, one bit each. Each fires once
+    // however many of its deadlines went by.
+    unsigned advance(double seconds);
+    // seconds since the start of the earliest deadline still ahead
+    double nextDeadline() const;
+};
+
+// Named numeric metrics in sections of SystemSnapshot::metricValues: first the
+// built-in ones, taken from the typed fields once their collector has run, then
+// one section per loaded plugin (monitor_plugin.h), which writes its values
+// there itself. A schema is built once when the sampler starts and shared by
+// every snapshot after that.
+struct MetricSection {
+    string name;         // "cpu", or the plugin's name
+    Collector collector; // whose runs update it; COLLECTOR_PLUGINS for a plugin
+    float cadence;       // seconds a plugin asked for; 0 for a built-in section
+    size_t first, count; // its metrics in names/units and its values in the snapshot
+};
+
+struct MetricSchema {
+    vector<MetricSection> sections;
+    vector<string> names; // "section.metric"
+    vector<string> units;
+    size_t size() const { return names.size(); }
+    // index of a metric by its full name, or -1
+    int find(const string& name) const;
+};
+
+// Alert rules (alerts.cpp), one per line:
+//     [info|warning|critical] [name:] <value> [rate] [avg <duration>] <op> <threshold> [for <duration>] [clear <threshold>]
+// The value is a metric from the schema (cpu.total, psi.memory.some.avg10,
+// a plugin's), one interface's net.<name>.rx_rate or tx_rate, or the sum of a
+// field over the processes of one name, proc[name=<name>].<field>. Thresholds
+// take units: 90%, 800MB/s, 10MiB/min. A rule fires once its condition has
+// held for the `for` duration, and clears once the value is back past the
+// clear threshold, 5% short of the threshold unless given.
+enum AlertLevel { ALERT_INFO, ALERT_WARNING, ALERT_CRITICAL };
+
+const char* alertLevelName(AlertLevel level);
+
+enum AlertSource {
+    ALERT_METRIC,    // a metric in the schema
+    ALERT_INTERFACE, // one interface's rate
+    ALERT_PROCESSES, // a field summed over the processes of one name
+};
+
+// what proc[name=...] sums
+enum ProcessField {
+    PROCESS_CPU,       // % of one CPU
+    PROCESS_RSS,       // bytes
+    PROCESS_PSS,       // bytes
+    PROCESS_SWAP,      // bytes
+    PROCESS_READ_RATE, // bytes/s
+    PROCESS_WRITE_RATE,
+    PROCESS_NET_RX,    // bytes/s
+    PROCESS_NET_TX,
+    PROCESS_FDS,
+    PROCESS_COUNT,     // processes of that name
+    PROCESS_FIELDS
+};
+
+struct AlertRule {
+    string name;         // as given, or the expression
+    string expression;   // the rule as written, without level and name
+    AlertLevel level = ALERT_WARNING;
+    AlertSource source = ALERT_METRIC;
+    string target;       // metric name, interface name or process name
+    int field = 0;       // ALERT_INTERFACE: 0 for rx, 1 for tx; ALERT_PROCESSES: a ProcessField
+    bool rate = false;   // per second change of the value rather than the value
+    float average = 0;   // time constant of an exponential moving average in seconds; 0 for none
+    bool above = true;   // > or >=, else < or <=
+    bool inclusive = false;
+    double threshold = 0, clear = 0; // in the value's base unit (bytes, bytes/s, %)
+    float hold = 0;      // seconds the condition must hold before firing
+};
+
+// Parses a rules file; false with `error` set ("line 3: ...") on the first bad line
+bool parseAlertRules(const string& text, vector<AlertRule>& rules, string& error);
+// Rules new Samplers start with (--alerts); without any, the thermal defaults
+void setAlertRules(const vector<AlertRule>& rules);
+const vector<AlertRule>& alertRules();
+// Where transitions go as JSON lines besides the UI (--alert-log, --alert-socket); "" for nowhere
+void setAlertOutputs(const string& logFile, const string& socketPath);
+const string& alertLogFile();
+const string& alertSocketPath();
+
+struct ActiveAlert {
+    int rule;     // index into SystemSnapshot::alertRules
+    float since;  // SystemSnapshot::time it fired
+    double value; // as of this snapshot
+};
+
+struct AlertEvent {
+    int rule;
+    bool firing;     // fired, or cleared
+    float time;      // SystemSnapshot::time
+    double wallTime; // CLOCK_REALTIME seconds, for display
+    double value;
+};
+
+// Everything the frontends display, collected in one pass by the Sampler.
+// Snapshots are immutable once published, so the UI can read one while the
+// sampler is already building the next.
+struct SystemSnapshot {
+    unsigned long long generation = 0; // increases by one per snapshot
+    float time = 0.0f;                 // seconds since the sampler started
+
+    CollectorStatus collectors[COLLECTORS];
+
+    // inventory, refreshed on COLLECTOR_INVENTORY's long cadence
+    string hostname;
+    string username;
+    string cpuModel;
+
+    float cpuUsage = 0.0f; // smoothed over the last few samples
+    float temperature = 0.0f;
+    float fanSpeed = 0.0f;
+    MemoryInfo memory{};
+    DiskInfo disk{}; // the filesystem mounted at /
+    vector<MountUsage> mounts;
+    vector<DiskIO> disks;
+
+    Pressure pressure[PRESSURE_RESOURCES] = {};
+    vector<StallEvent> stallEvents; // most recent PSI trigger events, oldest first
+
+    vector<CgroupUsage> cgroups; // tree order, see CgroupTracker
+
+    map<char, int> processStates;
+    int totalProcesses = 0;
+    vector<Proc> processes;
+    vector<ThreadUsage> threads; // of the processes given to Sampler::setThreadPids()
+    FileHandles fileHandles;
+
+    bool socketsAvailable = false; // see SocketTracker::update
+    vector<SocketInfo> sockets;
+    vector<char> socketNames;      // NUL-terminated Unix socket paths, see SocketInfo::nameOffset
+
+    Networks interfaces;
+    map<string, RX> rx;
+    map<string, TX> tx;
+    map<string, float> rxRate, txRate; // smoothed bytes/s
+
+    shared_ptr<const MetricSchema> metrics;
+    vector<double> metricValues;  // one per metric in the schema; NAN for none
+    vector<float> sectionUpdated; // time of each section's last values, -1 before the first
+
+    shared_ptr<const vector<AlertRule>> alertRules;
+    vector<ActiveAlert> alerts;      // firing now, in rule order
+    vector<AlertEvent> alertEvents;  // most recent transitions, oldest first
+};
+
+// Loads collector plugins and keeps SystemSnapshot's metric sections up to
+// date. Only the sampler's worker thread uses it after start().
+class PluginHost {
+private:
+    // a loaded plugin, or one of the built-in sections behind the same interface
+    struct Plugin {
+        void* handle;        // from dlopen(); nullptr for a built-in section
+        monitor_plugin plugin;
+        Collector collector; // COLLECTOR_PLUGINS for a loaded plugin
+        size_t section;
+        unsigned countdown;  // runs of COLLECTOR_PLUGINS until its next own
+    };
+    vector<Plugin> plugins;
+    shared_ptr<const MetricSchema> schema;
+    const SystemSnapshot* filling = nullptr; // what the built-in sections read from
+
+    bool add(Plugin plugin, MetricSchema& schema, const char*& problem);
+    bool load(const string& path, const string& directory, MetricSchema& schema);
+
+public:
+    PluginHost() = default;
+    ~PluginHost();
+    PluginHost(const PluginHost&) = delete;
+    PluginHost& operator=(const PluginHost&) = delete;
+    // loads every *.so in `directory` ("" for none) and builds the schema, once;
+    // plugins that fail to load are reported on stderr and skipped
+    void loadAll(const string& directory);
+    size_t pluginCount() const; // loaded, built-in sections not counted
+    // Fills the sections of the collectors in `due` and, if COLLECTOR_PLUGINS
+    // is due, those of the plugins whose turn it is; `pluginCadence` is its
+    // effective cadence. The rest keep the values in `previous`.
+    void update(SystemSnapshot& snap, const SystemSnapshot* previous, unsigned due, float pluginCadence);
+};
+
+// Evaluates alert rules as snapshots are taken. A rule is only looked at when
+// the collector behind its value has run, and keeps a few numbers of state
+// (the last value for a rate, the average, when the condition started to
+// hold), so thousands of rules take tens of microseconds and no history is kept.
+class AlertEngine {
+private:
+    struct State {
+        int metric = -1;      // ALERT_METRIC: index into the snapshot's values; ALERT_PROCESSES: name slot
+        int section = -1;     // the metric's section
+        double last = NAN;    // for rates: the previous value and its time
+        float lastTime = 0;
+        double average = NAN; // moving average, NAN until the first value
+        float averageTime = 0;
+        float holding = -1;   // since when the condition holds, -1 while it doesn't
+        bool firing = false;
+        float since = 0;
+        double value = NAN;   // after rate and average
+    };
+    // process fields summed per name; the names are sorted for lookup
+    struct ProcessTotals {
+        double fields[PROCESS_FIELDS];
+    };
+    shared_ptr<const vector<AlertRule>> rules;
+    vector<State> states;
+    vector<int> firing;                  // rules firing now, in order
+    vector<int> byCollector[COLLECTORS]; // the rules whose value that collector updates
+    vector<string> processNames;
+    vector<ProcessTotals> processTotals;
+    shared_ptr<const MetricSchema> schema; // the rules were resolved against this one
+    AlertEvent events[256];                // ring of the most recent transitions
+    size_t eventCount = 0;
+    int logFd = -1, socketFd = -1;
+    sockaddr_un socketAddress{};
+    bool configured = false;
+
+    void resolve(const shared_ptr<const MetricSchema>& metrics);
+    double read(const AlertRule& rule, const State& state, const SystemSnapshot& snap) const;
+    void evaluate(int index, const SystemSnapshot& snap);
+    void sumProcesses(const SystemSnapshot& snap);
+    void record(const AlertEvent& event);
+
+public:
+    static constexpr size_t MAX_EVENTS = sizeof(events) / sizeof(events[0]);
+
+    AlertEngine() = default;
+    AlertEngine(const AlertEngine&) = delete;
+    AlertEngine& operator=(const AlertEngine&) = delete;
+    ~AlertEngine();
+    // once, before the first update; opens the log and the socket if given
+    void configure(const vector<AlertRule>& rules, const string& logFile, const string& socketPath);
+    // evaluates the rules whose collectors are in `due` against `snap` and
+    // fills its alerts and alertEvents
+    void update(SystemSnapshot& snap, unsigned due);
+};
+
+// The directory Samplers load plugins from (--plugins); "" for none
+void setPluginDirectory(const string& directory);
+const string& pluginDirectory();
+
+// Collects SystemSnapshots on a background thread so that rendering never waits
+// on /proc. Each new snapshot is announced through the callback given to start(),
+// which the frontends use to wake up and redraw.
+class Sampler {
+private:
+    std::thread worker;
+    std::mutex snapshotLock;
+    shared_ptr<const SystemSnapshot> latestSnapshot;
+    // snapshots handed out before; one that nobody else holds any more is
+    // overwritten instead of allocating a new one
+    vector<shared_ptr<SystemSnapshot>> snapshotPool;
+    std::function<void()> onSnapshot;
+    std::atomic<bool> running;
+    std::atomic<bool> background;
+    std::atomic<float> interval;           // shortest time between samples while visible
+    std::atomic<float> backgroundInterval; // shortest time between samples while hidden
+    int wakeFd;                            // eventfd used to interrupt the wait
+
+    // collector state, only touched by the worker thread
+    CPUUsageTracker cpuTracker;
+    ProcessUsageTracker processTracker;
+    ProcessTree processTree;
+    ThreadTracker threadTracker;
+    SmapsTracker smapsTracker;
+    ProcessIOTracker processIOTracker;
+    FdTracker fdTracker;
+    SocketTracker socketTracker;
+    SystemResourceTracker resourceTracker;
+    NetworkTracker networkTracker;
+    NetworkRate rateTracker;
+    MountTracker mountTracker;
+    DiskStatsTracker diskStatsTracker;
+    PressureTracker pressureTracker; // its triggers are polled alongside wakeFd
+    CgroupTracker cgroupTracker;
+    PluginHost pluginHost;
+    AlertEngine alertEngine;
+    SnapshotPublisher publisher;
+    vector<float> cpuUsageBuffer; // last few readings for the moving average
+    int bufferIndex;
+    CollectorSchedule schedule;
+    CollectorStatus status[COLLECTORS];
+    std::mutex frontendLock;  // guards what the frontend hands over below
+    vector<int> threadPids;
+    vector<int> visiblePids;
+    float cadences[COLLECTORS]; // requested; the worker moves them into schedule
+    bool cadencesChanged = false;
+    vector<int> watchedPids;  // the worker's copies of them
+    vector<int> priorityPids;
+    double startTime; // monitorClock() when the sampler started
+
+    void run();
+    shared_ptr<SystemSnapshot> reusableSnapshot();
+    void applyCadences();
+    bool sample(SystemSnapshot& snap, const SystemSnapshot* previous);
+    void publish(const SystemSnapshot& snap);
+
+public:
+    Sampler();
+    ~Sampler();
+    void start(std::function<void()> callback, bool publishShm = true);
+    void stop();
+    // caps how often snapshots are taken, whatever the cadences ask for
+    void setInterval(float seconds);
+    void setBackground(bool hidden);
+    // seconds between runs of a collector; takes effect on the worker's next wakeup
+    void setCadence(Collector collector, float seconds);
+    float cadence(Collector collector);
+    // processes whose threads are listed in SystemSnapshot::threads; empty for none
+    void setThreadPids(const set<int>& pids);
+    // processes on screen, whose PSS and swap are read before any other's
+    void setVisiblePids(const vector<int>& pids);
+    shared_ptr<const SystemSnapshot> latest();
+    // takes and publishes one sample on the calling thread, running the
+    // collectors that are due; this is what the worker thread runs
+    void tick();
+};
+
+// Every /proc and /sys path the collectors open goes through monitorPath(), which
+// prefixes the root set with setMonitorRoot(). The default root is "", the live
+// system; the benchmark points it at a fixture tree.
+void setMonitorRoot(const string& root);
+string monitorPath(const string& path);
+bool hasMonitorRoot();
+unsigned monitorRootGeneration(); // changes on every setMonitorRoot(), for path caches
+// formats a path below the root into `out` without allocating; false if it doesn't fit
+bool monitorPathf(char* out, size_t size, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+// reads a whole (small) file into `buffer` and NUL-terminates it; returns the
+// length, or -1 if it can't be opened
+ssize_t readFileInto(const char* path, char* buffer, size_t size);
+// same, growing `buffer` as needed; it keeps its capacity for the next read
+ssize_t readFileInto(const char* path, vector<char>& buffer);
+// Seconds on a monotonic clock, used wherever counter deltas become rates.
+// setMonitorClock() swaps in another source (nullptr restores steady_clock).
+void setMonitorClock(std::function<double()> clock);
+double monitorClock();
+
+// Synthetic /proc and /sys trees (fixture.cpp). Every counter advances at a
+// fixed per-second rate, so the CPU% and byte rates the collectors compute
+// between two steps are known exactly; see the fixtureExpected* functions.
+struct FixtureSpec {
+    int processes = 1000;
+    int interfaces = 8;
+    int sensors = 4;
+    int cpus = 4;
+    int disks = 4; // block devices in /proc/diskstats
+    int cgroups = 8; // control groups under sys/fs/cgroup, the root and three slices included
+    double stepSeconds = 1.0; // simulated time between two steps
+    bool processDetails = true; // smaps_rollup, io, fd and task for every process, not just stat
+};
+
+bool writeFixtureTree(const string& root, const FixtureSpec& spec, int step);
+int fixturePid(int index);
+int fixtureParentIndex(int index);                // -1 for the process whose parent isn't in the tree
+float fixtureExpectedCPUUsage();                  // whole-system CPU%
+float fixtureExpectedProcessCPU(int index);       // CPU% of one core for process `index`
+float fixtureExpectedRxRate(int iface);           // bytes/s
+float fixtureExpectedTxRate(int iface);
+MemoryInfo fixtureExpectedMemory(int step);        // raw /proc/meminfo fields (the *_kb and hugepages_*)
+string fixtureInterfaceName(int iface);
+Pressure fixtureExpectedPressure(PressureResource resource); // avg10/60/300 and recent (totals aren't fixed)
+DiskIO fixtureExpectedDisk(int index);            // name, label, kind and rates of block device `index`
+vector<string> fixtureMountPoints();              // filesystems listed in proc/self/mountinfo
+CgroupUsage fixtureExpectedCgroup(const FixtureSpec& spec, int index); // path, depth, memory and rates
+int fixtureThreadCount(int index);                // threads of process `index`
+ThreadUsage fixtureExpectedThread(const FixtureSpec& spec, int index, int thread);
+long long fixtureExpectedPss(int index);         // kB, from smaps_rollup
+long long fixtureExpectedSwap(int index);        // kB
+ProcessIO fixtureExpectedProcessIO(int index);
+FdUsage fixtureExpectedFds(const FixtureSpec& spec, int index, int step); // counts and growth at `step`
+unsigned fixtureSocketInode(int index, int fd); // target of fd `fd`; the last `sockets` fds are sockets
+FileHandles fixtureExpectedFileHandles();
+
 // System functions
 string CPUinfo();
 const char* getOsName();
 string getCurrentUsername();
 string getHostname();
 map<char, int> countProcessStates();
+void countProcessStates(map<char, int>& states); // reuses the map's nodes
 int getTotalProcessCount();
 float getCPUTemperature();
 float getFanSpeed();
+// both of the above, their files read together
+void readSensors(float& temperature, float& fanSpeed);
 string formatNetworkBytes(long long bytes);
 
-template<typename... Args>
-string TextF(const char* fmt, Args... args) {
+// Terminal frontend (tui.cpp), used instead of the SDL window with --tui
+int runTerminalUI(float refreshInterval);
+
+// ImGui windows (ui.cpp). They only need an ImGui context, so the benchmark
+// can draw them without SDL or OpenGL.
+void systemWindow(const char* id, ImVec2 size, ImVec2 position, const SystemSnapshot& snap);
+void memoryProcessesWindow(const char* id, ImVec2 size, ImVec2 position, const SystemSnapshot& snap);
+void networkWindow(const char* id, ImVec2 size, ImVec2 position, const SystemSnapshot& snap);
+// cadences changed in the Sampling table, one per collector, 0 where untouched;
+// the frontend hands them to Sampler::setCadence
+const float* requestedCadences();
+const set<int>& selectedProcesses(); // PIDs selected in the process list
+const vector<int>& visibleProcesses(); // PIDs of the process rows drawn in the last frame
+// the Network window's Connections tab, on its own for the benchmark
+void connectionsTable(const SystemSnapshot& snap);
+
+// Formatted text in a fixed buffer, for labels built every frame
+struct FormattedText {
     char buffer[256];
-    snprintf(buffer, sizeof(buffer), fmt, args...);
-    return string(buffer);
+    const char* c_str() const { return buffer; }
+};
+
+template<typename... Args>
+FormattedText TextF(const char* fmt, Args... args) {
+    FormattedText text;
+    snprintf(text.buffer, sizeof(text.buffer), fmt, args...);
+    return text;
 }
 
 #endif
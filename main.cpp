@@ -3,483 +3,107 @@
 #include <GL/gl3w.h>
 #include <vector>
 #include <algorithm>
-#include <set>
 #include <chrono>
-
-// A struct that measures and smooths network upload/download rates
-// in bytes per second over time
-struct NetworkRate {
-    map<string, pair<long long, float>> lastRX, lastTX; // Last bytes, timestamp
-    map<string, float> rxRate, txRate; // Smoothed rates in bytes/sec
-    float lastUpdateTime = 0.0f; // Last time rates were updated
-    static constexpr float UPDATE_INTERVAL = 0.5f; // Update every 0.5 seconds
-    static constexpr float ALPHA = 0.3f; // Smoothing factor (0 < ALPHA < 1, lower = smoother)
-
-    void update(NetworkTracker& tracker, float time) {
-        // Only update rates if enough time has passed
-        if (time - lastUpdateTime < UPDATE_INTERVAL) {
-            return;
-        }
-        lastUpdateTime = time;
-
-        auto rxStats = tracker.getNetworkRX();
-        auto txStats = tracker.getNetworkTX();
-
-        // Update RX rates
-        for (auto& [iface, rx] : rxStats) {
-            if (lastRX.count(iface)) {
-                float dt = time - lastRX[iface].second; //dt is time since last sample
-                float instantaneousRate = dt > 0 ? (rx.bytes - lastRX[iface].first) / dt : 0;
-                // Apply exponential moving average
-                if (rxRate.count(iface)) {
-                    rxRate[iface] = ALPHA * instantaneousRate + (1.0f - ALPHA) * rxRate[iface];
-                } else {
-                    rxRate[iface] = instantaneousRate; // Initialize with first value
-                }
-            }
-            lastRX[iface] = {rx.bytes, time};
-        }
-
-        // Update TX rates
-        for (auto& [iface, tx] : txStats) {
-            if (lastTX.count(iface)) {
-                float dt = time - lastTX[iface].second;
-                float instantaneousRate = dt > 0 ? (tx.bytes - lastTX[iface].first) / dt : 0;
-                // Apply exponential moving average
-                if (txRate.count(iface)) {
-                    txRate[iface] = ALPHA * instantaneousRate + (1.0f - ALPHA) * txRate[iface];
-                } else {
-                    txRate[iface] = instantaneousRate; // Initialize with first value
-                }
-            }
-            lastTX[iface] = {tx.bytes, time};
-        }
-    }
-};
-
-
-static CPUUsageTracker cpuTracker;
-static ProcessUsageTracker processTracker;
-static vector<float> cpuUsageHistory(100, 0.0f);
-static vector<float> temperatureHistory(100, 0.0f);
-static NetworkRate rateTracker;
-static vector<float> cpuUsageBuffer(5, 0.0f);  // Buffer for last 5 readings
-static int bufferIndex = 0;
-
-// Timing variables for graph updates
-static float cpuUpdateTime = 0.0f;
-static float fanUpdateTime = 0.0f;
-static float thermalUpdateTime = 0.0f;
-
-// system monitoring UI function with tabs for CPU, Fan, and Thermal info, plus system metadata.
-// id is unique identifier for the window, size refers to the window size in pixels, while position
-// refers to window position on the screen.
-void systemWindow(const char* id, ImVec2 size, ImVec2 position) {
-    ImGuiIO& io = ImGui::GetIO(); // get reference to ImGui's IO interface
-    ImGui::Begin(id);
-    ImGui::SetWindowSize(size);
-    ImGui::SetWindowPos(position);
-
-    ImGui::BeginChild("SystemInfo", ImVec2(0, 150), true); // create a child window(scrollable sub-section)
-    ImGui::Text("Operating System: %s", getOsName());
-    ImGui::Text("Username: %s", getCurrentUsername().c_str());
-    ImGui::Text("Hostname: %s", getHostname().c_str());
-    ImGui::Text("Total Processes: %d", getTotalProcessCount());
-    ImGui::Text("CPU Type: %s", CPUinfo().c_str());
-
-    static auto lastUpdateTime = std::chrono::steady_clock::now(); // last time process states were updated
-    static std::map<char, int> cachedStates; // count of processes per state (e.g Running, Sleeping etc)
-    
-    //update process state counts only once per second
-    auto now = std::chrono::steady_clock::now();
-    if (std::chrono::duration_cast<std::chrono::seconds>(now - lastUpdateTime).count() >= 1) {
-        cachedStates = countProcessStates();
-        lastUpdateTime = now;
-    }
-    
-    ImGui::Text("Process States:");
-    // Define known states with their labels
-    const vector<pair<char, string>> stateLabels = {
-        {'R', "Running"},
-        {'S', "Sleeping"},
-        {'D', "Uninterruptible Sleep"},
-        {'Z', "Zombie"},
-        {'T', "Stopped"},
-        {'I', "Idle"}
-    };
-    
-    int totalProcesses = 0;
-    for (const auto& [state, count] : cachedStates) {
-        totalProcesses += count;
-    }
-    ImGui::Text("  Total Processes: %d", totalProcesses);
-
-    // Display known states first
-    for (const auto& [code, label] : stateLabels) {
-        if (cachedStates.count(code)) {
-            ImGui::Text("  %s: %d", label.c_str(), cachedStates.at(code));
-        }
-    }
-    
-    // Display any unknown states
-    for (const auto& [state, count] : cachedStates) {
-        bool isKnown = any_of(stateLabels.begin(), stateLabels.end(),
-                            [state](const auto& pair) { return pair.first == state; });
-        if (!isKnown) {
-            ImGui::Text("  Unknown State (%c): %d", state, count);
-        }
-    }
-    ImGui::EndChild();
-
-    // start tab for CPU, Fan, and Thermal
-    if (ImGui::BeginTabBar("SystemPerformanceTabs")) {
-       // display CPU data 
-       if (ImGui::BeginTabItem("CPU")) {
-        static bool pauseGraph = false;
-        static float graphFPS = 30.0f;
-        static float graphYScale = 100.0f;
-        float currentCPUUsage = cpuTracker.calculateCPUUsage();
-
-        // Add moving average calculation
-        cpuUsageBuffer[bufferIndex] = currentCPUUsage;
-        bufferIndex = (bufferIndex + 1) % cpuUsageBuffer.size();
-
-        // calculate average CPU usage over last N readings
-        float smoothedCPUUsage = 0.0f;
-        for (float usage : cpuUsageBuffer) {
-            smoothedCPUUsage += usage;
-        }
-        smoothedCPUUsage /= cpuUsageBuffer.size();
-
-        if (!pauseGraph) {
-            float updateInterval = 1.0f / graphFPS;
-            cpuUpdateTime += io.DeltaTime;
-            if (cpuUpdateTime >= updateInterval) {
-                cpuUsageHistory.erase(cpuUsageHistory.begin());
-                cpuUsageHistory.push_back(smoothedCPUUsage);  // Use smoothed value
-                cpuUpdateTime = 0.0f;
-            }
-        }
-
-        ImGui::Checkbox("Pause Graph", &pauseGraph);
-        ImGui::SliderFloat("Graph FPS", &graphFPS, 1.0f, 60.0f);
-        ImGui::SliderFloat("Y-Scale", &graphYScale, 10.0f, 200.0f);
-
-        ImGui::PlotLines("CPU Usage", cpuUsageHistory.data(), cpuUsageHistory.size(),
-                        0, TextF("CPU: %.1f%%", smoothedCPUUsage).c_str(),  // Use smoothed value
-                        0.0f, graphYScale, ImVec2(0, 80));
-        ImGui::EndTabItem();
-    }
-
-    // display fan data
-    if (ImGui::BeginTabItem("Fan")) {
-            static bool pauseGraph = false;
-            static float graphFPS = 30.0f;
-            static float graphYScale = 5000.0f;
-            static vector<float> fanSpeedHistory(100, 0.0f);
-            float fanSpeed = getFanSpeed();
-            bool fanAvailable = fanSpeed > 0;
-
-            if (!pauseGraph) {
-                float updateInterval = 1.0f / graphFPS;
-                fanUpdateTime += io.DeltaTime;
-                if (fanUpdateTime >= updateInterval) {
-                    fanSpeedHistory.erase(fanSpeedHistory.begin());
-                    fanSpeedHistory.push_back(fanSpeed);
-                    fanUpdateTime = 0.0f;
-                }
-            }
-
-            ImGui::Checkbox("Pause Graph", &pauseGraph);
-            ImGui::SliderFloat("Graph FPS", &graphFPS, 1.0f, 60.0f);
-            ImGui::SliderFloat("Y-Scale", &graphYScale, 1000.0f, 10000.0f);
-
-            if (fanAvailable) {
-                ImGui::Text("Fan Status: Active");
-                ImGui::Text("Fan Speed: %.0f RPM", fanSpeed);
-                ImGui::Text("Fan Level: %s",
-                            fanSpeed < 1000 ? "Low" : fanSpeed < 3000 ? "Medium" : "High");
-
-                ImGui::PlotLines("Fan Speed", fanSpeedHistory.data(), fanSpeedHistory.size(),
-                                0, TextF("%.0f RPM", fanSpeed).c_str(),
-                                0.0f, graphYScale, ImVec2(0, 80));
-            } else {
-                ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Fan information not available on this system");
-                ImGui::Text("Fan monitoring is supported on some ThinkPad models and");
-                ImGui::Text("other systems with accessible fan sensors.");
-            }
-            ImGui::EndTabItem();
-        }
-
-        // display thermal data
-        if (ImGui::BeginTabItem("Thermal")) {
-            static bool pauseGraph = false;
-            static float graphFPS = 30.0f;
-            static float graphYScale = 100.0f;
-            float temperature = getCPUTemperature();
-            bool tempAvailable = temperature > 0.1f; // Small threshold to detect valid readings
-
-            if (!pauseGraph) {
-                float updateInterval = 1.0f / graphFPS;
-                thermalUpdateTime += io.DeltaTime;
-                if (thermalUpdateTime >= updateInterval) {
-                    temperatureHistory.erase(temperatureHistory.begin());
-                    temperatureHistory.push_back(temperature);
-                    thermalUpdateTime = 0.0f;
-                }
+#include <sys/resource.h>
+
+static Sampler sampler;
+
+int main(int argc, char** argv) {
+    // command line: --tui runs the terminal frontend, --interval sets its refresh period,
+    // --trace records spans from startup and saves them to the given file on exit,
+    // --root reads /proc and /sys below the given directory (e.g. from monitor-fixture),
+    // --psi-trigger sets the PSI trigger for stall events ("" turns them off),
+    // --io-budget caps the system calls spent on /proc/<pid>/io per sample,
+    // --scan-share caps the share of the CPUs the /proc scan's threads may use,
+    // --no-io-uring reads held /proc and /sys files with pread() even where io_uring works,
+    // --cadence name=seconds sets how often a collector runs (see collectorName()),
+    // --plugins loads the collector plugins (*.so, see monitor_plugin.h) in a directory,
+    // --alerts reads alert rules from a file instead of the thermal defaults (see AlertRule),
+    // --alert-log and --alert-socket also send alerts as JSON lines to a file or a Unix datagram socket
+    bool terminalMode = false;
+    float refreshInterval = 1.0f;
+    const char* traceFile = nullptr;
+    string alertLog, alertSocket;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--tui") == 0) {
+            terminalMode = true;
+        } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            refreshInterval = max(0.1f, static_cast<float>(atof(argv[++i])));
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+            setMonitorRoot(argv[++i]);
+        } else if (strcmp(argv[i], "--psi-trigger") == 0 && i + 1 < argc) {
+            setPressureTrigger(argv[++i]);
+        } else if (strcmp(argv[i], "--io-budget") == 0 && i + 1 < argc) {
+            setProcessIOBudget(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--scan-share") == 0 && i + 1 < argc) {
+            setProcessScanShare(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--no-io-uring") == 0) {
+            setIoUringAllowed(false);
+        } else if (strcmp(argv[i], "--plugins") == 0 && i + 1 < argc) {
+            setPluginDirectory(argv[++i]);
+        } else if (strcmp(argv[i], "--alerts") == 0 && i + 1 < argc) {
+            const char* path = argv[++i];
+            std::ifstream file(path);
+            if (!file) {
+                fprintf(stderr, "Error: could not read alert rules from %s\n", path);
+                return 1;
             }
-
-            ImGui::Checkbox("Pause Graph", &pauseGraph);
-            ImGui::SliderFloat("Graph FPS", &graphFPS, 1.0f, 60.0f);
-            ImGui::SliderFloat("Y-Scale", &graphYScale, 10.0f, 200.0f);
-
-            if (tempAvailable) {
-                ImGui::Text("Current Temperature: %.1f°C", temperature);
-                ImGui::PlotLines("Temperature", temperatureHistory.data(), temperatureHistory.size(),
-                                0, TextF("Temp: %.1f°C", temperature).c_str(),
-                                0.0f, graphYScale, ImVec2(0, 80));
-
-                // Add temperature status indicator
-                if (temperature < 50.0f) {
-                    ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Temperature Status: Normal");
-                } else if (temperature < 70.0f) {
-                    ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "Temperature Status: Warm");
-                } else if (temperature < 85.0f) {
-                    ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Temperature Status: Hot");
-                } else {
-                    ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Temperature Status: Critical!");
-                }
-            } else {
-                ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Temperature information not available");
-                ImGui::Text("The system is using a hardware-agnostic approach to find");
-                ImGui::Text("temperature sensors. No compatible sensors were found.");
+            std::stringstream text;
+            text << file.rdbuf();
+            vector<AlertRule> rules;
+            string error;
+            if (!parseAlertRules(text.str(), rules, error)) {
+                fprintf(stderr, "Error: %s, %s\n", path, error.c_str());
+                return 1;
             }
-            ImGui::EndTabItem();
-        }
-        ImGui::EndTabBar();
-    }
-    ImGui::End();
-}
-
-
-// display memory, disk, and process usage.
-// id is a unique identifier for ImGui window, size gives the desired dimensions of the window,
-// position represents the desired position of the window on the screen.
-void memoryProcessesWindow(const char* id, ImVec2 size, ImVec2 position) {
-    ImGuiIO& io = ImGui::GetIO();
-    processTracker.updateDeltaTime(io.DeltaTime); // tracks time elapsed since last frame
-    float currentTime = ImGui::GetTime();
-
-    ImGui::Begin(id);
-    ImGui::SetWindowSize(size);
-    ImGui::SetWindowPos(position);
-
-    SystemResourceTracker resourceTracker;
-    MemoryInfo memInfo = resourceTracker.getMemoryInfo(); 
-    DiskInfo diskInfo = resourceTracker.getDiskInfo();
-
-    ImGui::BeginChild("Memory Info", ImVec2(0, 150), true);
-    // Display RAM in GB with one decimal place
-    ImGui::Text("RAM Usage: %.1f GB / %.1f GB (%.2f%%)",
-                memInfo.used_ram, memInfo.total_ram, memInfo.ram_percent);
-    ImGui::ProgressBar(memInfo.ram_percent / 100.0f, ImVec2(0, 0),
-                       TextF("%.2f%%", memInfo.ram_percent).c_str());
-
-    // Display Swap in GB with one decimal place
-    ImGui::Text("Swap Usage: %.1f GB / %.1f GB (%.2f%%)",
-                memInfo.used_swap, memInfo.total_swap, memInfo.swap_percent);
-    ImGui::ProgressBar(memInfo.swap_percent / 100.0f, ImVec2(0, 0),
-                       TextF("%.2f%%", memInfo.swap_percent).c_str());
-
-    // Format disk usage with rounding to match 'df -h'
-    ImGui::Text("Disk Usage: %.1f GB / %.1f GB (%.2f%%)",
-                diskInfo.used_space, diskInfo.total_space, diskInfo.usage_percent);
-
-    // Progress bar with percentage label
-    ImGui::ProgressBar(diskInfo.usage_percent / 100.0f, ImVec2(0, 0),
-                    TextF("%.1f%%", diskInfo.usage_percent).c_str());
-    ImGui::EndChild();
-
-    static char processFilter[256] = ""; // buffer for user-typed filter text
-    ImGui::InputText("Filter Processes", processFilter, sizeof(processFilter));
-
-    vector<Proc> processes = resourceTracker.getProcessList();
-    static set<int> selectedPids;
-
-    if (ImGui::BeginTable("Processes", 5,
-                          ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable | ImGuiTableFlags_Sortable)) {
-        ImGui::TableSetupColumn("PID");
-        ImGui::TableSetupColumn("Name");
-        ImGui::TableSetupColumn("State");
-        ImGui::TableSetupColumn("CPU Usage");
-        ImGui::TableSetupColumn("Memory Usage");
-        ImGui::TableHeadersRow();
-
-        for (const auto& proc : processes) {
-            if (processFilter[0] != '\0' && strstr(proc.name.c_str(), processFilter) == nullptr)
-                continue; // if filter string is typed, skip processes whose name does not contain the filter
-
-            ImGui::TableNextRow();
-            ImGui::TableNextColumn();
-            bool isSelected = selectedPids.count(proc.pid) > 0;
-            // create a selectable text element for the PID
-            // if Ctrl is held, toggle selection of this PID else select only this PID
-            if (ImGui::Selectable(TextF("%d", proc.pid).c_str(), isSelected, ImGuiSelectableFlags_SpanAllColumns)) {
-                if (ImGui::GetIO().KeyCtrl) {
-                    if (isSelected) selectedPids.erase(proc.pid);
-                    else selectedPids.insert(proc.pid);
-                } else {
-                    selectedPids.clear();
-                    selectedPids.insert(proc.pid);
-                }
+            setAlertRules(rules);
+        } else if (strcmp(argv[i], "--alert-log") == 0 && i + 1 < argc) {
+            alertLog = argv[++i];
+        } else if (strcmp(argv[i], "--alert-socket") == 0 && i + 1 < argc) {
+            alertSocket = argv[++i];
+        } else if (strcmp(argv[i], "--cadence") == 0 && i + 1 < argc) {
+            const char* setting = argv[++i];
+            const char* equals = strchr(setting, '=');
+            Collector collector;
+            if (!equals || !collectorByName(string(setting, equals).c_str(), collector) || atof(equals + 1) <= 0) {
+                fprintf(stderr, "Unknown cadence %s; collectors are:", setting);
+                for (int c = 0; c < COLLECTORS; ++c) fprintf(stderr, " %s", collectorName(static_cast<Collector>(c)));
+                fprintf(stderr, "\n");
+                return 1;
             }
-
-            ImGui::TableNextColumn(); ImGui::Text("%s", proc.name.c_str());
-            ImGui::TableNextColumn(); ImGui::Text("%c", proc.state);
-            ImGui::TableNextColumn();
-            float cpuUsage = processTracker.calculateProcessCPUUsage(proc, currentTime);
-            ImGui::Text("%.1f%%", cpuUsage);
-            ImGui::TableNextColumn();
-            // Convert vsize to GB for consistency
-            float memUsageGB = proc.vsize / (1024.0f * 1024.0f * 1024.0f);
-            // float memPercent = (memInfo.total_ram > 0) ? (memUsageGB / memInfo.total_ram * 100.0f) : 0.0f;
-            // ImGui::Text("%.1f%% (%.1f GB)", memPercent, memUsageGB);
-            ImGui::Text("%.1f%%",  memUsageGB);
-
+            setDefaultCadence(collector, static_cast<float>(atof(equals + 1)));
+        } else {
+            printf("Usage: %s [--tui] [--interval seconds] [--trace file.json] [--root dir]\n"
+                   "          [--psi-trigger \"some|full <stall us> <window us>\"] [--io-budget syscalls]\n"
+                   "          [--cadence collector=seconds]... [--scan-share fraction] [--no-io-uring]\n"
+                   "          [--plugins dir] [--alerts rules] [--alert-log file] [--alert-socket path]\n", argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
         }
-        ImGui::EndTable();
     }
-
-    ImGui::Text("Selected processes: %zu", selectedPids.size());
-    ImGui::End();
-}
-
-// display network interface information and stats in an ImGui window
-void networkWindow(const char* id, ImVec2 size, ImVec2 position) {
-    ImGui::Begin(id);
-    ImGui::SetWindowSize(size);
-    ImGui::SetWindowPos(position);
-
-    NetworkTracker networkTracker;
-    Networks interfaces = networkTracker.getNetworkInterfaces();
-
-    ImGui::Text("Network Interfaces:");
-    ImGui::Separator();
-
-    for (const auto& iface : interfaces.ip4s) {
-        // Display interface name as a bold label
-        ImGui::TextColored(ImVec4(0.7f, 0.9f, 1.0f, 1.0f), "%s", iface.name);
-
-        // Indent the address under it
-        ImGui::SameLine(200); // Align address to column 2
-        ImGui::Text("%s", iface.addressBuffer);
+    setAlertOutputs(alertLog, alertSocket);
+    // the cgroup collector keeps several files open per cgroup, within half of
+    // the soft open-file limit, the process I/O collector one per process
+    // within a quarter, and the process list one per process within an eighth;
+    // raise it as far as we're allowed to
+    rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < files.rlim_max) {
+        files.rlim_cur = files.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &files);
     }
-
-    // start tabbed interface
-    if (ImGui::BeginTabBar("NetworkTabs")) {
-        //create tab labeled RX(Receiver)
-        if (ImGui::BeginTabItem("RX (Receiver)")) {
-            map<string, RX> rxStats = networkTracker.getNetworkRX();
-            if (ImGui::BeginTable("RX Stats", 8, ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable)) {
-                ImGui::TableSetupColumn("Interface");
-                ImGui::TableSetupColumn("Bytes");
-                ImGui::TableSetupColumn("Packets");
-                ImGui::TableSetupColumn("Errs");
-                ImGui::TableSetupColumn("Drop");
-                ImGui::TableSetupColumn("FIFO");
-                ImGui::TableSetupColumn("Frame");
-                ImGui::TableSetupColumn("Compressed");
-                ImGui::TableHeadersRow();
-
-                for (const auto& [iface, rx] : rxStats) {
-                    ImGui::TableNextRow();
-                    ImGui::TableNextColumn(); ImGui::Text("%s", iface.c_str());
-                    ImGui::TableNextColumn(); ImGui::Text("%s", formatNetworkBytes(rx.bytes).c_str());
-                    ImGui::TableNextColumn(); ImGui::Text("%d", rx.packets);
-                    ImGui::TableNextColumn(); ImGui::Text("%d", rx.errs);
-                    ImGui::TableNextColumn(); ImGui::Text("%d", rx.drop);
-                    ImGui::TableNextColumn(); ImGui::Text("%d", rx.fifo);
-                    ImGui::TableNextColumn(); ImGui::Text("%d", rx.frame);
-                    ImGui::TableNextColumn(); ImGui::Text("%d", rx.compressed);
-                }
-                ImGui::EndTable();
-            }
-            ImGui::EndTabItem();
+    setTracing(traceFile != nullptr);
+    auto saveTrace = [traceFile]() {
+        if (traceFile && !writeChromeTrace(traceFile)) {
+            fprintf(stderr, "Error: could not write trace to %s\n", traceFile);
         }
-
-        if (ImGui::BeginTabItem("TX (Transmitter)")) {
-            map<string, TX> txStats = networkTracker.getNetworkTX();
-            if (ImGui::BeginTable("TX Stats", 8, ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable)) {
-                ImGui::TableSetupColumn("Interface");
-                ImGui::TableSetupColumn("Bytes");
-                ImGui::TableSetupColumn("Packets");
-                ImGui::TableSetupColumn("Errs");
-                ImGui::TableSetupColumn("Drop");
-                ImGui::TableSetupColumn("FIFO");
-                ImGui::TableSetupColumn("Colls");
-                ImGui::TableSetupColumn("Compressed");
-                ImGui::TableHeadersRow();
-
-                for (const auto& [iface, tx] : txStats) {
-                    ImGui::TableNextRow();
-                    ImGui::TableNextColumn(); ImGui::Text("%s", iface.c_str());
-                    ImGui::TableNextColumn(); ImGui::Text("%s", formatNetworkBytes(tx.bytes).c_str());
-                    ImGui::TableNextColumn(); ImGui::Text("%d", tx.packets);
-                    ImGui::TableNextColumn(); ImGui::Text("%d", tx.errs);
-                    ImGui::TableNextColumn(); ImGui::Text("%d", tx.drop);
-                    ImGui::TableNextColumn(); ImGui::Text("%d", tx.fifo);
-                    ImGui::TableNextColumn(); ImGui::Text("%d", tx.colls);
-                    ImGui::TableNextColumn(); ImGui::Text("%d", tx.compressed);
-                }
-                ImGui::EndTable();
-            }
-            ImGui::EndTabItem();
-        }
-
-        if (ImGui::BeginTabItem("Network Usage")) {
-            static bool showRX = true, showTX = true;
-            ImGui::Checkbox("Show RX", &showRX);
-            ImGui::SameLine();
-            ImGui::Checkbox("Show TX", &showTX);
-
-            map<string, RX> rxStats = networkTracker.getNetworkRX();
-            map<string, TX> txStats = networkTracker.getNetworkTX();
-            rateTracker.update(networkTracker, ImGui::GetTime()); // Update rates
-
-            if (showRX) {
-                ImGui::Text("RX Network Usage:");
-                for (const auto& [iface, rx] : rxStats) {
-                    if (iface.find("lo") != string::npos) continue;
-                    float rate = rateTracker.rxRate[iface]; // Smoothed rate in bytes/sec
-                    float scaledRate = rate / (1024 * 1024); // Scale to MB/s for progress bar
-                    ImGui::Text("%s:", iface.c_str());
-                    ImGui::SameLine(150);
-                    // Cap the progress bar to a reasonable max value (e.g., 10 MB/s) to avoid overflow
-                    float maxRate = 10.0f; // Adjust based on your network's expected max bandwidth
-                    ImGui::ProgressBar(scaledRate / maxRate, ImVec2(-1, 0), formatNetworkBytes(rate).c_str());
-                }
-            }
-
-            if (showTX) {
-                ImGui::Text("TX Network Usage:");
-                for (const auto& [iface, tx] : txStats) {
-                    if (iface.find("lo") != string::npos) continue;
-                    float rate = rateTracker.txRate[iface]; // Smoothed rate in bytes/sec
-                    float scaledRate = rate / (1024 * 1024); // Scale to MB/s for progress bar
-                    ImGui::Text("%s:", iface.c_str());
-                    ImGui::SameLine(150);
-                    float maxRate = 10.0f; // Adjust based on your network's expected max bandwidth
-                    ImGui::ProgressBar(scaledRate / maxRate, ImVec2(-1, 0), formatNetworkBytes(rate).c_str());
-                }
-            }
-            ImGui::EndTabItem();
-        }
-        ImGui::EndTabBar();
+    };
+    if (terminalMode) {
+        int status = runTerminalUI(refreshInterval);
+        saveTrace();
+        return status;
     }
-    ImGui::End();
-}
 
-int main(int, char**) {
     //initialize SDL with video, timer, and game controller subsystems
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMECONTROLLER) != 0) {
         printf("Error: %s\n", SDL_GetError());
@@ -516,37 +140,111 @@ int main(int, char**) {
     ImGui_ImplSDL2_InitForOpenGL(window, gl_context); // initialize ImGui SDL2 backend (event handling, input)
     ImGui_ImplOpenGL3_Init(glsl_version); // initialize ImGui OpenGL3 backend (rendering using OpenGL)
 
+    setProbeThreadName("ui");
+
+    // the sampler wakes the event loop with a user event whenever a new snapshot is ready
+    const Uint32 snapshotEvent = SDL_RegisterEvents(1);
+    // the sampler was constructed before --cadence was parsed
+    for (int c = 0; c < COLLECTORS; ++c) sampler.setCadence(static_cast<Collector>(c), defaultCadence(static_cast<Collector>(c)));
+    sampler.start([snapshotEvent]() {
+        SDL_Event wake = {};
+        wake.type = snapshotEvent;
+        SDL_PushEvent(&wake);
+    });
+
     ImVec4 clear_color = ImVec4(0.0f, 0.0f, 0.0f, 1.0f); //set background color
     bool done = false;
+    bool windowVisible = true;
+    int pendingFrames = 2; // ImGui needs a couple of frames after input for its layout to settle
 
     while (!done) {
+        // Sleep until there is input, a new snapshot, or an animation deadline (the text
+        // cursor blink while typing in the filter box). While the window is minimized or
+        // hidden nothing is rendered at all; we only wait for it to come back.
+        int timeoutMs = pendingFrames > 0 ? 0 : (windowVisible && io.WantTextInput ? 500 : 1000);
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
-            ImGui_ImplSDL2_ProcessEvent(&event);
-            if (event.type == SDL_QUIT || (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE))
-                done = true; // exit loop if quit event or window close event occurs
+        bool gotEvent = SDL_WaitEventTimeout(&event, timeoutMs) != 0;
+        if (gotEvent) {
+            do {
+                ImGui_ImplSDL2_ProcessEvent(&event);
+                if (event.type == SDL_QUIT || (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE))
+                    done = true; // exit loop if quit event or window close event occurs
+                if (event.type == SDL_WINDOWEVENT) {
+                    switch (event.window.event) {
+                        case SDL_WINDOWEVENT_MINIMIZED:
+                        case SDL_WINDOWEVENT_HIDDEN:
+                            windowVisible = false;
+                            break;
+                        case SDL_WINDOWEVENT_RESTORED:
+                        case SDL_WINDOWEVENT_SHOWN:
+                        case SDL_WINDOWEVENT_EXPOSED:
+                        case SDL_WINDOWEVENT_MAXIMIZED:
+                            windowVisible = true;
+                            break;
+                    }
+                    sampler.setBackground(!windowVisible);
+                }
+                // a new snapshot needs one frame, input needs one more to settle
+                pendingFrames = max(pendingFrames, event.type == snapshotEvent ? 1 : 2);
+            } while (SDL_PollEvent(&event));
+        }
+
+        if (done) break;
+        if (!windowVisible) {
+            pendingFrames = 0;
+            continue;
         }
+        if (!gotEvent && pendingFrames == 0 && !io.WantTextInput) {
+            continue; // timed out with nothing to animate
+        }
+        if (pendingFrames > 0) pendingFrames--;
+
+        TRACE_SCOPE("Frame");
+        shared_ptr<const SystemSnapshot> snapshot = sampler.latest();
 
         //start a new frame for ImGui
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplSDL2_NewFrame(window);
-        ImGui::NewFrame();
+        {
+            TRACE_SCOPE("ImGui::NewFrame");
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplSDL2_NewFrame(window);
+            ImGui::NewFrame();
+        }
 
         ImVec2 mainDisplay = io.DisplaySize; //retrieve display size
         // draw 3 custom UI windows
-        memoryProcessesWindow("== Memory and Processes ==", ImVec2((mainDisplay.x / 2) - 20, (mainDisplay.y / 2) + 30), ImVec2((mainDisplay.x / 2) + 10, 10));
-        systemWindow("== System ==", ImVec2((mainDisplay.x / 2) - 10, (mainDisplay.y / 2) + 30), ImVec2(10, 10));
-        networkWindow("== Network ==", ImVec2(mainDisplay.x - 20, (mainDisplay.y / 2) - 60), ImVec2(10, (mainDisplay.y / 2) + 50));
-
-        ImGui::Render();
+        memoryProcessesWindow("== Memory and Processes ==", ImVec2((mainDisplay.x / 2) - 20, (mainDisplay.y / 2) + 30), ImVec2((mainDisplay.x / 2) + 10, 10), *snapshot);
+        systemWindow("== System ==", ImVec2((mainDisplay.x / 2) - 10, (mainDisplay.y / 2) + 30), ImVec2(10, 10), *snapshot);
+        networkWindow("== Network ==", ImVec2(mainDisplay.x - 20, (mainDisplay.y / 2) - 60), ImVec2(10, (mainDisplay.y / 2) + 50), *snapshot);
+
+        // cadences changed in the Sampling tab or next to the graphs
+        const float* cadences = requestedCadences();
+        for (int c = 0; c < COLLECTORS; ++c)
+            if (cadences[c] > 0) sampler.setCadence(static_cast<Collector>(c), cadences[c]);
+        // selecting processes lists their threads, and the rows on screen get
+        // their PSS read first
+        sampler.setThreadPids(selectedProcesses());
+        sampler.setVisiblePids(visibleProcesses());
+
+        {
+            TRACE_SCOPE("ImGui::Render");
+            ImGui::Render();
+        }
         glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y); // set OpenGL viewport to match the display size
         glClearColor(clear_color.x, clear_color.y, clear_color.z, clear_color.w); // clear the screen to black
         glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // render ImGui draw data
-        SDL_GL_SwapWindow(window); //swap buffers to display rendered frame
+        {
+            TRACE_SCOPE("ImGui_ImplOpenGL3_RenderDrawData");
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // render ImGui draw data
+        }
+        {
+            TRACE_SCOPE("SDL_GL_SwapWindow");
+            SDL_GL_SwapWindow(window); //swap buffers to display rendered frame
+        }
     }
 
     //cleanup
+    sampler.stop();
+    saveTrace();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
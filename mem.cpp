@@ -9,35 +9,86 @@
 #include <map>
 #include <dirent.h>
 #include <cctype>
+#include <cstring>
 #include <cmath> // Include for std::round
 
+// Maps a /proc/meminfo key (without the colon) to the MemoryInfo field it fills,
+// or nullptr for keys we don't keep. Switching on the first character and then
+// comparing the length leaves at most one memcmp per line.
+static unsigned long* meminfoField(MemoryInfo& mem, const char* key, size_t length) {
+#define MEMINFO_KEY(name, field) \
+    if (length == sizeof(name) - 1 && memcmp(key, name, sizeof(name) - 1) == 0) return &mem.field
+    switch (key[0]) {
+        case 'A':
+            MEMINFO_KEY("AnonPages", anon_pages_kb);
+            break;
+        case 'B':
+            MEMINFO_KEY("Buffers", buffers_kb);
+            break;
+        case 'C':
+            MEMINFO_KEY("Cached", cached_kb);
+            MEMINFO_KEY("CommitLimit", commit_limit_kb);
+            MEMINFO_KEY("Committed_AS", committed_as_kb);
+            break;
+        case 'D':
+            MEMINFO_KEY("Dirty", dirty_kb);
+            break;
+        case 'H':
+            MEMINFO_KEY("HugePages_Total", hugepages_total);
+            MEMINFO_KEY("HugePages_Free", hugepages_free);
+            MEMINFO_KEY("HugePages_Rsvd", hugepages_reserved);
+            MEMINFO_KEY("HugePages_Surp", hugepages_surplus);
+            MEMINFO_KEY("Hugepagesize", hugepage_size_kb);
+            break;
+        case 'M':
+            MEMINFO_KEY("MemTotal", mem_total_kb);
+            MEMINFO_KEY("MemFree", mem_free_kb);
+            MEMINFO_KEY("MemAvailable", mem_available_kb);
+            MEMINFO_KEY("Mapped", mapped_kb);
+            break;
+        case 'S':
+            MEMINFO_KEY("SwapTotal", swap_total_kb);
+            MEMINFO_KEY("SwapFree", swap_free_kb);
+            MEMINFO_KEY("SwapCached", swap_cached_kb);
+            MEMINFO_KEY("Shmem", shmem_kb);
+            MEMINFO_KEY("Slab", slab_kb);
+            MEMINFO_KEY("SReclaimable", slab_reclaimable_kb);
+            MEMINFO_KEY("SUnreclaim", slab_unreclaimable_kb);
+            break;
+        case 'W':
+            MEMINFO_KEY("Writeback", writeback_kb);
+            break;
+    }
+#undef MEMINFO_KEY
+    return nullptr;
+}
+
 // Function that reads Linux system memory stats from /proc/meminfo and converts them
 // into a MemoryInfo struct.
 MemoryInfo SystemResourceTracker::getMemoryInfo() {
-    MemoryInfo mem = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
-
-    // Use a unified map to store all values
-    std::map<std::string, unsigned long> memStats;
-    std::ifstream meminfo("/proc/meminfo");
-    std::string line;
-
-    while (std::getline(meminfo, line)) {
-        std::istringstream iss(line);
-        std::string key;
-        unsigned long value;
-        iss >> key >> value;
-        // The colon is part of the key in /proc/meminfo
-        if (!key.empty()) {
-            key.pop_back(); // Remove the colon
-            memStats[key] = value;
-        }
+    MONITOR_PROBE(PROBE_GET_MEMORY_INFO);
+    MemoryInfo mem{};
+
+    char path[PATH_MAX];
+    char text[8192]; // /proc/meminfo is around 1.5 KB
+    if (!monitorPathf(path, sizeof(path), "/proc/meminfo") || readFileInto(path, text, sizeof(text)) <= 0)
+        return mem;
+
+    // every line is "Key:   value kB" (or just "Key:   value" for page counts)
+    for (const char* line = text; *line; ) {
+        const char* colon = strchr(line, ':');
+        if (!colon) break;
+        if (unsigned long* field = meminfoField(mem, line, colon - line))
+            *field = strtoul(colon + 1, nullptr, 10);
+        const char* next = strchr(colon, '\n');
+        if (!next) break;
+        line = next + 1;
     }
-    meminfo.close();
 
-    unsigned long memTotal = memStats["MemTotal"];
-    unsigned long memAvailable = memStats["MemAvailable"];
-    unsigned long swapTotal = memStats["SwapTotal"];
-    unsigned long swapFree = memStats["SwapFree"];
+    unsigned long memTotal = mem.mem_total_kb;
+    unsigned long memAvailable = mem.mem_available_kb;
+    unsigned long swapTotal = mem.swap_total_kb;
+    unsigned long swapFree = mem.swap_free_kb;
 
     // Calculate used memory based on MemAvailable, matching 'free' command logic
     unsigned long usedMem = memTotal - memAvailable;
@@ -58,15 +109,33 @@ MemoryInfo SystemResourceTracker::getMemoryInfo() {
     return mem;
 }
 
-// This is a method of the SystemResourceTracer class.
-// It returns  disk information struct containing total_space, used_space, usage_percent
-DiskInfo SystemResourceTracker::getDiskInfo() {
-    struct statvfs stat;
-    statvfs("/", &stat);
+const char* memoryLayerName(MemoryLayer layer) {
+    static const char* const names[MEMORY_LAYER_COUNT] = {
+        "Anonymous", "Shmem", "Page cache", "Buffers", "Slab", "Kernel", "Free",
+    };
+    return layer < MEMORY_LAYER_COUNT ? names[layer] : "?";
+}
 
-    DiskInfo disk;
-    disk.total_space = static_cast<float>(stat.f_blocks) * stat.f_frsize / (1024.0f * 1024.0f * 1024.0f);
-    disk.used_space = static_cast<float>(stat.f_blocks - stat.f_bfree) * stat.f_frsize / (1024.0f * 1024.0f * 1024.0f);
+void memoryComposition(const MemoryInfo& mem, float layersKb[MEMORY_LAYER_COUNT]) {
+    // the counters are read at slightly different moments, so clamp rather than
+    // let one layer go negative
+    auto atLeastZero = [](double kb) { return static_cast<float>(kb > 0 ? kb : 0); };
+    layersKb[MEMORY_ANON] = mem.anon_pages_kb;
+    layersKb[MEMORY_SHMEM] = mem.shmem_kb;
+    layersKb[MEMORY_PAGE_CACHE] = atLeastZero(static_cast<double>(mem.cached_kb) - mem.shmem_kb);
+    layersKb[MEMORY_BUFFERS] = mem.buffers_kb;
+    layersKb[MEMORY_SLAB] = mem.slab_kb;
+    layersKb[MEMORY_FREE] = mem.mem_free_kb;
+    double accounted = 0;
+    for (int i = 0; i < MEMORY_LAYER_COUNT; ++i)
+        if (i != MEMORY_KERNEL) accounted += layersKb[i];
+    layersKb[MEMORY_KERNEL] = atLeastZero(mem.mem_total_kb - accounted);
+}
+
+DiskInfo makeDiskInfo(unsigned long long totalBytes, unsigned long long usedBytes) {
+    DiskInfo disk = {0.0f, 0.0f, 0.0f, totalBytes, usedBytes};
+    disk.total_space = static_cast<float>(totalBytes) / (1024.0f * 1024.0f * 1024.0f);
+    disk.used_space = static_cast<float>(usedBytes) / (1024.0f * 1024.0f * 1024.0f);
 
     // Round off the values
     disk.total_space = std::round(disk.total_space);
@@ -77,58 +146,174 @@ DiskInfo SystemResourceTracker::getDiskInfo() {
     return disk;
 }
 
+// This is a method of the SystemResourceTracer class.
+// It returns  disk information struct containing total_space, used_space, usage_percent
+DiskInfo SystemResourceTracker::getDiskInfo() {
+    MONITOR_PROBE(PROBE_GET_DISK_INFO);
+    struct statvfs stat;
+    if (statvfs("/", &stat) != 0) return makeDiskInfo(0, 0);
+    return makeDiskInfo(static_cast<unsigned long long>(stat.f_blocks) * stat.f_frsize,
+                        static_cast<unsigned long long>(stat.f_blocks - stat.f_bfree) * stat.f_frsize);
+}
+
+SystemResourceTracker::~SystemResourceTracker() {
+    if (procDir) closedir(procDir);
+}
+
 // Function that reads and returns a list of all running processes on a Linux system
 std::vector<Proc> SystemResourceTracker::getProcessList() {
     std::vector<Proc> processes;
-    DIR *dir = opendir("/proc");
-    if (!dir) return processes;
+    getProcessList(processes);
+    return processes;
+}
 
+// Parses one /proc/<pid>/stat line into `process`. Fields after the name, which is
+// in parentheses and may itself contain spaces or ')', are counted from the state.
+static bool parseProcessStat(const char* line, Proc& process) {
+    const char* nameStart = strchr(line, '(');
+    const char* nameEnd = strrchr(line, ')');
+    if (!nameStart || !nameEnd || nameEnd < nameStart) return false;
+    process.name.assign(nameStart + 1, nameEnd - nameStart - 1); // comm fits the small-string buffer
+
+    // fields[0] is the state, [1] ppid, [11] utime, [12] stime, [19] starttime, [20] vsize, [21] rss
+    long long fields[24] = {};
+    char state = 0;
+    int count = 0;
+    const char* at = nameEnd + 1;
+    while (count < 24) {
+        while (*at == ' ') at++;
+        if (*at == '\0' || *at == '\n') break;
+        if (count == 0) state = *at;
+        else fields[count] = strtoll(at, nullptr, 10);
+        count++;
+        while (*at && *at != ' ' && *at != '\n') at++;
+    }
+
+    process.state = 0;
+    process.ppid = 0;
+    process.vsize = process.rss = process.utime = process.stime = process.startTime = 0;
+    if (count >= 24) {
+        process.state = state;
+        process.ppid = fields[1];
+        process.vsize = fields[20]; //virtual memory size
+        process.rss = fields[21]; // resident set size
+        process.utime = fields[11]; // user mode CPU time
+        process.stime = fields[12]; // kernel mode CPU time
+        process.startTime = fields[19];
+    }
+    return true;
+}
+
+bool readProcess(int pid, int& fd, Proc& process) {
+    char line[SystemResourceTracker::STAT_READ_SIZE];
+    if (fd >= 0) {
+        ssize_t length = pread(fd, line, sizeof(line) - 1, 0);
+        if (length > 0) {
+            line[length] = '\0';
+            return parseProcess(pid, line, process);
+        }
+        fd = ProcessStatFiles::STALE;
+    }
+    char path[PATH_MAX];
+    if (!monitorPathf(path, sizeof(path), "/proc/%d/stat", pid)) return false;
+    if (readFileInto(path, line, sizeof(line)) <= 0) return false; // exited since readdir
+    return parseProcess(pid, line, process);
+}
+
+bool parseProcess(int pid, const char* line, Proc& process) {
+    process.pid = pid;
+    process.cpuPercent = 0.0f;
+    process.pss = process.swap = -1;
+    process.io = ProcessIO{};
+    process.fds = FdUsage{};
+    process.netReceiveRate = process.netSendRate = 0.0f;
+    if (!parseProcessStat(line, process)) return false;
+    // a tree of its own until ProcessTree links it up
+    process.parent = process.firstChild = process.nextSibling = -1;
+    process.treeCPU = 0.0f;
+    process.treeRss = process.rss;
+    process.treeCount = 1;
+    return true;
+}
+
+// Fills `processes` with every process in /proc. Elements that are already in the
+// vector are overwritten rather than reallocated, and the /proc directory stream
+// stays open between calls, as do the stat files of the processes found. The
+// directory is read first; a long PID list is then parsed by the scan pool,
+// whose workers batch their chunks' held files through io_uring, and a short
+// one by this thread, batched the same way.
+void SystemResourceTracker::getProcessList(std::vector<Proc>& processes) {
+    MONITOR_PROBE(PROBE_GET_PROCESS_LIST);
+    if (procDir && procDirRoot != monitorRootGeneration()) {
+        closedir(procDir);
+        procDir = nullptr;
+    }
+    if (!procDir) {
+        procDir = opendir(monitorPath("/proc").c_str());
+        procDirRoot = monitorRootGeneration();
+    } else {
+        rewinddir(procDir); // re-reads the directory, so new and exited PIDs show up
+    }
+    if (!procDir) {
+        processes.clear();
+        return;
+    }
+
+    pids.clear();
     struct dirent *entry;
-    while ((entry = readdir(dir)) != nullptr) {
+    while ((entry = readdir(procDir)) != nullptr) {
         // check if entry is a directory and its name starts with a digit
-        if (entry->d_type == DT_DIR && std::isdigit(entry->d_name[0])) {
-            std::string pid = entry->d_name;
-            std::string statPath = "/proc/" + pid + "/stat";
-            std::ifstream statFile(statPath);
-
-            if (statFile.is_open()) {
-                Proc process;
-                process.pid = std::stoi(pid); //parse pid string to an integer
-
-                std::string line;
-                std::getline(statFile, line);
-
-                size_t nameStart = line.find('(');
-                size_t nameEnd = line.rfind(')');
-
-                // extracts the process name between the parentheses
-                if (nameStart != std::string::npos && nameEnd != std::string::npos) {
-                    process.name = line.substr(nameStart + 1, nameEnd - nameStart - 1);
-
-                    // create an input string stream from the remainder of the line after the closing parenthesis
-                    std::istringstream iss(line.substr(nameEnd + 1));
-                    std::string field; // variable for temporarily holding each extracted word/token
-                    std::vector<std::string> fields;
-
-                    while (iss >> field) {
-                        fields.push_back(field);
-                    }
-
-                    if (fields.size() >= 24) {
-                        process.state = fields[0][0];
-                        process.vsize = std::stoll(fields[20]); //virtual memory size
-                        process.rss = std::stoll(fields[21]); // resident set size
-                        process.utime = std::stoll(fields[11]); // user mode CPU time
-                        process.stime = std::stoll(fields[12]); // kernel mode CPU time
-                    }
-
-                    processes.push_back(process);
-                }
-                statFile.close();
-            }
+        if (entry->d_type != DT_DIR || !std::isdigit(entry->d_name[0])) continue;
+        pids.push_back(atoi(entry->d_name));
+    }
+    // /proc lists PIDs in order; a fixture tree on disk doesn't
+    if (!is_sorted(pids.begin(), pids.end())) sort(pids.begin(), pids.end());
+    statFiles.match(pids, statFds);
+
+    int workers = scanWorkers > 0 ? scanWorkers : processScanWorkers();
+    scanThreads = 1;
+    if (workers > 1 && pids.size() >= ProcessScanPool::PARALLEL_MIN) {
+        scanPool.setWorkers(workers);
+        scanPool.scan(pids, statFds, processes);
+        scanThreads = scanPool.lastScanThreads();
+    } else if (statReads.usesRing()) {
+        processes.resize(readProcessesBatched(statReads, pids, statFds, 0, pids.size(), processes, 0));
+    } else {
+        size_t count = 0;
+        for (size_t i = 0; i < pids.size(); ++i) {
+            if (count == processes.size()) processes.emplace_back();
+            if (readProcess(pids[i], statFds[i], processes[count])) count++;
         }
+        processes.resize(count);
     }
+    statFiles.dropStale(pids, statFds);
+}
 
-    closedir(dir);
-    return processes;
-}
\ No newline at end of file
+size_t readProcessesBatched(ReadBatch& reads, const vector<int>& pids, vector<int>& fds, size_t begin, size_t end,
+                            vector<Proc>& processes, size_t used) {
+    reads.clear();
+    for (size_t i = begin; i < end; ++i)
+        if (fds[i] >= 0) reads.add(fds[i]);
+    size_t at = begin;
+    auto readByPath = [&](size_t until) {
+        for (; at < until; ++at) {
+            if (used == processes.size()) processes.emplace_back();
+            if (readProcess(pids[at], fds[at], processes[used])) used++;
+        }
+    };
+    reads.run([&](size_t, const char* line, ssize_t length) {
+        while (fds[at] < 0) readByPath(at + 1);
+        if (used == processes.size()) processes.emplace_back();
+        bool read;
+        if (length > 0) {
+            read = parseProcess(pids[at], line, processes[used]);
+        } else {
+            fds[at] = ProcessStatFiles::STALE; // the PID was reused, or the process is gone
+            read = readProcess(pids[at], fds[at], processes[used]);
+        }
+        if (read) used++;
+        at++;
+    });
+    readByPath(end);
+    return used;
+}
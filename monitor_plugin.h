@@ -0,0 +1,95 @@
+/*
+ * monitor_plugin.h - collector plugins for the system monitor.
+ *
+ * A plugin is a shared object in the directory given with --plugins. The
+ * monitor dlopen()s every *.so there when its sampler starts and calls the
+ * plugin's MONITOR_PLUGIN_ENTRY function once, which describes the plugin:
+ * its name, how often it wants to run, and the metrics it reports. That list
+ * is fixed for the plugin's lifetime.
+ *
+ * The monitor sets aside a section of metric_count doubles for the plugin in
+ * every snapshot it takes. When the plugin is due, sample() is called with a
+ * pointer to its section in the snapshot being filled and writes its values
+ * there, in the order of `metrics`; nothing is copied afterwards. A value that
+ * can't be read is written as NAN. Between runs the section keeps the values
+ * of the last one.
+ *
+ * sample() runs on the monitor's sampler thread, between the built-in
+ * collectors, so it should take well under a millisecond and must not block.
+ * The monitor's own CPU, memory, disk, process and network figures are
+ * described with the same structures and listed alongside the plugins'.
+ *
+ * This header is plain C:
+ *
+ *     static const struct monitor_metric metrics[] = {{"queue_depth", "jobs"}};
+ *     static int sample(void *state, double *values, uint32_t count, double now)
+ *     {
+ *         values[0] = read_queue_depth();
+ *         return 0;
+ *     }
+ *     int monitor_plugin_register(struct monitor_plugin *plugin, const struct monitor_plugin_host *host)
+ *     {
+ *         if (host->abi_version != MONITOR_PLUGIN_ABI_VERSION) return -1;
+ *         plugin->name = "queue";
+ *         plugin->cadence = 1.0f;
+ *         plugin->metric_count = 1;
+ *         plugin->metrics = metrics;
+ *         plugin->sample = sample;
+ *         return 0;
+ *     }
+ */
+#ifndef MONITOR_PLUGIN_H
+#define MONITOR_PLUGIN_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bump whenever a structure below changes */
+#define MONITOR_PLUGIN_ABI_VERSION 1u
+/* the function every plugin exports, see monitor_plugin_register_fn */
+#define MONITOR_PLUGIN_ENTRY "monitor_plugin_register"
+/* longest section or metric name the monitor shows, without the NUL */
+#define MONITOR_PLUGIN_NAME_MAX 47
+
+struct monitor_metric {
+    const char *name; /* [a-z0-9_.], unique within the plugin */
+    const char *unit; /* shown after the value, e.g. "%", "B/s"; "" for none */
+};
+
+/* What the monitor tells a plugin when loading it */
+struct monitor_plugin_host {
+    uint32_t abi_version;   /* MONITOR_PLUGIN_ABI_VERSION of the monitor */
+    uint32_t reserved;
+    const char *directory;  /* the plugin directory, e.g. for a config file next to
+                             * the plugin; only valid during the call */
+};
+
+/* What the plugin fills in. Strings and the metrics array must stay valid
+ * until destroy() is called. */
+struct monitor_plugin {
+    const char *name;      /* section name: [a-z0-9_], unique among the loaded plugins */
+    float cadence;         /* seconds between runs; rounded to the monitor's schedule */
+    uint32_t metric_count;
+    const struct monitor_metric *metrics;
+    void *state;           /* passed back to the functions below */
+
+    /* Writes `count` values (metric_count) for sample time `now`, seconds on
+     * a monotonic clock. Returns 0, or -1 if nothing could be read, which
+     * marks the section stale without touching its values. */
+    int (*sample)(void *state, double *values, uint32_t count, double now);
+    /* called once when the monitor unloads the plugin; may be NULL */
+    void (*destroy)(void *state);
+};
+
+/* Returns 0 once `plugin` is filled in, or nonzero to not be loaded. The
+ * monitor zeroes `plugin` before the call. */
+typedef int (*monitor_plugin_register_fn)(struct monitor_plugin *plugin, const struct monitor_plugin_host *host);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MONITOR_PLUGIN_H */
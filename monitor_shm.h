@@ -0,0 +1,153 @@
+/*
+ * monitor_shm.h - read-only access to the system monitor's shared-memory snapshot.
+ *
+ * The monitor publishes its latest sample into a POSIX shared-memory segment
+ * (MONITOR_SHM_NAME) with the fixed binary layout below. Any local process can
+ * map it read-only and copy the snapshot out with monitor_shm_read(), which costs
+ * a memcpy instead of a walk over /proc.
+ *
+ * The segment is protected by a seqlock: the writer makes `seq` odd while it
+ * copies a new snapshot in and even again once it is done. Readers never take a
+ * lock, so they can't block the writer; they retry if they raced with an update.
+ * Until the first snapshot is published `seq` is MONITOR_SHM_SEQ_UNPUBLISHED,
+ * which is odd, so readers built against an older copy of this header see a
+ * busy writer rather than an all-zero snapshot.
+ *
+ * This header is plain C so it can be dropped into any tool:
+ *
+ *     const struct monitor_shm_segment *seg = monitor_shm_map(MONITOR_SHM_NAME);
+ *     struct monitor_shm_snapshot snap;
+ *     if (seg && monitor_shm_read(seg, &snap) == 0)
+ *         printf("cpu %.1f%%\n", snap.cpu_percent);
+ *     monitor_shm_unmap(seg);
+ */
+#ifndef MONITOR_SHM_H
+#define MONITOR_SHM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MONITOR_SHM_NAME "/system-monitor"
+#define MONITOR_SHM_MAGIC 0x534e4f4du /* "MONS" */
+/* bump whenever the layout of monitor_shm_snapshot changes */
+#define MONITOR_SHM_VERSION 1u
+
+#define MONITOR_SHM_MAX_IFACES 32
+#define MONITOR_SHM_IFNAME_LEN 16
+/* how many times a reader retries before giving up on a busy writer */
+#define MONITOR_SHM_READ_RETRIES 64
+/* `seq` of a segment nothing has been published into yet */
+#define MONITOR_SHM_SEQ_UNPUBLISHED 1u
+
+struct monitor_shm_iface {
+    char name[MONITOR_SHM_IFNAME_LEN];
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    double rx_rate; /* smoothed bytes/s */
+    double tx_rate; /* smoothed bytes/s */
+};
+
+struct monitor_shm_snapshot {
+    uint64_t timestamp_ns; /* CLOCK_REALTIME of the sample */
+    uint64_t sequence;     /* number of snapshots published so far */
+
+    float cpu_percent;
+    float temperature_c; /* 0 when no sensor was found */
+    float fan_rpm;       /* 0 when no fan was found */
+    float reserved0;
+
+    uint64_t mem_total_kb;
+    uint64_t mem_available_kb;
+    uint64_t swap_total_kb;
+    uint64_t swap_free_kb;
+    uint64_t disk_total_bytes;
+    uint64_t disk_used_bytes;
+
+    uint32_t proc_total;
+    uint32_t proc_running;
+    uint32_t proc_sleeping; /* includes idle kernel threads, like top */
+    uint32_t proc_disk_sleep;
+    uint32_t proc_zombie;
+    uint32_t proc_stopped;
+
+    uint32_t iface_count;
+    uint32_t reserved1;
+    struct monitor_shm_iface ifaces[MONITOR_SHM_MAX_IFACES];
+};
+
+struct monitor_shm_segment {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;   /* offset of `data` from the start of the segment */
+    uint32_t snapshot_size; /* sizeof(struct monitor_shm_snapshot) of the writer */
+    uint64_t seq;           /* seqlock counter, odd while the writer is updating */
+    uint8_t reserved[40];   /* keep `data` on its own cache line */
+    struct monitor_shm_snapshot data;
+};
+
+/* Copies the latest snapshot into `out`. Returns 0 on success and -1 if no
+ * snapshot has been published yet or every attempt overlapped a write (the
+ * writer is not blocked by this in any way). */
+static inline int monitor_shm_read(const struct monitor_shm_segment *seg, struct monitor_shm_snapshot *out)
+{
+    int attempt;
+    for (attempt = 0; attempt < MONITOR_SHM_READ_RETRIES; ++attempt) {
+        uint64_t before = __atomic_load_n(&seg->seq, __ATOMIC_ACQUIRE);
+        if (before == MONITOR_SHM_SEQ_UNPUBLISHED)
+            return -1;
+        if (before & 1u)
+            continue; /* writer is mid-update */
+        memcpy(out, &seg->data, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&seg->seq, __ATOMIC_RELAXED) == before)
+            return 0;
+    }
+    return -1;
+}
+
+/* Maps the segment read-only and checks that its layout matches this header.
+ * Returns NULL if the monitor isn't running or publishes an incompatible version. */
+static inline const struct monitor_shm_segment *monitor_shm_map(const char *name)
+{
+    struct stat st;
+    void *addr;
+    const struct monitor_shm_segment *seg;
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct monitor_shm_segment)) {
+        close(fd);
+        return NULL;
+    }
+    addr = mmap(NULL, sizeof(struct monitor_shm_segment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return NULL;
+    seg = (const struct monitor_shm_segment *)addr;
+    if (seg->magic != MONITOR_SHM_MAGIC || seg->version != MONITOR_SHM_VERSION ||
+        seg->snapshot_size != sizeof(struct monitor_shm_snapshot)) {
+        munmap(addr, sizeof(struct monitor_shm_segment));
+        return NULL;
+    }
+    return seg;
+}
+
+static inline void monitor_shm_unmap(const struct monitor_shm_segment *seg)
+{
+    if (seg)
+        munmap((void *)seg, sizeof(struct monitor_shm_segment));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
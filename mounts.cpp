@@ -0,0 +1,262 @@
+#include "header.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+
+// Per-filesystem usage. statvfs() on a mount whose NFS server went away blocks
+// in the kernel until the server returns, possibly forever, and can't be
+// interrupted. So only pool workers call it, one request per mount at a time:
+// a hung mount ties up one worker, which is replaced (up to MAX_WORKERS), and the
+// sampler keeps publishing the mount's last values marked as hung.
+
+// filesystems without blocks of their own worth showing
+static const char* const PSEUDO_FILESYSTEMS[] = {
+    "autofs", "binfmt_misc", "bpf", "cgroup", "cgroup2", "configfs", "debugfs",
+    "devpts", "devtmpfs", "efivarfs", "fusectl", "hugetlbfs", "mqueue", "nsfs",
+    "proc", "pstore", "rpc_pipefs", "securityfs", "selinuxfs", "sysfs", "tracefs",
+};
+
+struct MountSlot {
+    MountUsage usage;         // state and age are filled in by update()
+    string statPath;          // mount point under the monitor root
+    bool listed = true;       // false once the mount is gone but a worker still runs its statvfs()
+    unsigned long long request = 0; // queued or running statvfs(), 0 if none
+    bool running = false;     // a worker has picked the request up
+    bool completed = false;   // a result arrived that update() hasn't timestamped yet
+    double requestedAt = -1e18; // monitorClock() when the last request was queued
+    double sampledAt = -1;    // monitorClock() when the last result arrived, -1 if none yet
+};
+
+// Workers only touch the pool under its lock and never read the clock, so a
+// worker that returns from a long statvfs() just files its result and carries on.
+struct MountTracker::Pool {
+    std::mutex lock;
+    std::condition_variable wake;
+    vector<MountSlot> slots;
+    vector<unsigned long long> queue; // requests waiting for a worker, oldest first
+    unsigned long long nextRequest = 1;
+    int workers = 0;
+    bool stopping = false;
+
+    MountSlot* find(unsigned long long request) {
+        for (MountSlot& slot : slots)
+            if (slot.request == request) return &slot;
+        return nullptr;
+    }
+};
+
+const char* mountStateName(MountState state) {
+    switch (state) {
+        case MOUNT_PENDING: return "pending";
+        case MOUNT_OK: return "ok";
+        case MOUNT_HUNG: return "hung";
+        case MOUNT_STALE: return "stale";
+        case MOUNT_ERROR: return "error";
+    }
+    return "?";
+}
+
+static void mountWorker(shared_ptr<MountTracker::Pool> pool);
+
+MountTracker::MountTracker() : pool(make_shared<Pool>()) {}
+
+MountTracker::~MountTracker() {
+    {
+        std::lock_guard<std::mutex> guard(pool->lock);
+        pool->stopping = true;
+    }
+    pool->wake.notify_all();
+    if (mountinfoFd >= 0) close(mountinfoFd);
+}
+
+static void mountWorker(shared_ptr<MountTracker::Pool> pool) {
+    setProbeThreadName("mount worker");
+    char path[PATH_MAX];
+    std::unique_lock<std::mutex> guard(pool->lock);
+    while (true) {
+        pool->wake.wait(guard, [&] { return pool->stopping || !pool->queue.empty(); });
+        if (pool->stopping) break;
+        unsigned long long request = pool->queue.front();
+        pool->queue.erase(pool->queue.begin());
+        MountSlot* slot = pool->find(request);
+        if (!slot) continue; // unmounted while queued
+        snprintf(path, sizeof(path), "%s", slot->statPath.c_str());
+        slot->running = true;
+        guard.unlock();
+
+        struct statvfs stat;
+        int error = statvfs(path, &stat) == 0 ? 0 : errno;
+
+        guard.lock();
+        slot = pool->find(request); // the slot list may have been rebuilt meanwhile
+        if (!slot) continue;
+        slot->request = 0;
+        slot->running = false;
+        slot->completed = true;
+        slot->usage.error = error;
+        if (error == 0) {
+            MountUsage& usage = slot->usage;
+            usage.totalBytes = static_cast<unsigned long long>(stat.f_blocks) * stat.f_frsize;
+            usage.usedBytes = static_cast<unsigned long long>(stat.f_blocks - stat.f_bfree) * stat.f_frsize;
+            usage.availableBytes = static_cast<unsigned long long>(stat.f_bavail) * stat.f_frsize;
+            usage.totalInodes = stat.f_files;
+            usage.usedInodes = stat.f_files - stat.f_ffree;
+        }
+    }
+    pool->workers--;
+}
+
+// True when the mount table has to be (re)read: the first time, after the monitor
+// root changed, and whenever the kernel flags the open mountinfo with POLLPRI.
+// A regular file (fixture trees) never raises POLLPRI, so it is read once.
+bool MountTracker::mountsChanged() {
+    if (mountinfoRoot != monitorRootGeneration()) {
+        if (mountinfoFd >= 0) close(mountinfoFd);
+        char path[PATH_MAX];
+        mountinfoFd = monitorPathf(path, sizeof(path), "/proc/self/mountinfo") ? open(path, O_RDONLY | O_CLOEXEC) : -1;
+        mountinfoRoot = monitorRootGeneration();
+        return true;
+    }
+    if (mountinfoFd < 0) return false;
+    pollfd fd = {mountinfoFd, POLLPRI, 0};
+    return poll(&fd, 1, 0) > 0 && (fd.revents & (POLLPRI | POLLERR));
+}
+
+// mountinfo escapes space, tab, newline and backslash as \ooo
+static void unescapeMountField(char* field) {
+    char* out = field;
+    for (char* in = field; *in; ++in) {
+        if (in[0] == '\\' && in[1] >= '0' && in[1] <= '3' && in[2] >= '0' && in[2] <= '7' && in[3] >= '0' && in[3] <= '7') {
+            *out++ = static_cast<char>((in[1] - '0') * 64 + (in[2] - '0') * 8 + (in[3] - '0'));
+            in += 3;
+        } else {
+            *out++ = *in;
+        }
+    }
+    *out = '\0';
+}
+
+// Parses mountinfo into a new slot list. Mounts that were there before keep their
+// values and any outstanding request; one whose statvfs() is still running after
+// it disappeared stays as an unlisted slot, so its stuck worker is still counted.
+void MountTracker::readMounts() {
+    size_t length = 0;
+    if (mountinfoFd >= 0) {
+        if (mountinfo.size() < 4096) mountinfo.resize(4096);
+        while (true) {
+            if (length + 1 >= mountinfo.size()) mountinfo.resize(mountinfo.size() * 2);
+            ssize_t n = pread(mountinfoFd, mountinfo.data() + length, mountinfo.size() - 1 - length, length);
+            if (n <= 0) break;
+            length += n;
+        }
+    }
+    if (mountinfo.empty()) mountinfo.resize(1);
+    mountinfo[length] = '\0';
+
+    // "36 35 98:0 /root /mnt/point rw,noatime master:1 - ext4 /dev/sda1 rw"
+    vector<MountSlot> parsed;
+    vector<string> devices; // major:minor of every listed mount; bind mounts show up once
+    for (char* line = mountinfo.data(); *line; ) {
+        char* next = strchr(line, '\n');
+        if (next) *next = '\0';
+        char* following = next ? next + 1 : line + strlen(line);
+
+        char* fields[16];
+        int count = 0;
+        for (char* save = nullptr, *token = strtok_r(line, " ", &save); token && count < 16;
+             token = strtok_r(nullptr, " ", &save)) {
+            fields[count++] = token;
+        }
+        int separator = 6;
+        while (separator < count && strcmp(fields[separator], "-") != 0) separator++;
+        line = following;
+        if (separator + 2 >= count) continue; // malformed
+
+        const char* fsType = fields[separator + 1];
+        bool pseudo = false;
+        for (const char* name : PSEUDO_FILESYSTEMS) pseudo = pseudo || strcmp(fsType, name) == 0;
+        if (pseudo || std::find(devices.begin(), devices.end(), fields[2]) != devices.end()) continue;
+        devices.push_back(fields[2]);
+
+        unescapeMountField(fields[4]);
+        unescapeMountField(fields[separator + 2]);
+        // a later mount on the same point hides the earlier one
+        parsed.erase(std::remove_if(parsed.begin(), parsed.end(),
+                                    [&](const MountSlot& slot) { return slot.usage.mountPoint == fields[4]; }),
+                     parsed.end());
+        MountSlot slot;
+        slot.usage.id = atoi(fields[0]);
+        slot.usage.mountPoint = fields[4];
+        slot.usage.fsType = fsType;
+        slot.usage.source = fields[separator + 2];
+        slot.statPath = monitorPath(slot.usage.mountPoint);
+        parsed.push_back(std::move(slot));
+    }
+
+    std::lock_guard<std::mutex> guard(pool->lock);
+    for (MountSlot& old : pool->slots) {
+        auto same = std::find_if(parsed.begin(), parsed.end(), [&](const MountSlot& slot) {
+            return old.listed && slot.usage.id == old.usage.id && slot.usage.mountPoint == old.usage.mountPoint;
+        });
+        if (same != parsed.end()) {
+            MountUsage fresh = std::move(same->usage);
+            string statPath = std::move(same->statPath);
+            *same = std::move(old);
+            same->usage.fsType = std::move(fresh.fsType);
+            same->usage.source = std::move(fresh.source);
+            same->statPath = std::move(statPath);
+        } else if (old.running) {
+            old.listed = false;
+            parsed.push_back(std::move(old));
+        }
+    }
+    pool->slots = std::move(parsed);
+}
+
+void MountTracker::update(vector<MountUsage>& mounts) {
+    MONITOR_PROBE(PROBE_UPDATE_MOUNTS);
+    if (mountsChanged()) readMounts();
+
+    double now = monitorClock();
+    std::unique_lock<std::mutex> guard(pool->lock);
+    int stuck = 0;
+    bool queued = false;
+    size_t listed = 0;
+    for (MountSlot& slot : pool->slots) {
+        if (slot.completed) {
+            slot.completed = false;
+            slot.sampledAt = now;
+        }
+        bool hung = slot.running && now - slot.requestedAt > TIMEOUT;
+        stuck += hung;
+        if (!slot.listed) continue; // dropped on the next reparse once its worker is back
+        if (slot.request == 0 && now - slot.requestedAt >= INTERVAL) {
+            slot.request = pool->nextRequest++;
+            slot.requestedAt = now;
+            pool->queue.push_back(slot.request);
+            queued = true;
+        }
+
+        if (listed == mounts.size()) mounts.emplace_back();
+        MountUsage& out = mounts[listed++];
+        out = slot.usage;
+        out.age = slot.sampledAt < 0 ? 0.0f : static_cast<float>(now - slot.sampledAt);
+        if (hung) out.state = MOUNT_HUNG;
+        else if (slot.usage.error == ESTALE) out.state = MOUNT_STALE;
+        else if (slot.usage.error != 0) out.state = MOUNT_ERROR;
+        else if (slot.sampledAt < 0) out.state = MOUNT_PENDING;
+        else if (out.age > STALE_AGE) out.state = MOUNT_STALE;
+        else out.state = MOUNT_OK;
+    }
+    mounts.resize(listed);
+
+    // workers stuck in statvfs() don't count towards the ones kept free
+    while (pool->workers - stuck < WORKERS && pool->workers < MAX_WORKERS) {
+        pool->workers++;
+        std::thread(mountWorker, pool).detach();
+    }
+    guard.unlock();
+    if (queued) pool->wake.notify_all();
+}
@@ -1,5 +1,7 @@
 #include "header.h"
+#include <algorithm>
 #include <arpa/inet.h>
+#include <cstring>
 #include <net/if.h>
 #include <sys/ioctl.h>
 
@@ -21,108 +23,177 @@ string formatNetworkBytes(long long bytes) {
     return string(buffer);
 }
 
+// Lists the interfaces of a fixture tree from <root>/sys/class/net. Addresses
+// only exist in the kernel (getifaddrs), so they show up as N/A.
+static void getFixtureInterfaces(Networks& nets) {
+    char path[PATH_MAX];
+    if (!monitorPathf(path, sizeof(path), "/sys/class/net")) return;
+    DIR* dir = opendir(path);
+    if (!dir) return;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        size_t length = strlen(entry->d_name);
+        if (entry->d_name[0] == '.' || length >= IFNAMSIZ) continue; // not an interface name
+        IP4 interface = {};
+        memcpy(interface.name, entry->d_name, length);
+        strncpy(interface.addressBuffer, "N/A", INET_ADDRSTRLEN);
+        nets.ip4s.push_back(interface);
+    }
+    closedir(dir);
+    sort(nets.ip4s.begin(), nets.ip4s.end(),
+         [](const IP4& a, const IP4& b) { return strcmp(a.name, b.name) < 0; });
+}
+
 // Function that retrieves IPV4 network interfaces
 Networks NetworkTracker::getNetworkInterfaces() {
     Networks nets;
+    getNetworkInterfaces(nets);
+    return nets;
+}
+
+// Refills nets.ip4s with one entry per interface, sorted by name, reusing the
+// vector's capacity. getifaddrs() itself allocates, so this is left to the
+// sampler's slower interface cadence.
+void NetworkTracker::getNetworkInterfaces(Networks& nets) {
+    MONITOR_PROBE(PROBE_GET_NETWORK_INTERFACES);
+    nets.ip4s.clear();
+    if (hasMonitorRoot()) {
+        getFixtureInterfaces(nets);
+        return;
+    }
     struct ifaddrs *ifap, *ifa;
 
     if (getifaddrs(&ifap) == -1) {
-        return nets;
+        return;
     }
 
-    std::map<std::string, IP4> ifaceMap; // to deduplicate by name
-
+    // one entry per address; interfaces without an IPv4 address show N/A
     for (ifa = ifap; ifa; ifa = ifa->ifa_next) {
         if (!ifa->ifa_name) continue;
-
-        std::string name = ifa->ifa_name;
-        auto it = ifaceMap.find(name);
-
-        // If not seen before, create entry with N/A
-        if (it == ifaceMap.end()) {
-            IP4 interface;
-            interface.name = strdup(name.c_str());
-            strncpy(interface.addressBuffer, "N/A", INET_ADDRSTRLEN);
-            ifaceMap[name] = interface;
-        }
-
-        // If this entry has IPv4, update address
+        IP4 interface;
+        snprintf(interface.name, sizeof(interface.name), "%s", ifa->ifa_name);
         if (ifa->ifa_addr && ifa->ifa_addr->sa_family == AF_INET) {
             struct sockaddr_in *addr = (struct sockaddr_in*)ifa->ifa_addr;
-            inet_ntop(AF_INET, &(addr->sin_addr), ifaceMap[name].addressBuffer, INET_ADDRSTRLEN);
+            inet_ntop(AF_INET, &(addr->sin_addr), interface.addressBuffer, INET_ADDRSTRLEN);
+        } else {
+            strncpy(interface.addressBuffer, "N/A", INET_ADDRSTRLEN);
         }
+        nets.ip4s.push_back(interface);
     }
-
-    // Move deduplicated interfaces into final vector
-    for (auto &kv : ifaceMap) {
-        nets.ip4s.push_back(kv.second);   
-    }
-
     freeifaddrs(ifap);
-    return nets;
-}
-
 
+    // deduplicate by name, keeping an IPv4 address over N/A
+    auto hasAddress = [](const IP4& entry) { return strcmp(entry.addressBuffer, "N/A") != 0; };
+    sort(nets.ip4s.begin(), nets.ip4s.end(), [&](const IP4& a, const IP4& b) {
+        int order = strcmp(a.name, b.name);
+        return order != 0 ? order < 0 : hasAddress(a) > hasAddress(b);
+    });
+    nets.ip4s.erase(unique(nets.ip4s.begin(), nets.ip4s.end(),
+                           [](const IP4& a, const IP4& b) { return strcmp(a.name, b.name) == 0; }),
+                    nets.ip4s.end());
+}
 
 // Function that reads network receive (RX) statistics from /proc/net/dev and
 // returns them in a map<string, RX>, where each key is a network interface name (e.g "eth0" or "wlan0")
 // and each value is an RX struct holding the stats.
-// The purpose of the function is to parse and extract network receive statistics (e.g number of bytes and packets)
-// for each network interface.
 map<string, RX> NetworkTracker::getNetworkRX() {
+    MONITOR_PROBE(PROBE_GET_NETWORK_RX);
     map<string, RX> rxStats;
-    ifstream netDevFile("/proc/net/dev");
-    string line;
-    
-    getline(netDevFile, line); // Skip header line
-    getline(netDevFile, line); // Skip second header line
-
-    while (getline(netDevFile, line)) {
-        istringstream iss(line);
-        string interfaceName;
-        getline(iss, interfaceName, ':'); // read characters from iss(the line) up to the colon : and stores them in interfaceName
-        interfaceName = interfaceName.substr(interfaceName.find_first_not_of(" \t")); // remove any leading spaces or tabs from the interface name
-        
-        RX rx;
-        // extract numbers from the rest of the line
-        iss >> rx.bytes >> rx.packets >> rx.errs >> rx.drop 
-            >> rx.fifo >> rx.frame >> rx.compressed >> rx.multicast;
-        
-        rxStats[interfaceName] = rx; // store the parsed stats into the map using the interface name as the key
-    }
-
-    netDevFile.close();
+    map<string, TX> txStats;
+    getNetworkStats(rxStats, txStats);
     return rxStats;
 }
 
 // Function that reads the file /proc/net/dev to extract transmit (TX) statistics
 // for each network interface and returns them as a map
 map<string, TX> NetworkTracker::getNetworkTX() {
+    MONITOR_PROBE(PROBE_GET_NETWORK_TX);
+    map<string, RX> rxStats;
     map<string, TX> txStats;
-    ifstream netDevFile("/proc/net/dev");
-    string line;
-    
-    getline(netDevFile, line); // Skip header line
-    getline(netDevFile, line); // Skip second header line
-
-    while (getline(netDevFile, line)) {
-        istringstream iss(line);
-        string interfaceName;
-        getline(iss, interfaceName, ':');
-        interfaceName = interfaceName.substr(interfaceName.find_first_not_of(" \t"));
-        
-        long long rxDummy;
-        for (int i = 0; i < 8; ++i) { // TX stats appear after the first 8 RX values. In this loop, We read and discard the RX values
-            iss >> rxDummy;
+    getNetworkStats(rxStats, txStats);
+    return txStats;
+}
+
+// Parses /proc/net/dev into per-interface RX and TX stats. Each line after the two
+// header lines is "name: <8 RX counters> <8 TX counters>".
+void NetworkTracker::getNetworkStats(map<string, RX>& rxStats, map<string, TX>& txStats) {
+    MONITOR_PROBE(PROBE_GET_NETWORK_STATS);
+    char path[PATH_MAX];
+    if (!monitorPathf(path, sizeof(path), "/proc/net/dev") || readFileInto(path, netDev) < 0) {
+        rxStats.clear();
+        txStats.clear();
+        return;
+    }
+
+    const char* line = netDev.data();
+    for (int header = 0; header < 2 && line; ++header) { // skip the two header lines
+        line = strchr(line, '\n');
+        if (line) line++;
+    }
+
+    size_t interfaces = 0;
+    while (line && *line) {
+        const char* end = strchr(line, '\n');
+        const char* colon = strchr(line, ':');
+        if (colon && (!end || colon < end)) {
+            const char* start = line + strspn(line, " \t"); // names are right-aligned
+            name.assign(start, colon - start);
+
+            long long values[16] = {};
+            char* at = const_cast<char*>(colon + 1);
+            for (long long& value : values) value = strtoll(at, &at, 10);
+
+            auto rx = rxStats.find(name);
+            if (rx == rxStats.end()) rx = rxStats.emplace(name, RX{}).first;
+            rx->second = RX{values[0], values[1], values[2], values[3],
+                            values[4], values[5], values[6], values[7]};
+            auto tx = txStats.find(name);
+            if (tx == txStats.end()) tx = txStats.emplace(name, TX{}).first;
+            tx->second = TX{values[8], values[9], values[10], values[11],
+                            values[12], values[13], values[14], values[15]};
+            interfaces++;
         }
-        
-        TX tx;
-        iss >> tx.bytes >> tx.packets >> tx.errs >> tx.drop 
-            >> tx.fifo >> tx.colls >> tx.carrier >> tx.compressed;
-        
-        txStats[interfaceName] = tx;
+        line = end ? end + 1 : nullptr;
     }
 
-    netDevFile.close();
-    return txStats;
-}
\ No newline at end of file
+    // an interface went away: start over so its entries don't linger
+    if (rxStats.size() != interfaces || txStats.size() != interfaces) {
+        rxStats.clear();
+        txStats.clear();
+        getNetworkStats(rxStats, txStats);
+    }
+}
+
+// Folds the per-interface byte deltas since the last update into
+// exponentially smoothed rates
+void NetworkRate::update(const map<string, RX>& rxStats, const map<string, TX>& txStats, float time) {
+    // Update RX rates
+    for (auto& [iface, rx] : rxStats) {
+        if (lastRX.count(iface)) {
+            float dt = time - lastRX[iface].second; //dt is time since last sample
+            float instantaneousRate = dt > 0 ? (rx.bytes - lastRX[iface].first) / dt : 0;
+            // Apply exponential moving average
+            if (rxRate.count(iface)) {
+                rxRate[iface] = ALPHA * instantaneousRate + (1.0f - ALPHA) * rxRate[iface];
+            } else {
+                rxRate[iface] = instantaneousRate; // Initialize with first value
+            }
+        }
+        lastRX[iface] = {rx.bytes, time};
+    }
+
+    // Update TX rates
+    for (auto& [iface, tx] : txStats) {
+        if (lastTX.count(iface)) {
+            float dt = time - lastTX[iface].second;
+            float instantaneousRate = dt > 0 ? (tx.bytes - lastTX[iface].first) / dt : 0;
+            // Apply exponential moving average
+            if (txRate.count(iface)) {
+                txRate[iface] = ALPHA * instantaneousRate + (1.0f - ALPHA) * txRate[iface];
+            } else {
+                txRate[iface] = instantaneousRate; // Initialize with first value
+            }
+        }
+        lastTX[iface] = {tx.bytes, time};
+    }
+}
@@ -0,0 +1,315 @@
+#include "header.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <time.h>
+
+// Self-instrumentation: per-thread probe counters and the monitor's own usage.
+//
+// Every thread that runs a probe gets its own block of counters. Only the owning
+// thread writes to it (plain load + store on relaxed atomics, no read-modify-write),
+// and readers just load, so neither side ever waits on the other. The registry
+// mutex is only taken once per thread, when its block is created.
+
+struct ProbeCounters {
+    std::atomic<unsigned long long> calls{0};
+    std::atomic<unsigned long long> wallNs{0};
+    std::atomic<unsigned long long> maxNs{0};
+    std::atomic<unsigned long long> syscalls{0};
+    std::atomic<unsigned long long> bytesRead{0};
+    std::atomic<unsigned long long> allocations{0};
+};
+
+struct ThreadProbes {
+    char name[16] = "thread";
+    std::atomic<unsigned> epoch{0}; // counters are only valid while this matches resetEpoch
+    ProbeCounters probes[PROBE_COUNT];
+    int ioFd = -1;                         // held open /proc/thread-self/io, closed on thread exit
+    unsigned long long probeSyscalls = 0;  // reads of ioFd done by the probes themselves,
+    unsigned long long probeBytes = 0;     // subtracted so probes don't bill their own cost
+    std::atomic<bool> retired{false};      // the thread has exited; the counters are final
+};
+
+// Lets go of a thread's block when the thread exits. The block itself stays in
+// the registry for its totals, but the fd on the dead thread's io file doesn't.
+struct ThreadProbesRetirer {
+    ThreadProbes* probes = nullptr;
+    ~ThreadProbesRetirer() {
+        if (!probes) return;
+        if (probes->ioFd >= 0) close(probes->ioFd);
+        probes->ioFd = -2; // a probe in a later thread_local destructor mustn't reopen it
+        probes->retired.store(true, std::memory_order_release);
+    }
+};
+
+static std::mutex registryLock;
+static vector<ThreadProbes*> registry; // never shrinks, so totals survive thread exit
+static std::atomic<unsigned> resetEpoch{0};
+static thread_local ThreadProbes* localProbes = nullptr;
+static thread_local ThreadProbesRetirer localRetirer;
+static thread_local unsigned long long localAllocations = 0;
+static thread_local unsigned long long localRingEnters = 0;
+
+static const char* const probeNames[PROBE_COUNT] = {
+    "Sampler tick",
+    "calculateCPUUsage",
+    "getProcessList",
+    "countProcessStates",
+    "ProcessTree::update",
+    "ThreadTracker::update",
+    "SmapsTracker::update",
+    "ProcessIOTracker::update",
+    "FdTracker::update",
+    "SocketTracker::update",
+    "getMemoryInfo",
+    "getDiskInfo",
+    "MountTracker::update",
+    "DiskStatsTracker::update",
+    "PressureTracker::read",
+    "CgroupTracker::update",
+    "PluginHost::update",
+    "AlertEngine::update",
+    "getNetworkInterfaces",
+    "getNetworkRX",
+    "getNetworkTX",
+    "getNetworkStats",
+    "getCPUTemperature",
+    "getFanSpeed",
+    "readSensors",
+    "CPUinfo",
+    "systemWindow",
+    "memoryProcessesWindow",
+    "networkWindow",
+    "Terminal frame",
+};
+
+const char* probeName(ProbeId id) { return id < PROBE_COUNT ? probeNames[id] : "?"; }
+
+// Count every C++ heap allocation on the calling thread. This is a plain
+// thread_local increment, cheap enough to leave on in normal builds.
+//
+// With -DMONITOR_COUNT_MALLOC=1 the malloc family is replaced as well, which also
+// catches allocations made inside libc (opendir, fopen, getifaddrs, ...). Since
+// operator new goes through malloc, it doesn't count separately then.
+#ifndef MONITOR_COUNT_MALLOC
+#define MONITOR_COUNT_MALLOC 0
+#endif
+
+#if MONITOR_COUNT_MALLOC
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* p);
+
+void* malloc(size_t size) {
+    ++localAllocations;
+    return __libc_malloc(size);
+}
+void* calloc(size_t count, size_t size) {
+    ++localAllocations;
+    return __libc_calloc(count, size);
+}
+void* realloc(void* p, size_t size) {
+    ++localAllocations;
+    return __libc_realloc(p, size);
+}
+void* memalign(size_t alignment, size_t size) {
+    ++localAllocations;
+    return __libc_memalign(alignment, size);
+}
+void* aligned_alloc(size_t alignment, size_t size) { return memalign(alignment, size); }
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    void* p = memalign(alignment, size);
+    if (!p) return ENOMEM;
+    *out = p;
+    return 0;
+}
+void free(void* p) { __libc_free(p); }
+}
+#endif
+
+void* operator new(std::size_t size) {
+#if !MONITOR_COUNT_MALLOC
+    ++localAllocations;
+#endif
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, std::size_t) noexcept { free(p); }
+void operator delete[](void* p, std::size_t) noexcept { free(p); }
+
+unsigned long long threadAllocationCount() { return localAllocations; }
+
+void countRingEnter() { ++localRingEnters; }
+
+unsigned long long threadRingEnters() { return localRingEnters; }
+
+static unsigned long long monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long long>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+static ThreadProbes* threadProbes() {
+    if (!localProbes) {
+        localProbes = new ThreadProbes();
+        localProbes->epoch = resetEpoch.load();
+        std::lock_guard<std::mutex> guard(registryLock);
+        registry.push_back(localProbes);
+        localRetirer.probes = localProbes;
+    }
+    return localProbes;
+}
+
+void setProbeThreadName(const char* name) {
+    snprintf(threadProbes()->name, sizeof(ThreadProbes::name), "%s", name);
+    setTraceThreadName(name);
+}
+
+static unsigned long long parseIoField(const char* text, const char* key) {
+    const char* at = strstr(text, key);
+    return at ? strtoull(at + strlen(key), nullptr, 10) : 0;
+}
+
+// Reads this thread's I/O accounting. The kernel bumps the counters after a read
+// completes, so the values never include the read that fetched them.
+static void readThreadIo(ThreadProbes* probes, unsigned long long& syscalls, unsigned long long& bytes) {
+    syscalls = bytes = 0;
+    if (probes->ioFd == -1) {
+        probes->ioFd = open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC);
+        if (probes->ioFd < 0) probes->ioFd = -2; // not available; don't retry every call
+    }
+    if (probes->ioFd < 0) return;
+
+    char buffer[256];
+    ssize_t n = pread(probes->ioFd, buffer, sizeof(buffer) - 1, 0);
+    if (n <= 0) return;
+    buffer[n] = '\0';
+    bytes = parseIoField(buffer, "rchar:");
+    syscalls = parseIoField(buffer, "syscr:") + parseIoField(buffer, "syscw:");
+    probes->probeSyscalls += 1;
+    probes->probeBytes += n;
+}
+
+ScopedProbe::ScopedProbe(ProbeId probe) : id(probe) {
+    ThreadProbes* probes = threadProbes();
+    startProbeSyscalls = probes->probeSyscalls;
+    startProbeBytes = probes->probeBytes;
+    readThreadIo(probes, startSyscalls, startBytes);
+    startAllocations = localAllocations;
+    startRingEnters = localRingEnters;
+    startNs = monotonicNs();
+}
+
+ScopedProbe::~ScopedProbe() {
+    unsigned long long elapsed = monotonicNs() - startNs;
+    unsigned long long allocations = localAllocations - startAllocations;
+    ThreadProbes* probes = localProbes;
+
+    // syscalls and bytes made by probes nested in this scope (and by our own
+    // opening read) are the probes' cost, not the measured code's
+    unsigned long long ownSyscalls = probes->probeSyscalls - startProbeSyscalls;
+    unsigned long long ownBytes = probes->probeBytes - startProbeBytes;
+    unsigned long long endSyscalls, endBytes;
+    readThreadIo(probes, endSyscalls, endBytes);
+    unsigned long long syscalls = endSyscalls >= startSyscalls + ownSyscalls ? endSyscalls - startSyscalls - ownSyscalls : 0;
+    unsigned long long bytes = endBytes >= startBytes + ownBytes ? endBytes - startBytes - ownBytes : 0;
+    syscalls += localRingEnters - startRingEnters; // syscr doesn't count them
+
+    // a reset from another thread just bumps the epoch; the owner clears its own counters
+    unsigned epoch = resetEpoch.load(std::memory_order_relaxed);
+    if (probes->epoch.load(std::memory_order_relaxed) != epoch) {
+        for (auto& counters : probes->probes) {
+            counters.calls.store(0, std::memory_order_relaxed);
+            counters.wallNs.store(0, std::memory_order_relaxed);
+            counters.maxNs.store(0, std::memory_order_relaxed);
+            counters.syscalls.store(0, std::memory_order_relaxed);
+            counters.bytesRead.store(0, std::memory_order_relaxed);
+            counters.allocations.store(0, std::memory_order_relaxed);
+        }
+        probes->epoch.store(epoch, std::memory_order_release);
+    }
+
+    auto add = [](std::atomic<unsigned long long>& counter, unsigned long long value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    };
+    ProbeCounters& counters = probes->probes[id];
+    add(counters.calls, 1);
+    add(counters.wallNs, elapsed);
+    add(counters.syscalls, syscalls);
+    add(counters.bytesRead, bytes);
+    add(counters.allocations, allocations);
+    if (elapsed > counters.maxNs.load(std::memory_order_relaxed))
+        counters.maxNs.store(elapsed, std::memory_order_relaxed);
+}
+
+// The registry lock is held throughout (rather than copying the list), so drawing
+// the overhead table doesn't allocate; it only delays a new thread's first probe.
+void forEachProbeTotal(const std::function<void(const char*, ProbeId, const ProbeTotals&)>& fn) {
+    std::lock_guard<std::mutex> guard(registryLock);
+    unsigned epoch = resetEpoch.load();
+    for (ThreadProbes* probes : registry) {
+        if (probes->epoch.load(std::memory_order_acquire) != epoch) continue; // reset, not yet cleared
+        for (int i = 0; i < PROBE_COUNT; ++i) {
+            const ProbeCounters& counters = probes->probes[i];
+            ProbeTotals totals = {
+                counters.calls.load(std::memory_order_relaxed),
+                counters.wallNs.load(std::memory_order_relaxed),
+                counters.maxNs.load(std::memory_order_relaxed),
+                counters.syscalls.load(std::memory_order_relaxed),
+                counters.bytesRead.load(std::memory_order_relaxed),
+                counters.allocations.load(std::memory_order_relaxed),
+            };
+            if (totals.calls > 0) fn(probes->name, static_cast<ProbeId>(i), totals);
+        }
+    }
+}
+
+void resetProbeTotals() { resetEpoch++; }
+
+SelfUsageTracker::SelfUsageTracker() : lastCPUTime(-1), current{0.0f, 0, 0, 0} {}
+
+// Reads utime/stime, thread count and memory from /proc/self/stat. CPU% is the
+// share of one core used since the previous update, like top's per-process column.
+SelfUsage SelfUsageTracker::update() {
+    auto now = std::chrono::steady_clock::now();
+    if (lastCPUTime >= 0 && now - lastSample < std::chrono::seconds(1)) return current;
+
+    int fd = open("/proc/self/stat", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return current;
+    char buffer[1024];
+    ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (n <= 0) return current;
+    buffer[n] = '\0';
+
+    const char* fields = strrchr(buffer, ')');
+    if (!fields) return current;
+    long long utime, stime, threads, vsize, rss;
+    // fields after the name: state(3) ... utime(14) stime(15) ... num_threads(20) ... vsize(23) rss(24)
+    if (sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lld %lld %*d %*d %*d %*d %lld %*d %*u %lld %lld",
+               &utime, &stime, &threads, &vsize, &rss) != 5) {
+        return current;
+    }
+
+    static const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    long long cpuTime = utime + stime;
+    if (lastCPUTime >= 0) {
+        float seconds = std::chrono::duration<float>(now - lastSample).count();
+        if (seconds > 0 && ticksPerSecond > 0)
+            current.cpuPercent = 100.0f * (cpuTime - lastCPUTime) / (seconds * ticksPerSecond);
+    }
+    lastCPUTime = cpuTime;
+    lastSample = now;
+    current.rssBytes = static_cast<unsigned long long>(rss) * pageSize;
+    current.vmBytes = vsize;
+    current.threads = threads;
+    return current;
+}
@@ -0,0 +1,279 @@
+#include "header.h"
+#include <algorithm>
+#include <cstring>
+#include <dlfcn.h>
+
+// Plugins (monitor_plugin.h) and the built-in collectors' headline numbers are
+// both sections of SystemSnapshot::metricValues. A built-in section is a
+// monitor_plugin like any other whose sample() reads the typed fields its
+// collector just filled, so anything that consumes metrics by name (the
+// Metrics tab, alert rules) sees one list.
+
+static string directory;
+
+void setPluginDirectory(const string& path) { directory = path; }
+
+const string& pluginDirectory() { return directory; }
+
+int MetricSchema::find(const string& name) const {
+    auto it = std::find(names.begin(), names.end(), name);
+    return it != names.end() ? static_cast<int>(it - names.begin()) : -1;
+}
+
+// ---- built-in sections ----------------------------------------------------
+
+static const SystemSnapshot& filled(void* state) { return **static_cast<const SystemSnapshot**>(state); }
+
+static const monitor_metric cpuMetrics[] = {{"total", "%"}};
+
+static int sampleCPU(void* state, double* values, uint32_t, double) {
+    values[0] = filled(state).cpuUsage;
+    return 0;
+}
+
+static const monitor_metric sensorMetrics[] = {{"temperature", "C"}, {"fan", "rpm"}};
+
+static int sampleSensors(void* state, double* values, uint32_t, double) {
+    const SystemSnapshot& snap = filled(state);
+    values[0] = snap.temperature;
+    values[1] = snap.fanSpeed;
+    return 0;
+}
+
+static const monitor_metric memoryMetrics[] = {
+    {"used_percent", "%"}, {"used", "B"}, {"available", "B"}, {"total", "B"}, {"swap_used_percent", "%"}};
+
+static int sampleMemory(void* state, double* values, uint32_t, double) {
+    const MemoryInfo& memory = filled(state).memory;
+    values[0] = memory.ram_percent;
+    values[1] = (static_cast<double>(memory.mem_total_kb) - memory.mem_available_kb) * 1024.0;
+    values[2] = memory.mem_available_kb * 1024.0;
+    values[3] = memory.mem_total_kb * 1024.0;
+    values[4] = memory.swap_percent;
+    return 0;
+}
+
+static const monitor_metric diskMetrics[] = {{"used_percent", "%"}, {"used", "B"}, {"total", "B"}};
+
+static int sampleDisk(void* state, double* values, uint32_t, double) {
+    const DiskInfo& disk = filled(state).disk;
+    values[0] = disk.usage_percent;
+    values[1] = static_cast<double>(disk.used_bytes);
+    values[2] = static_cast<double>(disk.total_bytes);
+    return 0;
+}
+
+static const monitor_metric pressureMetrics[] = {
+    {"cpu.some.avg10", "%"},    {"cpu.some.avg60", "%"},    {"cpu.full.avg10", "%"},    {"cpu.full.avg60", "%"},
+    {"memory.some.avg10", "%"}, {"memory.some.avg60", "%"}, {"memory.full.avg10", "%"}, {"memory.full.avg60", "%"},
+    {"io.some.avg10", "%"},     {"io.some.avg60", "%"},     {"io.full.avg10", "%"},     {"io.full.avg60", "%"}};
+
+static int samplePressure(void* state, double* values, uint32_t, double) {
+    for (const Pressure& pressure : filled(state).pressure) {
+        bool on = pressure.available;
+        *values++ = on ? pressure.some.avg10 : NAN;
+        *values++ = on ? pressure.some.avg60 : NAN;
+        *values++ = on ? pressure.full.avg10 : NAN;
+        *values++ = on ? pressure.full.avg60 : NAN;
+    }
+    return 0;
+}
+
+static const monitor_metric processMetrics[] = {
+    {"total", ""}, {"running", ""}, {"sleeping", ""}, {"disk_sleep", ""}, {"zombie", ""}, {"stopped", ""}};
+
+static int sampleProcesses(void* state, double* values, uint32_t count, double) {
+    const SystemSnapshot& snap = filled(state);
+    fill(values, values + count, 0.0);
+    values[0] = snap.totalProcesses;
+    for (const auto& [code, processes] : snap.processStates) {
+        switch (code) {
+            case 'R': values[1] += processes; break;
+            case 'S': values[2] += processes; break;
+            case 'D': values[3] += processes; break;
+            case 'Z': values[4] += processes; break;
+            case 'T': case 't': values[5] += processes; break;
+        }
+    }
+    return 0;
+}
+
+static const monitor_metric networkMetrics[] = {{"rx_rate", "B/s"}, {"tx_rate", "B/s"}};
+
+static int sampleNetwork(void* state, double* values, uint32_t, double) {
+    const SystemSnapshot& snap = filled(state);
+    values[0] = values[1] = 0.0;
+    for (const auto& rate : snap.rxRate) values[0] += rate.second;
+    for (const auto& rate : snap.txRate) values[1] += rate.second;
+    return 0;
+}
+
+struct BuiltinSection {
+    Collector collector;
+    const char* name;
+    uint32_t count;
+    const monitor_metric* metrics;
+    int (*sample)(void* state, double* values, uint32_t count, double now);
+};
+
+#define BUILTIN(collector, name, metrics, sample) {collector, name, sizeof(metrics) / sizeof(metrics[0]), metrics, sample}
+
+static const BuiltinSection builtinSections[] = {
+    BUILTIN(COLLECTOR_CPU, "cpu", cpuMetrics, sampleCPU),
+    BUILTIN(COLLECTOR_SENSORS, "sensors", sensorMetrics, sampleSensors),
+    BUILTIN(COLLECTOR_MEMORY, "memory", memoryMetrics, sampleMemory),
+    BUILTIN(COLLECTOR_MOUNTS, "disk", diskMetrics, sampleDisk), // the filesystem mounted at /
+    BUILTIN(COLLECTOR_PRESSURE, "psi", pressureMetrics, samplePressure),
+    BUILTIN(COLLECTOR_PROCESSES, "processes", processMetrics, sampleProcesses),
+    BUILTIN(COLLECTOR_NETWORK, "net", networkMetrics, sampleNetwork), // all interfaces together
+};
+
+#undef BUILTIN
+
+// ---- loading --------------------------------------------------------------
+
+static bool validName(const char* name, const char* allowed) {
+    size_t length = name ? strlen(name) : 0;
+    if (length == 0 || length > MONITOR_PLUGIN_NAME_MAX) return false;
+    for (const char* c = name; *c; ++c)
+        if (!(*c >= 'a' && *c <= 'z') && !(*c >= '0' && *c <= '9') && !strchr(allowed, *c)) return false;
+    return true;
+}
+
+// Checks what a plugin described and gives it a section; false, with
+// `problem` set, if the description is unusable.
+bool PluginHost::add(Plugin entry, MetricSchema& out, const char*& problem) {
+    const monitor_plugin& plugin = entry.plugin;
+    static constexpr uint32_t MAX_METRICS = 4096;
+    if (!validName(plugin.name, "_")) problem = "its name isn't [a-z0-9_]";
+    else if (plugin.metric_count == 0 || plugin.metric_count > MAX_METRICS || !plugin.metrics)
+        problem = "it has no metrics, or too many";
+    else if (!plugin.sample) problem = "it has no sample function";
+    if (problem) return false;
+    for (const MetricSection& section : out.sections) {
+        if (section.name != plugin.name) continue;
+        problem = "a section of that name is already loaded";
+        return false;
+    }
+    for (uint32_t i = 0; i < plugin.metric_count; ++i) {
+        if (!validName(plugin.metrics[i].name, "_.")) {
+            problem = "a metric name isn't [a-z0-9_.]";
+            return false;
+        }
+        for (uint32_t j = 0; j < i; ++j) {
+            if (strcmp(plugin.metrics[i].name, plugin.metrics[j].name) != 0) continue;
+            problem = "a metric name appears twice";
+            return false;
+        }
+    }
+
+    entry.section = out.sections.size();
+    entry.countdown = 0;
+    if (entry.handle && !(entry.plugin.cadence > 0)) entry.plugin.cadence = defaultCadence(COLLECTOR_PLUGINS);
+    out.sections.push_back(
+        MetricSection{plugin.name, entry.collector, entry.plugin.cadence, out.names.size(), plugin.metric_count});
+    for (uint32_t i = 0; i < plugin.metric_count; ++i) {
+        out.names.push_back(string(plugin.name) + "." + plugin.metrics[i].name);
+        out.units.push_back(plugin.metrics[i].unit ? plugin.metrics[i].unit : "");
+    }
+    plugins.push_back(entry);
+    return true;
+}
+
+bool PluginHost::load(const string& path, const string& dir, MetricSchema& out) {
+    void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        fprintf(stderr, "Warning: could not load plugin %s: %s\n", path.c_str(), dlerror());
+        return false;
+    }
+    auto entry = reinterpret_cast<monitor_plugin_register_fn>(dlsym(handle, MONITOR_PLUGIN_ENTRY));
+    monitor_plugin plugin;
+    memset(&plugin, 0, sizeof(plugin));
+    monitor_plugin_host host{MONITOR_PLUGIN_ABI_VERSION, 0, dir.c_str()};
+    const char* problem = nullptr;
+    bool registered = false;
+    if (!entry) problem = "it has no " MONITOR_PLUGIN_ENTRY "()";
+    else if (entry(&plugin, &host) != 0) problem = "it declined (built for another ABI version?)";
+    else registered = true;
+    if (registered && add(Plugin{handle, plugin, COLLECTOR_PLUGINS, 0, 0}, out, problem)) return true;
+
+    fprintf(stderr, "Warning: skipping plugin %s: %s\n", path.c_str(), problem);
+    if (registered && plugin.destroy) plugin.destroy(plugin.state);
+    dlclose(handle);
+    return false;
+}
+
+void PluginHost::loadAll(const string& dir) {
+    if (schema) return;
+    auto built = make_shared<MetricSchema>();
+    const char* problem = nullptr;
+    for (const BuiltinSection& section : builtinSections) {
+        monitor_plugin plugin{section.name, 0.0f, section.count, section.metrics, &filling, section.sample, nullptr};
+        add(Plugin{nullptr, plugin, section.collector, 0, 0}, *built, problem);
+    }
+
+    // in name order, so sections come out the same on every start
+    vector<string> files;
+    if (!dir.empty()) {
+        DIR* listing = opendir(dir.c_str());
+        if (!listing) fprintf(stderr, "Warning: could not open plugin directory %s\n", dir.c_str());
+        for (dirent* file; listing && (file = readdir(listing));) {
+            size_t length = strlen(file->d_name);
+            if (length > 3 && strcmp(file->d_name + length - 3, ".so") == 0) files.push_back(file->d_name);
+        }
+        if (listing) closedir(listing);
+    }
+    sort(files.begin(), files.end());
+    for (const string& file : files) load(dir + "/" + file, dir, *built);
+    schema = built;
+}
+
+size_t PluginHost::pluginCount() const {
+    return count_if(plugins.begin(), plugins.end(), [](const Plugin& plugin) { return plugin.handle != nullptr; });
+}
+
+PluginHost::~PluginHost() {
+    for (Plugin& plugin : plugins) {
+        if (!plugin.handle) continue;
+        if (plugin.plugin.destroy) plugin.plugin.destroy(plugin.plugin.state);
+        dlclose(plugin.handle);
+    }
+}
+
+// The values are carried over from `previous` first; a section that is due is
+// then overwritten in place by its sample(), straight into this snapshot.
+void PluginHost::update(SystemSnapshot& snap, const SystemSnapshot* previous, unsigned due, float pluginCadence) {
+    MONITOR_PROBE(PROBE_UPDATE_PLUGINS);
+    snap.metrics = schema;
+    if (!schema) {
+        snap.metricValues.clear();
+        snap.sectionUpdated.clear();
+        return;
+    }
+    if (previous && previous->metrics == schema) {
+        snap.metricValues = previous->metricValues;
+        snap.sectionUpdated = previous->sectionUpdated;
+    } else {
+        snap.metricValues.assign(schema->size(), NAN);
+        snap.sectionUpdated.assign(schema->sections.size(), -1.0f);
+    }
+
+    filling = &snap;
+    double now = monitorClock();
+    for (Plugin& entry : plugins) {
+        if (!(due & (1u << entry.collector))) continue;
+        if (entry.handle) {
+            // a 5 s plugin on a 1 s plugin cadence takes every fifth run
+            if (entry.countdown > 1) {
+                entry.countdown--;
+                continue;
+            }
+            entry.countdown = static_cast<unsigned>(max(1L, lround(entry.plugin.cadence / pluginCadence)));
+        }
+        const MetricSection& section = schema->sections[entry.section];
+        double* values = snap.metricValues.data() + section.first;
+        if (entry.plugin.sample(entry.plugin.state, values, static_cast<uint32_t>(section.count), now) == 0)
+            snap.sectionUpdated[entry.section] = snap.time;
+    }
+    filling = nullptr;
+}
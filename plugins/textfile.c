@@ -0,0 +1,138 @@
+/*
+ * textfile.c - sample collector plugin: numbers from a text file.
+ *
+ * Reads textfile.txt in the plugin directory, one metric per line:
+ *
+ *     # name value [unit]
+ *     backup_age 3600 s
+ *     queue_depth 12
+ *
+ * The names are taken once, when the plugin is loaded; after that the file is
+ * re-read every second and each value lands under its name, in whatever order
+ * the lines come. Names missing from the file read as NAN. Anything that can
+ * keep a file up to date (a cron job, a shell loop) can feed the monitor this
+ * way.
+ *
+ *     make plugins/textfile.so
+ *     ./monitor --plugins plugins
+ */
+#include "../monitor_plugin.h"
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_METRICS 64
+#define FILE_SIZE 8192
+
+struct textfile {
+    char path[4096];
+    char text[FILE_SIZE];
+    uint32_t count;
+    struct monitor_metric metrics[MAX_METRICS];
+    char names[MAX_METRICS][MONITOR_PLUGIN_NAME_MAX + 1];
+    char units[MAX_METRICS][16];
+};
+
+/* reads the whole file into t->text; 0 on success */
+static int read_text(struct textfile *t)
+{
+    int fd = open(t->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    ssize_t length = read(fd, t->text, FILE_SIZE - 1);
+    close(fd);
+    if (length < 0) return -1;
+    t->text[length] = '\0';
+    return 0;
+}
+
+/* Splits the next non-comment line into name, value and unit. Returns the
+ * position after the line, or NULL at the end of the text. */
+static char *next_line(char *at, char **name, char **value, char **unit)
+{
+    while (*at) {
+        char *end = strchr(at, '\n');
+        char *next = end ? end + 1 : at + strlen(at);
+        if (end) *end = '\0';
+        char *save = NULL;
+        *name = strtok_r(at, " \t", &save);
+        *value = *name ? strtok_r(NULL, " \t", &save) : NULL;
+        *unit = *value ? strtok_r(NULL, " \t", &save) : NULL;
+        if (*name && **name != '#' && *value) return next;
+        at = next;
+    }
+    return NULL;
+}
+
+static int sample(void *state, double *values, uint32_t count, double now)
+{
+    struct textfile *t = state;
+    (void)now;
+    if (read_text(t) != 0) return -1;
+    for (uint32_t i = 0; i < count; ++i) values[i] = NAN;
+    char *name, *value, *unit;
+    for (char *at = t->text; (at = next_line(at, &name, &value, &unit));) {
+        for (uint32_t i = 0; i < count; ++i) {
+            if (strcmp(t->names[i], name) != 0) continue;
+            values[i] = strtod(value, NULL);
+            break;
+        }
+    }
+    return 0;
+}
+
+static void destroy(void *state)
+{
+    free(state);
+}
+
+static int valid_name(const char *name)
+{
+    size_t length = strlen(name);
+    if (length == 0 || length > MONITOR_PLUGIN_NAME_MAX) return 0;
+    for (const char *c = name; *c; ++c)
+        if (!((*c >= 'a' && *c <= 'z') || (*c >= '0' && *c <= '9') || *c == '_' || *c == '.')) return 0;
+    return 1;
+}
+
+int monitor_plugin_register(struct monitor_plugin *plugin, const struct monitor_plugin_host *host)
+{
+    if (host->abi_version != MONITOR_PLUGIN_ABI_VERSION) return -1;
+    struct textfile *t = calloc(1, sizeof(*t));
+    if (!t) return -1;
+    snprintf(t->path, sizeof(t->path), "%s/textfile.txt", host->directory);
+    if (read_text(t) != 0) {
+        fprintf(stderr, "textfile plugin: can't read %s\n", t->path);
+        free(t);
+        return -1;
+    }
+
+    char *name, *value, *unit;
+    for (char *at = t->text; t->count < MAX_METRICS && (at = next_line(at, &name, &value, &unit));) {
+        if (!valid_name(name)) continue;
+        int seen = 0;
+        for (uint32_t i = 0; i < t->count; ++i) seen |= strcmp(t->names[i], name) == 0;
+        if (seen) continue;
+        snprintf(t->names[t->count], sizeof(t->names[0]), "%s", name);
+        snprintf(t->units[t->count], sizeof(t->units[0]), "%s", unit ? unit : "");
+        t->metrics[t->count].name = t->names[t->count];
+        t->metrics[t->count].unit = t->units[t->count];
+        t->count++;
+    }
+    if (t->count == 0) {
+        fprintf(stderr, "textfile plugin: no \"name value\" lines in %s\n", t->path);
+        free(t);
+        return -1;
+    }
+
+    plugin->name = "textfile";
+    plugin->cadence = 1.0f;
+    plugin->metric_count = t->count;
+    plugin->metrics = t->metrics;
+    plugin->state = t;
+    plugin->sample = sample;
+    plugin->destroy = destroy;
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include "header.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/resource.h>
+
+// /proc/<pid>/io (Documentation/filesystems/proc.rst):
+//   rchar: 323934931          bytes passed to read() and friends, cache hits included
+//   wchar: 323929600
+//   syscr: 632687             read system calls
+//   syscw: 632675
+//   read_bytes: 0             bytes the process caused to be fetched from storage
+//   write_bytes: 323932160    bytes it caused to be sent to storage
+//   cancelled_write_bytes: 0  dirtied, then truncated or deleted before writeback
+// read_bytes/write_bytes are what a saturated disk is made of; rchar/wchar also
+// count page cache hits and pipes, so they aren't used.
+
+static int syscallBudget = 1024;
+
+void setProcessIOBudget(int syscalls) { syscallBudget = max(1, syscalls); }
+
+int processIOBudget() { return syscallBudget; }
+
+ProcessIOTracker::~ProcessIOTracker() {
+    for (auto& entry : entries) forget(entry.second);
+}
+
+void ProcessIOTracker::forget(Entry& entry) {
+    if (entry.fd < 0) return;
+    close(entry.fd);
+    entry.fd = -1;
+    cachedFds--;
+}
+
+// Opens one process's file and reads it, keeping the file open if the budget
+// allows. Returns the number of system calls it took.
+int ProcessIOTracker::read(int pid, Entry& entry, double now) {
+    int calls = 0;
+    char path[PATH_MAX];
+    if (!monitorPathf(path, sizeof(path), "/proc/%d/io", pid)) return 0;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    calls++;
+    if (fd < 0) {
+        entry.denied = errno == EACCES || errno == EPERM;
+        entry.io = ProcessIO{};
+        return calls;
+    }
+    if (cachedFds < fdBudget) {
+        entry.fd = fd;
+        cachedFds++;
+    }
+
+    char text[IO_READ_SIZE];
+    ssize_t length = pread(fd, text, sizeof(text) - 1, 0);
+    calls++;
+    if (entry.fd < 0) {
+        close(fd);
+        calls++;
+    }
+    text[max<ssize_t>(length, 0)] = '\0';
+    parse(entry, text, length, now);
+    return calls;
+}
+
+// Works out the rates since the last read from `text`, `length` bytes of the
+// file or -errno.
+void ProcessIOTracker::parse(Entry& entry, char* text, ssize_t length, double now) {
+    if (length <= 0) {
+        forget(entry); // the process is gone; a new one under its PID gets a new fd
+        entry.io = ProcessIO{};
+        entry.lastTime = -1;
+        return;
+    }
+
+    Counters counters;
+    for (char* line = text; *line;) {
+        char* colon = strchr(line, ':');
+        if (!colon) break;
+        *colon = '\0';
+        char* end;
+        unsigned long long value = strtoull(colon + 1, &end, 10);
+        if (strcmp(line, "read_bytes") == 0) counters.readBytes = value;
+        else if (strcmp(line, "write_bytes") == 0) counters.writeBytes = value;
+        else if (strcmp(line, "cancelled_write_bytes") == 0) counters.cancelledWriteBytes = value;
+        else if (strcmp(line, "syscr") == 0) counters.readCalls = value;
+        else if (strcmp(line, "syscw") == 0) counters.writeCalls = value;
+        line = *end ? end + 1 : end;
+    }
+
+    double elapsed = now - entry.lastTime;
+    if (entry.lastTime >= 0 && elapsed > 0) {
+        auto rate = [elapsed](unsigned long long current, unsigned long long last) {
+            return current >= last ? static_cast<float>((current - last) / elapsed) : 0.0f;
+        };
+        entry.io.available = true;
+        entry.io.readBytesPerSec = rate(counters.readBytes, entry.last.readBytes);
+        entry.io.writeBytesPerSec = rate(counters.writeBytes, entry.last.writeBytes);
+        entry.io.cancelledWriteBytesPerSec = rate(counters.cancelledWriteBytes, entry.last.cancelledWriteBytes);
+        entry.io.readCallsPerSec = rate(counters.readCalls, entry.last.readCalls);
+        entry.io.writeCallsPerSec = rate(counters.writeCalls, entry.last.writeCalls);
+    }
+    entry.last = counters;
+    entry.lastTime = now;
+}
+
+void ProcessIOTracker::update(vector<Proc>& processes) {
+    MONITOR_PROBE(PROBE_UPDATE_PROCESS_IO);
+    if (rootGeneration != monitorRootGeneration()) {
+        for (auto& entry : entries) forget(entry.second);
+        entries.clear();
+        rootGeneration = monitorRootGeneration();
+    }
+    if (fdBudget < 0) {
+        // the cgroup collector may hold half the open-file limit; take a quarter
+        rlimit limit;
+        fdBudget = getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY
+                       ? static_cast<int>(min<rlim_t>(limit.rlim_cur / 4, INT_MAX))
+                       : 256;
+    }
+
+    pass++;
+    for (const Proc& proc : processes) entries[proc.pid].seenPass = pass;
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.seenPass == pass) {
+            ++it;
+            continue;
+        }
+        forget(it->second);
+        it = entries.erase(it);
+    }
+
+    // PID order from where the last update stopped, until the budget runs out.
+    // Files already open are queued and read together; a queued read counts
+    // against the budget like a pread(), so the budget bounds the kernel's work
+    // whichever way the reads are done.
+    double now = monitorClock();
+    int calls = 0;
+    reads.clear();
+    queued.clear();
+    auto it = entries.upper_bound(nextPid);
+    for (size_t visited = 0; visited < entries.size() && calls < syscallBudget; ++visited, ++it) {
+        if (it == entries.end()) it = entries.begin();
+        if (it->second.denied) continue;
+        if (it->second.fd >= 0) {
+            reads.add(it->second.fd);
+            queued.push_back(&it->second);
+            calls++;
+        } else {
+            calls += read(it->first, it->second, now);
+        }
+        nextPid = it->first;
+    }
+    reads.run([&](size_t i, char* text, ssize_t length) { parse(*queued[i], text, length, now); });
+
+    apply(processes);
+}
+
+void ProcessIOTracker::apply(vector<Proc>& processes) const {
+    for (Proc& proc : processes) {
+        auto it = entries.find(proc.pid);
+        proc.io = it != entries.end() ? it->second.io : ProcessIO{};
+    }
+}
@@ -0,0 +1,196 @@
+#include "header.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/resource.h>
+
+// With tens of thousands of processes, parsing /proc/<pid>/stat is almost all
+// of getProcessList(): an open, a read and a close per process, each a trip
+// into the kernel that generates the file. The directory itself is read once;
+// the files are independent, so they are parsed in parallel.
+
+static double scanShare = 0.25;
+
+void setProcessScanShare(double share) { scanShare = std::clamp(share, 0.0, 1.0); }
+
+int processScanWorkers() {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = static_cast<int>(max(1L, cpus) * scanShare);
+    return std::clamp(workers, 1, ProcessScanPool::MAX_WORKERS);
+}
+
+ProcessScanPool::~ProcessScanPool() { stopThreads(); }
+
+void ProcessScanPool::stopThreads() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) thread.join();
+    threads.clear();
+    stopping = false;
+}
+
+void ProcessScanPool::setWorkers(int count) {
+    count = std::clamp(count, 1, MAX_WORKERS);
+    if (count == size()) return;
+    stopThreads();
+    workers.resize(count);
+    for (auto& worker : workers) {
+        if (worker) continue;
+        worker = make_unique<Worker>();
+        // one io-wq thread per worker keeps the scan at `count` threads reading
+        worker->reads = make_unique<ReadBatch>(SystemResourceTracker::STAT_READ_SIZE, CHUNK, 1);
+    }
+    // a thread that starts after the next scan has begun must still take part in it
+    for (int i = 1; i < count; ++i) threads.emplace_back(&ProcessScanPool::threadMain, this, i, round);
+}
+
+void ProcessScanPool::threadMain(int self, unsigned long long seen) {
+    FormattedText name = TextF("proc-scan-%d", self);
+    setProbeThreadName(name.c_str());
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [&] { return stopping || round != seen; });
+        if (stopping) return;
+        seen = round;
+        guard.unlock();
+        {
+            MONITOR_PROBE(PROBE_GET_PROCESS_LIST); // the caller's share is billed by getProcessList()
+            work(self);
+        }
+        guard.lock();
+        if (--busy == 0) finished.notify_one();
+    }
+}
+
+void ProcessScanPool::parseChunk(Worker& worker, int self, size_t chunk) {
+    size_t begin = chunk * CHUNK, end = min(pids->size(), begin + CHUNK);
+    unsigned first = static_cast<unsigned>(worker.used);
+    if (worker.reads->usesRing()) {
+        worker.used = readProcessesBatched(*worker.reads, *pids, *fds, begin, end, worker.out, worker.used);
+    } else {
+        for (size_t i = begin; i < end; ++i) {
+            if (worker.used == worker.out.size()) worker.out.emplace_back();
+            if (readProcess((*pids)[i], (*fds)[i], worker.out[worker.used])) worker.used++;
+        }
+    }
+    chunks[chunk] = ChunkResult{self, first, static_cast<unsigned>(worker.used - first)};
+}
+
+// Its own share first, then whatever the others haven't started on. Owner and
+// thieves take chunks the same way, with a fetch_add on the share's counter.
+void ProcessScanPool::work(int self) {
+    Worker& worker = *workers[self];
+    worker.used = 0;
+    for (int offset = 0; offset < size(); ++offset) {
+        Worker& share = *workers[(self + offset) % size()];
+        for (size_t chunk; (chunk = share.next.fetch_add(1, std::memory_order_relaxed)) < share.end;)
+            parseChunk(worker, self, chunk);
+    }
+}
+
+void ProcessScanPool::scan(const vector<int>& list, vector<int>& files, vector<Proc>& processes) {
+    if (size() == 0) setWorkers(1);
+    size_t chunkCount = (list.size() + CHUNK - 1) / CHUNK;
+    pids = &list;
+    fds = &files;
+    chunks.resize(chunkCount);
+    for (int i = 0; i < size(); ++i) {
+        workers[i]->next.store(chunkCount * i / size(), std::memory_order_relaxed);
+        workers[i]->end = chunkCount * (i + 1) / size();
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        busy = size() - 1;
+        round++;
+    }
+    wake.notify_all();
+    work(0);
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        finished.wait(guard, [&] { return busy == 0; });
+    }
+
+    // swapping keeps every Proc's name buffer with one element or the other
+    size_t count = 0;
+    unsigned took = 0; // a bit per worker
+    for (const ChunkResult& chunk : chunks) {
+        count += chunk.count;
+        took |= 1u << chunk.worker;
+    }
+    threadsUsed = __builtin_popcount(took);
+    if (processes.size() < count) processes.resize(count);
+    size_t at = 0;
+    for (const ChunkResult& chunk : chunks) {
+        Worker& worker = *workers[chunk.worker];
+        for (unsigned i = 0; i < chunk.count; ++i) std::swap(processes[at++], worker.out[chunk.first + i]);
+    }
+    processes.resize(count);
+    pids = nullptr;
+    fds = nullptr;
+}
+
+unsigned long long ProcessScanPool::batchedReadSyscalls() const {
+    unsigned long long calls = 0;
+    for (const auto& worker : workers) calls += worker->reads->syscalls();
+    return calls;
+}
+
+void ProcessStatFiles::closeAll() {
+    for (const Held& file : held) close(file.fd);
+    held.clear();
+}
+
+// Both lists are in PID order, so one pass pairs them up.
+void ProcessStatFiles::match(const vector<int>& pids, vector<int>& fds) {
+    if (rootGeneration != monitorRootGeneration()) {
+        closeAll();
+        rootGeneration = monitorRootGeneration();
+    }
+    if (budget < 0) {
+        // cgroups may hold half of the limit and process I/O a quarter
+        rlimit limit;
+        budget = getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY
+                     ? static_cast<int>(min<rlim_t>(limit.rlim_cur / 8, INT_MAX))
+                     : 128;
+    }
+
+    fds.resize(pids.size());
+    opened.clear();
+    size_t kept = 0, at = 0;
+    for (size_t i = 0; i < pids.size(); ++i) {
+        for (; at < held.size() && held[at].pid < pids[i]; ++at) close(held[at].fd); // exited
+        if (at < held.size() && held[at].pid == pids[i]) {
+            fds[i] = held[at].fd;
+            held[kept++] = held[at++];
+            continue;
+        }
+        fds[i] = -1;
+        if (static_cast<int>(kept + opened.size()) >= budget) continue;
+        char path[PATH_MAX];
+        if (!monitorPathf(path, sizeof(path), "/proc/%d/stat", pids[i])) continue;
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue; // exited, or the limit was reached after all
+        fds[i] = fd;
+        opened.push_back(Held{pids[i], fd});
+    }
+    for (; at < held.size(); ++at) close(held[at].fd);
+    held.resize(kept);
+    size_t middle = held.size();
+    held.insert(held.end(), opened.begin(), opened.end());
+    inplace_merge(held.begin(), held.begin() + middle, held.end(),
+                  [](const Held& a, const Held& b) { return a.pid < b.pid; });
+}
+
+void ProcessStatFiles::dropStale(const vector<int>& pids, const vector<int>& fds) {
+    size_t kept = 0, at = 0;
+    for (size_t i = 0; i < pids.size(); ++i) {
+        if (fds[i] != STALE) continue;
+        for (; at < held.size() && held[at].pid < pids[i]; ++at) held[kept++] = held[at];
+        if (at < held.size() && held[at].pid == pids[i]) close(held[at++].fd);
+    }
+    if (kept == at) return; // nothing dropped
+    for (; at < held.size(); ++at) held[kept++] = held[at];
+    held.resize(kept);
+}
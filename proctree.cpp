@@ -0,0 +1,128 @@
+#include "header.h"
+
+// The tree lives in slots that persist between updates, linked by slot number.
+// Every node carries the totals of its subtree, so a change to one process is
+// added along the path up to its root, and a subtree that moves (its parent
+// exited and it was reparented) is subtracted from one path and added to another.
+// Nothing is recomputed from scratch, so an update costs in proportion to what
+// changed, not to the number of processes.
+
+int ProcessTree::slotOf(int pid) const {
+    auto it = slots.find(pid);
+    return it != slots.end() ? it->second : -1;
+}
+
+// adds to the totals of `slot` and every ancestor
+void ProcessTree::addToPath(int slot, double cpu, long long rss, int count) {
+    for (int at = slot; at >= 0; at = nodes[at].parent) {
+        nodes[at].treeCPU += cpu;
+        nodes[at].treeRss += rss;
+        nodes[at].treeCount += count;
+    }
+}
+
+// makes `slot` a root, taking its subtree's totals off its former ancestors
+void ProcessTree::detach(int slot) {
+    Node& node = nodes[slot];
+    if (node.parent < 0) return;
+    addToPath(node.parent, -node.treeCPU, -node.treeRss, -node.treeCount);
+    if (node.prevSibling >= 0) nodes[node.prevSibling].nextSibling = node.nextSibling;
+    else nodes[node.parent].firstChild = node.nextSibling;
+    if (node.nextSibling >= 0) nodes[node.nextSibling].prevSibling = node.prevSibling;
+    node.parent = node.prevSibling = node.nextSibling = -1;
+}
+
+// links the root `slot` below `parentSlot`, keeping children in PID order
+void ProcessTree::attach(int slot, int parentSlot) {
+    Node& node = nodes[slot];
+    int previous = -1;
+    int next = nodes[parentSlot].firstChild;
+    while (next >= 0 && nodes[next].pid < node.pid) {
+        previous = next;
+        next = nodes[next].nextSibling;
+    }
+    node.parent = parentSlot;
+    node.prevSibling = previous;
+    node.nextSibling = next;
+    if (previous >= 0) nodes[previous].nextSibling = slot;
+    else nodes[parentSlot].firstChild = slot;
+    if (next >= 0) nodes[next].prevSibling = slot;
+    addToPath(parentSlot, node.treeCPU, node.treeRss, node.treeCount);
+}
+
+void ProcessTree::update(vector<Proc>& processes) {
+    MONITOR_PROBE(PROBE_UPDATE_PROCESS_TREE);
+    for (Node& node : nodes) node.listIndex = -1;
+
+    // new processes start out as roots of their own
+    listSlots.resize(processes.size());
+    for (size_t i = 0; i < processes.size(); ++i) {
+        int slot = slotOf(processes[i].pid);
+        if (slot < 0) {
+            if (freeSlots.empty()) {
+                slot = nodes.size();
+                nodes.emplace_back();
+            } else {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+                nodes[slot] = Node{};
+            }
+            nodes[slot].pid = processes[i].pid;
+            nodes[slot].ppid = processes[i].ppid;
+            slots[processes[i].pid] = slot;
+        }
+        nodes[slot].listIndex = i;
+        listSlots[i] = slot;
+    }
+
+    // exited processes leave their children as roots until their new parent,
+    // usually init or a subreaper, is linked up below
+    for (size_t slot = 0; slot < nodes.size(); ++slot) {
+        Node& node = nodes[slot];
+        if (node.pid == 0 || node.listIndex >= 0) continue;
+        while (node.firstChild >= 0) detach(node.firstChild);
+        detach(slot);
+        slots.erase(node.pid);
+        node.pid = 0;
+        freeSlots.push_back(slot);
+    }
+
+    // reparented processes, and roots whose parent showed up
+    for (size_t i = 0; i < processes.size(); ++i) {
+        int slot = listSlots[i];
+        Node& node = nodes[slot];
+        int ppid = processes[i].ppid;
+        if (node.ppid == ppid && node.parent >= 0) continue;
+        node.ppid = ppid;
+        int parentSlot = ppid > 0 && ppid != node.pid ? slotOf(ppid) : -1;
+        if (parentSlot == node.parent) continue;
+        detach(slot);
+        // a PID reused between two reads of /proc could make a cycle
+        bool cycle = false;
+        for (int at = parentSlot; at >= 0 && !cycle; at = nodes[at].parent) cycle = at == slot;
+        if (parentSlot >= 0 && !cycle) attach(slot, parentSlot);
+    }
+
+    for (size_t i = 0; i < processes.size(); ++i) {
+        int slot = listSlots[i];
+        const Proc& proc = processes[i];
+        double cpu = proc.cpuPercent - nodes[slot].cpu;
+        long long rss = proc.rss - nodes[slot].rss;
+        if (cpu == 0 && rss == 0) continue;
+        nodes[slot].cpu = proc.cpuPercent;
+        nodes[slot].rss = proc.rss;
+        addToPath(slot, cpu, rss, 0);
+    }
+
+    auto listIndex = [&](int slot) { return slot >= 0 ? nodes[slot].listIndex : -1; };
+    for (size_t i = 0; i < processes.size(); ++i) {
+        const Node& node = nodes[listSlots[i]];
+        Proc& proc = processes[i];
+        proc.parent = listIndex(node.parent);
+        proc.firstChild = listIndex(node.firstChild);
+        proc.nextSibling = listIndex(node.nextSibling);
+        proc.treeCPU = static_cast<float>(max(0.0, node.treeCPU));
+        proc.treeRss = node.treeRss;
+        proc.treeCount = node.treeCount;
+    }
+}
@@ -0,0 +1,154 @@
+#include "header.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+
+// Pressure Stall Information (Documentation/accounting/psi.rst). Each file has
+//   some avg10=0.12 avg60=0.05 avg300=0.01 total=123456
+//   full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+// The averages are the kernel's; `recent` is worked out from the total, so it
+// follows the sampling interval instead of a fixed 10 s window.
+//
+// Triggers: writing "some 150000 1000000" to an open pressure file asks the kernel
+// to raise POLLPRI on that fd whenever tasks stall for 150 ms within any 1 s
+// window. The sampler polls these fds together with its wake-up eventfd, so an
+// episode is timestamped when it happens, not at the next sample.
+
+static const char* const PRESSURE_FILES[PRESSURE_RESOURCES] = {
+    "/proc/pressure/cpu", "/proc/pressure/memory", "/proc/pressure/io",
+};
+
+// the kernel only accepts windows of whole multiples of 2 s from unprivileged
+// processes, so this is tried when the configured trigger is refused
+static const char UNPRIVILEGED_TRIGGER[] = "some 300000 2000000";
+
+static string trigger = "some 150000 1000000";
+
+void setPressureTrigger(const string& value) { trigger = value; }
+
+const string& pressureTrigger() { return trigger; }
+
+const char* pressureResourceName(PressureResource resource) {
+    static const char* const names[PRESSURE_RESOURCES] = {"CPU", "Memory", "I/O"};
+    return resource < PRESSURE_RESOURCES ? names[resource] : "?";
+}
+
+// parses one "some ..." or "full ..." line; missing keys stay 0
+static void parsePressureLine(const char* line, PressureLine& out) {
+    const char* at;
+    if ((at = strstr(line, "avg10="))) out.avg10 = strtof(at + 6, nullptr);
+    if ((at = strstr(line, "avg60="))) out.avg60 = strtof(at + 6, nullptr);
+    if ((at = strstr(line, "avg300="))) out.avg300 = strtof(at + 7, nullptr);
+    if ((at = strstr(line, "total="))) out.total = strtoull(at + 6, nullptr, 10);
+}
+
+bool parsePressure(char* text, Pressure& out) {
+    out = Pressure{};
+    char* full = strstr(text, "full ");
+    if (full && full > text) {
+        full[-1] = '\0'; // end the "some" line
+        parsePressureLine(full, out.full);
+    }
+    if (strncmp(text, "some ", 5) != 0) return false;
+    parsePressureLine(text, out.some);
+    out.available = true;
+    return true;
+}
+
+static bool readPressureFile(PressureResource resource, Pressure& out) {
+    char path[PATH_MAX];
+    char text[256];
+    out = Pressure{};
+    return monitorPathf(path, sizeof(path), "%s", PRESSURE_FILES[resource]) &&
+           readFileInto(path, text, sizeof(text)) > 0 && parsePressure(text, out);
+}
+
+PressureTracker::~PressureTracker() { disarmTriggers(); }
+
+void PressureTracker::read(Pressure pressure[PRESSURE_RESOURCES]) {
+    MONITOR_PROBE(PROBE_READ_PRESSURE);
+    double now = monitorClock();
+    double elapsedUs = lastTime >= 0 ? (now - lastTime) * 1e6 : 0;
+    lastTime = now;
+    for (int i = 0; i < PRESSURE_RESOURCES; ++i) {
+        Pressure& current = pressure[i];
+        readPressureFile(static_cast<PressureResource>(i), current);
+        PressureLine* lines[2] = {&current.some, &current.full};
+        for (int kind = 0; kind < 2; ++kind) {
+            unsigned long long total = lines[kind]->total;
+            unsigned long long& last = lastTotals[i][kind];
+            if (elapsedUs > 0 && total >= last && last > 0)
+                lines[kind]->recent = static_cast<float>(min(100.0, (total - last) / elapsedUs * 100.0));
+            last = total;
+        }
+    }
+}
+
+int PressureTracker::armTriggers(const string& value) {
+    disarmTriggers();
+    if (value.empty()) return 0;
+    int armed = 0;
+    for (int i = 0; i < PRESSURE_RESOURCES; ++i) {
+        char path[PATH_MAX];
+        if (!monitorPathf(path, sizeof(path), "%s", PRESSURE_FILES[i])) continue;
+        int fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) continue;
+        // the kernel wants the terminating NUL written as well
+        bool accepted = write(fd, value.c_str(), value.size() + 1) >= 0;
+        if (!accepted && (errno == EINVAL || errno == EPERM))
+            accepted = write(fd, UNPRIVILEGED_TRIGGER, sizeof(UNPRIVILEGED_TRIGGER)) >= 0;
+        if (!accepted) {
+            close(fd);
+            continue;
+        }
+        triggerFds[i] = fd;
+        armed++;
+    }
+    return armed;
+}
+
+void PressureTracker::disarmTriggers() {
+    for (int& fd : triggerFds) {
+        if (fd >= 0) close(fd); // closing the fd removes its trigger
+        fd = -1;
+    }
+}
+
+int PressureTracker::addPollFds(pollfd* fds, int capacity) const {
+    int count = 0;
+    for (int fd : triggerFds) {
+        if (fd < 0 || count == capacity) continue;
+        fds[count++] = pollfd{fd, POLLPRI, 0};
+    }
+    return count;
+}
+
+void PressureTracker::handlePollFds(const pollfd* fds, int count, float time) {
+    for (int n = 0; n < count; ++n) {
+        if (!(fds[n].revents & (POLLPRI | POLLERR | POLLNVAL))) continue;
+        for (int i = 0; i < PRESSURE_RESOURCES; ++i) {
+            if (triggerFds[i] != fds[n].fd) continue;
+            if (fds[n].revents & (POLLERR | POLLNVAL)) {
+                // The trigger is gone (its cgroup was removed, say), and poll()
+                // reports that on every call, so it is dropped; read() still
+                // gets the averages at the collector's cadence.
+                if (!(fds[n].revents & POLLNVAL)) close(triggerFds[i]); // NVAL: not open any more
+                triggerFds[i] = -1;
+                break;
+            }
+            timespec wall;
+            clock_gettime(CLOCK_REALTIME, &wall);
+            Pressure pressure;
+            readPressureFile(static_cast<PressureResource>(i), pressure);
+            events[eventCount % MAX_EVENTS] = StallEvent{static_cast<PressureResource>(i), time,
+                                                         wall.tv_sec + wall.tv_nsec / 1e9, pressure.some.avg10};
+            eventCount++;
+        }
+    }
+}
+
+void PressureTracker::copyEvents(vector<StallEvent>& out) const {
+    size_t count = min(eventCount, MAX_EVENTS);
+    out.resize(count);
+    for (size_t i = 0; i < count; ++i) out[i] = events[(eventCount - count + i) % MAX_EVENTS];
+}
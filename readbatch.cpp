@@ -0,0 +1,179 @@
+#include "header.h"
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+// io_uring without liburing. The kernel shares two rings with us, mapped from
+// the ring's fd:
+//   submission queue  sqes[] holds the requests; array[] lists which sqes
+//                     the kernel should take, up to the tail we advance
+//   completion queue  cqes[] holds one result per request, up to the tail the
+//                     kernel advances; we advance the head as we consume them
+// io_uring_enter() hands over the new submissions and waits for completions in
+// the same call. /proc and /sys reads can't be done without blocking, so the
+// kernel passes them to its io-wq worker threads, and they run in parallel.
+
+static std::atomic<bool> ringAllowed{true};
+
+void setIoUringAllowed(bool allowed) { ringAllowed.store(allowed, std::memory_order_relaxed); }
+
+bool ioUringAllowed() { return ringAllowed.load(std::memory_order_relaxed); }
+
+struct ReadBatch::Ring {
+    int fd = -1;
+    void* sqMap = MAP_FAILED;
+    void* cqMap = MAP_FAILED;
+    size_t sqMapSize = 0, cqMapSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+    unsigned *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    const char* registered = nullptr; // buffer registered for READ_FIXED, nullptr for none
+    size_t registeredSize = 0;
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqMap != MAP_FAILED && cqMap != sqMap) munmap(cqMap, cqMapSize);
+        if (sqMap != MAP_FAILED) munmap(sqMap, sqMapSize);
+        if (fd >= 0) close(fd);
+    }
+
+    bool setup(unsigned entries, unsigned ioWorkers) {
+        io_uring_params params{};
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) return false; // ENOSYS, or EPERM from a seccomp filter or kernel.io_uring_disabled
+
+        sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP; // both rings in one mapping
+        if (single) sqMapSize = cqMapSize = max(sqMapSize, cqMapSize);
+        sqMap = mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqMap == MAP_FAILED) return false;
+        cqMap = single ? sqMap
+                       : mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqMap == MAP_FAILED) return false;
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(
+            mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) return false;
+
+        char* sq = static_cast<char*>(sqMap);
+        char* cq = static_cast<char*>(cqMap);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // the io-wq threads doing the blocking reads are held to what the /proc
+        // scan may use (5.15 and later; older kernels don't cap them)
+        unsigned workers[2] = {ioWorkers, ioWorkers};
+        syscall(__NR_io_uring_register, fd, IORING_REGISTER_IOWQ_MAX_WORKERS, workers, 2);
+        return true;
+    }
+
+    // Registering pins the pages, which counts against RLIMIT_MEMLOCK; without
+    // it the reads are plain IORING_OP_READs into the same buffer.
+    void registerBuffer(const vector<char>& buffer) {
+        if (registered == buffer.data() && registeredSize == buffer.size()) return;
+        if (registered) syscall(__NR_io_uring_register, fd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+        iovec range{const_cast<char*>(buffer.data()), buffer.size()};
+        bool ok = syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, &range, 1) == 0;
+        registered = ok ? buffer.data() : nullptr;
+        registeredSize = ok ? buffer.size() : 0;
+    }
+};
+
+ReadBatch::ReadBatch(size_t readSize, unsigned window, unsigned ioWorkers)
+    : readSize(max<size_t>(2, readSize)), window(max(1u, window)), ioWorkers(ioWorkers) {}
+
+ReadBatch::~ReadBatch() = default;
+
+bool ReadBatch::usesRing() {
+    if (!ioUringAllowed() || ringFailed) return false;
+    if (ring) return true;
+    ring = make_unique<Ring>();
+    if (!ring->setup(window, ioWorkers > 0 ? ioWorkers : static_cast<unsigned>(processScanWorkers()))) {
+        ring.reset();
+        ringFailed = true;
+        return false;
+    }
+    return true;
+}
+
+void ReadBatch::runWindow(size_t first, size_t count) {
+    if (buffers.size() < count * readSize) buffers.resize(window * readSize);
+    results.assign(count, -EAGAIN);
+    if (usesRing() && !submit(first, count)) {
+        // Reads the kernel already took may still complete into `buffers` after
+        // the ring is gone, so that buffer is set aside for good and the window
+        // is read again, into a new one, with pread from now on.
+        retired.swap(buffers);
+        buffers.assign(window * readSize, '\0');
+        results.assign(count, -EAGAIN);
+        ring.reset();
+    }
+    for (size_t i = 0; i < count; ++i) {
+        char* text = buffers.data() + i * readSize;
+        // not done by the ring (or it was interrupted): done here instead
+        if (results[i] == -EAGAIN || results[i] == -EINTR) {
+            ssize_t length = pread(fds[first + i], text, readSize - 1, 0);
+            calls++;
+            results[i] = length >= 0 ? static_cast<int>(length) : -errno;
+        }
+        text[results[i] > 0 ? results[i] : 0] = '\0';
+    }
+}
+
+// Queues the window's reads and waits for all of them. False if the ring can't
+// be used; reads it never completed are left at -EAGAIN.
+bool ReadBatch::submit(size_t first, size_t count) {
+    Ring& r = *ring;
+    r.registerBuffer(buffers);
+    unsigned tail = *r.sqTail; // only we write it
+    for (size_t i = 0; i < count; ++i) {
+        unsigned index = tail & *r.sqMask;
+        io_uring_sqe& sqe = r.sqes[index];
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = r.registered ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe.fd = fds[first + i];
+        sqe.addr = reinterpret_cast<unsigned long long>(buffers.data() + i * readSize);
+        sqe.len = static_cast<unsigned>(readSize - 1);
+        sqe.off = 0;
+        sqe.buf_index = 0;
+        sqe.user_data = i;
+        r.sqArray[index] = index;
+        tail++;
+    }
+    __atomic_store_n(r.sqTail, tail, __ATOMIC_RELEASE);
+
+    size_t submitted = 0, completed = 0;
+    while (completed < count) {
+        long entered = syscall(__NR_io_uring_enter, r.fd, static_cast<unsigned>(count - submitted),
+                               static_cast<unsigned>(count - completed), IORING_ENTER_GETEVENTS, nullptr, 0);
+        calls++;
+        countRingEnter();
+        if (entered < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            ringFailed = true; // requests may still be queued; the ring is dropped
+            return false;
+        }
+        if (entered > 0) submitted += entered;
+
+        unsigned head = *r.cqHead;
+        unsigned ready = __atomic_load_n(r.cqTail, __ATOMIC_ACQUIRE);
+        for (; head != ready; ++head, ++completed) {
+            const io_uring_cqe& cqe = r.cqes[head & *r.cqMask];
+            // a kernel without IORING_OP_READ (before 5.6) refuses the opcode
+            if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP) ringFailed = true;
+            else results[cqe.user_data] = cqe.res;
+        }
+        __atomic_store_n(r.cqHead, head, __ATOMIC_RELEASE);
+    }
+    return !ringFailed;
+}
@@ -0,0 +1,447 @@
+#include "header.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+// interrupts the worker's poll() so it samples (or exits) right away
+static void signalWakeFd(int fd) {
+    uint64_t one = 1;
+    ssize_t written = write(fd, &one, sizeof(one));
+    (void)written; // a saturated counter still wakes the worker
+}
+
+Sampler::Sampler()
+    : running(false), background(false), interval(0.0f), backgroundInterval(2.0f), wakeFd(-1),
+      cpuUsageBuffer(5, 0.0f), bufferIndex(0), startTime(monitorClock()) {
+    for (int c = 0; c < COLLECTORS; ++c) {
+        cadences[c] = schedule.cadence(static_cast<Collector>(c));
+        status[c].cadence = cadences[c];
+        status[c].effective = schedule.effectiveCadence(static_cast<Collector>(c));
+    }
+}
+
+Sampler::~Sampler() { stop(); }
+
+// Takes the first snapshot synchronously, so latest() is never empty, then starts
+// the worker thread. `callback` runs on the worker thread after every new snapshot.
+void Sampler::start(std::function<void()> callback, bool publishShm) {
+    if (running) return;
+    onSnapshot = std::move(callback);
+    startTime = monitorClock();
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    // publish snapshots for local tools; the frontends work fine without it
+    if (publishShm && !publisher.open()) {
+        if (errno == EBUSY)
+            fprintf(stderr, "Warning: another monitor is publishing %s; not publishing\n", MONITOR_SHM_NAME);
+        else
+            fprintf(stderr, "Warning: could not create shared-memory segment %s: %s\n", MONITOR_SHM_NAME, strerror(errno));
+    }
+
+    // triggers would be written into a fixture tree's plain files
+    pressureTracker.armTriggers(hasMonitorRoot() ? "" : pressureTrigger());
+
+    applyCadences();
+    shared_ptr<SystemSnapshot> first = reusableSnapshot();
+    sample(*first, nullptr);
+    {
+        std::lock_guard<std::mutex> guard(snapshotLock);
+        latestSnapshot = first;
+    }
+    publish(*first);
+
+    running = true;
+    worker = std::thread(&Sampler::run, this);
+}
+
+void Sampler::stop() {
+    if (!running) return;
+    running = false;
+    signalWakeFd(wakeFd);
+    worker.join();
+    close(wakeFd);
+    wakeFd = -1;
+    publisher.close();
+}
+
+void Sampler::setInterval(float seconds) { interval = std::max(0.01f, seconds); }
+
+// While the window is hidden nobody looks at the graphs, but the shared-memory
+// snapshot should stay reasonably fresh, so sampling slows down instead of stopping.
+void Sampler::setBackground(bool hidden) {
+    // sample right away when the window comes back so it doesn't show stale data
+    if (background.exchange(hidden) != hidden && !hidden && wakeFd >= 0) {
+        signalWakeFd(wakeFd);
+    }
+}
+
+void Sampler::setCadence(Collector collector, float seconds) {
+    if (!(seconds > 0)) return;
+    {
+        std::lock_guard<std::mutex> guard(frontendLock);
+        if (cadences[collector] == seconds) return;
+        cadences[collector] = seconds;
+        cadencesChanged = true;
+    }
+    if (running) signalWakeFd(wakeFd); // so the worker waits for the new deadline
+}
+
+float Sampler::cadence(Collector collector) {
+    std::lock_guard<std::mutex> guard(frontendLock);
+    return cadences[collector];
+}
+
+// Runs on the worker: hands the frontend's cadences to the schedule.
+void Sampler::applyCadences() {
+    std::lock_guard<std::mutex> guard(frontendLock);
+    if (!cadencesChanged) return;
+    cadencesChanged = false;
+    for (int c = 0; c < COLLECTORS; ++c) schedule.setCadence(static_cast<Collector>(c), cadences[c]);
+    for (int c = 0; c < COLLECTORS; ++c) {
+        status[c].cadence = schedule.cadence(static_cast<Collector>(c));
+        status[c].effective = schedule.effectiveCadence(static_cast<Collector>(c));
+    }
+}
+
+// These two are called by the UI every frame, so an unchanged list only takes the lock.
+void Sampler::setThreadPids(const set<int>& pids) {
+    std::lock_guard<std::mutex> guard(frontendLock);
+    if (equal(pids.begin(), pids.end(), threadPids.begin(), threadPids.end())) return;
+    threadPids.assign(pids.begin(), pids.end());
+}
+
+void Sampler::setVisiblePids(const vector<int>& pids) {
+    std::lock_guard<std::mutex> guard(frontendLock);
+    if (pids != visiblePids) visiblePids = pids;
+}
+
+shared_ptr<const SystemSnapshot> Sampler::latest() {
+    std::lock_guard<std::mutex> guard(snapshotLock);
+    return latestSnapshot;
+}
+
+void Sampler::run() {
+    setProbeThreadName("sampler");
+    pollfd fds[1 + PRESSURE_RESOURCES];
+    double lastTick = monitorClock();
+    while (running) {
+        // sleep until the next collector is due, but no sooner than the
+        // interval allows. PSI triggers that fire while waiting are timestamped
+        // right away but don't bring the next sample forward. The wait is real
+        // time even when monitorClock() is scripted.
+        applyCadences();
+        double now = monitorClock();
+        double wait = max(startTime + schedule.nextDeadline() - now,
+                          lastTick + (background ? backgroundInterval : interval) - now);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(max(0.0, wait));
+        while (running) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now() + std::chrono::microseconds(999));
+            if (remaining.count() <= 0) break;
+            fds[0] = pollfd{wakeFd, POLLIN, 0};
+            int count = 1 + pressureTracker.addPollFds(fds + 1, PRESSURE_RESOURCES);
+            if (poll(fds, count, static_cast<int>(remaining.count())) <= 0) continue;
+            pressureTracker.handlePollFds(fds + 1, count - 1, static_cast<float>(monitorClock() - startTime));
+            if (fds[0].revents & POLLIN) {
+                uint64_t wakeups;
+                ssize_t drained = read(wakeFd, &wakeups, sizeof(wakeups));
+                (void)drained;
+                break;
+            }
+        }
+        if (!running) break;
+        lastTick = monitorClock();
+        tick();
+    }
+}
+
+void Sampler::tick() {
+    applyCadences();
+    shared_ptr<const SystemSnapshot> previous = latest();
+    shared_ptr<SystemSnapshot> next = reusableSnapshot();
+    if (!sample(*next, previous.get())) return;
+    {
+        std::lock_guard<std::mutex> guard(snapshotLock);
+        latestSnapshot = next;
+    }
+    publish(*next);
+    if (onSnapshot) onSnapshot();
+}
+
+// Returns a pooled snapshot that no frontend holds any more, so its containers
+// (process list, maps, strings) can be overwritten with their capacity intact.
+// Only the worker thread calls this. A snapshot that only the pool references
+// can't be picked up again by anyone else, since latest() never returns it.
+shared_ptr<SystemSnapshot> Sampler::reusableSnapshot() {
+    for (const auto& snapshot : snapshotPool) {
+        if (snapshot.use_count() == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire); // the last reader is done with it
+            return snapshot;
+        }
+    }
+    auto snapshot = make_shared<SystemSnapshot>();
+    if (snapshotPool.size() < 4) snapshotPool.push_back(snapshot); // latest, one being drawn, spares
+    return snapshot;
+}
+
+// Fills `snap` with a new sample, running the collectors that are due and
+// carrying everything else over from `previous`. The first sample runs them
+// all. Returns false, leaving `snap` alone, when nothing was due.
+bool Sampler::sample(SystemSnapshot& snap, const SystemSnapshot* previous) {
+    double sinceStart = monitorClock() - startTime;
+    unsigned due = schedule.advance(sinceStart);
+    if (!previous) due = (1u << COLLECTORS) - 1;
+    if (!due) return false;
+    if (!previous) {
+        // once; the schema and the rules stay for the sampler's life
+        pluginHost.loadAll(pluginDirectory());
+        alertEngine.configure(alertRules(), alertLogFile(), alertSocketPath());
+    }
+    // a collector working on another's data needs it fresh; the alignment makes
+    // this a no-op unless a cadence just changed
+    for (int c = COLLECTORS - 1; c >= 0; --c)
+        if (due & (1u << c)) due |= 1u << CollectorSchedule::base(static_cast<Collector>(c));
+
+    MONITOR_PROBE(PROBE_SAMPLER_TICK);
+    float now = static_cast<float>(sinceStart);
+    snap.time = now;
+    snap.generation = previous ? previous->generation + 1 : 0;
+    auto runs = [&](Collector collector) { return (due & (1u << collector)) != 0; };
+    std::chrono::steady_clock::time_point started;
+    auto startRun = [&] { started = std::chrono::steady_clock::now(); };
+    auto finishRun = [&](Collector collector) {
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - started).count();
+        CollectorStatus& run = status[collector];
+        run.costMs = run.lastRun < 0 ? ms : run.costMs * 0.8f + ms * 0.2f;
+        run.lastRun = now;
+    };
+
+    if (runs(COLLECTOR_INVENTORY)) {
+        startRun();
+        snap.hostname = getHostname();
+        snap.username = getCurrentUsername();
+        snap.cpuModel = CPUinfo();
+        finishRun(COLLECTOR_INVENTORY);
+    } else {
+        snap.hostname = previous->hostname;
+        snap.username = previous->username;
+        snap.cpuModel = previous->cpuModel;
+    }
+
+    if (runs(COLLECTOR_CPU)) {
+        startRun();
+        // moving average over the last few readings to smooth out short spikes
+        cpuUsageBuffer[bufferIndex] = cpuTracker.calculateCPUUsage();
+        bufferIndex = (bufferIndex + 1) % cpuUsageBuffer.size();
+        snap.cpuUsage = 0.0f;
+        for (float usage : cpuUsageBuffer) snap.cpuUsage += usage;
+        snap.cpuUsage /= cpuUsageBuffer.size();
+        finishRun(COLLECTOR_CPU);
+    } else {
+        snap.cpuUsage = previous->cpuUsage;
+    }
+
+    if (runs(COLLECTOR_SENSORS)) {
+        startRun();
+        readSensors(snap.temperature, snap.fanSpeed);
+        finishRun(COLLECTOR_SENSORS);
+    } else {
+        snap.temperature = previous->temperature;
+        snap.fanSpeed = previous->fanSpeed;
+    }
+
+    if (runs(COLLECTOR_MEMORY)) {
+        startRun();
+        snap.memory = resourceTracker.getMemoryInfo();
+        readFileHandles(snap.fileHandles);
+        finishRun(COLLECTOR_MEMORY);
+    } else {
+        snap.memory = previous->memory;
+        snap.fileHandles = previous->fileHandles;
+    }
+
+    if (runs(COLLECTOR_MOUNTS)) {
+        startRun();
+        // / is sampled by the mount workers like every other filesystem; without a
+        // readable mountinfo (some fixture trees) fall back to a direct statvfs()
+        mountTracker.update(snap.mounts);
+        const MountUsage* root = nullptr;
+        for (const MountUsage& mount : snap.mounts)
+            if (mount.mountPoint == "/" && mount.totalBytes > 0) root = &mount;
+        if (root) snap.disk = makeDiskInfo(root->totalBytes, root->usedBytes);
+        else if (snap.mounts.empty()) snap.disk = resourceTracker.getDiskInfo();
+        else snap.disk = previous ? previous->disk : makeDiskInfo(0, 0);
+        finishRun(COLLECTOR_MOUNTS);
+    } else {
+        snap.mounts = previous->mounts;
+        snap.disk = previous->disk;
+    }
+
+    if (runs(COLLECTOR_DISKS)) {
+        startRun();
+        diskStatsTracker.update(snap.disks);
+        finishRun(COLLECTOR_DISKS);
+    } else {
+        snap.disks = previous->disks;
+    }
+
+    if (runs(COLLECTOR_PRESSURE)) {
+        startRun();
+        pressureTracker.read(snap.pressure);
+        finishRun(COLLECTOR_PRESSURE);
+    } else {
+        copy(std::begin(previous->pressure), std::end(previous->pressure), snap.pressure);
+    }
+    snap.stallEvents.reserve(PressureTracker::MAX_EVENTS); // so a burst of events doesn't allocate
+    pressureTracker.copyEvents(snap.stallEvents);
+
+    if (runs(COLLECTOR_PROCESSES)) {
+        startRun();
+        processTracker.setUpdateInterval(schedule.effectiveCadence(COLLECTOR_PROCESSES) * 0.9f);
+        resourceTracker.getProcessList(snap.processes);
+        // count states from the list we already have instead of walking /proc again;
+        // 'I' (idle) is folded into 'S' like countProcessStates does. Counts are
+        // reset rather than the map cleared, so its nodes are reused.
+        for (auto& entry : snap.processStates) entry.second = 0;
+        for (auto& proc : snap.processes) {
+            proc.cpuPercent = processTracker.calculateProcessCPUUsage(proc, now);
+            snap.processStates[proc.state == 'I' ? 'S' : proc.state]++;
+        }
+        for (auto it = snap.processStates.begin(); it != snap.processStates.end();) {
+            if (it->second == 0) it = snap.processStates.erase(it);
+            else ++it;
+        }
+        snap.totalProcesses = snap.processes.size();
+        processTracker.forgetExited(snap.processes);
+        processTree.update(snap.processes);
+        {
+            std::lock_guard<std::mutex> guard(frontendLock);
+            watchedPids = threadPids;
+            priorityPids = visiblePids;
+        }
+        threadTracker.update(watchedPids, snap.threads);
+        finishRun(COLLECTOR_PROCESSES);
+
+        // a fresh list has none of the slower per-process values; they are read
+        // now or copied from what was read last
+        startRun();
+        if (runs(COLLECTOR_PROCESS_DETAILS)) {
+            smapsTracker.update(snap.processes, priorityPids);
+            processIOTracker.update(snap.processes);
+            fdTracker.update(snap.processes);
+            finishRun(COLLECTOR_PROCESS_DETAILS);
+        } else {
+            smapsTracker.apply(snap.processes);
+            processIOTracker.apply(snap.processes);
+            fdTracker.apply(snap.processes);
+        }
+
+        if (runs(COLLECTOR_SOCKETS)) {
+            startRun();
+            snap.socketsAvailable = socketTracker.update(snap.sockets, snap.socketNames, fdTracker, snap.processes);
+            finishRun(COLLECTOR_SOCKETS);
+        } else {
+            snap.socketsAvailable = previous->socketsAvailable;
+            snap.sockets = previous->sockets;
+            snap.socketNames = previous->socketNames;
+            socketTracker.attribute(snap.sockets, fdTracker, snap.processes);
+        }
+    } else {
+        snap.processes = previous->processes;
+        snap.socketsAvailable = previous->socketsAvailable;
+        snap.sockets = previous->sockets;
+        snap.socketNames = previous->socketNames;
+        snap.threads = previous->threads;
+        snap.processStates = previous->processStates;
+        snap.totalProcesses = previous->totalProcesses;
+    }
+
+    if (runs(COLLECTOR_CGROUPS)) {
+        startRun();
+        cgroupTracker.update(snap.cgroups);
+        finishRun(COLLECTOR_CGROUPS);
+    } else {
+        snap.cgroups = previous->cgroups;
+    }
+
+    if (runs(COLLECTOR_INTERFACES)) {
+        startRun();
+        networkTracker.getNetworkInterfaces(snap.interfaces);
+        finishRun(COLLECTOR_INTERFACES);
+    } else {
+        snap.interfaces = previous->interfaces;
+    }
+
+    if (runs(COLLECTOR_NETWORK)) {
+        startRun();
+        networkTracker.getNetworkStats(snap.rx, snap.tx);
+        rateTracker.update(snap.rx, snap.tx, now);
+        snap.rxRate = rateTracker.rxRate;
+        snap.txRate = rateTracker.txRate;
+        finishRun(COLLECTOR_NETWORK);
+    } else {
+        snap.rx = previous->rx;
+        snap.tx = previous->tx;
+        snap.rxRate = previous->rxRate;
+        snap.txRate = previous->txRate;
+    }
+
+    // the built-in sections are filled from the fields above
+    startRun();
+    pluginHost.update(snap, previous, due, schedule.effectiveCadence(COLLECTOR_PLUGINS));
+    if (runs(COLLECTOR_PLUGINS)) finishRun(COLLECTOR_PLUGINS);
+    alertEngine.update(snap, due);
+
+    copy(std::begin(status), std::end(status), snap.collectors);
+    return true;
+}
+
+// Copies the parts of the snapshot that have a place in the shared-memory layout.
+void Sampler::publish(const SystemSnapshot& snap) {
+    if (!publisher.isOpen()) return;
+    TRACE_SCOPE("Sampler::publish");
+
+    monitor_shm_snapshot out;
+    memset(&out, 0, sizeof(out));
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    out.timestamp_ns = static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+
+    out.cpu_percent = snap.cpuUsage;
+    out.temperature_c = snap.temperature;
+    out.fan_rpm = snap.fanSpeed;
+    out.mem_total_kb = snap.memory.mem_total_kb;
+    out.mem_available_kb = snap.memory.mem_available_kb;
+    out.swap_total_kb = snap.memory.swap_total_kb;
+    out.swap_free_kb = snap.memory.swap_free_kb;
+    out.disk_total_bytes = snap.disk.total_bytes;
+    out.disk_used_bytes = snap.disk.used_bytes;
+
+    for (const auto& [state, count] : snap.processStates) {
+        out.proc_total += count;
+        switch (state) {
+            case 'R': out.proc_running += count; break;
+            case 'S': out.proc_sleeping += count; break;
+            case 'D': out.proc_disk_sleep += count; break;
+            case 'Z': out.proc_zombie += count; break;
+            case 'T': case 't': out.proc_stopped += count; break;
+        }
+    }
+
+    for (const auto& [iface, rx] : snap.rx) {
+        if (out.iface_count >= MONITOR_SHM_MAX_IFACES) break;
+        monitor_shm_iface& entry = out.ifaces[out.iface_count++];
+        snprintf(entry.name, sizeof(entry.name), "%s", iface.c_str());
+        entry.rx_bytes = rx.bytes;
+        auto rate = snap.rxRate.find(iface);
+        entry.rx_rate = rate != snap.rxRate.end() ? rate->second : 0.0;
+        auto tx = snap.tx.find(iface);
+        if (tx != snap.tx.end()) entry.tx_bytes = tx->second.bytes;
+        rate = snap.txRate.find(iface);
+        entry.tx_rate = rate != snap.txRate.end() ? rate->second : 0.0;
+    }
+
+    publisher.publish(out);
+}
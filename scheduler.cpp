@@ -0,0 +1,186 @@
+#include "header.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Cadences the Sampler starts with. The process list feeds three collectors:
+// CPU% and states come with the list, PSS/I/O/fds are read for the processes
+// in it, and sockets are matched to owners through those fds.
+struct CollectorInfo {
+    const char* name;
+    float cadence;  // seconds
+    Collector base; // whose data it works on; itself for none
+    bool expensive; // costs milliseconds a run, so it shouldn't share a tick with another
+};
+
+static const CollectorInfo collectorInfo[COLLECTORS] = {
+    {"cpu", 0.25f, COLLECTOR_CPU, false},
+    {"sensors", 1.0f, COLLECTOR_SENSORS, false},
+    {"memory", 0.5f, COLLECTOR_MEMORY, false},
+    {"disks", 0.5f, COLLECTOR_DISKS, false},
+    {"pressure", 0.5f, COLLECTOR_PRESSURE, false},
+    {"network", 0.5f, COLLECTOR_NETWORK, false},
+    {"processes", 1.0f, COLLECTOR_PROCESSES, true},
+    {"process-details", 1.0f, COLLECTOR_PROCESSES, true},
+    {"sockets", 1.0f, COLLECTOR_PROCESS_DETAILS, true},
+    {"cgroups", 1.0f, COLLECTOR_CGROUPS, true},
+    {"mounts", 10.0f, COLLECTOR_MOUNTS, false},
+    {"interfaces", 5.0f, COLLECTOR_INTERFACES, false},
+    {"inventory", 60.0f, COLLECTOR_INVENTORY, false},
+    {"plugins", 1.0f, COLLECTOR_PLUGINS, false},
+};
+
+static float defaultCadences[COLLECTORS];
+
+const char* collectorName(Collector collector) {
+    return collector >= 0 && collector < COLLECTORS ? collectorInfo[collector].name : "?";
+}
+
+bool collectorByName(const char* name, Collector& collector) {
+    for (int c = 0; c < COLLECTORS; ++c) {
+        if (strcmp(collectorInfo[c].name, name) != 0) continue;
+        collector = static_cast<Collector>(c);
+        return true;
+    }
+    return false;
+}
+
+void setDefaultCadence(Collector collector, float seconds) { defaultCadences[collector] = max(0.0f, seconds); }
+
+float defaultCadence(Collector collector) {
+    return defaultCadences[collector] > 0 ? defaultCadences[collector] : collectorInfo[collector].cadence;
+}
+
+Collector CollectorSchedule::base(Collector collector) { return collectorInfo[collector].base; }
+
+bool CollectorSchedule::expensive(Collector collector) { return collectorInfo[collector].expensive; }
+
+CollectorSchedule::CollectorSchedule() {
+    for (auto& level : heads) fill(begin(level), end(level), -1);
+    for (int c = 0; c < COLLECTORS; ++c) {
+        timers[c] = Timer{0, -1, -1, -1};
+        requested[c] = defaultCadence(static_cast<Collector>(c));
+    }
+    align();
+}
+
+void CollectorSchedule::setCadence(Collector collector, float seconds) {
+    if (!(seconds > 0) || requested[collector] == seconds) return;
+    requested[collector] = seconds;
+    align();
+}
+
+// Works out every collector's period and phase from the requested cadences and
+// re-arms them all from the current jiffy.
+void CollectorSchedule::align() {
+    for (int c = 0; c < COLLECTORS; ++c) {
+        double jiffies = std::round(requested[c] / JIFFY);
+        period[c] = static_cast<unsigned long long>(std::clamp(jiffies, 1.0, static_cast<double>(MAX_PERIOD)));
+        phase[c] = 0;
+        // bases come earlier in the enum, so theirs is already final
+        int b = base(static_cast<Collector>(c));
+        if (b != c) {
+            unsigned long long multiple = max(1ull, (period[c] + period[b] / 2) / period[b]);
+            period[c] = min(multiple * period[b], MAX_PERIOD / period[b] * period[b]);
+            phase[c] = phase[b];
+        }
+    }
+    // the k-th of n expensive collectors sharing a period starts k/n of the way into it
+    for (int c = 0; c < COLLECTORS; ++c) {
+        if (!expensive(static_cast<Collector>(c)) || base(static_cast<Collector>(c)) != c) continue;
+        int before = 0, sharing = 0;
+        for (int other = 0; other < COLLECTORS; ++other) {
+            Collector o = static_cast<Collector>(other);
+            if (!expensive(o) || base(o) != other || period[other] != period[c]) continue;
+            sharing++;
+            if (other < c) before++;
+        }
+        phase[c] = period[c] * before / sharing;
+    }
+    for (int c = 0; c < COLLECTORS; ++c) {
+        int b = base(static_cast<Collector>(c));
+        if (b != c) phase[c] = phase[b];
+        unlink(c);
+        arm(c, current);
+    }
+}
+
+// the first jiffy after `after` on the collector's grid
+void CollectorSchedule::arm(int id, unsigned long long after) {
+    unsigned long long next = after >= phase[id] ? ((after - phase[id]) / period[id] + 1) * period[id] + phase[id]
+                                                 : phase[id];
+    timers[id].expires = next;
+    link(id);
+}
+
+void CollectorSchedule::link(int id) {
+    Timer& timer = timers[id];
+    unsigned long long delta = timer.expires > current ? timer.expires - current : 0;
+    unsigned long long expires = current + delta;
+    timer.level = delta < SLOTS ? 0 : delta < SLOTS * SLOTS ? 1 : 2;
+    timer.slot = static_cast<int>((expires >> (timer.level * SLOT_BITS)) & (SLOTS - 1));
+    timer.next = heads[timer.level][timer.slot];
+    heads[timer.level][timer.slot] = id;
+}
+
+void CollectorSchedule::unlink(int id) {
+    Timer& timer = timers[id];
+    if (timer.level < 0) return;
+    for (int* at = &heads[timer.level][timer.slot]; *at >= 0; at = &timers[*at].next) {
+        if (*at != id) continue;
+        *at = timer.next;
+        break;
+    }
+    timer.level = timer.slot = timer.next = -1;
+}
+
+// Moves the timers of the slot whose range starts at `current` one level down.
+void CollectorSchedule::cascade(int level) {
+    int slot = static_cast<int>((current >> (level * SLOT_BITS)) & (SLOTS - 1));
+    int id = heads[level][slot];
+    heads[level][slot] = -1;
+    while (id >= 0) {
+        int next = timers[id].next;
+        timers[id].level = -1;
+        link(id);
+        id = next;
+    }
+}
+
+unsigned CollectorSchedule::advance(double seconds) {
+    unsigned long long target = seconds > 0 ? static_cast<unsigned long long>(seconds / JIFFY + 1e-6) : 0;
+    if (target <= current) return 0;
+    unsigned fired = 0;
+    if (target - current > MAX_PERIOD) {
+        // asleep for longer than any period: everything is due
+        for (int c = 0; c < COLLECTORS; ++c) unlink(c);
+        fired = (1u << COLLECTORS) - 1;
+        current = target;
+    }
+    while (current < target) {
+        current++;
+        int slot = static_cast<int>(current & (SLOTS - 1));
+        if (slot == 0) {
+            if (((current >> SLOT_BITS) & (SLOTS - 1)) == 0) cascade(2);
+            cascade(1);
+        }
+        for (int id = heads[0][slot]; id >= 0;) {
+            int next = timers[id].next;
+            timers[id].level = timers[id].slot = timers[id].next = -1;
+            fired |= 1u << id;
+            id = next;
+        }
+        heads[0][slot] = -1;
+    }
+    for (int c = 0; c < COLLECTORS; ++c)
+        if (fired & (1u << c)) arm(c, current);
+    return fired;
+}
+
+// With a dozen timers the earliest is quicker found by looking at all of them
+// than by walking the slots.
+double CollectorSchedule::nextDeadline() const {
+    unsigned long long earliest = current + MAX_PERIOD;
+    for (const Timer& timer : timers) earliest = min(earliest, timer.expires);
+    return earliest * JIFFY;
+}
@@ -0,0 +1,120 @@
+#include "header.h"
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// The layout is shared with C readers, so make sure the compiler laid it out the
+// way monitor_shm.h documents it.
+static_assert(offsetof(monitor_shm_segment, seq) % 8 == 0, "seq must be 8-byte aligned");
+static_assert(offsetof(monitor_shm_segment, data) == 64, "snapshot must start on its own cache line");
+
+SnapshotPublisher::SnapshotPublisher() : fd(-1), segment(nullptr), sequence(0) {}
+
+SnapshotPublisher::~SnapshotPublisher() { close(); }
+
+// Whether `shmName` names the object open as `fd`, rather than nothing or a
+// newer one.
+bool SnapshotPublisher::isNamed(const char* shmName) const {
+    int named = shm_open(shmName, O_RDONLY | O_CLOEXEC, 0);
+    if (named < 0) return false;
+    struct stat held, current;
+    bool same = fstat(fd, &held) == 0 && fstat(named, &current) == 0 && held.st_dev == current.st_dev &&
+                held.st_ino == current.st_ino;
+    ::close(named);
+    return same;
+}
+
+// Creates the shared-memory segment, or takes over one left behind by a run
+// that didn't exit cleanly, and writes its header. The seqlock has a single
+// writer, so the segment is held with an exclusive flock() for as long as it
+// is open: if another monitor holds it, this fails with errno EBUSY and leaves
+// that monitor's segment alone. The segment is world-readable so other users'
+// tools can map it read-only.
+bool SnapshotPublisher::open(const char* shmName) {
+    close();
+    name = shmName;
+
+    // A monitor that is exiting unlinks the name while it still holds the
+    // lock, so the object opened here may lose its name before the lock is
+    // ours. Once locked, the name must still lead to it; if not, start over.
+    for (int attempt = 0;; ++attempt) {
+        fd = shm_open(shmName, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            int error = errno == EWOULDBLOCK ? EBUSY : errno;
+            ::close(fd); // without unlinking: the name is the other monitor's
+            fd = -1;
+            errno = error;
+            return false;
+        }
+        if (isNamed(shmName)) break;
+        ::close(fd);
+        fd = -1;
+        if (attempt == 8) {
+            errno = EBUSY; // monitors keep starting and stopping under this name
+            return false;
+        }
+    }
+
+    if (ftruncate(fd, sizeof(monitor_shm_segment)) != 0) {
+        close();
+        return false;
+    }
+
+    void* addr = mmap(nullptr, sizeof(monitor_shm_segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        close();
+        return false;
+    }
+    segment = static_cast<monitor_shm_segment*>(addr);
+
+    // Invalidate the segment while the header is rewritten, in case a reader
+    // still has a segment from a previous run mapped. Until the first publish
+    // the sequence says nothing has been, so readers don't take the zeroed
+    // snapshot for a sample.
+    __atomic_store_n(&segment->magic, 0u, __ATOMIC_RELAXED);
+    __atomic_store_n(&segment->seq, static_cast<uint64_t>(MONITOR_SHM_SEQ_UNPUBLISHED), __ATOMIC_RELAXED);
+    memset(&segment->data, 0, sizeof(segment->data));
+    segment->version = MONITOR_SHM_VERSION;
+    segment->header_size = offsetof(monitor_shm_segment, data);
+    segment->snapshot_size = sizeof(monitor_shm_snapshot);
+    __atomic_store_n(&segment->magic, MONITOR_SHM_MAGIC, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Unmaps and removes the segment so readers don't pick up a stale snapshot
+// after the monitor exits. The name is unlinked while the lock is still held,
+// so it can't be a new monitor's segment by then.
+void SnapshotPublisher::close() {
+    if (segment) {
+        munmap(segment, sizeof(monitor_shm_segment));
+        segment = nullptr;
+    }
+    if (fd >= 0) {
+        shm_unlink(name.c_str());
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool SnapshotPublisher::isOpen() const { return segment != nullptr; }
+
+// Seqlock write: make the counter odd, copy the snapshot in, make it even again.
+// The first write starts from MONITOR_SHM_SEQ_UNPUBLISHED, which is odd already.
+// There is a single writer, so this never waits on anything.
+void SnapshotPublisher::publish(const monitor_shm_snapshot& snapshot) {
+    if (!segment) return;
+
+    uint64_t seq = __atomic_load_n(&segment->seq, __ATOMIC_RELAXED) | 1;
+    __atomic_store_n(&segment->seq, seq, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(&segment->data, &snapshot, sizeof(snapshot));
+    segment->data.sequence = ++sequence;
+
+    __atomic_store_n(&segment->seq, seq + 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,90 @@
+#include "header.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+// /proc/<pid>/smaps_rollup (Linux 4.14+) sums smaps over all mappings:
+//   00400000-7ffd2c5f1000 ---p 00000000 00:00 0    [rollup]
+//   Rss:               14328 kB
+//   Pss:                6212 kB
+//   ...
+//   Swap:                  0 kB
+//   SwapPss:               0 kB
+// Pss splits every shared page between the processes that map it, so unlike RSS
+// it adds up to the memory actually in use. The kernel walks the page tables to
+// produce it, which for a large process takes hundreds of microseconds.
+
+void SmapsTracker::read(int pid, Entry& entry) {
+    char path[PATH_MAX];
+    entry.readPass = pass;
+    entry.pss = entry.swap = -1;
+    if (!monitorPathf(path, sizeof(path), "/proc/%d/smaps_rollup", pid)) return;
+    ssize_t length = readFileInto(path, buffer);
+    if (length < 0) entry.denied = errno == EACCES || errno == EPERM;
+    if (length <= 0) return; // exited, another user's process, or an older kernel
+    const char* text = buffer.data();
+    const char* at;
+    if ((at = strstr(text, "\nPss:"))) entry.pss = strtoll(at + 5, nullptr, 10);
+    if ((at = strstr(text, "\nSwap:"))) entry.swap = strtoll(at + 6, nullptr, 10);
+}
+
+void SmapsTracker::update(vector<Proc>& processes, const vector<int>& visible) {
+    MONITOR_PROBE(PROBE_UPDATE_SMAPS);
+    // a PID that names another process now starts over
+    pass++;
+    for (const Proc& proc : processes) {
+        Entry& entry = entries[proc.pid];
+        if (entry.startTime != proc.startTime) {
+            entry = Entry{};
+            entry.startTime = proc.startTime;
+        }
+        entry.seenPass = pass;
+    }
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.seenPass != pass) it = entries.erase(it);
+        else ++it;
+    }
+
+    // the budget is real time spent reading, whatever clock the sampler runs on;
+    // one file is always read, so the values never stop moving altogether
+    auto start = std::chrono::steady_clock::now();
+    int reads = 0;
+    auto outOfTime = [&] {
+        return reads > 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= budget;
+    };
+    auto readOnce = [&](int pid) {
+        auto it = entries.find(pid);
+        if (it == entries.end() || it->second.readPass == pass || it->second.denied || outOfTime()) return;
+        read(pid, it->second);
+        reads++;
+    };
+
+    for (int pid : visible) readOnce(pid);
+
+    largest.resize(processes.size());
+    for (size_t i = 0; i < processes.size(); ++i) largest[i] = i;
+    size_t top = min(largest.size(), static_cast<size_t>(TOP_PROCESSES));
+    partial_sort(largest.begin(), largest.begin() + top, largest.end(),
+                 [&](int a, int b) { return processes[a].rss > processes[b].rss; });
+    for (size_t i = 0; i < top; ++i) readOnce(processes[largest[i]].pid);
+
+    // everything else in PID order, continuing where the last update stopped
+    auto it = entries.upper_bound(nextPid);
+    for (size_t visited = 0; visited < entries.size() && !outOfTime(); ++visited, ++it) {
+        if (it == entries.end()) it = entries.begin();
+        if (it->second.readPass == pass || it->second.denied) continue;
+        read(it->first, it->second);
+        reads++;
+        nextPid = it->first;
+    }
+
+    apply(processes);
+}
+
+void SmapsTracker::apply(vector<Proc>& processes) const {
+    for (Proc& proc : processes) {
+        auto it = entries.find(proc.pid);
+        proc.pss = it != entries.end() ? it->second.pss : -1;
+        proc.swap = it != entries.end() ? it->second.swap : -1;
+    }
+}
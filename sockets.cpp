@@ -0,0 +1,241 @@
+#include "header.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/tcp.h>
+#include <linux/unix_diag.h>
+#include <sys/socket.h>
+
+// A sock_diag dump is one request and a stream of replies, each holding as many
+// messages as fit, ending with NLMSG_DONE:
+//   inet_diag_msg  state, ports and addresses, queues, uid, inode
+//     INET_DIAG_INFO  struct tcp_info (TCP only, and only when asked for)
+//   unix_diag_msg  type, state, inode
+//     UNIX_DIAG_NAME  bound path, starting with '\0' for the abstract namespace
+//     UNIX_DIAG_PEER  inode of the other end
+//     UNIX_DIAG_RQLEN queued bytes (for a listener, pending connections and backlog)
+// Owners aren't part of the answer; they come from the socket inodes that
+// FdTracker finds in /proc/<pid>/fd.
+
+const char* socketProtocolName(SocketProtocol protocol) {
+    switch (protocol) {
+        case SOCKET_TCP: return "tcp";
+        case SOCKET_UDP: return "udp";
+        case SOCKET_UNIX: return "unix";
+        default: return "?";
+    }
+}
+
+// from the kernel's include/net/tcp_states.h, which isn't exported to userspace
+static constexpr unsigned char STATE_CLOSE = 7;
+
+const char* socketStateName(const SocketInfo& socket) {
+    static const char* const names[] = {"?", "ESTAB", "SYN-SENT", "SYN-RECV", "FIN-WAIT-1", "FIN-WAIT-2",
+                                        "TIME-WAIT", "UNCONN", "CLOSE-WAIT", "LAST-ACK", "LISTEN", "CLOSING",
+                                        "NEW-SYN-RECV"};
+    // a TCP socket in TCP_CLOSE has been closed; anything else there was never connected
+    if (socket.protocol == SOCKET_TCP && socket.state == STATE_CLOSE) return "CLOSE";
+    return socket.state < sizeof(names) / sizeof(names[0]) ? names[socket.state] : "?";
+}
+
+SocketTracker::~SocketTracker() {
+    if (netlinkFd >= 0) close(netlinkFd);
+}
+
+// the next element of `sockets` to fill in, reusing one from the last update if there is one
+SocketInfo& SocketTracker::next(vector<SocketInfo>& sockets) {
+    if (count == sockets.size()) sockets.emplace_back();
+    SocketInfo& socket = sockets[count++];
+    memset(&socket, 0, sizeof(socket));
+    socket.pid = socket.process = socket.nameOffset = -1;
+    return socket;
+}
+
+// Sends one dump request and appends what comes back. Returns false if the
+// request failed, which leaves the netlink socket in an unknown state.
+bool SocketTracker::dump(const void* request, size_t length, vector<SocketInfo>& sockets, vector<char>& names) {
+    sockaddr_nl kernel{};
+    kernel.nl_family = AF_NETLINK;
+    if (sendto(netlinkFd, request, length, 0, reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel)) < 0)
+        return false;
+    // every request starts with sdiag_family and sdiag_protocol
+    const unsigned char* payload = static_cast<const unsigned char*>(request) + NLMSG_HDRLEN;
+    const unsigned char family = payload[0];
+    const unsigned char protocol = payload[1];
+
+    while (true) {
+        ssize_t received = recv(netlinkFd, buffer.data(), buffer.size(), 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        int remaining = static_cast<int>(received);
+        for (nlmsghdr* header = reinterpret_cast<nlmsghdr*>(buffer.data()); NLMSG_OK(header, remaining);
+             header = NLMSG_NEXT(header, remaining)) {
+            if (header->nlmsg_type == NLMSG_DONE) return true;
+            // a protocol the kernel has no diag module for (udp_diag not
+            // loaded) answers ENOENT; that is an empty table, not a failure
+            if (header->nlmsg_type == NLMSG_ERROR)
+                return static_cast<const nlmsgerr*>(NLMSG_DATA(header))->error == -ENOENT;
+
+            if (family == AF_UNIX) {
+                const unix_diag_msg* message = static_cast<const unix_diag_msg*>(NLMSG_DATA(header));
+                SocketInfo& socket = next(sockets);
+                socket.protocol = SOCKET_UNIX;
+                socket.family = AF_UNIX;
+                socket.state = message->udiag_state;
+                socket.unixType = message->udiag_type;
+                socket.inode = message->udiag_ino;
+                int attributesLength = header->nlmsg_len - NLMSG_LENGTH(sizeof(*message));
+                for (rtattr* attribute = reinterpret_cast<rtattr*>(const_cast<unix_diag_msg*>(message) + 1);
+                     RTA_OK(attribute, attributesLength); attribute = RTA_NEXT(attribute, attributesLength)) {
+                    const char* data = static_cast<const char*>(RTA_DATA(attribute));
+                    size_t dataLength = RTA_PAYLOAD(attribute);
+                    if (attribute->rta_type == UNIX_DIAG_NAME && dataLength > 0) {
+                        socket.nameOffset = static_cast<int>(names.size());
+                        names.push_back(data[0] == '\0' ? '@' : data[0]); // abstract names are shown as @name
+                        names.insert(names.end(), data + 1, data + strnlen(data + 1, dataLength - 1) + 1);
+                        names.push_back('\0');
+                    } else if (attribute->rta_type == UNIX_DIAG_PEER && dataLength >= sizeof(uint32_t)) {
+                        memcpy(&socket.peerInode, data, sizeof(uint32_t));
+                    } else if (attribute->rta_type == UNIX_DIAG_RQLEN && dataLength >= sizeof(unix_diag_rqlen)) {
+                        unix_diag_rqlen queues;
+                        memcpy(&queues, data, sizeof(queues));
+                        socket.receiveQueue = queues.udiag_rqueue;
+                        socket.sendQueue = queues.udiag_wqueue;
+                    }
+                }
+                continue;
+            }
+
+            const inet_diag_msg* message = static_cast<const inet_diag_msg*>(NLMSG_DATA(header));
+            SocketInfo& socket = next(sockets);
+            socket.protocol = protocol == IPPROTO_TCP ? SOCKET_TCP : SOCKET_UDP;
+            socket.family = message->idiag_family;
+            socket.state = message->idiag_state;
+            socket.inode = message->idiag_inode;
+            socket.receiveQueue = message->idiag_rqueue;
+            socket.sendQueue = message->idiag_wqueue;
+            size_t addressLength = socket.family == AF_INET6 ? 16 : 4;
+            memcpy(socket.localAddress, message->id.idiag_src, addressLength);
+            memcpy(socket.remoteAddress, message->id.idiag_dst, addressLength);
+            socket.localPort = ntohs(message->id.idiag_sport);
+            socket.remotePort = ntohs(message->id.idiag_dport);
+            int attributesLength = header->nlmsg_len - NLMSG_LENGTH(sizeof(*message));
+            for (rtattr* attribute = reinterpret_cast<rtattr*>(const_cast<inet_diag_msg*>(message) + 1);
+                 RTA_OK(attribute, attributesLength); attribute = RTA_NEXT(attribute, attributesLength)) {
+                if (attribute->rta_type != INET_DIAG_INFO) continue;
+                // an older kernel sends a shorter tcp_info; the fields it lacks stay 0
+                tcp_info info{};
+                memcpy(&info, RTA_DATA(attribute), min<size_t>(RTA_PAYLOAD(attribute), sizeof(info)));
+                socket.rttUs = info.tcpi_rtt;
+                socket.retransmits = info.tcpi_total_retrans;
+                if (socket.inode)
+                    transferred.push_back(Transferred{socket.inode, static_cast<int>(count - 1),
+                                                      info.tcpi_bytes_received, info.tcpi_bytes_acked});
+            }
+        }
+    }
+}
+
+bool SocketTracker::update(vector<SocketInfo>& sockets, vector<char>& names, const FdTracker& owners,
+                           vector<Proc>& processes) {
+    MONITOR_PROBE(PROBE_UPDATE_SOCKETS);
+    count = 0;
+    names.clear();
+    transferred.clear();
+    if (hasMonitorRoot()) {
+        sockets.clear();
+        attribute(sockets, owners, processes);
+        return false;
+    }
+    if (netlinkFd < 0) netlinkFd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    if (netlinkFd < 0) {
+        sockets.clear();
+        attribute(sockets, owners, processes);
+        return false;
+    }
+    if (buffer.size() < BUFFER_SIZE) buffer.resize(BUFFER_SIZE);
+
+    struct InetRequest {
+        nlmsghdr header;
+        inet_diag_req_v2 request;
+    };
+    struct UnixRequest {
+        nlmsghdr header;
+        unix_diag_req request;
+    };
+    bool ok = true;
+    static const unsigned char families[] = {AF_INET, AF_INET6};
+    static const unsigned char protocols[] = {IPPROTO_TCP, IPPROTO_UDP};
+    for (unsigned char protocol : protocols) {
+        for (unsigned char family : families) {
+            InetRequest request{};
+            request.header.nlmsg_len = sizeof(request);
+            request.header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+            request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+            request.request.sdiag_family = family;
+            request.request.sdiag_protocol = protocol;
+            request.request.idiag_states = ~0u;
+            if (protocol == IPPROTO_TCP) request.request.idiag_ext = 1 << (INET_DIAG_INFO - 1);
+            ok = ok && dump(&request, sizeof(request), sockets, names);
+        }
+    }
+    UnixRequest request{};
+    request.header.nlmsg_len = sizeof(request);
+    request.header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.request.sdiag_family = AF_UNIX;
+    request.request.udiag_states = ~0u;
+    request.request.udiag_show = UDIAG_SHOW_NAME | UDIAG_SHOW_PEER | UDIAG_SHOW_RQLEN;
+    ok = ok && dump(&request, sizeof(request), sockets, names);
+    sockets.resize(count);
+    if (!ok) {
+        // replies may still be queued; a fresh socket starts clean next time
+        close(netlinkFd);
+        netlinkFd = -1;
+        lastTime = -1;
+        attribute(sockets, owners, processes);
+        return false;
+    }
+
+    // byte counts since the last dump, matched up by inode
+    double now = monitorClock();
+    double elapsed = now - lastTime;
+    sort(transferred.begin(), transferred.end(),
+         [](const Transferred& a, const Transferred& b) { return a.inode < b.inode; });
+    if (lastTime >= 0 && elapsed > 0) {
+        auto last = lastTransferred.begin();
+        for (const Transferred& current : transferred) {
+            while (last != lastTransferred.end() && last->inode < current.inode) ++last;
+            bool seen = last != lastTransferred.end() && last->inode == current.inode;
+            unsigned long long received = seen ? last->received : 0, acked = seen ? last->acked : 0;
+            SocketInfo& socket = sockets[current.socket];
+            socket.receiveRate = current.received >= received ? static_cast<float>((current.received - received) / elapsed) : 0.0f;
+            socket.sendRate = current.acked >= acked ? static_cast<float>((current.acked - acked) / elapsed) : 0.0f;
+        }
+    }
+    attribute(sockets, owners, processes);
+    transferred.swap(lastTransferred);
+    lastTime = now;
+    return true;
+}
+
+void SocketTracker::attribute(vector<SocketInfo>& sockets, const FdTracker& owners, vector<Proc>& processes) {
+    for (Proc& proc : processes) proc.netReceiveRate = proc.netSendRate = 0.0f;
+    processIndex.resize(processes.size());
+    for (size_t i = 0; i < processes.size(); ++i) processIndex[i] = {processes[i].pid, static_cast<int>(i)};
+    sort(processIndex.begin(), processIndex.end());
+    for (SocketInfo& socket : sockets) {
+        socket.pid = owners.socketOwner(socket.inode);
+        socket.process = -1;
+        if (socket.pid < 0) continue;
+        auto found = lower_bound(processIndex.begin(), processIndex.end(), make_pair(socket.pid, -1));
+        if (found == processIndex.end() || found->first != socket.pid) continue;
+        socket.process = found->second;
+        processes[socket.process].netReceiveRate += socket.receiveRate;
+        processes[socket.process].netSendRate += socket.sendRate;
+    }
+}
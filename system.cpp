@@ -1,9 +1,13 @@
 #include "header.h"
+#include <algorithm>
+#include <cstdarg>
 #include <cstring>
+#include <fcntl.h>
 #include <fstream>
 #include <pwd.h>
 #include <sstream>
 #include <unistd.h>
+#include <set>
 
 #include <fstream>
 #include <string>
@@ -12,6 +16,7 @@
 // get cpu id and information, you can use `proc/cpuinfo`
 string CPUinfo()
 {
+    MONITOR_PROBE(PROBE_CPU_INFO);
     char CPUBrandString[0x40];
     unsigned int CPUInfo[4] = {0, 0, 0, 0};
 
@@ -39,6 +44,77 @@ string CPUinfo()
     return str;
 }
 
+// prefix for every /proc and /sys path the collectors read; empty means the live system
+static string monitorRoot;
+static unsigned rootGeneration = 1;
+
+void setMonitorRoot(const string& root) {
+    monitorRoot = root;
+    while (!monitorRoot.empty() && monitorRoot.back() == '/') monitorRoot.pop_back();
+    rootGeneration++;
+}
+
+unsigned monitorRootGeneration() { return rootGeneration; }
+
+bool monitorPathf(char* out, size_t size, const char* fmt, ...) {
+    int prefix = snprintf(out, size, "%s", monitorRoot.c_str());
+    if (prefix < 0 || static_cast<size_t>(prefix) >= size) return false;
+    va_list args;
+    va_start(args, fmt);
+    int length = vsnprintf(out + prefix, size - prefix, fmt, args);
+    va_end(args);
+    return length >= 0 && static_cast<size_t>(length) < size - prefix;
+}
+
+ssize_t readFileInto(const char* path, char* buffer, size_t size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    size_t length = 0;
+    while (length + 1 < size) {
+        ssize_t n = read(fd, buffer + length, size - 1 - length);
+        if (n <= 0) break;
+        length += n;
+    }
+    close(fd);
+    buffer[length] = '\0';
+    return length;
+}
+
+ssize_t readFileInto(const char* path, vector<char>& buffer) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    if (buffer.size() < 4096) buffer.resize(4096);
+    size_t length = 0;
+    while (true) {
+        if (length + 1 >= buffer.size()) buffer.resize(buffer.size() * 2);
+        ssize_t n = read(fd, buffer.data() + length, buffer.size() - 1 - length);
+        if (n <= 0) break;
+        length += n;
+    }
+    close(fd);
+    buffer[length] = '\0';
+    return length;
+}
+
+string monitorPath(const string& path) {
+    return monitorRoot.empty() ? path : monitorRoot + path;
+}
+
+bool hasMonitorRoot() { return !monitorRoot.empty(); }
+
+// time source for everything that turns counter deltas into rates; replaced by
+// a scripted clock when collectors run against generated fixtures
+static std::function<double()> monitorClockSource;
+
+void setMonitorClock(std::function<double()> clock) {
+    monitorClockSource = std::move(clock);
+}
+
+double monitorClock() {
+    if (monitorClockSource) return monitorClockSource();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 // getOsName, this will get the OS of the current computer
 const char *getOsName()
 {
@@ -83,31 +159,41 @@ string getHostname() {
 // containin process info
 map<char, int> countProcessStates() {
     map<char, int> processStates;
-    DIR *dir = opendir("/proc"); 
-    if (!dir) return processStates;
+    countProcessStates(processStates);
+    return processStates;
+}
+
+// Same, counting into an existing map. Counts are reset rather than the map
+// cleared, so states that are still present keep their nodes.
+void countProcessStates(map<char, int>& processStates) {
+    MONITOR_PROBE(PROBE_COUNT_PROCESS_STATES);
+    for (auto& entry : processStates) entry.second = 0;
+    char path[PATH_MAX];
+    char stat[1024];
+    DIR *dir = opendir(monitorPath("/proc").c_str()); 
+    if (!dir) return;
 
     struct dirent *entry;
     while ((entry = readdir(dir)) != nullptr) { // iterate over each entry in the /proc directory
         // Check if the directory name is numeric (PID)
-        if (isdigit(entry->d_name[0])) {
-            string statPath = "/proc/" + string(entry->d_name) + "/stat";
-            ifstream statFile(statPath); // open file using input file stream
-            if (statFile.is_open()) {
-                string fullStat;
-                getline(statFile, fullStat); //read entire line of the file
-                size_t statePos = fullStat.find_last_of(")");
-                if (statePos != string::npos && statePos + 2 < fullStat.length()) {
-                    char state = fullStat[statePos + 2]; // extract the process state character
-                    // Map 'I' (idle) to 'S' (sleeping) to match top's behavior
-                    if (state == 'I') state = 'S';
-                    processStates[state]++;
-                }
-                statFile.close();
-            }
+        if (!isdigit(entry->d_name[0])) continue;
+        if (!monitorPathf(path, sizeof(path), "/proc/%s/stat", entry->d_name)) continue;
+        if (readFileInto(path, stat, sizeof(stat)) <= 0) continue;
+        const char* nameEnd = strrchr(stat, ')'); // the name itself may contain ')'
+        if (nameEnd && nameEnd[1] == ' ' && nameEnd[2] != '\0') {
+            char state = nameEnd[2]; // extract the process state character
+            // Map 'I' (idle) to 'S' (sleeping) to match top's behavior
+            if (state == 'I') state = 'S';
+            processStates[state]++;
         }
     }
     closedir(dir);
-    return processStates;
+
+    // drop states that no longer occur
+    for (auto it = processStates.begin(); it != processStates.end();) {
+        if (it->second == 0) it = processStates.erase(it);
+        else ++it;
+    }
 }  
 
 // returns the total number of processes found
@@ -120,114 +206,162 @@ int getTotalProcessCount() {
 
 
 
-// getCPUTemperature retrieves the current CPU temp on a Linux system using several
-// different methods. If one method fails it tries a different one. It is designed to
-// be compatible with different hardware vendors and kernel configurations.
-float getCPUTemperature() {
+// A sensor file found by one of the search methods below. Searching opens
+// every hwmon and thermal entry, so it only runs again when the file found
+// stops being readable, the root changes, or (when nothing was found) after
+// SENSOR_RETRY_SECONDS.
+struct SensorSource {
+    char path[PATH_MAX] = "";
+    const char* key = nullptr; // text before the value (ThinkPad files), nullptr for sysfs
+    float scale = 1.0f;        // converts the raw value to degrees / RPM
+    unsigned root = 0;         // monitorRootGeneration() the search ran under
+    double searchedAt = 0.0;
+    int fd = -1;               // the file, held open and re-read from the start
+};
+
+static constexpr double SENSOR_RETRY_SECONDS = 30.0;
+static constexpr size_t SENSOR_READ_SIZE = 512;
+
+static SensorSource temperatureSource, fanSource; // only the sampler thread reads them
+
+static void releaseSensor(SensorSource& source) {
+    if (source.fd >= 0) close(source.fd);
+    source.fd = -1;
+}
+
+static bool parseSensor(const SensorSource& source, const char* text, float& value) {
+    const char* at = text;
+    if (source.key) {
+        at = strstr(text, source.key);
+        if (!at) return false;
+        at += strlen(source.key);
+    }
+    char* end;
+    long raw = strtol(at, &end, 10);
+    if (end == at) return false;
+    value = raw * source.scale;
+    return true;
+}
+
+static bool readSensor(SensorSource& source, float& value) {
+    if (!source.path[0]) return false;
+    if (source.fd < 0) source.fd = open(source.path, O_RDONLY | O_CLOEXEC);
+    if (source.fd < 0) return false;
+    char text[SENSOR_READ_SIZE];
+    ssize_t length = pread(source.fd, text, sizeof(text) - 1, 0);
+    if (length <= 0) {
+        releaseSensor(source); // the device went away; the search runs again
+        return false;
+    }
+    text[length] = '\0';
+    return parseSensor(source, text, value);
+}
+
+// points `source` at the file and reads it; false (and `source` unusable) if that fails
+static bool trySensor(SensorSource& source, float& value, const char* key, float scale, const char* fmt, const char* name) {
+    releaseSensor(source);
+    source.key = key;
+    source.scale = scale;
+    return monitorPathf(source.path, sizeof(source.path), fmt, name) && readSensor(source, value);
+}
+
+// true if the first line of the file contains one of the NULL-terminated words
+static bool fileHasWord(const char* path, const char* const* words) {
+    char text[256];
+    if (readFileInto(path, text, sizeof(text)) <= 0) return false;
+    text[strcspn(text, "\n")] = '\0';
+    for (; *words; ++words) {
+        if (strstr(text, *words)) return true;
+    }
+    return false;
+}
+
+// Reads the cached sensor, searching for it first if needed
+static float readCachedSensor(SensorSource& source, bool (*search)(SensorSource&, float&)) {
+    float value;
+    bool sameRoot = source.root == monitorRootGeneration();
+    if (sameRoot && readSensor(source, value)) return value;
+    if (sameRoot && !source.path[0] && monitorClock() - source.searchedAt < SENSOR_RETRY_SECONDS)
+        return 0.0f; // nothing found last time; don't rescan every tick
+
+    releaseSensor(source);
+    source.root = monitorRootGeneration();
+    source.searchedAt = monitorClock();
+    if (search(source, value)) return value;
+    releaseSensor(source);
+    source.path[0] = '\0';
+    return 0.0f;
+}
+
+// The temperature search tries several methods in order. If one method fails it
+// tries a different one. It is designed to be compatible with different hardware
+// vendors and kernel configurations.
+static bool findTemperatureSensor(SensorSource& source, float& temp) {
+    char path[PATH_MAX];
     // Method 1: Try to find coretemp in hwmon devices. hwmon dir contains hardware monitor devices.
-    DIR* hwmonDir = opendir("/sys/class/hwmon"); 
+    static const char* const coretemp[] = {"coretemp", nullptr};
+    DIR* hwmonDir = opendir(monitorPath("/sys/class/hwmon").c_str()); 
     if (hwmonDir) {
         struct dirent* entry;
         while ((entry = readdir(hwmonDir)) != nullptr) {
             if (entry->d_type == DT_LNK || entry->d_type == DT_DIR) { //ensure only link directories are read
-                if (strncmp(entry->d_name, "hwmon", 5) == 0) {
-                    std::string namePath = "/sys/class/hwmon/" + std::string(entry->d_name) + "/name";
-                    std::ifstream nameFile(namePath);
-                    std::string name;
-                    if (nameFile.is_open() && std::getline(nameFile, name)) {
-                        if (name == "coretemp") {
-                            // Found coretemp, read Package id 0 temperature
-                            std::string tempPath = "/sys/class/hwmon/" + std::string(entry->d_name) + "/temp1_input";
-                            std::ifstream tempFile(tempPath);
-                            int temp;
-                            if (tempFile.is_open() && (tempFile >> temp)) {
-                                closedir(hwmonDir);
-                                return temp / 1000.0f; // Convert from millidegrees to degrees celsius
-                            }
-                        }
-                    }
+                if (strncmp(entry->d_name, "hwmon", 5) == 0 &&
+                    monitorPathf(path, sizeof(path), "/sys/class/hwmon/%s/name", entry->d_name) &&
+                    fileHasWord(path, coretemp) &&
+                    // Found coretemp, read Package id 0 temperature (millidegrees)
+                    trySensor(source, temp, nullptr, 0.001f, "/sys/class/hwmon/%s/temp1_input", entry->d_name)) {
+                    closedir(hwmonDir);
+                    return true;
                 }
             }
         }
         closedir(hwmonDir);
     }
 
-
     // Method 2: Try x86_pkg_temp thermal zone
-    std::ifstream pkgTempFile("/sys/class/thermal/thermal_zone14/temp");
-    if (pkgTempFile.is_open()) {
-        int temp;
-        if (pkgTempFile >> temp) {
-            return temp / 1000.0f; // Convert from millidegrees to degrees
-        }
-    }
+    if (trySensor(source, temp, nullptr, 0.001f, "/sys/class/thermal/%s/temp", "thermal_zone14")) return true;
 
     // Method 3: Try to find any CPU-related thermal zone
-    DIR* thermalDir = opendir("/sys/class/thermal");
+    static const char* const cpuTypes[] = {"x86", "cpu", "CPU", "processor", nullptr};
+    DIR* thermalDir = opendir(monitorPath("/sys/class/thermal").c_str());
     if (thermalDir) {
         struct dirent* entry;
         while ((entry = readdir(thermalDir)) != nullptr) {
-            if (strncmp(entry->d_name, "thermal_zone", 12) == 0) {
-                std::string typePath = "/sys/class/thermal/" + std::string(entry->d_name) + "/type"; //check the sensor type
-                std::ifstream typeFile(typePath);
-                std::string type;
-                if (typeFile.is_open() && std::getline(typeFile, type)) {
-                    // Look for CPU-related thermal zones
-                    if (type.find("x86") != std::string::npos || //npos represents not found
-                        type.find("cpu") != std::string::npos ||
-                        type.find("CPU") != std::string::npos ||
-                        type.find("processor") != std::string::npos) {
-                        std::string tempPath = "/sys/class/thermal/" + std::string(entry->d_name) + "/temp";
-                        std::ifstream tempFile(tempPath);
-                        int temp;
-                        if (tempFile.is_open() && (tempFile >> temp)) {
-                            closedir(thermalDir);
-                            return temp / 1000.0f; // Convert from millidegrees to degrees
-                        }
-                    }
-                }
+            if (strncmp(entry->d_name, "thermal_zone", 12) == 0 &&
+                monitorPathf(path, sizeof(path), "/sys/class/thermal/%s/type", entry->d_name) && //check the sensor type
+                fileHasWord(path, cpuTypes) &&
+                trySensor(source, temp, nullptr, 0.001f, "/sys/class/thermal/%s/temp", entry->d_name)) {
+                closedir(thermalDir);
+                return true;
             }
         }
         closedir(thermalDir);
     }
 
-     // Method 4: ThinkPad-specific method (fallback)
-    std::ifstream thinkpadTempFile("/proc/acpi/ibm/thermal");
-    if (thinkpadTempFile.is_open()) {
-        std::string line;
-        if (getline(thinkpadTempFile, line)) {
-            // Parse the temperatures line
-            // Format is "temperatures: 50 -128 0 0 39 0 0 -128"
-            if (line.find("temperatures:") != std::string::npos) {
-                std::istringstream iss(line.substr(line.find(":") + 1));
-                int temp;
-                iss >> temp; // Read the first temperature value
-                return temp; // Already in degrees C, no need to divide by 1000
-            }
-        }
-    }
-
-    // default value to be returned if all methods fail
-    return 0.0f;
+    // Method 4: ThinkPad-specific method (fallback)
+    // Format is "temperatures: 50 -128 0 0 39 0 0 -128", already in degrees C
+    return trySensor(source, temp, "temperatures:", 1.0f, "/proc/acpi/ibm/%s", "thermal");
+}
 
+// getCPUTemperature retrieves the current CPU temp on a Linux system, in degrees
+// celsius, or 0 if no sensor was found. Only the sampler thread calls it.
+float getCPUTemperature() {
+    MONITOR_PROBE(PROBE_GET_CPU_TEMPERATURE);
+    return readCachedSensor(temperatureSource, findTemperatureSensor);
 }
 
-float getFanSpeed() {
+static bool findFanSensor(SensorSource& source, float& speed) {
     // Method 1: Try to find fan speed in hwmon devices
-    DIR* hwmonDir = opendir("/sys/class/hwmon");
+    DIR* hwmonDir = opendir(monitorPath("/sys/class/hwmon").c_str());
     if (hwmonDir) {
         struct dirent* entry;
         while ((entry = readdir(hwmonDir)) != nullptr) {
             if (entry->d_type == DT_LNK || entry->d_type == DT_DIR) {
-                if (strncmp(entry->d_name, "hwmon", 5) == 0) {
-                    // Check for fan1_input or similar files
-                    std::string fanPath = "/sys/class/hwmon/" + std::string(entry->d_name) + "/fan1_input";
-                    std::ifstream fanFile(fanPath);
-                    int speed;
-                    if (fanFile.is_open() && (fanFile >> speed)) {
-                        closedir(hwmonDir);
-                        return static_cast<float>(speed);
-                    }
+                // Check for fan1_input or similar files
+                if (strncmp(entry->d_name, "hwmon", 5) == 0 &&
+                    trySensor(source, speed, nullptr, 1.0f, "/sys/class/hwmon/%s/fan1_input", entry->d_name)) {
+                    closedir(hwmonDir);
+                    return true;
                 }
             }
         }
@@ -239,45 +373,57 @@ float getFanSpeed() {
     // Research the specific paths for HP EliteBook
 
     // Method 3: ThinkPad-specific method (fallback)
-    std::ifstream thinkpadFanFile("/proc/acpi/ibm/fan");
-    if (thinkpadFanFile.is_open()) {
-        std::string line;
-        while (getline(thinkpadFanFile, line)) {
-            // Look for the line that starts with "speed:"
-            // Format is "speed:      2814"
-            if (line.find("speed:") != std::string::npos) {
-                std::istringstream iss(line.substr(line.find(":") + 1));
-                float speed;
-                iss >> speed;
-                return speed;
-            }
-        }
-    }
+    // Look for the line that starts with "speed:", format is "speed:      2814"
+    return trySensor(source, speed, "speed:", 1.0f, "/proc/acpi/ibm/%s", "fan");
+}
 
-    // If all methods fail, return 0
-    return 0.0f;
+// fan speed in RPM, or 0 if no fan sensor was found. Only the sampler thread calls it.
+float getFanSpeed() {
+    MONITOR_PROBE(PROBE_GET_FAN_SPEED);
+    return readCachedSensor(fanSource, findFanSensor);
 }
 
-// Destructor for class Networks
-// Networks::~Networks() {
-//     for (auto& ip : ip4s) free(ip.name); // free memory allocated for ip.name
-// }
+// Both sensors at once, for the sampler. Their files are already open after the
+// first read, so with io_uring that is one system call for the two.
+void readSensors(float& temperature, float& fanSpeed) {
+    MONITOR_PROBE(PROBE_READ_SENSORS);
+    static ReadBatch reads(SENSOR_READ_SIZE, 2);
+    SensorSource* sources[2] = {&temperatureSource, &fanSource};
+    float* values[2] = {&temperature, &fanSpeed};
+    bool read[2] = {false, false};
+    int queued[2];
+    reads.clear();
+    for (int i = 0; i < 2; ++i) {
+        if (sources[i]->fd < 0 || sources[i]->root != monitorRootGeneration()) continue;
+        queued[reads.size()] = i;
+        reads.add(sources[i]->fd);
+    }
+    reads.run([&](size_t at, char* text, ssize_t length) {
+        int i = queued[at];
+        read[i] = length > 0 && parseSensor(*sources[i], text, *values[i]);
+    });
+    // not open yet, or failed: read (or searched for) on their own
+    if (!read[0]) temperature = readCachedSensor(temperatureSource, findTemperatureSensor);
+    if (!read[1]) fanSpeed = readCachedSensor(fanSource, findFanSensor);
+}
 
 // Constructor for CPUUsageTracker class
 CPUUsageTracker::CPUUsageTracker() : lastStats{0}, currentUsage(0.0f) {}
 
 // Calculate and return the current CPU usage percentage as a float
 float CPUUsageTracker::calculateCPUUsage() {
-    ifstream statFile("/proc/stat");
-    string line;
-    getline(statFile, line);
-
-    CPUStats current;
-    sscanf(line.c_str(), "cpu %lld %lld %lld %lld %lld %lld %lld %lld %lld %lld",
-           &current.user, &current.nice, &current.system,
-           &current.idle, &current.iowait, &current.irq,
-           &current.softirq, &current.steal, &current.guest,
-           &current.guestNice);
+    MONITOR_PROBE(PROBE_CALCULATE_CPU_USAGE);
+    // only the first line ("cpu  ...", the sum over all CPUs) is needed
+    char path[PATH_MAX];
+    char line[512];
+    CPUStats current = {};
+    if (monitorPathf(path, sizeof(path), "/proc/stat") && readFileInto(path, line, sizeof(line)) > 0) {
+        sscanf(line, "cpu %lld %lld %lld %lld %lld %lld %lld %lld %lld %lld",
+               &current.user, &current.nice, &current.system,
+               &current.idle, &current.iowait, &current.irq,
+               &current.softirq, &current.steal, &current.guest,
+               &current.guestNice);
+    }
 
     // compute total CPU time recorded in previous snapshot (excluding guest and guestNice)
     long long prevTotal = lastStats.user + lastStats.nice + lastStats.system +
@@ -304,21 +450,43 @@ float CPUUsageTracker::getCurrentUsage() { return currentUsage; }
 
 // constructor that initializes:
 // - deltaTime which accumulates time passed since last CPU usage.
-// - updateInterval 
-// - lastUpdateTime stores the time of the last update
+// - updateInterval is how long a process's cached CPU usage is reused
 ProcessUsageTracker::ProcessUsageTracker()
-    : deltaTime(0.0f), updateInterval(3.0f), lastUpdateTime(0.0f) {}
+    : deltaTime(0.0f), updateInterval(3.0f) {}
 
 void ProcessUsageTracker::updateDeltaTime(float dt) {
     deltaTime += dt; // Accumulate time since last major update
 }
 
+void ProcessUsageTracker::setUpdateInterval(float seconds) {
+    updateInterval = seconds;
+}
+
+// drops the samples of processes that are no longer in the list so the maps
+// don't keep growing as PIDs come and go
+void ProcessUsageTracker::forgetExited(const vector<Proc>& processes) {
+    alivePids.clear();
+    for (const auto& proc : processes) alivePids.push_back(proc.pid);
+    sort(alivePids.begin(), alivePids.end());
+    for (auto it = lastProcessCPUTime.begin(); it != lastProcessCPUTime.end();) {
+        if (binary_search(alivePids.begin(), alivePids.end(), it->first)) {
+            ++it;
+        } else {
+            cpuUsageCache.erase(it->first);
+            it = lastProcessCPUTime.erase(it);
+        }
+    }
+}
+
 // This is a per-process CPU usage tracker
 float ProcessUsageTracker::calculateProcessCPUUsage(const Proc& process, float currentTime) {
+    long long nowMs = static_cast<long long>(currentTime * 1000.0f);
+    auto last = lastProcessCPUTime.find(process.pid);
+
     // Return cached value if not time to update.
     // This ensures CPU usage isn't calculated every call, only after updateInterval
-    // seconds have passed.
-    if (currentTime - lastUpdateTime < updateInterval) {
+    // seconds have passed since this process was last sampled.
+    if (last != lastProcessCPUTime.end() && nowMs - last->second.second < updateInterval * 1000.0f) {
         auto it = cpuUsageCache.find(process.pid);
         return (it != cpuUsageCache.end()) ? it->second : 0.0f;
     }
@@ -331,29 +499,22 @@ float ProcessUsageTracker::calculateProcessCPUUsage(const Proc& process, float c
         return 0.0f;
     }
 
-
     // Calculate process CPU time using utime and stime
     long long processCPUTime = process.utime + process.stime;
 
-    // Get the wall clock time delta. This is the 'T' in 'top's calculation (CPU_TIME_DELTA / T).
-    float timeDeltaInSeconds = currentTime - lastUpdateTime;
-
-    // If this is the first time we've seen this process
-    if (lastProcessCPUTime.find(process.pid) == lastProcessCPUTime.end()) {
-        // store just the process CPU time, as total system time isn't needed.
-        // The original map was a pair, so we'll just use the 'first' element of the pair
-        // to match the original declaration and avoid errors.
-        lastProcessCPUTime[process.pid].first = processCPUTime;
-        // The second element is not used but is part of the pair.
-        lastProcessCPUTime[process.pid].second = 0;
+    // If this is the first time we've seen this process, remember its CPU time
+    // and when we saw it; usage can only be computed from the next sample on.
+    if (last == lastProcessCPUTime.end()) {
+        lastProcessCPUTime[process.pid] = {processCPUTime, nowMs};
         cpuUsageCache[process.pid] = 0.0f;
-        lastUpdateTime = currentTime;
         return 0.0f;
     }
 
+    // Get the wall clock time delta. This is the 'T' in 'top's calculation (CPU_TIME_DELTA / T).
+    float timeDeltaInSeconds = (nowMs - last->second.second) / 1000.0f;
+
     // Calculate deltas
-    long long lastProcTime = lastProcessCPUTime[process.pid].first;
-    long long procTimeDelta = processCPUTime - lastProcTime;
+    long long procTimeDelta = processCPUTime - last->second.first;
 
     // Calculate CPU usage percentage
     float cpuUsage = 0.0f;
@@ -365,8 +526,7 @@ float ProcessUsageTracker::calculateProcessCPUUsage(const Proc& process, float c
 
     // Update cache and last values
     cpuUsageCache[process.pid] = cpuUsage;
-    lastProcessCPUTime[process.pid].first = processCPUTime;
-    lastUpdateTime = currentTime;
+    last->second = {processCPUTime, nowMs};
 
     return cpuUsage;
 }
@@ -0,0 +1,132 @@
+#include "header.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+// Per-thread CPU% for the processes selected in the UI. A process's CPU% is the
+// sum over its threads, which hides the one thread that is spinning in a busy
+// server; /proc/<pid>/task/<tid>/stat has the same fields as the process's stat,
+// per thread. Only the watched processes are read, so with nothing selected an
+// update costs nothing at all.
+
+// Parses the fields the thread view needs from one task stat line. As with the
+// process stat, fields are counted from the state, after the parenthesised name:
+// [0] state, [11] utime, [12] stime, [36] processor.
+static bool parseThreadStat(const char* line, ThreadUsage& thread, long long& cpuTime) {
+    const char* nameStart = strchr(line, '(');
+    const char* nameEnd = strrchr(line, ')');
+    if (!nameStart || !nameEnd || nameEnd < nameStart) return false;
+    size_t length = min(static_cast<size_t>(nameEnd - nameStart - 1), sizeof(thread.name) - 1);
+    memcpy(thread.name, nameStart + 1, length);
+    thread.name[length] = '\0';
+
+    long long fields[37] = {};
+    char state = 0;
+    int count = 0;
+    const char* at = nameEnd + 1;
+    while (count < 37) {
+        while (*at == ' ') at++;
+        if (*at == '\0' || *at == '\n') break;
+        if (count == 0) state = *at;
+        else fields[count] = strtoll(at, nullptr, 10);
+        count++;
+        while (*at && *at != ' ' && *at != '\n') at++;
+    }
+    if (count < 13) return false;
+    thread.state = state;
+    thread.processor = count == 37 ? static_cast<int>(fields[36]) : -1;
+    cpuTime = fields[11] + fields[12];
+    return true;
+}
+
+ThreadTracker::~ThreadTracker() { release(); }
+
+// closes every task directory and gives the samples' memory back
+void ThreadTracker::release() {
+    for (Watched& process : watched)
+        if (process.tasks) closedir(process.tasks);
+    vector<Watched>().swap(watched);
+    vector<Sample>().swap(samples);
+    vector<Sample>().swap(nextSamples);
+    lastTime = -1;
+}
+
+void ThreadTracker::update(const vector<int>& pids, vector<ThreadUsage>& threads) {
+    if (pids.empty()) {
+        if (!watched.empty()) release();
+        threads.clear();
+        return;
+    }
+    MONITOR_PROBE(PROBE_UPDATE_THREADS);
+    if (rootGeneration != monitorRootGeneration()) {
+        release();
+        rootGeneration = monitorRootGeneration();
+    }
+
+    // follow the watch list: close what was deselected, add what was selected
+    for (size_t i = 0; i < watched.size();) {
+        if (find(pids.begin(), pids.end(), watched[i].pid) != pids.end()) {
+            i++;
+            continue;
+        }
+        if (watched[i].tasks) closedir(watched[i].tasks);
+        watched.erase(watched.begin() + i);
+    }
+    for (int pid : pids) {
+        auto known = find_if(watched.begin(), watched.end(), [pid](const Watched& process) { return process.pid == pid; });
+        if (known == watched.end()) watched.push_back(Watched{pid, nullptr});
+    }
+
+    static const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    double now = monitorClock();
+    double elapsed = lastTime >= 0 && ticksPerSecond > 0 ? now - lastTime : 0;
+    lastTime = now;
+
+    size_t count = 0;
+    nextSamples.clear();
+    for (Watched& process : watched) {
+        char path[PATH_MAX];
+        if (process.tasks) {
+            rewinddir(process.tasks);
+        } else if (monitorPathf(path, sizeof(path), "/proc/%d/task", process.pid)) {
+            process.tasks = opendir(path);
+        }
+        if (!process.tasks) continue;
+
+        size_t first = count;
+        while (dirent* entry = readdir(process.tasks)) {
+            if (!isdigit(static_cast<unsigned char>(entry->d_name[0]))) continue;
+            char line[1024];
+            if (!monitorPathf(path, sizeof(path), "/proc/%d/task/%s/stat", process.pid, entry->d_name) ||
+                readFileInto(path, line, sizeof(line)) <= 0)
+                continue; // the thread exited between the listing and the read
+
+            if (count == threads.size()) threads.emplace_back();
+            ThreadUsage& thread = threads[count];
+            long long cpuTime = 0;
+            if (!parseThreadStat(line, thread, cpuTime)) continue;
+            thread.pid = process.pid;
+            thread.tid = atoi(entry->d_name);
+            thread.cpuPercent = 0.0f;
+            auto previous = lower_bound(samples.begin(), samples.end(), thread.tid,
+                                        [](const Sample& sample, int tid) { return sample.tid < tid; });
+            if (elapsed > 0 && previous != samples.end() && previous->tid == thread.tid && cpuTime >= previous->cpuTime)
+                thread.cpuPercent = static_cast<float>((cpuTime - previous->cpuTime) * 100.0 / ticksPerSecond / elapsed);
+            nextSamples.push_back(Sample{thread.tid, cpuTime});
+            count++;
+        }
+        // an exited process's directory stays empty; if the PID comes back it
+        // is another process, so the directory is opened again
+        if (count == first) {
+            closedir(process.tasks);
+            process.tasks = nullptr;
+        }
+        sort(threads.begin() + first, threads.begin() + count, [](const ThreadUsage& a, const ThreadUsage& b) {
+            return a.cpuPercent != b.cpuPercent ? a.cpuPercent > b.cpuPercent : a.tid < b.tid;
+        });
+    }
+    threads.resize(count);
+
+    sort(nextSamples.begin(), nextSamples.end(), [](const Sample& a, const Sample& b) { return a.tid < b.tid; });
+    samples.swap(nextSamples);
+}
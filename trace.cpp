@@ -0,0 +1,128 @@
+#include "header.h"
+#include <cstring>
+#include <sys/syscall.h>
+
+// Span tracing. Each thread owns a fixed-size ring buffer that is allocated the
+// first time it records a span and never grows; recording a span is two TSC
+// reads and one store into that buffer. Old spans are overwritten, so a dump
+// always holds the most recent TRACE_CAPACITY spans of every thread.
+
+static constexpr unsigned long long TRACE_CAPACITY = 1 << 14; // spans kept per thread, power of two
+
+struct TraceBuffer {
+    char name[16];
+    int tid;
+    std::atomic<unsigned long long> head{0}; // total spans ever recorded
+    TraceEvent events[TRACE_CAPACITY];
+};
+
+std::atomic<bool> tracingEnabled{false};
+
+static std::mutex traceRegistryLock;
+static vector<TraceBuffer*> traceRegistry;
+static thread_local TraceBuffer* localTrace = nullptr;
+static thread_local char localTraceName[16] = "thread";
+
+// traceNow() reading and CLOCK_MONOTONIC time taken together when tracing was
+// switched on; a second pair taken at dump time gives the tick rate
+static unsigned long long calibrationTicks = 0;
+static unsigned long long calibrationNs = 0;
+
+static unsigned long long monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long long>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+void setTracing(bool enabled) {
+    if (enabled && calibrationTicks == 0) {
+        calibrationNs = monotonicNs();
+        calibrationTicks = traceNow();
+    }
+    tracingEnabled = enabled;
+}
+
+void setTraceThreadName(const char* name) {
+    snprintf(localTraceName, sizeof(localTraceName), "%s", name);
+    if (localTrace) memcpy(localTrace->name, localTraceName, sizeof(localTraceName));
+}
+
+static TraceBuffer* createTraceBuffer() {
+    localTrace = new TraceBuffer();
+    memcpy(localTrace->name, localTraceName, sizeof(localTraceName));
+    localTrace->tid = static_cast<int>(syscall(SYS_gettid));
+    std::lock_guard<std::mutex> guard(traceRegistryLock);
+    traceRegistry.push_back(localTrace);
+    return localTrace;
+}
+
+void recordTraceSpan(const char* name, unsigned long long start, unsigned long long end) {
+    TraceBuffer* buffer = localTrace ? localTrace : createTraceBuffer();
+    unsigned long long head = buffer->head.load(std::memory_order_relaxed);
+    // A dump may be copying this slot. The fence orders the head stores so far
+    // before the slot is rewritten, so a dump that sees any of the new values
+    // also sees a head that tells it the slot was overwritten.
+    std::atomic_thread_fence(std::memory_order_release);
+    TraceEvent& slot = buffer->events[head & (TRACE_CAPACITY - 1)];
+    __atomic_store_n(&slot.name, name, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.start, start, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.end, end, __ATOMIC_RELAXED);
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+// Writes the buffered spans as complete ("X") events plus thread-name metadata,
+// which chrome://tracing and Perfetto both load. Recording carries on meanwhile:
+// each buffer is copied out first, then its head is read again, and any span
+// whose slot the owner may have rewritten during the copy is dropped.
+bool writeChromeTrace(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+
+    vector<TraceBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> guard(traceRegistryLock);
+        buffers = traceRegistry;
+    }
+
+    // convert ticks to microseconds on the CLOCK_MONOTONIC timeline
+    unsigned long long nowNs = monotonicNs();
+    unsigned long long nowTicks = traceNow();
+    double nsPerTick = 1.0;
+    if (nowTicks > calibrationTicks && nowNs > calibrationNs)
+        nsPerTick = static_cast<double>(nowNs - calibrationNs) / (nowTicks - calibrationTicks);
+    auto toMicros = [&](unsigned long long ticks) {
+        return (calibrationNs + (static_cast<double>(ticks) - calibrationTicks) * nsPerTick) / 1000.0;
+    };
+
+    vector<TraceEvent> copy(TRACE_CAPACITY);
+    int pid = getpid();
+    bool first = true;
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (TraceBuffer* buffer : buffers) {
+        fprintf(out, "%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",", pid, buffer->tid, buffer->name);
+        first = false;
+
+        unsigned long long head = buffer->head.load(std::memory_order_acquire);
+        unsigned long long begin = head > TRACE_CAPACITY ? head - TRACE_CAPACITY : 0;
+        for (unsigned long long i = begin; i < head; ++i) {
+            const TraceEvent& slot = buffer->events[i & (TRACE_CAPACITY - 1)];
+            copy[i - begin] = TraceEvent{__atomic_load_n(&slot.name, __ATOMIC_RELAXED),
+                                         __atomic_load_n(&slot.start, __ATOMIC_RELAXED),
+                                         __atomic_load_n(&slot.end, __ATOMIC_RELAXED)};
+        }
+        // the slot of index newHead may be half written, and so may those of
+        // the indices before it that share a slot with one written since
+        std::atomic_thread_fence(std::memory_order_acquire);
+        unsigned long long newHead = buffer->head.load(std::memory_order_relaxed);
+        unsigned long long valid = newHead >= TRACE_CAPACITY ? newHead - TRACE_CAPACITY + 1 : 0;
+        for (unsigned long long i = max(begin, valid); i < head; ++i) {
+            const TraceEvent& event = copy[i - begin];
+            fprintf(out, ",\n{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    event.name, pid, buffer->tid, toMicros(event.start),
+                    (event.end - event.start) * nsPerTick / 1000.0);
+        }
+    }
+    fprintf(out, "\n]}\n");
+    return fclose(out) == 0;
+}
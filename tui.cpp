@@ -0,0 +1,486 @@
+#include "header.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdarg>
+#include <cstring>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <termios.h>
+
+// Terminal frontend for hosts where the SDL window isn't available (e.g. over SSH).
+// The screen is kept as two cell grids: the one the terminal currently shows and the
+// one being drawn. Each frame only the cells that differ are sent, batched into a
+// single write(), so a mostly static screen costs a few bytes per refresh.
+
+// cell styles: low nibble is the ANSI foreground color, high bits are attributes
+enum TermStyle : unsigned char {
+    STYLE_DEFAULT = 9, // SGR 39, terminal default color
+    STYLE_RED = 1,
+    STYLE_GREEN = 2,
+    STYLE_YELLOW = 3,
+    STYLE_BLUE = 4,
+    STYLE_CYAN = 6,
+    STYLE_BOLD = 0x10,
+    STYLE_REVERSE = 0x20,
+};
+
+struct TermCell {
+    char ch;
+    unsigned char style;
+    bool operator==(const TermCell& other) const { return ch == other.ch && style == other.style; }
+};
+
+// Double-buffered grid of character cells
+class TermScreen {
+private:
+    int width = 0, height = 0;
+    vector<TermCell> front, back; // front is what the terminal shows, back is the frame being drawn
+    string out;                   // escape sequences for one frame, reused between frames
+    bool fullRedraw = true;
+
+public:
+    int cols() const { return width; }
+    int rows() const { return height; }
+
+    void resize(int w, int h) {
+        width = max(w, 1);
+        height = max(h, 1);
+        front.assign(width * height, TermCell{' ', STYLE_DEFAULT});
+        back.assign(width * height, TermCell{' ', STYLE_DEFAULT});
+        fullRedraw = true;
+    }
+
+    void clear() { fill(back.begin(), back.end(), TermCell{' ', STYLE_DEFAULT}); }
+
+    // writes text at (x, y), clipped to the screen; returns the column after the text
+    int put(int x, int y, const char* text, unsigned char style = STYLE_DEFAULT) {
+        if (y < 0 || y >= height) return x;
+        for (; *text && x < width; ++text, ++x) {
+            if (x < 0) continue;
+            unsigned char c = static_cast<unsigned char>(*text);
+            back[y * width + x] = TermCell{(c >= 32 && c < 127) ? static_cast<char>(c) : '?', style};
+        }
+        return x;
+    }
+
+    __attribute__((format(printf, 5, 6))) int print(int x, int y, unsigned char style, const char* fmt, ...) {
+        char buffer[512];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(buffer, sizeof(buffer), fmt, args);
+        va_end(args);
+        return put(x, y, buffer, style);
+    }
+
+    // horizontal bar: `fraction` of `length` cells filled
+    void bar(int x, int y, int length, float fraction, unsigned char style) {
+        fraction = std::clamp(fraction, 0.0f, 1.0f);
+        int filled = static_cast<int>(fraction * length + 0.5f);
+        put(x, y, "[");
+        for (int i = 0; i < length; ++i) {
+            char c[2] = {i < filled ? '|' : ' ', 0};
+            put(x + 1 + i, y, c, style);
+        }
+        put(x + 1 + length, y, "]");
+    }
+
+    // forces the next flush to repaint everything (after a resize or a ^L)
+    void invalidate() { fullRedraw = true; }
+
+    // Emits the changed cells and swaps the buffers. Cursor moves are skipped when the
+    // next changed cell directly follows the previous one, and SGR codes are only sent
+    // when the style changes.
+    void flush(int fd) {
+        out.clear();
+        if (fullRedraw) out += "\x1b[0m\x1b[2J";
+
+        int cursorX = -1, cursorY = -1;
+        int currentStyle = -1;
+        char seq[32];
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const TermCell& cell = back[y * width + x];
+                if (!fullRedraw && cell == front[y * width + x]) continue;
+
+                if (x != cursorX || y != cursorY) {
+                    snprintf(seq, sizeof(seq), "\x1b[%d;%dH", y + 1, x + 1);
+                    out += seq;
+                }
+                if (cell.style != currentStyle) {
+                    snprintf(seq, sizeof(seq), "\x1b[0;%s%s3%dm",
+                             (cell.style & STYLE_BOLD) ? "1;" : "",
+                             (cell.style & STYLE_REVERSE) ? "7;" : "",
+                             cell.style & 0x0f);
+                    out += seq;
+                    currentStyle = cell.style;
+                }
+                out += cell.ch;
+                cursorX = x + 1;
+                cursorY = y;
+            }
+        }
+        fullRedraw = false;
+        front = back; // the terminal now shows this frame
+        if (out.empty()) return;
+
+        // one write() per frame; only loop if the terminal took a partial write
+        const char* data = out.data();
+        size_t left = out.size();
+        while (left > 0) {
+            ssize_t n = write(fd, data, left);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            data += n;
+            left -= n;
+        }
+    }
+};
+
+enum TermView { VIEW_SYSTEM, VIEW_PROCESSES, VIEW_NETWORK };
+enum TermSort { SORT_CPU, SORT_MEMORY, SORT_PID };
+
+static volatile sig_atomic_t termResized = 0;
+static volatile sig_atomic_t termQuit = 0;
+
+static void onTermResize(int) { termResized = 1; }
+static void onTermQuit(int) { termQuit = 1; }
+
+static void termSize(int& cols, int& rows) {
+    winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 && ws.ws_row > 0) {
+        cols = ws.ws_col;
+        rows = ws.ws_row;
+    } else {
+        cols = 80;
+        rows = 24;
+    }
+}
+
+static unsigned char percentStyle(float percent) {
+    return percent < 60.0f ? STYLE_GREEN : percent < 85.0f ? STYLE_YELLOW : STYLE_RED;
+}
+
+static void drawSystemView(TermScreen& screen, const SystemSnapshot& data, const vector<float>& cpuHistory, int top) {
+    int y = top;
+    screen.print(0, y++, STYLE_DEFAULT, "Operating System: %s", getOsName());
+    screen.print(0, y++, STYLE_DEFAULT, "Username: %s", data.username.c_str());
+    screen.print(0, y++, STYLE_DEFAULT, "Hostname: %s", data.hostname.c_str());
+    screen.print(0, y++, STYLE_DEFAULT, "CPU Type: %s", data.cpuModel.c_str());
+    y++;
+
+    screen.print(0, y++, STYLE_BOLD, "Processes: %d", data.totalProcesses);
+    auto count = [&](char c) {
+        auto it = data.processStates.find(c);
+        return it == data.processStates.end() ? 0 : it->second;
+    };
+    screen.print(2, y++, STYLE_DEFAULT, "Running: %d  Sleeping: %d  Disk sleep: %d  Zombie: %d  Stopped: %d",
+                 count('R'), count('S'), count('D'), count('Z'), count('T'));
+    y++;
+
+    screen.print(0, y, STYLE_BOLD, "CPU");
+    screen.bar(5, y, max(10, screen.cols() - 20), data.cpuUsage / 100.0f, percentStyle(data.cpuUsage));
+    screen.print(screen.cols() - 12, y++, STYLE_DEFAULT, "%5.1f%%", data.cpuUsage);
+
+    // history graph, newest sample on the right, one column per sample
+    int graphHeight = std::clamp(screen.rows() - y - 4, 3, 10);
+    int graphWidth = min<int>(cpuHistory.size(), screen.cols() - 6);
+    for (int row = 0; row < graphHeight; ++row) {
+        float threshold = 100.0f * (graphHeight - row - 0.5f) / graphHeight;
+        if (row == 0) screen.put(0, y + row, "100%");
+        if (row == graphHeight - 1) screen.put(0, y + row, "  0%");
+        for (int i = 0; i < graphWidth; ++i) {
+            float value = cpuHistory[cpuHistory.size() - graphWidth + i];
+            if (value >= threshold) screen.put(5 + i, y + row, "#", percentStyle(value));
+        }
+    }
+    y += graphHeight + 1;
+
+    if (data.temperature > 0.1f) {
+        unsigned char style = data.temperature < 50.0f ? STYLE_GREEN : data.temperature < 70.0f ? STYLE_YELLOW : STYLE_RED;
+        screen.print(0, y, STYLE_DEFAULT, "Temperature: ");
+        screen.print(13, y++, style, "%.1f C", data.temperature);
+    } else {
+        screen.put(0, y++, "Temperature: not available");
+    }
+    if (data.fanSpeed > 0) screen.print(0, y++, STYLE_DEFAULT, "Fan Speed: %.0f RPM", data.fanSpeed);
+    else screen.put(0, y++, "Fan Speed: not available");
+}
+
+static void drawProcessView(TermScreen& screen, const SystemSnapshot& data, vector<size_t>& order,
+                            TermSort sort, int& scroll, int top) {
+    const MemoryInfo& mem = data.memory;
+    int barLength = max(10, screen.cols() - 50);
+    int y = top;
+    screen.print(0, y, STYLE_BOLD, "RAM ");
+    screen.bar(5, y, barLength, mem.ram_percent / 100.0f, percentStyle(mem.ram_percent));
+    screen.print(barLength + 8, y++, STYLE_DEFAULT, "%.1f / %.1f GB (%.1f%%)", mem.used_ram, mem.total_ram, mem.ram_percent);
+    screen.print(0, y, STYLE_BOLD, "Swap");
+    screen.bar(5, y, barLength, mem.swap_percent / 100.0f, percentStyle(mem.swap_percent));
+    screen.print(barLength + 8, y++, STYLE_DEFAULT, "%.1f / %.1f GB (%.1f%%)", mem.used_swap, mem.total_swap, mem.swap_percent);
+    screen.print(0, y, STYLE_BOLD, "Disk");
+    screen.bar(5, y, barLength, data.disk.usage_percent / 100.0f, percentStyle(data.disk.usage_percent));
+    screen.print(barLength + 8, y++, STYLE_DEFAULT, "%.1f / %.1f GB (%.1f%%)", data.disk.used_space,
+                 data.disk.total_space, data.disk.usage_percent);
+    auto gb = [](unsigned long kb) { return kb / (1024.0f * 1024.0f); };
+    screen.print(0, y++, STYLE_CYAN, "Anon %.1f  Cache %.1f  Buffers %.1f  Shmem %.1f  Slab %.1f GB  Dirty %lu MB",
+                 gb(mem.anon_pages_kb), gb(mem.cached_kb), gb(mem.buffers_kb), gb(mem.shmem_kb),
+                 gb(mem.slab_kb), mem.dirty_kb / 1024);
+    y++;
+
+    int visible = screen.rows() - y - 2;
+    if (visible <= 0) return;
+
+    // only the rows that are on screen need to be in order, so a partial sort is enough
+    order.resize(data.processes.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    scroll = std::clamp(scroll, 0, max(0, static_cast<int>(order.size()) - visible));
+    size_t needed = min(order.size(), static_cast<size_t>(scroll + visible));
+    auto less = [&](size_t a, size_t b) {
+        switch (sort) {
+            case SORT_CPU: return data.processes[a].cpuPercent > data.processes[b].cpuPercent;
+            case SORT_MEMORY: return data.processes[a].rss > data.processes[b].rss;
+            default: return data.processes[a].pid < data.processes[b].pid;
+        }
+    };
+    partial_sort(order.begin(), order.begin() + needed, order.end(), less);
+
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    screen.print(0, y++, STYLE_REVERSE, "%-8s %-24s %-5s %8s %12s%*s", "PID", "Name", "State",
+                 sort == SORT_CPU ? "CPU%*" : "CPU%", sort == SORT_MEMORY ? "RSS*" : "RSS",
+                 max(0, screen.cols() - 61), "");
+    for (size_t i = scroll; i < needed; ++i, ++y) {
+        const Proc& proc = data.processes[order[i]];
+        float cpu = proc.cpuPercent;
+        screen.print(0, y, cpu >= 50.0f ? STYLE_RED : STYLE_DEFAULT, "%-8d %-24.24s %-5c %7.1f%% %12s",
+                     proc.pid, proc.name.c_str(), proc.state, cpu,
+                     formatNetworkBytes(proc.rss * pageSize).c_str());
+    }
+}
+
+static void drawNetworkView(TermScreen& screen, const SystemSnapshot& data, int top) {
+    auto rate = [](const map<string, float>& rates, const string& iface) {
+        auto it = rates.find(iface);
+        return it != rates.end() ? it->second : 0.0f;
+    };
+    int y = top;
+    screen.print(0, y++, STYLE_REVERSE, "%-16s %12s %12s %10s %8s %12s %12s %10s %8s%*s", "Interface",
+                 "RX/s", "RX bytes", "RX pkts", "RX errs", "TX/s", "TX bytes", "TX pkts", "TX errs",
+                 max(0, screen.cols() - 110), "");
+    for (const auto& [iface, rx] : data.rx) {
+        if (y >= screen.rows() - 1) break;
+        auto tx = data.tx.find(iface);
+        TX txStats = tx != data.tx.end() ? tx->second : TX{};
+        screen.print(0, y++, STYLE_DEFAULT, "%-16.16s %10s/s %12s %10lld %8lld %10s/s %12s %10lld %8lld",
+                     iface.c_str(), formatNetworkBytes(rate(data.rxRate, iface)).c_str(),
+                     formatNetworkBytes(rx.bytes).c_str(), rx.packets, rx.errs,
+                     formatNetworkBytes(rate(data.txRate, iface)).c_str(),
+                     formatNetworkBytes(txStats.bytes).c_str(), txStats.packets, txStats.errs);
+    }
+}
+
+// Keys past the byte range, decoded from escape sequences
+enum TermKey {
+    KEY_UP = 256,
+    KEY_DOWN,
+    KEY_PAGE_UP,
+    KEY_PAGE_DOWN,
+    KEY_ESCAPE,  // ESC on its own, or an Alt+key
+    KEY_UNKNOWN, // a sequence we have no use for
+};
+
+// How long a trailing ESC waits for the rest of a sequence before it counts as
+// the key itself. Over a slow link a sequence can arrive in pieces; nothing is
+// bound to ESC, so waiting costs nothing.
+static constexpr int ESCAPE_TIMEOUT_MS = 100;
+
+// Decodes the key at the start of `in` into `key`. Returns the bytes it took,
+// or 0 if `in` ends partway through an escape sequence.
+static size_t decodeTermKey(const char* in, size_t n, int& key) {
+    if (in[0] != '\x1b') {
+        key = static_cast<unsigned char>(in[0]);
+        return 1;
+    }
+    if (n < 2) return 0;
+    if (in[1] == 'O') { // SS3: cursor keys in application mode
+        if (n < 3) return 0;
+        key = in[2] == 'A' ? KEY_UP : in[2] == 'B' ? KEY_DOWN : KEY_UNKNOWN;
+        return 3;
+    }
+    if (in[1] != '[') {
+        key = KEY_ESCAPE;
+        return 1;
+    }
+    // CSI: parameter and intermediate bytes, then a final byte in @..~
+    size_t end = 2;
+    while (end < n && in[end] >= 0x20 && in[end] <= 0x3f) end++;
+    if (end == n) {
+        if (n < 32) return 0;
+        key = KEY_UNKNOWN; // no terminal sends one this long
+        return n;
+    }
+    if (in[end] < 0x40 || in[end] > 0x7e) {
+        key = KEY_UNKNOWN; // malformed; the byte that broke it is read as a key
+        return end;
+    }
+    bool single = end == 3;
+    switch (in[end]) {
+        case 'A': key = KEY_UP; break;
+        case 'B': key = KEY_DOWN; break;
+        case '~': key = single && in[2] == '5' ? KEY_PAGE_UP : single && in[2] == '6' ? KEY_PAGE_DOWN : KEY_UNKNOWN; break;
+        default: key = KEY_UNKNOWN; break;
+    }
+    return end + 1;
+}
+
+// Runs the terminal frontend until 'q' or a termination signal. The sampler collects
+// a snapshot at most every `refreshInterval` seconds and wakes the loop through an eventfd;
+// keystrokes redraw immediately from the latest snapshot.
+int runTerminalUI(float refreshInterval) {
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+        fprintf(stderr, "Error: --tui needs an interactive terminal\n");
+        return 1;
+    }
+
+    termios original;
+    tcgetattr(STDIN_FILENO, &original);
+    termios raw = original;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+
+    signal(SIGWINCH, onTermResize);
+    signal(SIGINT, onTermQuit);
+    signal(SIGTERM, onTermQuit);
+
+    const char enter[] = "\x1b[?1049h\x1b[?25l"; // alternate screen, hide cursor
+    const char leave[] = "\x1b[0m\x1b[?25h\x1b[?1049l";
+    if (write(STDOUT_FILENO, enter, sizeof(enter) - 1) < 0) return 1;
+
+    TermScreen screen;
+    int cols, rows;
+    termSize(cols, rows);
+    screen.resize(cols, rows);
+
+    int wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    Sampler sampler;
+    sampler.setInterval(refreshInterval);
+
+    // keep resize and quit signals on this thread so they interrupt our poll()
+    sigset_t termSignals, previousMask;
+    sigemptyset(&termSignals);
+    sigaddset(&termSignals, SIGWINCH);
+    sigaddset(&termSignals, SIGINT);
+    sigaddset(&termSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &termSignals, &previousMask);
+    sampler.start([wakeFd]() {
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written;
+    });
+    pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
+    shared_ptr<const SystemSnapshot> data = sampler.latest();
+    vector<float> cpuHistory(120, 0.0f);
+    float cpuHistoryTime = -1.0f; // CollectorStatus::lastRun of the newest point
+    vector<size_t> order;
+
+    TermView view = VIEW_SYSTEM;
+    TermSort sort = SORT_CPU;
+    int scroll = 0;
+    char pending[64]; // keys read but not yet decoded: the start of an escape sequence
+    size_t pendingLength = 0;
+    int key;
+
+    bool dirty = true;
+    setProbeThreadName("terminal");
+
+    while (!termQuit) {
+        if (termResized) {
+            termResized = 0;
+            termSize(cols, rows);
+            screen.resize(cols, rows);
+            dirty = true;
+        }
+
+        if (dirty) {
+            MONITOR_PROBE(PROBE_TERMINAL_FRAME);
+            screen.clear();
+            int x = 0;
+            const char* tabs[] = {" 1 System ", " 2 Memory/Processes ", " 3 Network "};
+            for (int i = 0; i < 3; ++i)
+                x = screen.put(x, 0, tabs[i], i == view ? (STYLE_REVERSE | STYLE_BOLD) : STYLE_DEFAULT) + 1;
+            screen.put(0, rows - 1, view == VIEW_PROCESSES
+                                        ? "q quit  1-3 views  c/m/p sort by CPU/memory/PID  up/down/PgUp/PgDn scroll"
+                                        : "q quit  1-3 views  tab next view", STYLE_CYAN);
+            switch (view) {
+                case VIEW_SYSTEM: drawSystemView(screen, *data, cpuHistory, 2); break;
+                case VIEW_PROCESSES: drawProcessView(screen, *data, order, sort, scroll, 2); break;
+                case VIEW_NETWORK: drawNetworkView(screen, *data, 2); break;
+            }
+            screen.flush(STDOUT_FILENO);
+            dirty = false;
+        }
+
+        // sleep until a key arrives or the sampler has a new snapshot; a
+        // partial escape sequence only waits ESCAPE_TIMEOUT_MS for the rest
+        pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+        int ready = poll(fds, 2, pendingLength > 0 ? ESCAPE_TIMEOUT_MS : -1);
+        if (ready < 0) continue;
+        if (ready == 0) {
+            pendingLength = 0; // it was ESC (or Alt+[) after all, and nothing is bound to that
+            continue;
+        }
+        if (fds[1].revents & POLLIN) {
+            uint64_t count;
+            ssize_t drained = read(wakeFd, &count, sizeof(count));
+            (void)drained;
+            data = sampler.latest();
+            if (data->collectors[COLLECTOR_CPU].lastRun != cpuHistoryTime) {
+                cpuHistoryTime = data->collectors[COLLECTOR_CPU].lastRun;
+                cpuHistory.erase(cpuHistory.begin());
+                cpuHistory.push_back(data->cpuUsage);
+            }
+            dirty = true;
+        }
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        ssize_t n = read(STDIN_FILENO, pending + pendingLength, sizeof(pending) - pendingLength);
+        if (n <= 0) continue;
+        pendingLength += n;
+        int page = max(1, rows - 10);
+        size_t at = 0;
+        for (size_t used; at < pendingLength && (used = decodeTermKey(pending + at, pendingLength - at, key)) > 0;) {
+            at += used;
+            switch (key) {
+                case 'q': case 'Q': termQuit = 1; break;
+                case '1': view = VIEW_SYSTEM; break;
+                case '2': view = VIEW_PROCESSES; break;
+                case '3': view = VIEW_NETWORK; break;
+                case '\t': view = static_cast<TermView>((view + 1) % 3); break;
+                case 'c': sort = SORT_CPU; break;
+                case 'm': sort = SORT_MEMORY; break;
+                case 'p': sort = SORT_PID; break;
+                case '\x0c': screen.invalidate(); break; // ^L repaints everything
+                case KEY_UP: scroll--; break;
+                case KEY_DOWN: scroll++; break;
+                case KEY_PAGE_UP: scroll -= page; break;
+                case KEY_PAGE_DOWN: scroll += page; break;
+            }
+        }
+        // an unfinished sequence stays for the next read
+        memmove(pending, pending + at, pendingLength - at);
+        pendingLength -= at;
+        dirty = true;
+    }
+
+    sampler.stop();
+    close(wakeFd);
+    ssize_t written = write(STDOUT_FILENO, leave, sizeof(leave) - 1);
+    (void)written; // nothing sensible left to do if the terminal is gone
+    tcsetattr(STDIN_FILENO, TCSANOW, &original);
+    return 0;
+}
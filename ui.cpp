@@ -0,0 +1,1466 @@
+#include "header.h"
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+// The ImGui windows of the SDL frontend. They only draw into the current ImGui
+// context, without touching SDL or OpenGL, so the benchmark can run them headless.
+
+static vector<float> cpuUsageHistory(100, 0.0f);
+static vector<float> temperatureHistory(100, 0.0f);
+
+// The graphs get one point per reading, so their time axis is the collector's
+// cadence; these are the readings (CollectorStatus::lastRun) last added.
+static float cpuGraphTime = -1.0f;
+static float fanGraphTime = -1.0f;
+static float thermalGraphTime = -1.0f;
+
+// cadences set in the UI, 0 for the ones left alone
+static float cadenceRequests[COLLECTORS];
+
+const float* requestedCadences() { return cadenceRequests; }
+
+// A slider for one collector's cadence, in seconds. The schedule runs on
+// 50 ms steps, so shorter ones aren't offered.
+static void cadenceSlider(const char* label, Collector collector, const SystemSnapshot& snap) {
+    float seconds = cadenceRequests[collector] > 0 ? cadenceRequests[collector] : snap.collectors[collector].cadence;
+    if (ImGui::SliderFloat(label, &seconds, 0.05f, 600.0f, "%.2f s", ImGuiSliderFlags_Logarithmic))
+        cadenceRequests[collector] = max(0.05f, seconds);
+}
+
+// Per-device history for the Disk I/O tab, recorded for every device whether or
+// not it is shown, so a graph has data as soon as its device is selected.
+static constexpr int DISK_HISTORY = 100;
+struct DiskHistory {
+    char name[sizeof(DiskIO::name)];
+    float readRate[DISK_HISTORY];  // bytes/s
+    float writeRate[DISK_HISTORY];
+    float utilization[DISK_HISTORY];
+    int next; // ring position of the oldest sample
+};
+static vector<DiskHistory> diskHistories;
+static float diskHistoryTime = -1.0f;
+
+static void recordDiskHistory(const SystemSnapshot& snap) {
+    if (snap.collectors[COLLECTOR_DISKS].lastRun == diskHistoryTime) return;
+    diskHistoryTime = snap.collectors[COLLECTOR_DISKS].lastRun;
+    for (const DiskIO& disk : snap.disks) {
+        auto history = find_if(diskHistories.begin(), diskHistories.end(),
+                               [&](const DiskHistory& entry) { return strcmp(entry.name, disk.name) == 0; });
+        if (history == diskHistories.end()) {
+            diskHistories.push_back(DiskHistory{});
+            history = diskHistories.end() - 1;
+            memcpy(history->name, disk.name, sizeof(history->name));
+        }
+        history->readRate[history->next] = disk.readBytesPerSec;
+        history->writeRate[history->next] = disk.writeBytesPerSec;
+        history->utilization[history->next] = disk.utilization;
+        history->next = (history->next + 1) % DISK_HISTORY;
+    }
+}
+
+static void diskIOTab(const SystemSnapshot& snap) {
+    static bool showPartitions = false;
+    static bool showVirtual = false;
+    static char selected[sizeof(DiskIO::name)] = "";
+    ImGui::Checkbox("Partitions", &showPartitions);
+    ImGui::SameLine();
+    ImGui::Checkbox("Loop/RAM devices", &showVirtual);
+
+    // whole disks only, so partitions and device-mapper volumes aren't counted twice
+    float totalRead = 0, totalWrite = 0;
+    for (const DiskIO& disk : snap.disks) {
+        if (disk.kind != DISK_WHOLE) continue;
+        totalRead += disk.readBytesPerSec;
+        totalWrite += disk.writeBytesPerSec;
+    }
+    ImGui::SameLine();
+    ImGui::Text("Total: read %s/s, write %s/s", formatNetworkBytes(totalRead).c_str(),
+                formatNetworkBytes(totalWrite).c_str());
+
+    if (ImGui::BeginTable("DiskIO", 9, ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+                          ImVec2(0, 140))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Device");
+        ImGui::TableSetupColumn("Read/s");
+        ImGui::TableSetupColumn("Write/s");
+        ImGui::TableSetupColumn("r IOPS");
+        ImGui::TableSetupColumn("w IOPS");
+        ImGui::TableSetupColumn("r await");
+        ImGui::TableSetupColumn("w await");
+        ImGui::TableSetupColumn("Util");
+        ImGui::TableSetupColumn("Queue");
+        ImGui::TableHeadersRow();
+        for (const DiskIO& disk : snap.disks) {
+            if ((disk.kind == DISK_PARTITION && !showPartitions) || (disk.kind == DISK_VIRTUAL && !showVirtual))
+                continue;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            bool isSelected = strcmp(selected, disk.name) == 0;
+            FormattedText label = TextF(disk.kind == DISK_PARTITION ? "  %s" : "%s", disk.label);
+            if (ImGui::Selectable(label.c_str(), isSelected, ImGuiSelectableFlags_SpanAllColumns))
+                memcpy(selected, disk.name, sizeof(selected));
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(formatNetworkBytes(disk.readBytesPerSec).c_str());
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(formatNetworkBytes(disk.writeBytesPerSec).c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%.0f", disk.readIops);
+            ImGui::TableNextColumn(); ImGui::Text("%.0f", disk.writeIops);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f ms", disk.readAwaitMs);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f ms", disk.writeAwaitMs);
+            ImGui::TableNextColumn(); ImGui::Text("%.0f%%", disk.utilization);
+            ImGui::TableNextColumn(); ImGui::Text("%.2f (%u)", disk.queueDepth, disk.inFlight);
+        }
+        ImGui::EndTable();
+    }
+
+    for (const DiskHistory& history : diskHistories) {
+        if (strcmp(history.name, selected) != 0) continue;
+        float maxRate = 1024.0f;
+        for (int i = 0; i < DISK_HISTORY; ++i) maxRate = max({maxRate, history.readRate[i], history.writeRate[i]});
+        ImGui::PlotLines("Read", history.readRate, DISK_HISTORY, history.next,
+                         TextF("%s read", history.name).c_str(), 0.0f, maxRate, ImVec2(0, 50));
+        ImGui::PlotLines("Write", history.writeRate, DISK_HISTORY, history.next,
+                         TextF("%s write", history.name).c_str(), 0.0f, maxRate, ImVec2(0, 50));
+        ImGui::PlotLines("Util %", history.utilization, DISK_HISTORY, history.next, nullptr, 0.0f, 100.0f,
+                         ImVec2(0, 50));
+    }
+}
+
+// "some" stall % per reading, one ring per resource like the disk history
+static constexpr int PRESSURE_HISTORY = 100;
+static float pressureHistory[PRESSURE_RESOURCES][PRESSURE_HISTORY];
+static int pressureHistoryNext = 0;
+static float pressureHistoryTime = -1.0f;
+
+static void recordPressureHistory(const SystemSnapshot& snap) {
+    if (snap.collectors[COLLECTOR_PRESSURE].lastRun == pressureHistoryTime) return;
+    pressureHistoryTime = snap.collectors[COLLECTOR_PRESSURE].lastRun;
+    for (int i = 0; i < PRESSURE_RESOURCES; ++i)
+        pressureHistory[i][pressureHistoryNext] = snap.pressure[i].some.recent;
+    pressureHistoryNext = (pressureHistoryNext + 1) % PRESSURE_HISTORY;
+}
+
+static void pressureTab(const SystemSnapshot& snap) {
+    if (!snap.pressure[PRESSURE_CPU].available) {
+        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Pressure stall information not available");
+        ImGui::Text("It needs Linux 4.20+ built with CONFIG_PSI (and psi=1 on some distributions).");
+        return;
+    }
+
+    if (ImGui::BeginTable("Pressure", 7, ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Resource");
+        ImGui::TableSetupColumn("Now");
+        ImGui::TableSetupColumn("avg10");
+        ImGui::TableSetupColumn("avg60");
+        ImGui::TableSetupColumn("avg300");
+        ImGui::TableSetupColumn("full avg10");
+        ImGui::TableSetupColumn("Stalled total");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < PRESSURE_RESOURCES; ++i) {
+            const Pressure& pressure = snap.pressure[i];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(pressureResourceName(static_cast<PressureResource>(i)));
+            ImGui::TableNextColumn(); ImGui::Text("%.1f%%", pressure.some.recent);
+            ImGui::TableNextColumn(); ImGui::Text("%.2f%%", pressure.some.avg10);
+            ImGui::TableNextColumn(); ImGui::Text("%.2f%%", pressure.some.avg60);
+            ImGui::TableNextColumn(); ImGui::Text("%.2f%%", pressure.some.avg300);
+            ImGui::TableNextColumn(); ImGui::Text("%.2f%%", pressure.full.avg10);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f s", pressure.some.total / 1e6);
+        }
+        ImGui::EndTable();
+    }
+
+    for (int i = 0; i < PRESSURE_RESOURCES; ++i) {
+        const char* name = pressureResourceName(static_cast<PressureResource>(i));
+        ImGui::PlotLines(name, pressureHistory[i], PRESSURE_HISTORY, pressureHistoryNext,
+                         TextF("%s some: %.1f%%", name, snap.pressure[i].some.recent).c_str(), 0.0f, 100.0f,
+                         ImVec2(0, 40));
+    }
+
+    // newest first; the trigger is "<some|full> <stall us> <window us>"
+    ImGui::Text("Stall events (trigger \"%s\"): %zu", pressureTrigger().c_str(), snap.stallEvents.size());
+    if (ImGui::BeginTable("StallEvents", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+                          ImVec2(0, ImGui::GetContentRegionAvail().y))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Time");
+        ImGui::TableSetupColumn("Resource");
+        ImGui::TableSetupColumn("some avg10");
+        ImGui::TableHeadersRow();
+        for (auto event = snap.stallEvents.rbegin(); event != snap.stallEvents.rend(); ++event) {
+            time_t seconds = static_cast<time_t>(event->wallTime);
+            tm local;
+            localtime_r(&seconds, &local);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%02d:%02d:%02d.%03d (%.1f s ago)", local.tm_hour, local.tm_min, local.tm_sec,
+                        static_cast<int>((event->wallTime - seconds) * 1000), snap.time - event->time);
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(pressureResourceName(event->resource));
+            ImGui::TableNextColumn(); ImGui::Text("%.2f%%", event->avg10);
+        }
+        ImGui::EndTable();
+    }
+}
+
+// Shows the monitor's own CPU% and RSS from /proc/self, and what every probed collector
+// and window function costs per call on each thread.
+static void monitorOverheadTab() {
+    static SelfUsageTracker selfUsage;
+    SelfUsage self = selfUsage.update();
+    ImGui::Text("Monitor CPU: %.1f%%   RSS: %s   Threads: %d", self.cpuPercent,
+                formatNetworkBytes(self.rssBytes).c_str(), self.threads);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Reset")) resetProbeTotals();
+
+    // span tracing, saved as Chrome trace-event JSON for chrome://tracing or Perfetto
+    static bool recordTrace = tracingEnabled;
+    static string traceStatus;
+    if (ImGui::Checkbox("Record trace", &recordTrace)) setTracing(recordTrace);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Save trace")) {
+        static int traceCount = 0;
+        FormattedText path = TextF("monitor-trace-%d-%d.json", getpid(), ++traceCount);
+        traceStatus = (writeChromeTrace(path.c_str()) ? "Saved " : "Could not write ") + string(path.c_str());
+    }
+    if (!traceStatus.empty()) {
+        ImGui::SameLine();
+        ImGui::TextUnformatted(traceStatus.c_str());
+    }
+
+    if (ImGui::BeginTable("Overhead", 8, ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg,
+                          ImVec2(0, ImGui::GetContentRegionAvail().y))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Thread");
+        ImGui::TableSetupColumn("Probe");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Avg (us)");
+        ImGui::TableSetupColumn("Max (us)");
+        ImGui::TableSetupColumn("R/W syscalls/call");
+        ImGui::TableSetupColumn("Bytes/call");
+        ImGui::TableSetupColumn("Allocs/call");
+        ImGui::TableHeadersRow();
+
+        forEachProbeTotal([](const char* thread, ProbeId probe, const ProbeTotals& totals) {
+            double calls = static_cast<double>(totals.calls);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::Text("%s", thread);
+            ImGui::TableNextColumn(); ImGui::Text("%s", probeName(probe));
+            ImGui::TableNextColumn(); ImGui::Text("%llu", totals.calls);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", totals.wallNs / calls / 1000.0);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", totals.maxNs / 1000.0);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", totals.syscalls / calls);
+            ImGui::TableNextColumn(); ImGui::Text("%s", formatNetworkBytes(totals.bytesRead / calls).c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", totals.allocations / calls);
+        });
+        ImGui::EndTable();
+    }
+}
+
+// Every collector's cadence, editable, with what it costs. Periods are rounded
+// to the schedule's steps, and to multiples of the collector they depend on.
+static void samplingTab(const SystemSnapshot& snap) {
+    if (!ImGui::BeginTable("Sampling", 5, ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg,
+                           ImVec2(0, ImGui::GetContentRegionAvail().y)))
+        return;
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Collector");
+    ImGui::TableSetupColumn("Every", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Runs every");
+    ImGui::TableSetupColumn("Cost (ms)");
+    ImGui::TableSetupColumn("Last run");
+    ImGui::TableHeadersRow();
+    for (int c = 0; c < COLLECTORS; ++c) {
+        const Collector collector = static_cast<Collector>(c);
+        const CollectorStatus& status = snap.collectors[c];
+        ImGui::PushID(c);
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(collectorName(collector));
+        if (CollectorSchedule::base(collector) != collector && ImGui::IsItemHovered())
+            ImGui::SetTooltip("runs together with %s", collectorName(CollectorSchedule::base(collector)));
+        ImGui::TableNextColumn();
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        cadenceSlider("##every", collector, snap);
+        ImGui::TableNextColumn(); ImGui::Text("%.2f s", status.effective);
+        ImGui::TableNextColumn(); ImGui::Text("%.3f", status.costMs);
+        ImGui::TableNextColumn();
+        if (status.lastRun >= 0) ImGui::Text("%.1f s ago", snap.time - status.lastRun);
+        else ImGui::TextUnformatted("-");
+        ImGui::PopID();
+    }
+    ImGui::EndTable();
+}
+
+static ImVec4 alertColor(AlertLevel level) {
+    switch (level) {
+        case ALERT_INFO: return ImVec4(1.0f, 1.0f, 0.0f, 1.0f);
+        case ALERT_WARNING: return ImVec4(1.0f, 0.5f, 0.0f, 1.0f);
+        case ALERT_CRITICAL: return ImVec4(1.0f, 0.0f, 0.0f, 1.0f);
+    }
+    return ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+// Alerts firing now, then the most recent transitions, newest first.
+static void alertsTab(const SystemSnapshot& snap) {
+    if (!snap.alertRules) return;
+    const vector<AlertRule>& rules = *snap.alertRules;
+    ImGui::Text("%zu rules, %zu firing", rules.size(), snap.alerts.size());
+    float half = ImGui::GetContentRegionAvail().y / 2;
+    if (ImGui::BeginTable("Firing", 4, ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg,
+                          ImVec2(0, half))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Level");
+        ImGui::TableSetupColumn("Rule", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Value");
+        ImGui::TableSetupColumn("Firing for");
+        ImGui::TableHeadersRow();
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(snap.alerts.size()));
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                const ActiveAlert& alert = snap.alerts[i];
+                const AlertRule& rule = rules[alert.rule];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextColored(alertColor(rule.level), "%s", alertLevelName(rule.level));
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(rule.name.c_str());
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s", rule.expression.c_str());
+                ImGui::TableNextColumn(); ImGui::Text("%.6g", alert.value);
+                ImGui::TableNextColumn(); ImGui::Text("%.1f s", snap.time - alert.since);
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    if (ImGui::BeginTable("AlertEvents", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+                          ImVec2(0, ImGui::GetContentRegionAvail().y))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Time");
+        ImGui::TableSetupColumn("Rule", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("State");
+        ImGui::TableSetupColumn("Value");
+        ImGui::TableHeadersRow();
+        for (auto event = snap.alertEvents.rbegin(); event != snap.alertEvents.rend(); ++event) {
+            const AlertRule& rule = rules[event->rule];
+            time_t seconds = static_cast<time_t>(event->wallTime);
+            tm local;
+            localtime_r(&seconds, &local);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%02d:%02d:%02d (%.1f s ago)", local.tm_hour, local.tm_min, local.tm_sec, snap.time - event->time);
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(rule.name.c_str());
+            ImGui::TableNextColumn();
+            if (event->firing) ImGui::TextColored(alertColor(rule.level), "fired");
+            else ImGui::TextUnformatted("cleared");
+            ImGui::TableNextColumn(); ImGui::Text("%.6g", event->value);
+        }
+        ImGui::EndTable();
+    }
+}
+
+// Every named metric: the built-in sections, then one per loaded plugin.
+static void metricsTab(const SystemSnapshot& snap) {
+    if (!snap.metrics) return;
+    const MetricSchema& schema = *snap.metrics;
+    ImGui::Text("Plugins from \"%s\": %zu sections, %zu metrics", pluginDirectory().c_str(), schema.sections.size(),
+                schema.size());
+    if (!ImGui::BeginTable("Metrics", 4, ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg,
+                           ImVec2(0, ImGui::GetContentRegionAvail().y)))
+        return;
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Metric", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Value");
+    ImGui::TableSetupColumn("Unit");
+    ImGui::TableSetupColumn("Updated");
+    ImGui::TableHeadersRow();
+    for (size_t s = 0; s < schema.sections.size(); ++s) {
+        const MetricSection& section = schema.sections[s];
+        float updated = s < snap.sectionUpdated.size() ? snap.sectionUpdated[s] : -1.0f;
+        for (size_t i = section.first; i < section.first + section.count; ++i) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(schema.names[i].c_str());
+            ImGui::TableNextColumn();
+            double value = i < snap.metricValues.size() ? snap.metricValues[i] : NAN;
+            if (std::isnan(value)) ImGui::TextUnformatted("-");
+            else ImGui::Text("%.6g", value);
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(schema.units[i].c_str());
+            ImGui::TableNextColumn();
+            if (updated >= 0) ImGui::Text("%.1f s ago", snap.time - updated);
+            else ImGui::TextUnformatted("-");
+        }
+    }
+    ImGui::EndTable();
+}
+
+// system monitoring UI function with tabs for CPU, Fan, and Thermal info, plus system metadata.
+// id is unique identifier for the window, size refers to the window size in pixels, while position
+// refers to window position on the screen.
+// snap is the latest sample taken by the background sampler.
+void systemWindow(const char* id, ImVec2 size, ImVec2 position, const SystemSnapshot& snap) {
+    MONITOR_PROBE(PROBE_SYSTEM_WINDOW);
+    ImGui::Begin(id);
+    ImGui::SetWindowSize(size);
+    ImGui::SetWindowPos(position);
+
+    ImGui::BeginChild("SystemInfo", ImVec2(0, 150), true); // create a child window(scrollable sub-section)
+    ImGui::Text("Operating System: %s", getOsName());
+    ImGui::Text("Username: %s", snap.username.c_str());
+    ImGui::Text("Hostname: %s", snap.hostname.c_str());
+    ImGui::Text("Total Processes: %d", snap.totalProcesses);
+    ImGui::Text("CPU Type: %s", snap.cpuModel.c_str());
+
+    // count of processes per state (e.g Running, Sleeping etc), refreshed by the sampler
+    const map<char, int>& cachedStates = snap.processStates;
+
+    ImGui::Text("Process States:");
+    // Define known states with their labels
+    static const pair<char, const char*> stateLabels[] = {
+        {'R', "Running"},
+        {'S', "Sleeping"},
+        {'D', "Uninterruptible Sleep"},
+        {'Z', "Zombie"},
+        {'T', "Stopped"},
+        {'I', "Idle"}
+    };
+    
+    int totalProcesses = 0;
+    for (const auto& [state, count] : cachedStates) {
+        totalProcesses += count;
+    }
+    ImGui::Text("  Total Processes: %d", totalProcesses);
+
+    // Display known states first
+    for (const auto& [code, label] : stateLabels) {
+        if (cachedStates.count(code)) {
+            ImGui::Text("  %s: %d", label, cachedStates.at(code));
+        }
+    }
+    
+    // Display any unknown states
+    for (const auto& [state, count] : cachedStates) {
+        bool isKnown = any_of(begin(stateLabels), end(stateLabels),
+                            [state](const auto& pair) { return pair.first == state; });
+        if (!isKnown) {
+            ImGui::Text("  Unknown State (%c): %d", state, count);
+        }
+    }
+    ImGui::EndChild();
+
+    recordDiskHistory(snap);
+    recordPressureHistory(snap);
+
+    // start tab for CPU, Fan, and Thermal
+    if (ImGui::BeginTabBar("SystemPerformanceTabs")) {
+       // display CPU data 
+       if (ImGui::BeginTabItem("CPU")) {
+        static bool pauseGraph = false;
+        static float graphYScale = 100.0f;
+        float smoothedCPUUsage = snap.cpuUsage; // averaged over the last few samples by the sampler
+
+        if (!pauseGraph && snap.collectors[COLLECTOR_CPU].lastRun != cpuGraphTime) {
+            cpuGraphTime = snap.collectors[COLLECTOR_CPU].lastRun;
+            cpuUsageHistory.erase(cpuUsageHistory.begin());
+            cpuUsageHistory.push_back(smoothedCPUUsage);  // Use smoothed value
+        }
+
+        ImGui::Checkbox("Pause Graph", &pauseGraph);
+        cadenceSlider("Sample every", COLLECTOR_CPU, snap);
+        ImGui::SliderFloat("Y-Scale", &graphYScale, 10.0f, 200.0f);
+
+        ImGui::PlotLines("CPU Usage", cpuUsageHistory.data(), cpuUsageHistory.size(),
+                        0, TextF("CPU: %.1f%%", smoothedCPUUsage).c_str(),  // Use smoothed value
+                        0.0f, graphYScale, ImVec2(0, 80));
+        ImGui::EndTabItem();
+    }
+
+    // display fan data
+    if (ImGui::BeginTabItem("Fan")) {
+            static bool pauseGraph = false;
+            static float graphYScale = 5000.0f;
+            static vector<float> fanSpeedHistory(100, 0.0f);
+            float fanSpeed = snap.fanSpeed;
+            bool fanAvailable = fanSpeed > 0;
+
+            if (!pauseGraph && snap.collectors[COLLECTOR_SENSORS].lastRun != fanGraphTime) {
+                fanGraphTime = snap.collectors[COLLECTOR_SENSORS].lastRun;
+                fanSpeedHistory.erase(fanSpeedHistory.begin());
+                fanSpeedHistory.push_back(fanSpeed);
+            }
+
+            ImGui::Checkbox("Pause Graph", &pauseGraph);
+            cadenceSlider("Sample every", COLLECTOR_SENSORS, snap);
+            ImGui::SliderFloat("Y-Scale", &graphYScale, 1000.0f, 10000.0f);
+
+            if (fanAvailable) {
+                ImGui::Text("Fan Status: Active");
+                ImGui::Text("Fan Speed: %.0f RPM", fanSpeed);
+                ImGui::Text("Fan Level: %s",
+                            fanSpeed < 1000 ? "Low" : fanSpeed < 3000 ? "Medium" : "High");
+
+                ImGui::PlotLines("Fan Speed", fanSpeedHistory.data(), fanSpeedHistory.size(),
+                                0, TextF("%.0f RPM", fanSpeed).c_str(),
+                                0.0f, graphYScale, ImVec2(0, 80));
+            } else {
+                ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Fan information not available on this system");
+                ImGui::Text("Fan monitoring is supported on some ThinkPad models and");
+                ImGui::Text("other systems with accessible fan sensors.");
+            }
+            ImGui::EndTabItem();
+        }
+
+        // display thermal data
+        if (ImGui::BeginTabItem("Thermal")) {
+            static bool pauseGraph = false;
+            static float graphYScale = 100.0f;
+            float temperature = snap.temperature;
+            bool tempAvailable = temperature > 0.1f; // Small threshold to detect valid readings
+
+            if (!pauseGraph && snap.collectors[COLLECTOR_SENSORS].lastRun != thermalGraphTime) {
+                thermalGraphTime = snap.collectors[COLLECTOR_SENSORS].lastRun;
+                temperatureHistory.erase(temperatureHistory.begin());
+                temperatureHistory.push_back(temperature);
+            }
+
+            ImGui::Checkbox("Pause Graph", &pauseGraph);
+            cadenceSlider("Sample every", COLLECTOR_SENSORS, snap);
+            ImGui::SliderFloat("Y-Scale", &graphYScale, 10.0f, 200.0f);
+
+            if (tempAvailable) {
+                ImGui::Text("Current Temperature: %.1f°C", temperature);
+                ImGui::PlotLines("Temperature", temperatureHistory.data(), temperatureHistory.size(),
+                                0, TextF("Temp: %.1f°C", temperature).c_str(),
+                                0.0f, graphYScale, ImVec2(0, 80));
+
+                // the most severe alert firing on the temperature; the default
+                // rules are Warm, Hot and Critical at 50, 70 and 85 °C
+                const AlertRule* status = nullptr;
+                for (const ActiveAlert& alert : snap.alerts) {
+                    const AlertRule& rule = (*snap.alertRules)[alert.rule];
+                    if (rule.source == ALERT_METRIC && rule.target == "sensors.temperature" &&
+                        (!status || rule.level > status->level))
+                        status = &rule;
+                }
+                if (!status) {
+                    ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Temperature Status: Normal");
+                } else {
+                    ImGui::TextColored(alertColor(status->level), "Temperature Status: %s", status->name.c_str());
+                }
+            } else {
+                ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Temperature information not available");
+                ImGui::Text("The system is using a hardware-agnostic approach to find");
+                ImGui::Text("temperature sensors. No compatible sensors were found.");
+            }
+            ImGui::EndTabItem();
+        }
+
+        // block device throughput, latency and utilization
+        if (ImGui::BeginTabItem("Disk I/O")) {
+            diskIOTab(snap);
+            ImGui::EndTabItem();
+        }
+
+        // pressure stall information and trigger events
+        if (ImGui::BeginTabItem("Pressure")) {
+            pressureTab(snap);
+            ImGui::EndTabItem();
+        }
+
+        // alert rules firing and their recent transitions
+        if (ImGui::BeginTabItem(TextF("Alerts (%zu)###Alerts", snap.alerts.size()).c_str())) {
+            alertsTab(snap);
+            ImGui::EndTabItem();
+        }
+
+        // built-in and plugin metrics by name
+        if (ImGui::BeginTabItem("Metrics")) {
+            metricsTab(snap);
+            ImGui::EndTabItem();
+        }
+
+        // display what the monitor itself costs
+        if (ImGui::BeginTabItem("Sampling")) {
+            samplingTab(snap);
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Monitor Overhead")) {
+            monitorOverheadTab();
+            ImGui::EndTabItem();
+        }
+        ImGui::EndTabBar();
+    }
+    ImGui::End();
+}
+
+
+// Stacked history of memoryComposition(), one column per reading.
+static constexpr int MEMORY_HISTORY = 100;
+static float memoryHistory[MEMORY_HISTORY][MEMORY_LAYER_COUNT]; // kB, oldest first
+static int memoryHistoryCount = 0;
+static float memoryHistoryTime = -1.0f;
+
+static const ImU32 memoryLayerColors[MEMORY_LAYER_COUNT] = {
+    IM_COL32(230, 110, 80, 255),  // anonymous
+    IM_COL32(200, 90, 200, 255),  // shmem
+    IM_COL32(90, 160, 230, 255),  // page cache
+    IM_COL32(110, 200, 220, 255), // buffers
+    IM_COL32(230, 200, 80, 255),  // slab
+    IM_COL32(150, 150, 150, 255), // kernel
+    IM_COL32(60, 70, 80, 255),    // free
+};
+
+static void memoryCompositionGraph(const SystemSnapshot& snap) {
+    const MemoryInfo& mem = snap.memory;
+    if (mem.mem_total_kb == 0) return;
+    if (snap.collectors[COLLECTOR_MEMORY].lastRun != memoryHistoryTime) {
+        memoryHistoryTime = snap.collectors[COLLECTOR_MEMORY].lastRun;
+        if (memoryHistoryCount == MEMORY_HISTORY)
+            memmove(memoryHistory[0], memoryHistory[1], sizeof(memoryHistory[0]) * (MEMORY_HISTORY - 1));
+        else
+            memoryHistoryCount++;
+        memoryComposition(mem, memoryHistory[memoryHistoryCount - 1]);
+    }
+
+    // newest sample at the right edge, scrolling left like the other graphs
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImVec2 size(ImGui::GetContentRegionAvail().x, 90.0f);
+    ImGui::InvisibleButton("##MemoryComposition", size);
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    draw->AddRectFilled(origin, ImVec2(origin.x + size.x, origin.y + size.y), ImGui::GetColorU32(ImGuiCol_FrameBg));
+    float step = size.x / (MEMORY_HISTORY - 1);
+    float bottom = origin.y + size.y;
+    for (int i = 1; i < memoryHistoryCount; ++i) {
+        const float* before = memoryHistory[i - 1];
+        const float* after = memoryHistory[i];
+        float x1 = origin.x + size.x - (memoryHistoryCount - 1 - i) * step;
+        float x0 = x1 - step;
+        float totalBefore = 0, totalAfter = 0;
+        for (int layer = 0; layer < MEMORY_LAYER_COUNT; ++layer) {
+            totalBefore += before[layer];
+            totalAfter += after[layer];
+        }
+        if (totalBefore <= 0 || totalAfter <= 0) continue;
+        float y0 = bottom, y1 = bottom;
+        for (int layer = 0; layer < MEMORY_LAYER_COUNT; ++layer) {
+            float top0 = y0 - before[layer] / totalBefore * size.y;
+            float top1 = y1 - after[layer] / totalAfter * size.y;
+            draw->AddQuadFilled(ImVec2(x0, top0), ImVec2(x1, top1), ImVec2(x1, y1), ImVec2(x0, y0),
+                                memoryLayerColors[layer]);
+            y0 = top0;
+            y1 = top1;
+        }
+    }
+
+    // hovering a column shows the numbers behind it
+    if (ImGui::IsItemHovered() && memoryHistoryCount > 0) {
+        float fromRight = (origin.x + size.x - ImGui::GetIO().MousePos.x) / step;
+        int sample = memoryHistoryCount - 1 - static_cast<int>(fromRight + 0.5f);
+        if (sample >= 0) {
+            ImGui::BeginTooltip();
+            for (int layer = MEMORY_LAYER_COUNT - 1; layer >= 0; --layer)
+                ImGui::Text("%-10s %6.2f GB", memoryLayerName(static_cast<MemoryLayer>(layer)),
+                            memoryHistory[sample][layer] / (1024.0f * 1024.0f));
+            ImGui::EndTooltip();
+        }
+    }
+
+    float latest[MEMORY_LAYER_COUNT];
+    memoryComposition(mem, latest);
+    for (int layer = 0; layer < MEMORY_LAYER_COUNT; ++layer) {
+        if (layer > 0) ImGui::SameLine();
+        const char* name = memoryLayerName(static_cast<MemoryLayer>(layer));
+        ImGui::ColorButton(name, ImColor(memoryLayerColors[layer]),
+                           ImGuiColorEditFlags_NoTooltip | ImGuiColorEditFlags_NoPicker, ImVec2(10, 10));
+        ImGui::SameLine(0, 4);
+        ImGui::Text("%s %.1f GB", name, latest[layer] / (1024.0f * 1024.0f));
+    }
+    ImGui::Text("Dirty: %.0f MB   Writeback: %.0f MB   Mapped: %.1f GB   Committed: %.1f / %.1f GB",
+                mem.dirty_kb / 1024.0f, mem.writeback_kb / 1024.0f, mem.mapped_kb / (1024.0f * 1024.0f),
+                mem.committed_as_kb / (1024.0f * 1024.0f), mem.commit_limit_kb / (1024.0f * 1024.0f));
+    if (mem.hugepages_total > 0) {
+        ImGui::Text("Huge pages: %lu / %lu free (%lu reserved, %lu surplus, %lu kB each)",
+                    mem.hugepages_free, mem.hugepages_total, mem.hugepages_reserved,
+                    mem.hugepages_surplus, mem.hugepage_size_kb);
+    }
+}
+
+// Usage of every mounted filesystem. Values of a hung or stale mount are the last
+// ones its statvfs() returned, shown with their age.
+static void filesystemsTable(const vector<MountUsage>& mounts) {
+    if (!ImGui::BeginTable("Filesystems", 7, ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+                           ImVec2(0, 120)))
+        return;
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Mount");
+    ImGui::TableSetupColumn("Type");
+    ImGui::TableSetupColumn("Source");
+    ImGui::TableSetupColumn("Size");
+    ImGui::TableSetupColumn("Used");
+    ImGui::TableSetupColumn("Inodes");
+    ImGui::TableSetupColumn("State");
+    ImGui::TableHeadersRow();
+    for (const MountUsage& mount : mounts) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn(); ImGui::TextUnformatted(mount.mountPoint.c_str());
+        ImGui::TableNextColumn(); ImGui::TextUnformatted(mount.fsType.c_str());
+        ImGui::TableNextColumn(); ImGui::TextUnformatted(mount.source.c_str());
+        ImGui::TableNextColumn();
+        if (mount.totalBytes > 0) ImGui::Text("%.1f GB", mount.totalBytes / (1024.0 * 1024.0 * 1024.0));
+        ImGui::TableNextColumn();
+        if (mount.totalBytes > 0) {
+            float used = static_cast<float>(mount.usedBytes) / mount.totalBytes;
+            ImGui::ProgressBar(used, ImVec2(-1, 0), TextF("%.1f%%", used * 100.0f).c_str());
+        }
+        ImGui::TableNextColumn();
+        if (mount.totalInodes > 0) ImGui::Text("%.1f%%", 100.0 * mount.usedInodes / mount.totalInodes);
+        ImGui::TableNextColumn();
+        if (mount.state == MOUNT_OK || mount.state == MOUNT_PENDING) {
+            ImGui::TextUnformatted(mountStateName(mount.state));
+        } else {
+            ImVec4 color = mount.state == MOUNT_HUNG ? ImVec4(1.0f, 0.3f, 0.3f, 1.0f) : ImVec4(1.0f, 0.8f, 0.2f, 1.0f);
+            if (mount.state == MOUNT_ERROR)
+                ImGui::TextColored(color, "%s (%s)", mountStateName(mount.state), strerror(mount.error));
+            else if (mount.totalBytes == 0) // never answered
+                ImGui::TextColored(color, "%s", mountStateName(mount.state));
+            else
+                ImGui::TextColored(color, "%s, %.0fs old", mountStateName(mount.state), mount.age);
+        }
+    }
+    ImGui::EndTable();
+}
+
+// The cgroup hierarchy as a tree; collapsed subtrees are skipped without being
+// drawn. CPU% and memory include everything below a cgroup.
+static void cgroupTree(const vector<CgroupUsage>& cgroups) {
+    if (cgroups.empty()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "No cgroup v2 hierarchy mounted");
+        return;
+    }
+    if (!ImGui::BeginTable("Cgroups", 7, ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+                           ImVec2(0, 160)))
+        return;
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Control group");
+    ImGui::TableSetupColumn("CPU");
+    ImGui::TableSetupColumn("Memory");
+    ImGui::TableSetupColumn("Read/s");
+    ImGui::TableSetupColumn("Write/s");
+    ImGui::TableSetupColumn("CPU pressure");
+    ImGui::TableSetupColumn("OOM kills");
+    ImGui::TableHeadersRow();
+    int openDepth = 0; // tree levels pushed by open nodes
+    for (size_t i = 0; i < cgroups.size(); ++i) {
+        const CgroupUsage& cgroup = cgroups[i];
+        for (; openDepth > cgroup.depth; --openDepth) ImGui::TreePop();
+        bool hasChildren = i + 1 < cgroups.size() && cgroups[i + 1].depth > cgroup.depth;
+        const char* slash = strrchr(cgroup.path.c_str(), '/');
+        const char* name = cgroup.path.empty() ? "/" : slash ? slash + 1 : cgroup.path.c_str();
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanFullWidth;
+        if (!hasChildren) flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+        if (cgroup.depth == 0) flags |= ImGuiTreeNodeFlags_DefaultOpen;
+        bool open = ImGui::TreeNodeEx(name, flags);
+        ImGui::TableNextColumn();
+        if (cgroup.throttledPercent > 0.0f)
+            ImGui::Text("%.1f%% (%.1f%% throttled)", cgroup.cpuPercent, cgroup.throttledPercent);
+        else
+            ImGui::Text("%.1f%%", cgroup.cpuPercent);
+        ImGui::TableNextColumn();
+        if (cgroup.memoryBytes > 0) ImGui::TextUnformatted(formatNetworkBytes(cgroup.memoryBytes).c_str());
+        ImGui::TableNextColumn(); ImGui::TextUnformatted(formatNetworkBytes(cgroup.readBytesPerSec).c_str());
+        ImGui::TableNextColumn(); ImGui::TextUnformatted(formatNetworkBytes(cgroup.writeBytesPerSec).c_str());
+        ImGui::TableNextColumn(); ImGui::Text("%.2f%%", cgroup.cpuSomePressure);
+        ImGui::TableNextColumn();
+        if (cgroup.oomKills > 0) ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%llu", cgroup.oomKills);
+
+        if (open && hasChildren) {
+            openDepth = cgroup.depth + 1;
+        } else if (hasChildren) {
+            while (i + 1 < cgroups.size() && cgroups[i + 1].depth > cgroup.depth) i++;
+        }
+    }
+    for (; openDepth > 0; --openDepth) ImGui::TreePop();
+    ImGui::EndTable();
+}
+
+static set<int> selectedPids; // the sampler lists the threads of these
+static vector<int> visiblePids; // and reads smaps_rollup of these first
+
+const set<int>& selectedProcesses() { return selectedPids; }
+
+const vector<int>& visibleProcesses() { return visiblePids; }
+
+// Threads of the selected processes, busiest first within each. The snapshot
+// can still be from before the selection changed, so its list is filtered again.
+static void threadTable(const vector<ThreadUsage>& threads) {
+    if (!ImGui::BeginTable("Threads", 6, ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY,
+                           ImVec2(0, 140)))
+        return;
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("PID");
+    ImGui::TableSetupColumn("TID");
+    ImGui::TableSetupColumn("Name");
+    ImGui::TableSetupColumn("State");
+    ImGui::TableSetupColumn("CPU Usage");
+    ImGui::TableSetupColumn("Last CPU");
+    ImGui::TableHeadersRow();
+    for (const ThreadUsage& thread : threads) {
+        if (selectedPids.count(thread.pid) == 0) continue;
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn(); ImGui::Text("%d", thread.pid);
+        ImGui::TableNextColumn(); ImGui::Text("%d", thread.tid);
+        ImGui::TableNextColumn(); ImGui::TextUnformatted(thread.name);
+        ImGui::TableNextColumn(); ImGui::Text("%c", thread.state);
+        ImGui::TableNextColumn(); ImGui::Text("%.1f%%", thread.cpuPercent);
+        ImGui::TableNextColumn();
+        if (thread.processor >= 0) ImGui::Text("%d", thread.processor);
+    }
+    ImGui::EndTable();
+}
+
+// if Ctrl is held, toggle selection of this PID else select only this PID
+static void selectProcess(set<int>& selectedPids, int pid, bool isSelected) {
+    if (ImGui::GetIO().KeyCtrl) {
+        if (isSelected) selectedPids.erase(pid);
+        else selectedPids.insert(pid);
+    } else {
+        selectedPids.clear();
+        selectedPids.insert(pid);
+    }
+}
+
+// The RSS, PSS and swap cells of a process row. RSS is shown as a share of
+// MemTotal; with `subtree` it is the total of the process and its descendants.
+// PSS and swap are blank until the sampler has got round to reading them.
+static void memoryCells(const Proc& proc, const MemoryInfo& memory, bool subtree) {
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    long long rssBytes = (subtree ? proc.treeRss : proc.rss) * pageSize;
+    double percent = memory.mem_total_kb > 0 ? 100.0 * rssBytes / (memory.mem_total_kb * 1024.0) : 0.0;
+    ImGui::TableNextColumn();
+    if (subtree) ImGui::Text("%.1f%% (%s in %d)", percent, formatNetworkBytes(rssBytes).c_str(), proc.treeCount);
+    else ImGui::Text("%.1f%% (%s)", percent, formatNetworkBytes(rssBytes).c_str());
+    ImGui::TableNextColumn();
+    if (proc.pss >= 0) ImGui::TextUnformatted(formatNetworkBytes(proc.pss * 1024).c_str());
+    ImGui::TableNextColumn();
+    if (proc.swap > 0) ImGui::TextUnformatted(formatNetworkBytes(proc.swap * 1024).c_str());
+}
+
+// The disk read and write rates of a process row, blank until /proc/<pid>/io has
+// been read twice or when it can't be read at all
+static void ioCells(const Proc& proc) {
+    ImGui::TableNextColumn();
+    if (proc.io.available) ImGui::Text("%s/s", formatNetworkBytes(proc.io.readBytesPerSec).c_str());
+    ImGui::TableNextColumn();
+    if (proc.io.available) ImGui::Text("%s/s", formatNetworkBytes(proc.io.writeBytesPerSec).c_str());
+}
+
+// The open fd count of a process row, broken down by kind on hover, and how fast
+// it has grown between the last two complete listings; blank until listed once
+static void fdCells(const Proc& proc) {
+    ImGui::TableNextColumn();
+    if (proc.fds.total >= 0) {
+        ImGui::Text("%d", proc.fds.total);
+        if (ImGui::IsItemHovered())
+            ImGui::SetTooltip("sockets %d, pipes %d, files %d, anon inodes %d, other %d", proc.fds.sockets,
+                              proc.fds.pipes, proc.fds.files, proc.fds.anonInodes, proc.fds.other);
+    }
+    ImGui::TableNextColumn();
+    if (proc.fds.total >= 0 && proc.fds.growthPerSec != 0.0f) ImGui::Text("%+.1f", proc.fds.growthPerSec);
+}
+
+// The TCP receive and send rates of a process row, summed over the sockets it
+// owns; blank while it moves nothing
+static void netCells(const Proc& proc) {
+    ImGui::TableNextColumn();
+    if (proc.netReceiveRate > 0) ImGui::Text("%s/s", formatNetworkBytes(proc.netReceiveRate).c_str());
+    ImGui::TableNextColumn();
+    if (proc.netSendRate > 0) ImGui::Text("%s/s", formatNetworkBytes(proc.netSendRate).c_str());
+}
+
+enum ProcessColumn {
+    COLUMN_PID, COLUMN_NAME, COLUMN_STATE, COLUMN_CPU, COLUMN_MEMORY, COLUMN_PSS, COLUMN_SWAP,
+    COLUMN_READ, COLUMN_WRITE, COLUMN_FDS, COLUMN_FD_GROWTH, COLUMN_NET_RECEIVE, COLUMN_NET_SEND, PROCESS_COLUMNS
+};
+
+// <0, 0 or >0 as `a` comes before, with or after `b` in ascending order of `column`
+static int compareProcesses(const Proc& a, const Proc& b, ImGuiID column) {
+    auto order = [](auto x, auto y) { return x < y ? -1 : y < x ? 1 : 0; };
+    switch (column) {
+        case COLUMN_NAME: return a.name.compare(b.name);
+        case COLUMN_STATE: return order(a.state, b.state);
+        case COLUMN_CPU: return order(a.cpuPercent, b.cpuPercent);
+        case COLUMN_MEMORY: return order(a.rss, b.rss);
+        case COLUMN_PSS: return order(a.pss, b.pss);
+        case COLUMN_SWAP: return order(a.swap, b.swap);
+        case COLUMN_READ: return order(a.io.readBytesPerSec, b.io.readBytesPerSec);
+        case COLUMN_WRITE: return order(a.io.writeBytesPerSec, b.io.writeBytesPerSec);
+        case COLUMN_FDS: return order(a.fds.total, b.fds.total);
+        case COLUMN_FD_GROWTH: return order(a.fds.growthPerSec, b.fds.growthPerSec);
+        case COLUMN_NET_RECEIVE: return order(a.netReceiveRate, b.netReceiveRate);
+        case COLUMN_NET_SEND: return order(a.netSendRate, b.netSendRate);
+        default: return order(a.pid, b.pid);
+    }
+}
+
+// One row of the process tree and, if it is expanded, its children. A process
+// with children shows its own CPU% followed by its subtree's, and the subtree's
+// resident memory and size.
+static void processTreeRow(const vector<Proc>& processes, int index, set<int>& selectedPids,
+                           const MemoryInfo& memory) {
+    const Proc& proc = processes[index];
+    bool isSelected = selectedPids.count(proc.pid) > 0;
+    ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanFullWidth | ImGuiTreeNodeFlags_OpenOnArrow;
+    if (proc.firstChild < 0) flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+    if (proc.parent < 0) flags |= ImGuiTreeNodeFlags_DefaultOpen;
+    if (isSelected) flags |= ImGuiTreeNodeFlags_Selected;
+
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    bool open = ImGui::TreeNodeEx(reinterpret_cast<void*>(static_cast<intptr_t>(proc.pid)), flags, "%d", proc.pid);
+    if (ImGui::IsItemVisible()) visiblePids.push_back(proc.pid);
+    if (ImGui::IsItemClicked() && !ImGui::IsItemToggledOpen()) selectProcess(selectedPids, proc.pid, isSelected);
+    ImGui::TableNextColumn(); ImGui::TextUnformatted(proc.name.c_str());
+    ImGui::TableNextColumn(); ImGui::Text("%c", proc.state);
+    ImGui::TableNextColumn();
+    if (proc.firstChild >= 0) ImGui::Text("%.1f%% (%.1f%%)", proc.cpuPercent, proc.treeCPU);
+    else ImGui::Text("%.1f%%", proc.cpuPercent);
+    memoryCells(proc, memory, proc.firstChild >= 0);
+    ioCells(proc);
+    fdCells(proc);
+    netCells(proc);
+
+    if (open && proc.firstChild >= 0) {
+        for (int child = proc.firstChild; child >= 0; child = processes[child].nextSibling)
+            processTreeRow(processes, child, selectedPids, memory);
+        ImGui::TreePop();
+    }
+}
+
+// display memory, disk, and process usage.
+// id is a unique identifier for ImGui window, size gives the desired dimensions of the window,
+// position represents the desired position of the window on the screen.
+void memoryProcessesWindow(const char* id, ImVec2 size, ImVec2 position, const SystemSnapshot& snap) {
+    MONITOR_PROBE(PROBE_MEMORY_PROCESSES_WINDOW);
+    ImGui::Begin(id);
+    ImGui::SetWindowSize(size);
+    ImGui::SetWindowPos(position);
+
+    const MemoryInfo& memInfo = snap.memory;
+    const DiskInfo& diskInfo = snap.disk;
+
+    ImGui::BeginChild("Memory Info", ImVec2(0, 195), true);
+    // Display RAM in GB with one decimal place
+    ImGui::Text("RAM Usage: %.1f GB / %.1f GB (%.2f%%)",
+                memInfo.used_ram, memInfo.total_ram, memInfo.ram_percent);
+    ImGui::ProgressBar(memInfo.ram_percent / 100.0f, ImVec2(0, 0),
+                       TextF("%.2f%%", memInfo.ram_percent).c_str());
+
+    // Display Swap in GB with one decimal place
+    ImGui::Text("Swap Usage: %.1f GB / %.1f GB (%.2f%%)",
+                memInfo.used_swap, memInfo.total_swap, memInfo.swap_percent);
+    ImGui::ProgressBar(memInfo.swap_percent / 100.0f, ImVec2(0, 0),
+                       TextF("%.2f%%", memInfo.swap_percent).c_str());
+
+    // Format disk usage with rounding to match 'df -h'
+    ImGui::Text("Disk Usage: %.1f GB / %.1f GB (%.2f%%)",
+                diskInfo.used_space, diskInfo.total_space, diskInfo.usage_percent);
+
+    // Progress bar with percentage label
+    ImGui::ProgressBar(diskInfo.usage_percent / 100.0f, ImVec2(0, 0),
+                    TextF("%.1f%%", diskInfo.usage_percent).c_str());
+
+    // system-wide open files against fs.file-max, from /proc/sys/fs/file-nr
+    const FileHandles& handles = snap.fileHandles;
+    float handlesUsed = handles.maximum > 0 ? static_cast<float>(handles.allocated) / handles.maximum : 0.0f;
+    ImGui::Text("Open Files: %lld / %lld", handles.allocated, handles.maximum);
+    ImGui::ProgressBar(handlesUsed, ImVec2(0, 0), TextF("%.2f%%", handlesUsed * 100.0f).c_str());
+    ImGui::EndChild();
+
+    if (ImGui::CollapsingHeader("Memory Composition", ImGuiTreeNodeFlags_DefaultOpen))
+        memoryCompositionGraph(snap);
+    if (ImGui::CollapsingHeader("Filesystems", ImGuiTreeNodeFlags_DefaultOpen))
+        filesystemsTable(snap.mounts);
+    if (ImGui::CollapsingHeader("Control Groups", ImGuiTreeNodeFlags_DefaultOpen))
+        cgroupTree(snap.cgroups);
+
+    static char processFilter[256] = ""; // buffer for user-typed filter text
+    ImGui::InputText("Filter Processes", processFilter, sizeof(processFilter));
+    static bool treeMode = false;
+    ImGui::SameLine();
+    ImGui::Checkbox("Tree", &treeMode);
+
+    const vector<Proc>& processes = snap.processes;
+    visiblePids.clear();
+
+    if (ImGui::BeginTable("Processes", PROCESS_COLUMNS,
+                          ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable | ImGuiTableFlags_Sortable)) {
+        const ImGuiTableColumnFlags descending = ImGuiTableColumnFlags_PreferSortDescending;
+        ImGui::TableSetupColumn("PID", ImGuiTableColumnFlags_DefaultSort, -1.0f, COLUMN_PID);
+        ImGui::TableSetupColumn("Name", 0, -1.0f, COLUMN_NAME);
+        ImGui::TableSetupColumn("State", 0, -1.0f, COLUMN_STATE);
+        ImGui::TableSetupColumn("CPU Usage", descending, -1.0f, COLUMN_CPU);
+        ImGui::TableSetupColumn("Memory Usage", descending, -1.0f, COLUMN_MEMORY);
+        ImGui::TableSetupColumn("PSS", descending, -1.0f, COLUMN_PSS);
+        ImGui::TableSetupColumn("Swap", descending, -1.0f, COLUMN_SWAP);
+        ImGui::TableSetupColumn("Read/s", descending, -1.0f, COLUMN_READ);
+        ImGui::TableSetupColumn("Write/s", descending, -1.0f, COLUMN_WRITE);
+        ImGui::TableSetupColumn("FDs", descending, -1.0f, COLUMN_FDS);
+        ImGui::TableSetupColumn("FD growth/s", descending, -1.0f, COLUMN_FD_GROWTH);
+        ImGui::TableSetupColumn("Net RX/s", descending, -1.0f, COLUMN_NET_RECEIVE);
+        ImGui::TableSetupColumn("Net TX/s", descending, -1.0f, COLUMN_NET_SEND);
+        ImGui::TableHeadersRow();
+
+        if (treeMode) {
+            // the roots, or with a filter, every match none of whose ancestors match
+            auto matches = [&](int index) { return strstr(processes[index].name.c_str(), processFilter) != nullptr; };
+            for (int i = 0; i < static_cast<int>(processes.size()); ++i) {
+                bool shown = processFilter[0] == '\0' ? processes[i].parent < 0 : matches(i);
+                for (int ancestor = processes[i].parent; shown && processFilter[0] != '\0' && ancestor >= 0;
+                     ancestor = processes[ancestor].parent)
+                    shown = !matches(ancestor);
+                if (shown) processTreeRow(processes, i, selectedPids, snap.memory);
+            }
+        } else {
+            // sorted again when the order or the data changes; only the row
+            // indices move, the snapshot stays as it is
+            static vector<int> rowOrder;
+            static unsigned long long sortedGeneration = ~0ull;
+            ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs();
+            if (rowOrder.size() != processes.size() || sortedGeneration != snap.generation ||
+                (sortSpecs && sortSpecs->SpecsDirty)) {
+                rowOrder.resize(processes.size());
+                for (size_t i = 0; i < processes.size(); ++i) rowOrder[i] = i;
+                if (sortSpecs && sortSpecs->SpecsCount > 0) {
+                    const ImGuiTableColumnSortSpecs& spec = sortSpecs->Specs[0];
+                    sort(rowOrder.begin(), rowOrder.end(), [&](int a, int b) {
+                        int order = compareProcesses(processes[a], processes[b], spec.ColumnUserID);
+                        if (order == 0) order = processes[a].pid < processes[b].pid ? -1 : 1;
+                        return spec.SortDirection == ImGuiSortDirection_Descending ? order > 0 : order < 0;
+                    });
+                    sortSpecs->SpecsDirty = false;
+                }
+                sortedGeneration = snap.generation;
+            }
+            for (int row : rowOrder) {
+                const Proc& proc = processes[row];
+                if (processFilter[0] != '\0' && strstr(proc.name.c_str(), processFilter) == nullptr)
+                    continue; // if filter string is typed, skip processes whose name does not contain the filter
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                bool isSelected = selectedPids.count(proc.pid) > 0;
+                // create a selectable text element for the PID
+                if (ImGui::Selectable(TextF("%d", proc.pid).c_str(), isSelected, ImGuiSelectableFlags_SpanAllColumns))
+                    selectProcess(selectedPids, proc.pid, isSelected);
+                if (ImGui::IsItemVisible()) visiblePids.push_back(proc.pid);
+
+                ImGui::TableNextColumn(); ImGui::Text("%s", proc.name.c_str());
+                ImGui::TableNextColumn(); ImGui::Text("%c", proc.state);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f%%", proc.cpuPercent);
+                memoryCells(proc, memInfo, false);
+                ioCells(proc);
+                fdCells(proc);
+                netCells(proc);
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::Text("Selected processes: %zu", selectedPids.size());
+    if (!selectedPids.empty() && ImGui::CollapsingHeader("Threads", ImGuiTreeNodeFlags_DefaultOpen))
+        threadTable(snap.threads);
+    ImGui::End();
+}
+
+// "addr:port", "[v6addr]:port" or "*:*" for an unbound end; a Unix socket's
+// local end is its path and its remote end the peer's inode
+static void formatEndpoint(const SocketInfo& socket, bool local, const vector<char>& names, char* out, size_t size) {
+    if (socket.protocol == SOCKET_UNIX) {
+        if (local && socket.nameOffset >= 0) snprintf(out, size, "%s", names.data() + socket.nameOffset);
+        else if (!local && socket.peerInode) snprintf(out, size, "peer %u", socket.peerInode);
+        else snprintf(out, size, "*");
+        return;
+    }
+    const unsigned char* address = local ? socket.localAddress : socket.remoteAddress;
+    unsigned short port = local ? socket.localPort : socket.remotePort;
+    char text[INET6_ADDRSTRLEN];
+    size_t length = socket.family == AF_INET6 ? 16 : 4;
+    bool any = all_of(address, address + length, [](unsigned char byte) { return byte == 0; });
+    if (any) snprintf(text, sizeof(text), "*");
+    else inet_ntop(socket.family, address, text, sizeof(text));
+    if (socket.family == AF_INET6 && !any) snprintf(out, size, "[%s]:", text);
+    else snprintf(out, size, "%s:", text);
+    size_t used = strlen(out);
+    if (port) snprintf(out + used, size - used, "%u", port);
+    else snprintf(out + used, size - used, "*");
+}
+
+enum SocketColumn {
+    SOCKET_COLUMN_PROTOCOL, SOCKET_COLUMN_STATE, SOCKET_COLUMN_LOCAL, SOCKET_COLUMN_REMOTE,
+    SOCKET_COLUMN_RECEIVE_QUEUE, SOCKET_COLUMN_SEND_QUEUE, SOCKET_COLUMN_RTT, SOCKET_COLUMN_RETRANSMITS,
+    SOCKET_COLUMN_RECEIVE_RATE, SOCKET_COLUMN_SEND_RATE, SOCKET_COLUMN_PID, SOCKET_COLUMN_PROCESS, SOCKET_COLUMNS
+};
+
+// The first 8 bytes of a string as a number that sorts the same way
+static unsigned long long prefixKey(const char* text) {
+    unsigned long long key = 0;
+    for (int i = 0; i < 8; ++i) {
+        key = key << 8 | static_cast<unsigned char>(*text);
+        if (*text) text++;
+    }
+    return key;
+}
+
+// A number that orders sockets by `column`, exactly for the numeric columns and
+// by a prefix for the text ones, whose ties compareSockets() settles. Sorting
+// 200,000 rows on a key is several times faster than through the comparator.
+static unsigned long long socketSortKey(const SystemSnapshot& snap, const SocketInfo& socket, ImGuiID column) {
+    auto endpoint = [&](bool local) -> unsigned long long {
+        if (socket.protocol == SOCKET_UNIX) {
+            if (!local) return socket.peerInode;
+            return prefixKey(socket.nameOffset >= 0 ? snap.socketNames.data() + socket.nameOffset : "");
+        }
+        const unsigned char* address = local ? socket.localAddress : socket.remoteAddress;
+        unsigned long long key = socket.family;
+        for (int i = 0; i < 5; ++i) key = key << 8 | address[i];
+        return key << 16 | (local ? socket.localPort : socket.remotePort);
+    };
+    switch (column) {
+        case SOCKET_COLUMN_STATE: return socket.state;
+        case SOCKET_COLUMN_LOCAL: return endpoint(true);
+        case SOCKET_COLUMN_REMOTE: return endpoint(false);
+        case SOCKET_COLUMN_RECEIVE_QUEUE: return socket.receiveQueue;
+        case SOCKET_COLUMN_SEND_QUEUE: return socket.sendQueue;
+        case SOCKET_COLUMN_RTT: return socket.rttUs;
+        case SOCKET_COLUMN_RETRANSMITS: return socket.retransmits;
+        case SOCKET_COLUMN_RECEIVE_RATE: return static_cast<unsigned long long>(socket.receiveRate);
+        case SOCKET_COLUMN_SEND_RATE: return static_cast<unsigned long long>(socket.sendRate);
+        case SOCKET_COLUMN_PID: return static_cast<unsigned>(socket.pid + 1); // unowned (-1) first
+        case SOCKET_COLUMN_PROCESS:
+            return prefixKey(socket.process >= 0 ? snap.processes[socket.process].name.c_str() : "");
+        default: return socket.protocol << 8 | socket.family;
+    }
+}
+
+// <0, 0 or >0 as `a` comes before, with or after `b` on the text columns whose
+// sort keys are only prefixes; 0 for the rest
+static int compareSockets(const SystemSnapshot& snap, const SocketInfo& a, const SocketInfo& b, ImGuiID column) {
+    auto name = [&](const SocketInfo& socket) {
+        return socket.nameOffset >= 0 ? snap.socketNames.data() + socket.nameOffset : "";
+    };
+    auto processName = [&](const SocketInfo& socket) {
+        return socket.process >= 0 ? snap.processes[socket.process].name.c_str() : "";
+    };
+    switch (column) {
+        case SOCKET_COLUMN_LOCAL:
+        case SOCKET_COLUMN_REMOTE: {
+            bool local = column == SOCKET_COLUMN_LOCAL;
+            if (a.protocol == SOCKET_UNIX || b.protocol == SOCKET_UNIX)
+                return local && a.protocol == b.protocol ? strcmp(name(a), name(b)) : 0;
+            return memcmp(local ? a.localAddress : a.remoteAddress, local ? b.localAddress : b.remoteAddress, 16);
+        }
+        case SOCKET_COLUMN_PROCESS: return strcmp(processName(a), processName(b));
+        default: return 0;
+    }
+}
+
+// Every socket from the last process sample. With hundreds of thousands of them
+// only the rows on screen are formatted (the list is clipped); the row order is
+// rebuilt when the snapshot, the sort or the protocol filter changes.
+void connectionsTable(const SystemSnapshot& snap) {
+    if (!snap.socketsAvailable) {
+        ImGui::TextDisabled(hasMonitorRoot() ? "Sockets are only listed for the live system"
+                                             : "Socket diagnostics (NETLINK_SOCK_DIAG) are not available");
+        return;
+    }
+    const vector<SocketInfo>& sockets = snap.sockets;
+    static bool shown[SOCKET_PROTOCOLS] = {true, true, true};
+    bool filterChanged = false;
+    for (int protocol = 0; protocol < SOCKET_PROTOCOLS; ++protocol) {
+        if (protocol > 0) ImGui::SameLine();
+        filterChanged |= ImGui::Checkbox(socketProtocolName(static_cast<SocketProtocol>(protocol)), &shown[protocol]);
+    }
+
+    struct Row {
+        unsigned long long key;
+        int index;
+    };
+    static vector<Row> rowOrder;
+    static unsigned long long sortedGeneration = ~0ull;
+    static int counts[SOCKET_PROTOCOLS], established, listening;
+    ImGui::SameLine();
+    ImGui::Text("  tcp %d (%d established, %d listening), udp %d, unix %d", counts[SOCKET_TCP], established,
+                listening, counts[SOCKET_UDP], counts[SOCKET_UNIX]);
+
+    const ImGuiTableFlags flags = ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable | ImGuiTableFlags_Sortable |
+                                  ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg;
+    if (!ImGui::BeginTable("Connections", SOCKET_COLUMNS, flags)) return;
+    const ImGuiTableColumnFlags descending = ImGuiTableColumnFlags_PreferSortDescending;
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Proto", ImGuiTableColumnFlags_DefaultSort, -1.0f, SOCKET_COLUMN_PROTOCOL);
+    ImGui::TableSetupColumn("State", 0, -1.0f, SOCKET_COLUMN_STATE);
+    ImGui::TableSetupColumn("Local", 0, -1.0f, SOCKET_COLUMN_LOCAL);
+    ImGui::TableSetupColumn("Remote", 0, -1.0f, SOCKET_COLUMN_REMOTE);
+    ImGui::TableSetupColumn("Recv-Q", descending, -1.0f, SOCKET_COLUMN_RECEIVE_QUEUE);
+    ImGui::TableSetupColumn("Send-Q", descending, -1.0f, SOCKET_COLUMN_SEND_QUEUE);
+    ImGui::TableSetupColumn("RTT", descending, -1.0f, SOCKET_COLUMN_RTT);
+    ImGui::TableSetupColumn("Retrans", descending, -1.0f, SOCKET_COLUMN_RETRANSMITS);
+    ImGui::TableSetupColumn("RX/s", descending, -1.0f, SOCKET_COLUMN_RECEIVE_RATE);
+    ImGui::TableSetupColumn("TX/s", descending, -1.0f, SOCKET_COLUMN_SEND_RATE);
+    ImGui::TableSetupColumn("PID", 0, -1.0f, SOCKET_COLUMN_PID);
+    ImGui::TableSetupColumn("Process", 0, -1.0f, SOCKET_COLUMN_PROCESS);
+    ImGui::TableHeadersRow();
+
+    ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs();
+    if (sortedGeneration != snap.generation || filterChanged || (sortSpecs && sortSpecs->SpecsDirty)) {
+        bool sorted = sortSpecs && sortSpecs->SpecsCount > 0;
+        ImGuiID column = sorted ? sortSpecs->Specs[0].ColumnUserID : SOCKET_COLUMN_PROTOCOL;
+        bool descending = sorted && sortSpecs->Specs[0].SortDirection == ImGuiSortDirection_Descending;
+        bool prefixOnly = column == SOCKET_COLUMN_LOCAL || column == SOCKET_COLUMN_REMOTE || column == SOCKET_COLUMN_PROCESS;
+        rowOrder.clear();
+        fill(begin(counts), end(counts), 0);
+        established = listening = 0;
+        for (size_t i = 0; i < sockets.size(); ++i) {
+            const SocketInfo& socket = sockets[i];
+            counts[socket.protocol]++;
+            if (socket.protocol == SOCKET_TCP) {
+                established += socket.state == 1; // TCP_ESTABLISHED
+                listening += socket.state == 10;  // TCP_LISTEN
+            }
+            if (!shown[socket.protocol]) continue;
+            unsigned long long key = sorted ? socketSortKey(snap, socket, column) : 0;
+            rowOrder.push_back(Row{descending ? ~key : key, static_cast<int>(i)});
+        }
+        if (sorted) {
+            sort(rowOrder.begin(), rowOrder.end(), [&](const Row& a, const Row& b) {
+                if (a.key != b.key) return a.key < b.key;
+                int order = prefixOnly ? compareSockets(snap, sockets[a.index], sockets[b.index], column) : 0;
+                if (order != 0) return descending ? order > 0 : order < 0;
+                return a.index < b.index;
+            });
+            sortSpecs->SpecsDirty = false;
+        }
+        sortedGeneration = snap.generation;
+    }
+
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(rowOrder.size()));
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            const SocketInfo& socket = sockets[rowOrder[row].index];
+            char endpoint[128];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s%s", socketProtocolName(socket.protocol), socket.family == AF_INET6 ? "6" : "");
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(socketStateName(socket));
+            formatEndpoint(socket, true, snap.socketNames, endpoint, sizeof(endpoint));
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(endpoint);
+            formatEndpoint(socket, false, snap.socketNames, endpoint, sizeof(endpoint));
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(endpoint);
+            ImGui::TableNextColumn(); ImGui::Text("%u", socket.receiveQueue);
+            ImGui::TableNextColumn(); ImGui::Text("%u", socket.sendQueue);
+            ImGui::TableNextColumn();
+            if (socket.protocol == SOCKET_TCP && socket.rttUs) ImGui::Text("%.2f ms", socket.rttUs / 1000.0);
+            ImGui::TableNextColumn();
+            if (socket.protocol == SOCKET_TCP) ImGui::Text("%u", socket.retransmits);
+            ImGui::TableNextColumn();
+            if (socket.receiveRate > 0) ImGui::Text("%s/s", formatNetworkBytes(socket.receiveRate).c_str());
+            ImGui::TableNextColumn();
+            if (socket.sendRate > 0) ImGui::Text("%s/s", formatNetworkBytes(socket.sendRate).c_str());
+            ImGui::TableNextColumn();
+            if (socket.pid >= 0) ImGui::Text("%d", socket.pid);
+            ImGui::TableNextColumn();
+            if (socket.process >= 0) ImGui::TextUnformatted(snap.processes[socket.process].name.c_str());
+        }
+    }
+    ImGui::EndTable();
+}
+
+// The processes moving the most TCP traffic, from the per-socket byte counters,
+// and how much traffic has no known owner (sockets of processes not listed yet,
+// or of other users'). Picked again only when a new snapshot comes in.
+static void topTalkers(const SystemSnapshot& snap) {
+    static constexpr size_t TOP = 15;
+    static vector<int> top; // indices into snap.processes
+    static unsigned long long pickedGeneration = ~0ull;
+    static float unownedReceive, unownedSend;
+    if (!snap.socketsAvailable) {
+        ImGui::TextDisabled("Per-process traffic needs socket diagnostics, see the Connections tab");
+        return;
+    }
+    const vector<Proc>& processes = snap.processes;
+    if (pickedGeneration != snap.generation) {
+        auto traffic = [&](int index) { return processes[index].netReceiveRate + processes[index].netSendRate; };
+        top.clear();
+        for (size_t i = 0; i < processes.size(); ++i) {
+            if (traffic(i) <= 0) continue;
+            // keep the TOP busiest, busiest first
+            auto at = upper_bound(top.begin(), top.end(), static_cast<int>(i),
+                                  [&](int a, int b) { return traffic(a) > traffic(b); });
+            if (static_cast<size_t>(at - top.begin()) >= TOP) continue;
+            if (top.size() == TOP) top.pop_back();
+            top.insert(at, i);
+        }
+        unownedReceive = unownedSend = 0.0f;
+        for (const SocketInfo& socket : snap.sockets) {
+            if (socket.process >= 0) continue;
+            unownedReceive += socket.receiveRate;
+            unownedSend += socket.sendRate;
+        }
+        pickedGeneration = snap.generation;
+    }
+
+    if (ImGui::BeginTable("Top Talkers", 4, ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("PID");
+        ImGui::TableSetupColumn("Name");
+        ImGui::TableSetupColumn("RX/s");
+        ImGui::TableSetupColumn("TX/s");
+        ImGui::TableHeadersRow();
+        for (int index : top) {
+            const Proc& proc = processes[index];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::Text("%d", proc.pid);
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(proc.name.c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%s/s", formatNetworkBytes(proc.netReceiveRate).c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%s/s", formatNetworkBytes(proc.netSendRate).c_str());
+        }
+        ImGui::EndTable();
+    }
+    ImGui::TextDisabled("TCP only; without a known owner: %s/s in, %s/s out", formatNetworkBytes(unownedReceive).c_str(),
+                        formatNetworkBytes(unownedSend).c_str());
+}
+
+// display network interface information and stats in an ImGui window
+void networkWindow(const char* id, ImVec2 size, ImVec2 position, const SystemSnapshot& snap) {
+    MONITOR_PROBE(PROBE_NETWORK_WINDOW);
+    ImGui::Begin(id);
+    ImGui::SetWindowSize(size);
+    ImGui::SetWindowPos(position);
+
+    const Networks& interfaces = snap.interfaces;
+
+    ImGui::Text("Network Interfaces:");
+    ImGui::Separator();
+
+    for (const auto& iface : interfaces.ip4s) {
+        // Display interface name as a bold label
+        ImGui::TextColored(ImVec4(0.7f, 0.9f, 1.0f, 1.0f), "%s", iface.name);
+
+        // Indent the address under it
+        ImGui::SameLine(200); // Align address to column 2
+        ImGui::Text("%s", iface.addressBuffer);
+    }
+
+    // start tabbed interface
+    if (ImGui::BeginTabBar("NetworkTabs")) {
+        //create tab labeled RX(Receiver)
+        if (ImGui::BeginTabItem("RX (Receiver)")) {
+            const map<string, RX>& rxStats = snap.rx;
+            if (ImGui::BeginTable("RX Stats", 8, ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable)) {
+                ImGui::TableSetupColumn("Interface");
+                ImGui::TableSetupColumn("Bytes");
+                ImGui::TableSetupColumn("Packets");
+                ImGui::TableSetupColumn("Errs");
+                ImGui::TableSetupColumn("Drop");
+                ImGui::TableSetupColumn("FIFO");
+                ImGui::TableSetupColumn("Frame");
+                ImGui::TableSetupColumn("Compressed");
+                ImGui::TableHeadersRow();
+
+                for (const auto& [iface, rx] : rxStats) {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn(); ImGui::Text("%s", iface.c_str());
+                    ImGui::TableNextColumn(); ImGui::Text("%s", formatNetworkBytes(rx.bytes).c_str());
+                    ImGui::TableNextColumn(); ImGui::Text("%lld", rx.packets);
+                    ImGui::TableNextColumn(); ImGui::Text("%lld", rx.errs);
+                    ImGui::TableNextColumn(); ImGui::Text("%lld", rx.drop);
+                    ImGui::TableNextColumn(); ImGui::Text("%lld", rx.fifo);
+                    ImGui::TableNextColumn(); ImGui::Text("%lld", rx.frame);
+                    ImGui::TableNextColumn(); ImGui::Text("%lld", rx.compressed);
+                }
+                ImGui::EndTable();
+            }
+            ImGui::EndTabItem();
+        }
+
+        if (ImGui::BeginTabItem("TX (Transmitter)")) {
+            const map<string, TX>& txStats = snap.tx;
+            if (ImGui::BeginTable("TX Stats", 8, ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable)) {
+                ImGui::TableSetupColumn("Interface");
+                ImGui::TableSetupColumn("Bytes");
+                ImGui::TableSetupColumn("Packets");
+                ImGui::TableSetupColumn("Errs");
+                ImGui::TableSetupColumn("Drop");
+                ImGui::TableSetupColumn("FIFO");
+                ImGui::TableSetupColumn("Colls");
+                ImGui::TableSetupColumn("Compressed");
+                ImGui::TableHeadersRow();
+
+                for (const auto& [iface, tx] : txStats) {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn(); ImGui::Text("%s", iface.c_str());
+                    ImGui::TableNextColumn(); ImGui::Text("%s", formatNetworkBytes(tx.bytes).c_str());
+                    ImGui::TableNextColumn(); ImGui::Text("%lld", tx.packets);
+                    ImGui::TableNextColumn(); ImGui::Text("%lld", tx.errs);
+                    ImGui::TableNextColumn(); ImGui::Text("%lld", tx.drop);
+                    ImGui::TableNextColumn(); ImGui::Text("%lld", tx.fifo);
+                    ImGui::TableNextColumn(); ImGui::Text("%lld", tx.colls);
+                    ImGui::TableNextColumn(); ImGui::Text("%lld", tx.compressed);
+                }
+                ImGui::EndTable();
+            }
+            ImGui::EndTabItem();
+        }
+
+        if (ImGui::BeginTabItem("Network Usage")) {
+            static bool showRX = true, showTX = true;
+            ImGui::Checkbox("Show RX", &showRX);
+            ImGui::SameLine();
+            ImGui::Checkbox("Show TX", &showTX);
+
+            const map<string, RX>& rxStats = snap.rx;
+            const map<string, TX>& txStats = snap.tx;
+
+            if (showRX) {
+                ImGui::Text("RX Network Usage:");
+                for (const auto& [iface, rx] : rxStats) {
+                    if (iface.find("lo") != string::npos) continue;
+                    auto it = snap.rxRate.find(iface);
+                    float rate = it != snap.rxRate.end() ? it->second : 0.0f; // Smoothed rate in bytes/sec
+                    float scaledRate = rate / (1024 * 1024); // Scale to MB/s for progress bar
+                    ImGui::Text("%s:", iface.c_str());
+                    ImGui::SameLine(150);
+                    // Cap the progress bar to a reasonable max value (e.g., 10 MB/s) to avoid overflow
+                    float maxRate = 10.0f; // Adjust based on your network's expected max bandwidth
+                    ImGui::ProgressBar(scaledRate / maxRate, ImVec2(-1, 0), formatNetworkBytes(rate).c_str());
+                }
+            }
+
+            if (showTX) {
+                ImGui::Text("TX Network Usage:");
+                for (const auto& [iface, tx] : txStats) {
+                    if (iface.find("lo") != string::npos) continue;
+                    auto it = snap.txRate.find(iface);
+                    float rate = it != snap.txRate.end() ? it->second : 0.0f; // Smoothed rate in bytes/sec
+                    float scaledRate = rate / (1024 * 1024); // Scale to MB/s for progress bar
+                    ImGui::Text("%s:", iface.c_str());
+                    ImGui::SameLine(150);
+                    float maxRate = 10.0f; // Adjust based on your network's expected max bandwidth
+                    ImGui::ProgressBar(scaledRate / maxRate, ImVec2(-1, 0), formatNetworkBytes(rate).c_str());
+                }
+            }
+            ImGui::EndTabItem();
+        }
+
+        if (ImGui::BeginTabItem("Connections")) {
+            connectionsTable(snap);
+            ImGui::EndTabItem();
+        }
+
+        if (ImGui::BeginTabItem("Top Talkers")) {
+            topTalkers(snap);
+            ImGui::EndTabItem();
+        }
+        ImGui::EndTabBar();
+    }
+    ImGui::End();
+}